@@ -26,6 +26,8 @@
 extern "C" {
 #endif
 
+struct os_mbuf;
+
 /**
  * base64_decoder: used for decoding chunked data.  All public fields must be
  * initialized before use.
@@ -53,6 +55,29 @@ int base64_decode_maxlen(const char *str, void *data, int len);
  */
 int base64_decoder_go(struct base64_decoder *dec);
 
+/**
+ * Base64-encodes len bytes of an mbuf chain, starting at offset off.  Unlike
+ * base64_encode(), the output is not null-terminated.  dst must have room for
+ * BASE64_ENCODE_SIZE(len) characters.
+ *
+ * @return                      The number of characters written on success;
+ *                                  -1 if the chain is too short.
+ */
+int base64_encode_mbuf(const struct os_mbuf *om, int off, int len, char *dst,
+                       uint8_t should_pad);
+
+/**
+ * Decodes base64 data in place in an mbuf chain.  The characters from offset
+ * off to the end of the chain are replaced with the decoded bytes, and the
+ * chain is trimmed to fit.
+ *
+ * @return                      The number of decoded bytes on success; -1 on
+ *                                  invalid or incomplete input, in which case
+ *                                  the chain contents past off are
+ *                                  unspecified.
+ */
+int base64_decode_mbuf(struct os_mbuf *om, int off);
+
 #define BASE64_ENCODE_SIZE(__size) (((((__size) - 1) / 3) * 4) + 4)
 
 #ifdef __cplusplus
@@ -20,13 +20,82 @@
 #include "os/mynewt.h"
 #include "base64_test_priv.h"
 
+#define BASE64_TEST_POOL_BUF_SIZE   \
+    (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + 32)
+#define BASE64_TEST_POOL_BUF_COUNT  400
+
+static os_membuf_t base64_test_membuf[
+    OS_MEMPOOL_SIZE(BASE64_TEST_POOL_BUF_COUNT, BASE64_TEST_POOL_BUF_SIZE)];
+static struct os_mempool base64_test_mempool;
+static struct os_mbuf_pool base64_test_mbuf_pool;
+
+static void
+base64_test_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&base64_test_mempool, BASE64_TEST_POOL_BUF_COUNT,
+                         BASE64_TEST_POOL_BUF_SIZE, base64_test_membuf,
+                         "base64_test");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(&base64_test_mbuf_pool, &base64_test_mempool,
+                           BASE64_TEST_POOL_BUF_SIZE,
+                           BASE64_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Builds a packet holding the specified data, split into mbufs of at most
+ * chunk bytes each (chunk <= 32).
+ */
+struct os_mbuf *
+base64_test_chain(const void *data, int len, int chunk)
+{
+    struct os_mbuf *prev;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int off;
+    int n;
+
+    om = os_mbuf_get_pkthdr(&base64_test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    prev = om;
+    for (off = 0; off < len; off += n) {
+        if (off == 0) {
+            m = om;
+        } else {
+            m = os_mbuf_get(&base64_test_mbuf_pool, 0);
+            TEST_ASSERT_FATAL(m != NULL);
+            SLIST_NEXT(prev, om_next) = m;
+        }
+
+        n = min(chunk, len - off);
+        TEST_ASSERT_FATAL(n <= OS_MBUF_TRAILINGSPACE(m));
+        memcpy(m->om_data, (const uint8_t *)data + off, n);
+        m->om_len = n;
+        OS_MBUF_PKTHDR(om)->omp_len += n;
+
+        prev = m;
+    }
+
+    return om;
+}
+
 TEST_SUITE(base64_test_suite)
 {
+    base64_test_init();
+
     hex2str();
     str2hex();
     decode_basic();
     decode_maxlen();
     decode_chunks();
+    encode_basic();
+    encode_mbuf();
+    decode_mbuf();
+    base64_perf();
 }
 
 int
@@ -34,6 +34,12 @@ TEST_CASE_DECL(str2hex);
 TEST_CASE_DECL(decode_basic);
 TEST_CASE_DECL(decode_maxlen);
 TEST_CASE_DECL(decode_chunks);
+TEST_CASE_DECL(encode_basic);
+TEST_CASE_DECL(encode_mbuf);
+TEST_CASE_DECL(decode_mbuf);
+TEST_CASE_DECL(base64_perf);
+
+struct os_mbuf *base64_test_chain(const void *data, int len, int chunk);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,178 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "base64_test_priv.h"
+
+#define BASE64_PERF_DATA_LEN    3000
+#define BASE64_PERF_ITERS       100
+
+/* Chunk size used for the mbuf benchmarks: 20-byte mbufs. */
+#define BASE64_PERF_CHUNK       20
+
+static const char ref_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*
+ * Reference codec: a byte at a time, with a linear scan of the alphabet per
+ * character, as base64.c did before it was table driven.
+ */
+static int
+ref_pos(char c)
+{
+    const char *p;
+
+    for (p = ref_chars; *p; p++) {
+        if (*p == c) {
+            return p - ref_chars;
+        }
+    }
+    return -1;
+}
+
+static int
+ref_encode(const uint8_t *q, int size, char *p)
+{
+    int i;
+    int c;
+
+    for (i = 0; i < size; i += 3) {
+        c = q[i] * 65536;
+        if (i + 1 < size) {
+            c += q[i + 1] * 256;
+        }
+        if (i + 2 < size) {
+            c += q[i + 2];
+        }
+        *p++ = ref_chars[(c & 0x00fc0000) >> 18];
+        *p++ = ref_chars[(c & 0x0003f000) >> 12];
+        *p++ = ref_chars[(c & 0x00000fc0) >> 6];
+        *p++ = ref_chars[(c & 0x0000003f) >> 0];
+    }
+    *p = '\0';
+    return BASE64_ENCODE_SIZE(size);
+}
+
+static int
+ref_decode(const char *s, uint8_t *dst)
+{
+    unsigned int val;
+    int len;
+    int i;
+
+    len = 0;
+    while (*s != '\0') {
+        val = 0;
+        for (i = 0; i < 4; i++) {
+            if (s[i] == '\0' || strchr(ref_chars, s[i]) == NULL) {
+                return -1;
+            }
+            val = val * 64 + ref_pos(s[i]);
+        }
+        dst[len++] = val >> 16;
+        dst[len++] = val >> 8;
+        dst[len++] = val;
+        s += 4;
+    }
+    return len;
+}
+
+/*
+ * Times encoding and decoding of a 3 KB buffer with the reference codec and
+ * with the table-driven one, both flat and in 20-byte mbufs.
+ */
+TEST_CASE_SELF(base64_perf)
+{
+    static uint8_t data[BASE64_PERF_DATA_LEN];
+    static uint8_t out[BASE64_PERF_DATA_LEN];
+    static char enc[BASE64_ENCODE_SIZE(BASE64_PERF_DATA_LEN) + 1];
+    static char enc2[BASE64_ENCODE_SIZE(BASE64_PERF_DATA_LEN) + 1];
+    struct os_mbuf *om;
+    uint32_t ref_enc_us;
+    uint32_t ref_dec_us;
+    uint32_t enc_us;
+    uint32_t dec_us;
+    uint32_t mbuf_enc_us;
+    uint32_t mbuf_dec_us;
+    int64_t start;
+    int len;
+    int i;
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 13 + (i >> 8);
+    }
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        len = ref_encode(data, sizeof data, enc);
+    }
+    ref_enc_us = os_get_uptime_usec() - start;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        len = base64_encode(data, sizeof data, enc2, 1);
+    }
+    enc_us = os_get_uptime_usec() - start;
+    TEST_ASSERT_FATAL(len == BASE64_ENCODE_SIZE(sizeof data));
+    TEST_ASSERT_FATAL(strcmp(enc, enc2) == 0);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        len = ref_decode(enc, out);
+    }
+    ref_dec_us = os_get_uptime_usec() - start;
+    TEST_ASSERT_FATAL(len == sizeof data);
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        len = base64_decode(enc, out);
+    }
+    dec_us = os_get_uptime_usec() - start;
+    TEST_ASSERT_FATAL(len == sizeof data);
+    TEST_ASSERT_FATAL(memcmp(out, data, sizeof data) == 0);
+
+    om = base64_test_chain(data, sizeof data, BASE64_PERF_CHUNK);
+    start = os_get_uptime_usec();
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        len = base64_encode_mbuf(om, 0, sizeof data, enc2, 1);
+    }
+    mbuf_enc_us = os_get_uptime_usec() - start;
+    os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(len == BASE64_ENCODE_SIZE(sizeof data));
+    TEST_ASSERT_FATAL(memcmp(enc, enc2, len) == 0);
+
+    /* Decoding in place consumes the chain; only time the decoding. */
+    mbuf_dec_us = 0;
+    for (i = 0; i < BASE64_PERF_ITERS; i++) {
+        om = base64_test_chain(enc, strlen(enc), BASE64_PERF_CHUNK);
+        start = os_get_uptime_usec();
+        len = base64_decode_mbuf(om, 0);
+        mbuf_dec_us += os_get_uptime_usec() - start;
+        TEST_ASSERT_FATAL(len == sizeof data);
+        TEST_ASSERT_FATAL(os_mbuf_cmpf(om, 0, data, len) == 0);
+        os_mbuf_free_chain(om);
+    }
+
+    TEST_PASS("%d bytes x %d: encode ref=%lu us table=%lu us mbuf=%lu us; "
+              "decode ref=%lu us table=%lu us mbuf=%lu us",
+              BASE64_PERF_DATA_LEN, BASE64_PERF_ITERS,
+              (unsigned long)ref_enc_us, (unsigned long)enc_us,
+              (unsigned long)mbuf_enc_us, (unsigned long)ref_dec_us,
+              (unsigned long)dec_us, (unsigned long)mbuf_dec_us);
+}
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "base64_test_priv.h"
+
+#define DECODE_MBUF_HDR_LEN     2
+
+static void
+pass(const char *src, const char *expected, int chunk)
+{
+    struct os_mbuf *om;
+    char buf[256];
+    int len;
+    int rc;
+
+    /* Leave a header in front of the encoded data, as a transport would. */
+    buf[0] = 'h';
+    buf[1] = 'd';
+    strcpy(buf + DECODE_MBUF_HDR_LEN, src);
+
+    om = base64_test_chain(buf, DECODE_MBUF_HDR_LEN + strlen(src), chunk);
+
+    len = base64_decode_mbuf(om, DECODE_MBUF_HDR_LEN);
+    TEST_ASSERT_FATAL(len == strlen(expected));
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == DECODE_MBUF_HDR_LEN + len);
+
+    rc = os_mbuf_cmpf(om, 0, "hd", DECODE_MBUF_HDR_LEN);
+    TEST_ASSERT(rc == 0);
+    rc = os_mbuf_cmpf(om, DECODE_MBUF_HDR_LEN, expected, len);
+    TEST_ASSERT(rc == 0);
+
+    os_mbuf_free_chain(om);
+}
+
+static void
+fail(const char *src, int chunk)
+{
+    struct os_mbuf *om;
+    int len;
+
+    om = base64_test_chain(src, strlen(src), chunk);
+    len = base64_decode_mbuf(om, 0);
+    TEST_ASSERT(len == -1);
+    os_mbuf_free_chain(om);
+}
+
+TEST_CASE_SELF(decode_mbuf)
+{
+    static const int chunks[] = { 1, 2, 3, 5, 6, 7, 32 };
+    int i;
+
+    for (i = 0; i < sizeof chunks / sizeof chunks[0]; i++) {
+        pass("", "", chunks[i]);
+        pass("dGhlIGRpZSBpcyBjYXN0", "the die is cast", chunks[i]);
+        pass("c29tZSB0ZXh0IHdpdGggcGFkZGluZw==", "some text with padding",
+             chunks[i]);
+        pass("Zm9vYmE=", "fooba", chunks[i]);
+        pass("Zm9vYg==Zm9v", "foobfoo", chunks[i]);
+        pass("RnJvbSBteSBpbmZhbmN5IEkgd2FzIG5vdGVkIGZvciB0aGUgZG9jaWxpdHkg"
+             "YW5kIGh1bWFuaXR5IG9mIG15IGRpc3Bvc2l0aW9uLg==",
+             "From my infancy I was noted for the docility and humanity of "
+             "my disposition.", chunks[i]);
+
+        /* Contains invalid character (space). */
+        fail("c29tZSB0ZXh IHdpdGggcGFkZGluZw==", chunks[i]);
+
+        /* Incomplete input. */
+        fail("c29tZSB0ZXh0IHdpdGggcGFkZGluZw=", chunks[i]);
+        fail("c29tZSB0ZXh0IHdpdGggcGFkZGluZ", chunks[i]);
+
+        /* Too much padding. */
+        fail("Zm9vZ===", chunks[i]);
+        fail("Z===", chunks[i]);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "base64_test_priv.h"
+
+static void
+pass(const char *src, const char *expected, uint8_t should_pad)
+{
+    char dst[64];
+    int len;
+
+    memset(dst, 0xa5, sizeof dst);
+    len = base64_encode(src, strlen(src), dst, should_pad);
+    TEST_ASSERT(len == strlen(expected));
+    TEST_ASSERT(strcmp(dst, expected) == 0);
+}
+
+TEST_CASE_SELF(encode_basic)
+{
+    /* RFC 4648 test vectors. */
+    pass("", "", 1);
+    pass("f", "Zg==", 1);
+    pass("fo", "Zm8=", 1);
+    pass("foo", "Zm9v", 1);
+    pass("foob", "Zm9vYg==", 1);
+    pass("fooba", "Zm9vYmE=", 1);
+    pass("foobar", "Zm9vYmFy", 1);
+
+    pass("f", "Zg", 0);
+    pass("fo", "Zm8", 0);
+    pass("foob", "Zm9vYg", 0);
+    pass("foobar", "Zm9vYmFy", 0);
+
+    pass("\xff\xfe\xfd\xfc", "//79/A==", 1);
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "base64_test_priv.h"
+
+#define ENCODE_MBUF_DATA_LEN    200
+
+/*
+ * Encodes ranges of mbuf chains of various shapes and ensures the result
+ * matches encoding the flat data.
+ */
+TEST_CASE_SELF(encode_mbuf)
+{
+    static const int chunks[] = { 1, 2, 4, 5, 32 };
+    static const int offs[] = { 0, 1, 2, 7 };
+    char expected[BASE64_ENCODE_SIZE(ENCODE_MBUF_DATA_LEN) + 1];
+    char actual[BASE64_ENCODE_SIZE(ENCODE_MBUF_DATA_LEN) + 1];
+    uint8_t data[ENCODE_MBUF_DATA_LEN];
+    struct os_mbuf *om;
+    int exp_len;
+    int len;
+    int c;
+    int o;
+    int n;
+    int i;
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 7;
+    }
+
+    for (c = 0; c < sizeof chunks / sizeof chunks[0]; c++) {
+        om = base64_test_chain(data, sizeof data, chunks[c]);
+
+        for (o = 0; o < sizeof offs / sizeof offs[0]; o++) {
+            for (n = 0; n <= 8; n++) {
+                len = sizeof data - offs[o] - n;
+
+                exp_len = base64_encode(data + offs[o], len, expected, n & 1);
+                len = base64_encode_mbuf(om, offs[o], len, actual, n & 1);
+                TEST_ASSERT(len == exp_len);
+                TEST_ASSERT(memcmp(actual, expected, exp_len) == 0);
+            }
+        }
+
+        /* Chain too short. */
+        len = base64_encode_mbuf(om, 10, sizeof data - 9, actual, 1);
+        TEST_ASSERT(len == -1);
+
+        os_mbuf_free_chain(om);
+    }
+}
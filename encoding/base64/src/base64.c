@@ -42,6 +42,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 #include <os/mynewt.h>
 #include <base64/base64.h>
@@ -49,58 +50,104 @@
 static const char base64_chars[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/*
+ * Maps each character to its value in the base64 alphabet.  Characters
+ * outside the alphabet, including '=' and '\0', map to 0xff.
+ */
+static const uint8_t base64_dec_tbl[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
+    0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
+    0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
+    0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#define BASE64_DEC_INVALID(c)   (base64_dec_tbl[(uint8_t)(c)] & 0xc0)
+
+/**
+ * Encodes a 24-bit group as four characters.
+ */
+static inline void
+base64_encode_group(char *p, uint32_t val)
+{
+    p[0] = base64_chars[(val >> 18) & 0x3f];
+    p[1] = base64_chars[(val >> 12) & 0x3f];
+    p[2] = base64_chars[(val >> 6) & 0x3f];
+    p[3] = base64_chars[val & 0x3f];
+}
+
+/**
+ * Encodes the final one or two bytes of the input.
+ *
+ * @return                      The number of characters written.
+ */
 static int
-pos(char c)
+base64_encode_tail(char *p, const uint8_t *q, int len, uint8_t should_pad)
 {
-    const char *p;
-    for (p = base64_chars; *p; p++)
-        if (*p == c)
-            return p - base64_chars;
-    return -1;
+    uint32_t val;
+
+    val = q[0] << 16;
+    if (len > 1) {
+        val |= q[1] << 8;
+    }
+    base64_encode_group(p, val);
+
+    if (len == 1) {
+        p[2] = '=';
+    }
+    p[3] = '=';
+
+    if (should_pad) {
+        return 4;
+    }
+    return len + 1;
 }
 
 int
 base64_encode(const void *data, int size, char *s, uint8_t should_pad)
 {
+    const uint8_t *q;
     char *p;
-    int i;
-    int c;
-    const unsigned char *q;
-    char *last;
-    int diff;
 
     p = s;
+    q = data;
 
-    q = (const unsigned char *) data;
-    last = NULL;
-    i = 0;
-    while (i < size) {
-        c = q[i++];
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        p[0] = base64_chars[(c & 0x00fc0000) >> 18];
-        p[1] = base64_chars[(c & 0x0003f000) >> 12];
-        p[2] = base64_chars[(c & 0x00000fc0) >> 6];
-        p[3] = base64_chars[(c & 0x0000003f) >> 0];
-        last = p;
+    while (size >= 3) {
+        base64_encode_group(p, (q[0] << 16) | (q[1] << 8) | q[2]);
         p += 4;
+        q += 3;
+        size -= 3;
     }
 
-    if (last) {
-        diff = i - size;
-        if (diff > 0) {
-            if (should_pad) {
-                memset(last + (4 - diff), '=', diff);
-            } else {
-                p = last + (4 - diff);
-            }
-        }
+    if (size > 0) {
+        p += base64_encode_tail(p, q, size, should_pad);
     }
 
     *p = 0;
@@ -108,6 +155,68 @@ base64_encode(const void *data, int size, char *s, uint8_t should_pad)
     return (p - s);
 }
 
+int
+base64_encode_mbuf(const struct os_mbuf *om, int off, int len, char *dst,
+                   uint8_t should_pad)
+{
+    const uint8_t *q;
+    uint8_t carry[3];
+    uint16_t mbuf_off;
+    char *p;
+    int carry_len;
+    int n;
+
+    om = os_mbuf_off(om, off, &mbuf_off);
+
+    p = dst;
+    carry_len = 0;
+
+    while (len > 0) {
+        if (om == NULL) {
+            return -1;
+        }
+
+        q = om->om_data + mbuf_off;
+        n = min(om->om_len - mbuf_off, len);
+        len -= n;
+
+        /* Complete a group begun in the previous mbuf. */
+        if (carry_len > 0) {
+            while (carry_len < 3 && n > 0) {
+                carry[carry_len++] = *q++;
+                n--;
+            }
+            if (carry_len == 3) {
+                base64_encode_group(p,
+                    (carry[0] << 16) | (carry[1] << 8) | carry[2]);
+                p += 4;
+                carry_len = 0;
+            }
+        }
+
+        while (n >= 3) {
+            base64_encode_group(p, (q[0] << 16) | (q[1] << 8) | q[2]);
+            p += 4;
+            q += 3;
+            n -= 3;
+        }
+
+        if (n > 0) {
+            memcpy(carry + carry_len, q, n);
+            carry_len += n;
+        }
+
+        om = SLIST_NEXT(om, om_next);
+        mbuf_off = 0;
+    }
+
+    if (carry_len > 0) {
+        p += base64_encode_tail(p, carry, carry_len, should_pad);
+    }
+
+    return (p - dst);
+}
+
 int
 base64_pad(char *buf, int len)
 {
@@ -125,17 +234,17 @@ base64_pad(char *buf, int len)
 
 #define DECODE_ERROR -1
 
+/**
+ * Decodes a full token of four characters, each of which is either in the
+ * base64 alphabet or '='.
+ */
 static unsigned int
-token_decode(const char *token, int len)
+token_decode(const char *token)
 {
     int i;
     unsigned int val = 0;
     int marker = 0;
 
-    if (len < 4) {
-        return DECODE_ERROR;
-    }
-
     for (i = 0; i < 4; i++) {
         val *= 64;
         if (token[i] == '=') {
@@ -143,7 +252,7 @@ token_decode(const char *token, int len)
         } else if (marker > 0) {
             return DECODE_ERROR;
         } else {
-            val += pos(token[i]);
+            val += base64_dec_tbl[(uint8_t)token[i]];
         }
     }
 
@@ -154,6 +263,32 @@ token_decode(const char *token, int len)
     return (marker << 24) | val;
 }
 
+/**
+ * Decodes a token of four characters without padding.
+ *
+ * @return                      The 24-bit value on success; -1 if any of the
+ *                                  characters is outside the base64 alphabet.
+ */
+static inline int32_t
+base64_decode_quad(const char *s)
+{
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t d;
+
+    a = base64_dec_tbl[(uint8_t)s[0]];
+    b = base64_dec_tbl[(uint8_t)s[1]];
+    c = base64_dec_tbl[(uint8_t)s[2]];
+    d = base64_dec_tbl[(uint8_t)s[3]];
+
+    if ((a | b | c | d) & 0xc0) {
+        return -1;
+    }
+
+    return (a << 18) | (b << 12) | (c << 6) | d;
+}
+
 int
 base64_decode(const char *str, void *data)
 {
@@ -195,6 +330,8 @@ base64_decoder_go(struct base64_decoder *dec)
     unsigned int marker;
     unsigned int val;
     uint8_t *dst;
+    int32_t quad;
+    bool terminated;
     char sval;
     int read_len;
     int src_len;
@@ -208,11 +345,15 @@ base64_decoder_go(struct base64_decoder *dec)
     dst_off = 0;
     src_off = 0;
 
-    /* A length <= 0 means "unbounded". */
+    /* A source length <= 0 means "null-terminated"; a destination length
+     * <= 0 means "unbounded".
+     */
     if (dec->src_len <= 0) {
-        src_len = INT_MAX;
+        src_len = strlen(dec->src);
+        terminated = true;
     } else {
         src_len = dec->src_len;
+        terminated = false;
     }
     if (dec->dst_len <= 0) {
         dst_len = INT_MAX;
@@ -221,6 +362,20 @@ base64_decoder_go(struct base64_decoder *dec)
     }
 
     while (1) {
+        /* Fast path: whole unpadded tokens with room for all three bytes. */
+        if (dec->buf_len == 0) {
+            while (src_len - src_off >= 4 && dst_len - dst_off >= 3) {
+                quad = base64_decode_quad(&dec->src[src_off]);
+                if (quad < 0) {
+                    break;
+                }
+                dst[dst_off++] = quad >> 16;
+                dst[dst_off++] = quad >> 8;
+                dst[dst_off++] = quad;
+                src_off += 4;
+            }
+        }
+
         src_rem = src_len - src_off;
         if (src_rem == 0) {
             /* End of source input. */
@@ -236,19 +391,24 @@ base64_decoder_go(struct base64_decoder *dec)
         read_len = 4 - dec->buf_len;
 
         /* Detect invalid input. */
-        for (i = 0; i < read_len; i++) {
+        for (i = 0; i < read_len && i < src_rem; i++) {
             sval = dec->src[src_off + i];
             if (sval == '\0') {
                 /* Incomplete input. */
                 return -1;
             }
-            if (sval != '=' && strchr(base64_chars, sval) == NULL) {
+            if (sval != '=' && BASE64_DEC_INVALID(sval)) {
                 /* Invalid base64 character. */
                 return -1;
             }
         }
 
         if (src_rem < read_len) {
+            if (terminated) {
+                /* Incomplete input. */
+                return -1;
+            }
+
             /* Input contains a partial token.  Stash it for use during the
              * next call.
              */
@@ -259,7 +419,7 @@ base64_decoder_go(struct base64_decoder *dec)
 
         /* Copy full token into buf and decode it. */
         memcpy(&dec->buf[dec->buf_len], &dec->src[src_off], read_len);
-        val = token_decode(dec->buf, read_len);
+        val = token_decode(dec->buf);
         if (val == DECODE_ERROR) {
             return -1;
         }
@@ -293,3 +453,95 @@ base64_decoder_go(struct base64_decoder *dec)
 
     return dst_off;
 }
+
+int
+base64_decode_mbuf(struct os_mbuf *om, int off)
+{
+    struct os_mbuf *rm;
+    struct os_mbuf *wm;
+    unsigned int val;
+    uint16_t roff;
+    uint16_t woff;
+    uint8_t out[3];
+    int32_t quad;
+    char token[4];
+    char sval;
+    int token_len;
+    int out_len;
+    int in_len;
+    int total;
+    int i;
+
+    rm = os_mbuf_off(om, off, &roff);
+    if (rm == NULL) {
+        return -1;
+    }
+
+    /* Decoded bytes are written behind the read position: every token of
+     * four characters yields at most three bytes.
+     */
+    wm = rm;
+    woff = roff;
+    token_len = 0;
+    in_len = 0;
+    total = 0;
+
+    for (; rm != NULL; rm = SLIST_NEXT(rm, om_next), roff = 0) {
+        in_len += rm->om_len - roff;
+
+        while (roff < rm->om_len) {
+            if (token_len == 0 && rm->om_len - roff >= 4 &&
+                (quad = base64_decode_quad((char *)rm->om_data + roff)) >= 0) {
+
+                /* Fast path: a whole unpadded token within this mbuf. */
+                roff += 4;
+                out[0] = quad >> 16;
+                out[1] = quad >> 8;
+                out[2] = quad;
+                out_len = 3;
+            } else {
+                sval = rm->om_data[roff++];
+                if (sval != '=' && BASE64_DEC_INVALID(sval)) {
+                    return -1;
+                }
+                token[token_len++] = sval;
+                if (token_len < 4) {
+                    continue;
+                }
+                token_len = 0;
+
+                val = token_decode(token);
+                if (val == DECODE_ERROR) {
+                    return -1;
+                }
+                out[0] = val >> 16;
+                out[1] = val >> 8;
+                out[2] = val;
+                out_len = 3 - ((val >> 24) & 0xff);
+            }
+
+            if (wm->om_len - woff >= out_len) {
+                memcpy(wm->om_data + woff, out, out_len);
+                woff += out_len;
+            } else {
+                for (i = 0; i < out_len; i++) {
+                    while (woff == wm->om_len) {
+                        wm = SLIST_NEXT(wm, om_next);
+                        woff = 0;
+                    }
+                    wm->om_data[woff++] = out[i];
+                }
+            }
+            total += out_len;
+        }
+    }
+
+    if (token_len != 0) {
+        /* Incomplete input. */
+        return -1;
+    }
+
+    os_mbuf_adj(om, total - in_len);
+
+    return total;
+}
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+#include "test_json_priv.h"
+
+#define JSON_PERF_ITERS     10000
+#define JSON_PERF_ATTRS     16
+
+static const char json_perf_input[] =
+    "{\"id\": 1, \"seq\": 2, \"flags\": 3, \"type\": \"sensor\","
+    " \"name\": \"temperature-0\", \"unit\": \"mC\", \"min\": -40000,"
+    " \"max\": 125000, \"value\": 23512, \"interval\": 1000,"
+    " \"enabled\": true, \"alarm\": false, \"owner\": \"app\","
+    " \"location\": \"board\", \"rev\": 7, \"crc\": 48879}";
+
+/*
+ * Times decoding of a 16-attribute object: a character at a time with a
+ * linear attribute search, from a flat buffer, and from a flat buffer with an
+ * attribute index.
+ */
+TEST_CASE(test_json_decode_perf)
+{
+    static const char *names[JSON_PERF_ATTRS] = {
+        "id", "seq", "flags", "type", "name", "unit", "min", "max", "value",
+        "interval", "enabled", "alarm", "owner", "location", "rev", "crc",
+    };
+    struct json_attr_t attrs[JSON_PERF_ATTRS + 1];
+    long long int ints[JSON_PERF_ATTRS];
+    char strs[JSON_PERF_ATTRS][16];
+    bool bools[JSON_PERF_ATTRS];
+    struct json_flat_buffer jfb;
+    struct json_attr_index idx;
+    struct test_jbuf tjb;
+    uint8_t slots[32];
+    uint32_t us[3];
+    int64_t start;
+    int mode;
+    int rc;
+    int i;
+
+    memset(attrs, 0, sizeof(attrs));
+    for (i = 0; i < JSON_PERF_ATTRS; i++) {
+        attrs[i].attribute = (char *)names[i];
+        if (i == 3 || i == 4 || i == 5 || i == 12 || i == 13) {
+            attrs[i].type = t_string;
+            attrs[i].addr.string = strs[i];
+            attrs[i].len = sizeof(strs[i]);
+        } else if (i == 10 || i == 11) {
+            attrs[i].type = t_boolean;
+            attrs[i].addr.boolean = &bools[i];
+        } else {
+            attrs[i].type = t_integer;
+            attrs[i].addr.integer = &ints[i];
+        }
+    }
+
+    rc = json_attr_index_init(&idx, attrs, slots, sizeof(slots));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (mode = 0; mode < 3; mode++) {
+        /* Each mode has to fill in the values itself. */
+        memset(ints, 0, sizeof(ints));
+        memset(strs, 0, sizeof(strs));
+        memset(bools, 0, sizeof(bools));
+        bools[11] = true;
+
+        start = os_get_uptime_usec();
+        for (i = 0; i < JSON_PERF_ITERS; i++) {
+            switch (mode) {
+            case 0:
+                test_buf_init(&tjb, (char *)json_perf_input);
+                rc = json_read_object(&tjb.json_buf, attrs);
+                break;
+            case 1:
+                json_flat_buffer_init(&jfb, json_perf_input,
+                                      sizeof(json_perf_input) - 1);
+                rc = json_read_object(&jfb.jfb_buf, attrs);
+                break;
+            default:
+                json_flat_buffer_init(&jfb, json_perf_input,
+                                      sizeof(json_perf_input) - 1);
+                rc = json_read_object_indexed(&jfb.jfb_buf, &idx);
+                break;
+            }
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        us[mode] = os_get_uptime_usec() - start;
+
+        TEST_ASSERT(ints[8] == 23512);
+        TEST_ASSERT(ints[15] == 48879);
+        TEST_ASSERT(strcmp(strs[4], "temperature-0") == 0);
+        TEST_ASSERT(bools[10] && !bools[11]);
+    }
+
+    TEST_PASS("%d objects of %d attributes: per-char=%lu us flat=%lu us "
+              "flat+index=%lu us", JSON_PERF_ITERS, JSON_PERF_ATTRS,
+              (unsigned long)us[0], (unsigned long)us[1],
+              (unsigned long)us[2]);
+}
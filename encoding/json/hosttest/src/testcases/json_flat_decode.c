@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json_priv.h"
+
+static const char json_flat_input[] =
+    "{\"KeyBool\": true,\"KeyInt\": -1234,\"KeyUint\": 1353214,"
+    "\"KeyString\": \"foo\\\"bar\",\"KeyStringN\": \"foobarlong\","
+    "\"KeyIntArr\": [153,2532,-322],\"KeyAny\": \"text\"}";
+
+/* Decodes with a character-at-a-time buffer and with a flat buffer, each
+ * with and without an attribute index; all four must agree.
+ */
+TEST_CASE(test_json_flat_decode)
+{
+    struct json_flat_buffer jfb;
+    struct json_attr_index idx;
+    struct test_jbuf tjb;
+    uint8_t slots[16];
+    long long unsigned int uint_val;
+    long long int int_val;
+    long long int any_int;
+    bool bool_val;
+    char string1[16];
+    char string2[11];
+    char any_str[8];
+    long long int intarr[8];
+    int array_count;
+    int mode;
+    int rc;
+
+    struct json_attr_t attrs[] = {
+        {
+            .attribute = "KeyBool",
+            .type = t_boolean,
+            .addr.boolean = &bool_val,
+            .nodefault = true
+        }, {
+            .attribute = "KeyInt",
+            .type = t_integer,
+            .addr.integer = &int_val,
+            .nodefault = true
+        }, {
+            .attribute = "KeyUint",
+            .type = t_uinteger,
+            .addr.uinteger = &uint_val,
+            .nodefault = true
+        }, {
+            .attribute = "KeyString",
+            .type = t_string,
+            .addr.string = string1,
+            .len = sizeof(string1)
+        }, {
+            .attribute = "KeyStringN",
+            .type = t_string,
+            .addr.string = string2,
+            .len = sizeof(string2)
+        }, {
+            .attribute = "KeyIntArr",
+            .type = t_array,
+            .addr.array = {
+                .element_type = t_integer,
+                .arr.integers.store = intarr,
+                .maxlen = sizeof intarr / sizeof intarr[0],
+                .count = &array_count,
+            },
+            .nodefault = true
+        }, {
+            /* Two specs for one name; the value picks between them. */
+            .attribute = "KeyAny",
+            .type = t_integer,
+            .addr.integer = &any_int,
+            .dflt.integer = -1
+        }, {
+            .attribute = "KeyAny",
+            .type = t_string,
+            .addr.string = any_str,
+            .len = sizeof(any_str)
+        }, {
+            .attribute = NULL
+        }
+    };
+
+    rc = json_attr_index_init(&idx, attrs, slots, sizeof(slots));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (mode = 0; mode < 4; mode++) {
+        memset(string1, 'x', sizeof(string1));
+        memset(string2, 'x', sizeof(string2));
+        memset(any_str, 'x', sizeof(any_str));
+        array_count = 0;
+
+        if (mode & 1) {
+            json_flat_buffer_init(&jfb, json_flat_input,
+                                  strlen(json_flat_input));
+            if (mode & 2) {
+                rc = json_read_object_indexed(&jfb.jfb_buf, &idx);
+            } else {
+                rc = json_read_object(&jfb.jfb_buf, attrs);
+            }
+        } else {
+            test_buf_init(&tjb, (char *)json_flat_input);
+            if (mode & 2) {
+                rc = json_read_object_indexed(&tjb.json_buf, &idx);
+            } else {
+                rc = json_read_object(&tjb.json_buf, attrs);
+            }
+        }
+
+        TEST_ASSERT_FATAL(rc == 0, "mode %d rc %d", mode, rc);
+        TEST_ASSERT(bool_val == true);
+        TEST_ASSERT(int_val == -1234);
+        TEST_ASSERT(uint_val == 1353214);
+        TEST_ASSERT(strcmp(string1, "foo\"bar") == 0);
+        TEST_ASSERT(strcmp(string2, "foobarlong") == 0);
+        TEST_ASSERT(array_count == 3);
+        TEST_ASSERT(intarr[2] == -322);
+        TEST_ASSERT(any_int == -1);
+        TEST_ASSERT(strcmp(any_str, "text") == 0);
+    }
+
+    /* Unknown attribute, in every mode. */
+    json_flat_buffer_init(&jfb, "{\"KeyNone\": 1}", 14);
+    rc = json_read_object_indexed(&jfb.jfb_buf, &idx);
+    TEST_ASSERT(rc == JSON_ERR_BADATTR);
+    json_flat_buffer_init(&jfb, "{\"KeyIn\": 1}", 12);
+    rc = json_read_object(&jfb.jfb_buf, attrs);
+    TEST_ASSERT(rc == JSON_ERR_BADATTR);
+    test_buf_init(&tjb, "{\"KeyIntX\": 1}");
+    rc = json_read_object_indexed(&tjb.json_buf, &idx);
+    TEST_ASSERT(rc == JSON_ERR_BADATTR);
+
+    /* A string that does not fit its destination. */
+    json_flat_buffer_init(&jfb, "{\"KeyStringN\": \"foobarlongs\"}", 29);
+    rc = json_read_object_indexed(&jfb.jfb_buf, &idx);
+    TEST_ASSERT(rc == JSON_ERR_STRLONG);
+
+    /* The input need not be NUL-terminated. */
+    json_flat_buffer_init(&jfb, "{\"KeyInt\": 42}{\"KeyInt\": 7}", 14);
+    rc = json_read_object(&jfb.jfb_buf, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(int_val == 42);
+
+    /* Slot counts must be a power of two larger than the name count. */
+    rc = json_attr_index_init(&idx, attrs, slots, 12);
+    TEST_ASSERT(rc == JSON_ERR_INDEX);
+    rc = json_attr_index_init(&idx, attrs, slots, 4);
+    TEST_ASSERT(rc == JSON_ERR_INDEX);
+    rc = json_attr_index_init(&idx, attrs, slots, 8);
+    TEST_ASSERT(rc == 0);
+}
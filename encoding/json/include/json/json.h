@@ -101,6 +101,73 @@ int json_encode_array_start(struct json_encoder *encoder);
 int json_encode_array_value(struct json_encoder *encoder, struct json_value *val);
 int json_encode_array_finish(struct json_encoder *encoder);
 
+struct os_mbuf;
+
+/**
+ * Receives a completed chunk from an mbuf writer.  The callee takes
+ * ownership of the chain, whether or not it succeeds.
+ *
+ * @return                      0 on success; nonzero to stop encoding.
+ */
+typedef int (*json_mbuf_flush_func_t)(void *arg, struct os_mbuf *om);
+
+/**
+ * Encoder sink that appends output to an mbuf chain.
+ *
+ * If a flush callback is set and jmw_chunk_sz is nonzero, the chain is passed
+ * to the callback each time it holds exactly jmw_chunk_sz bytes, and is
+ * replaced with an empty chain from the same pool.  A response of any size
+ * then takes at most one chunk of memory.
+ *
+ * The first error is kept in jmw_rc; later writes are dropped.  jmw_om is
+ * always the chain currently held by the writer, and is NULL once it has
+ * been flushed by json_mbuf_writer_finish().
+ */
+struct json_mbuf_writer {
+    struct os_mbuf *jmw_om;
+    struct os_mbuf *jmw_last;
+    json_mbuf_flush_func_t jmw_flush;
+    void *jmw_flush_arg;
+    uint16_t jmw_chunk_sz;
+    int jmw_rc;
+};
+
+/**
+ * Sets up an mbuf writer and points the encoder at it.
+ *
+ * @param jmw                   The writer to initialize.
+ * @param encoder               The encoder to write through jmw.
+ * @param om                    Packet header mbuf to append to; it may
+ *                                  already contain data.  If it holds
+ *                                  chunk_sz bytes or more, it is flushed
+ *                                  as is on the first write.
+ * @param chunk_sz              Chunk size, in bytes; 0 to never flush
+ *                                  before json_mbuf_writer_finish().
+ * @param flush                 Chunk callback; NULL to build the whole
+ *                                  document in om.
+ * @param flush_arg             Argument passed to the callback.
+ */
+void json_mbuf_writer_init(struct json_mbuf_writer *jmw,
+                           struct json_encoder *encoder, struct os_mbuf *om,
+                           uint16_t chunk_sz, json_mbuf_flush_func_t flush,
+                           void *flush_arg);
+
+/**
+ * json_write_func_t implementation for an mbuf writer.
+ *
+ * @return                      0 on success; the writer's error otherwise.
+ */
+int json_mbuf_write(void *arg, char *data, int len);
+
+/**
+ * Passes any remaining output to the flush callback.  Without a callback,
+ * the encoded document is left in jmw_om.
+ *
+ * @return                      0 on success; the first error seen by the
+ *                                  writer otherwise.
+ */
+int json_mbuf_writer_finish(struct json_mbuf_writer *jmw);
+
 /* Json parser definitions */
 typedef enum {
     t_integer,
@@ -194,10 +261,48 @@ struct json_buffer {
     json_buffer_read_prev_byte_t jb_read_prev;
 };
 
+/*
+ * A json_buffer over a contiguous string, which need not be NUL-terminated.
+ * The decoder recognizes this buffer type and scans attribute names and
+ * values in place instead of fetching them a character at a time; plain
+ * string values are copied straight to their destination.
+ */
+struct json_flat_buffer {
+    /* json_buffer must be first element in the structure */
+    struct json_buffer jfb_buf;
+    const char *jfb_start;
+    const char *jfb_end;
+    const char *jfb_cur;
+};
+
+void json_flat_buffer_init(struct json_flat_buffer *jfb, const char *str,
+                           int len);
+
+/*
+ * Hash index over the attribute names of a json_attr_t array.  Build it once
+ * with json_attr_index_init() and pass it to json_read_object_indexed() in
+ * place of the array; attribute names are then looked up by hash instead of
+ * compared against every entry.  The caller supplies the slot array, whose
+ * size must be a power of two larger than the number of distinct attribute
+ * names.  Neither the attribute array nor the slots may change while the
+ * index is in use.
+ */
+struct json_attr_index {
+    const struct json_attr_t *jai_attrs;
+    uint8_t *jai_slots;
+    uint16_t jai_mask;
+};
+
+int json_attr_index_init(struct json_attr_index *idx,
+                         const struct json_attr_t *attrs,
+                         uint8_t *slots, int num_slots);
+
 #define JSON_ATTR_MAX        31        /* max chars in JSON attribute name */
 #define JSON_VAL_MAX        512        /* max chars in JSON value part */
 
 int json_read_object(struct json_buffer *, const struct json_attr_t *);
+int json_read_object_indexed(struct json_buffer *,
+                             const struct json_attr_index *);
 int json_read_array(struct json_buffer *, const struct json_array_t *);
 
 #define JSON_ERR_OBSTART     1   /* non-WS when expecting object start */
@@ -223,6 +328,7 @@ int json_read_array(struct json_buffer *, const struct json_array_t *);
 #define JSON_ERR_MISC        20  /* other data conversion error */
 #define JSON_ERR_BADNUM      21  /* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR     22  /* unexpected null value or attribute pointer */
+#define JSON_ERR_INDEX       23  /* attribute index has too few slots */
 
 /*
  * Use the following macros to declare template initializers for structobject
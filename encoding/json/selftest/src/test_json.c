@@ -23,6 +23,9 @@
 
 TEST_CASE_DECL(test_json_simple_encode);
 TEST_CASE_DECL(test_json_simple_decode);
+TEST_CASE_DECL(test_json_flat_decode);
+TEST_CASE_DECL(test_json_decode_perf);
+TEST_CASE_DECL(test_json_mbuf_encode);
 
 TEST_SUITE(test_json_suite)
 {
@@ -31,6 +34,9 @@ TEST_SUITE(test_json_suite)
 
     test_json_simple_encode();
     test_json_simple_decode();
+    test_json_flat_decode();
+    test_json_decode_perf();
+    test_json_mbuf_encode();
 
     free(bigbuf);
 }
@@ -0,0 +1,248 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os/mynewt.h"
+#include "test_json_priv.h"
+
+#define JSON_MBUF_TEST_BUF_SIZE     \
+    (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + 32)
+#define JSON_MBUF_TEST_BUF_COUNT    64
+#define JSON_MBUF_TEST_ENTRIES      40
+#define JSON_MBUF_TEST_CHUNK        100
+
+static os_membuf_t json_mbuf_test_membuf[
+    OS_MEMPOOL_SIZE(JSON_MBUF_TEST_BUF_COUNT, JSON_MBUF_TEST_BUF_SIZE)];
+static struct os_mempool json_mbuf_test_mempool;
+static struct os_mbuf_pool json_mbuf_test_pool;
+
+static char json_mbuf_test_out[2048];
+static int json_mbuf_test_out_len;
+static int json_mbuf_test_chunks;
+static int json_mbuf_test_short_chunks;
+static int json_mbuf_test_writes;
+
+static int
+json_mbuf_test_write(void *arg, char *data, int len)
+{
+    TEST_ASSERT_FATAL(json_mbuf_test_out_len + len <=
+                      sizeof json_mbuf_test_out);
+    memcpy(json_mbuf_test_out + json_mbuf_test_out_len, data, len);
+    json_mbuf_test_out_len += len;
+    json_mbuf_test_writes++;
+
+    return 0;
+}
+
+static int
+json_mbuf_test_flush(void *arg, struct os_mbuf *om)
+{
+    int len;
+    int rc;
+
+    len = OS_MBUF_PKTLEN(om);
+    TEST_ASSERT_FATAL(json_mbuf_test_out_len + len <=
+                      sizeof json_mbuf_test_out);
+    rc = os_mbuf_copydata(om, 0, len,
+                          json_mbuf_test_out + json_mbuf_test_out_len);
+    TEST_ASSERT_FATAL(rc == 0);
+    json_mbuf_test_out_len += len;
+
+    json_mbuf_test_chunks++;
+    if (len != JSON_MBUF_TEST_CHUNK) {
+        json_mbuf_test_short_chunks++;
+    }
+
+    os_mbuf_free_chain(om);
+    return 0;
+}
+
+/**
+ * Encodes an object large enough to span many chunks: scalar entries,
+ * strings that need escaping, and nested composite values.
+ */
+static void
+json_mbuf_test_encode(struct json_encoder *encoder)
+{
+    struct json_value *values[2];
+    struct json_value inner[2];
+    struct json_value value;
+    char *keys[2] = { "a", "b" };
+    char key[16];
+    int rc;
+    int i;
+
+    rc = json_encode_object_start(encoder);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < JSON_MBUF_TEST_ENTRIES; i++) {
+        sprintf(key, "key%d", i);
+        switch (i % 4) {
+        case 0:
+            JSON_VALUE_INT(&value, -1000 * i);
+            break;
+        case 1:
+            JSON_VALUE_STRING(&value, "line \"one\"\n\tline/two\\");
+            break;
+        case 2:
+            JSON_VALUE_BOOL(&value, i & 1);
+            break;
+        default:
+            JSON_VALUE_UINT(&inner[0], i);
+            JSON_VALUE_STRING(&inner[1], "x");
+            values[0] = &inner[0];
+            values[1] = &inner[1];
+            value.jv_type = JSON_VALUE_TYPE_OBJECT;
+            value.jv_len = 2;
+            value.jv_val.composite.keys = keys;
+            value.jv_val.composite.values = values;
+            break;
+        }
+        rc = json_encode_object_entry(encoder, key, &value);
+        TEST_ASSERT(rc == 0);
+    }
+
+    rc = json_encode_array_name(encoder, "arr");
+    TEST_ASSERT(rc == 0);
+    rc = json_encode_array_start(encoder);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 3; i++) {
+        JSON_VALUE_INT(&value, i);
+        rc = json_encode_array_value(encoder, &value);
+        TEST_ASSERT(rc == 0);
+    }
+    rc = json_encode_array_finish(encoder);
+    TEST_ASSERT(rc == 0);
+
+    rc = json_encode_object_finish(encoder);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE_SELF(test_json_mbuf_encode)
+{
+    struct json_mbuf_writer jmw;
+    struct json_encoder encoder;
+    struct json_value value;
+    struct os_mbuf *om;
+    char expected[sizeof json_mbuf_test_out];
+    char fill[JSON_MBUF_TEST_CHUNK + 10];
+    int expected_len;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&json_mbuf_test_mempool, JSON_MBUF_TEST_BUF_COUNT,
+                         JSON_MBUF_TEST_BUF_SIZE, json_mbuf_test_membuf,
+                         "json_mbuf_test");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&json_mbuf_test_pool, &json_mbuf_test_mempool,
+                           JSON_MBUF_TEST_BUF_SIZE, JSON_MBUF_TEST_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Reference output through a plain write callback. */
+    memset(&encoder, 0, sizeof encoder);
+    encoder.je_write = json_mbuf_test_write;
+    json_mbuf_test_out_len = 0;
+    json_mbuf_test_encode(&encoder);
+    expected_len = json_mbuf_test_out_len;
+    TEST_ASSERT_FATAL(expected_len < sizeof expected);
+    memcpy(expected, json_mbuf_test_out, expected_len);
+    expected[expected_len] = '\0';
+    TEST_ASSERT_FATAL(expected_len > 4 * JSON_MBUF_TEST_CHUNK);
+
+    /* Nested objects are comma-separated only between their own entries. */
+    TEST_ASSERT(strstr(expected, "\"key3\": {\"a\": 3,\"b\": \"x\"},") !=
+                NULL);
+    TEST_ASSERT(strstr(expected, "\"key1\": "
+                "\"line \\\"one\\\"\\n\\tline\\/two\\\\\",") != NULL);
+
+    /* An entry with a scalar value takes a single write. */
+    json_mbuf_test_writes = 0;
+    JSON_VALUE_INT(&value, 12345);
+    rc = json_encode_object_entry(&encoder, "single", &value);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(json_mbuf_test_writes == 1);
+
+    /*** Whole document in one chain. */
+    om = os_mbuf_get_pkthdr(&json_mbuf_test_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    json_mbuf_writer_init(&jmw, &encoder, om, 0, NULL, NULL);
+    json_mbuf_test_encode(&encoder);
+    rc = json_mbuf_writer_finish(&jmw);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT_FATAL(jmw.jmw_om == om);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == expected_len);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, expected, expected_len) == 0);
+    os_mbuf_free_chain(om);
+
+    /*** Chunked output; each chunk is freed as soon as it is complete. */
+    json_mbuf_test_out_len = 0;
+    json_mbuf_test_chunks = 0;
+    json_mbuf_test_short_chunks = 0;
+    om = os_mbuf_get_pkthdr(&json_mbuf_test_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    json_mbuf_writer_init(&jmw, &encoder, om, JSON_MBUF_TEST_CHUNK,
+                          json_mbuf_test_flush, NULL);
+    json_mbuf_test_encode(&encoder);
+    rc = json_mbuf_writer_finish(&jmw);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(jmw.jmw_om == NULL);
+    TEST_ASSERT(json_mbuf_test_out_len == expected_len);
+    TEST_ASSERT(memcmp(json_mbuf_test_out, expected, expected_len) == 0);
+    TEST_ASSERT(json_mbuf_test_chunks ==
+                (expected_len + JSON_MBUF_TEST_CHUNK - 1) /
+                JSON_MBUF_TEST_CHUNK);
+    TEST_ASSERT(json_mbuf_test_short_chunks ==
+                (expected_len % JSON_MBUF_TEST_CHUNK != 0));
+    TEST_ASSERT(json_mbuf_test_mempool.mp_num_free ==
+                JSON_MBUF_TEST_BUF_COUNT);
+
+    /*** A chain that already holds more than a chunk is flushed first. */
+    json_mbuf_test_out_len = 0;
+    json_mbuf_test_chunks = 0;
+    om = os_mbuf_get_pkthdr(&json_mbuf_test_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    memset(fill, 'x', sizeof fill);
+    rc = os_mbuf_append(om, fill, sizeof fill);
+    TEST_ASSERT_FATAL(rc == 0);
+    json_mbuf_writer_init(&jmw, &encoder, om, JSON_MBUF_TEST_CHUNK,
+                          json_mbuf_test_flush, NULL);
+    json_mbuf_test_encode(&encoder);
+    rc = json_mbuf_writer_finish(&jmw);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(json_mbuf_test_out_len == sizeof fill + expected_len);
+    TEST_ASSERT(memcmp(json_mbuf_test_out, fill, sizeof fill) == 0);
+    TEST_ASSERT(memcmp(json_mbuf_test_out + sizeof fill, expected,
+                       expected_len) == 0);
+    TEST_ASSERT(json_mbuf_test_chunks ==
+                1 + (expected_len + JSON_MBUF_TEST_CHUNK - 1) /
+                JSON_MBUF_TEST_CHUNK);
+    TEST_ASSERT(json_mbuf_test_mempool.mp_num_free ==
+                JSON_MBUF_TEST_BUF_COUNT);
+
+    /*** Running out of mbufs is reported once the document is finished. */
+    om = os_mbuf_get_pkthdr(&json_mbuf_test_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    json_mbuf_writer_init(&jmw, &encoder, om, 0, NULL, NULL);
+    for (i = 0; i < 10 && jmw.jmw_rc == 0; i++) {
+        json_mbuf_test_encode(&encoder);
+    }
+    rc = json_mbuf_writer_finish(&jmw);
+    TEST_ASSERT(rc == OS_ENOMEM);
+    os_mbuf_free_chain(jmw.jmw_om);
+    TEST_ASSERT(json_mbuf_test_mempool.mp_num_free ==
+                JSON_MBUF_TEST_BUF_COUNT);
+}
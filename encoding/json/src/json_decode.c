@@ -144,9 +144,205 @@ json_target_address(const struct json_attr_t *cursor,
     return targetaddr;
 }
 
+/* FNV-1a, computed over attribute names as they are read. */
+#define JSON_HASH_INIT          2166136261UL
+#define JSON_HASH_STEP(h, c)    (((h) ^ (uint8_t)(c)) * 16777619UL)
+
+static char
+json_flat_read_next(struct json_buffer *jb)
+{
+    struct json_flat_buffer *jfb = (struct json_flat_buffer *)jb;
+    char c;
+
+    /* The end of the buffer reads as a single '\0', like a C string. */
+    if (jfb->jfb_cur > jfb->jfb_end) {
+        return '\0';
+    }
+    c = jfb->jfb_cur < jfb->jfb_end ? *jfb->jfb_cur : '\0';
+    jfb->jfb_cur++;
+
+    return c;
+}
+
+static char
+json_flat_read_prev(struct json_buffer *jb)
+{
+    struct json_flat_buffer *jfb = (struct json_flat_buffer *)jb;
+
+    if (jfb->jfb_cur == jfb->jfb_start) {
+        return '\0';
+    }
+    jfb->jfb_cur--;
+
+    return jfb->jfb_cur < jfb->jfb_end ? *jfb->jfb_cur : '\0';
+}
+
+static int
+json_flat_readn(struct json_buffer *jb, char *buf, int n)
+{
+    struct json_flat_buffer *jfb = (struct json_flat_buffer *)jb;
+
+    if (jfb->jfb_cur >= jfb->jfb_end) {
+        return 0;
+    }
+    if (n > jfb->jfb_end - jfb->jfb_cur) {
+        n = jfb->jfb_end - jfb->jfb_cur;
+    }
+    memcpy(buf, jfb->jfb_cur, n);
+    jfb->jfb_cur += n;
+
+    return n;
+}
+
+void
+json_flat_buffer_init(struct json_flat_buffer *jfb, const char *str, int len)
+{
+    jfb->jfb_buf.jb_read_next = json_flat_read_next;
+    jfb->jfb_buf.jb_read_prev = json_flat_read_prev;
+    jfb->jfb_buf.jb_readn = json_flat_readn;
+    jfb->jfb_start = str;
+    jfb->jfb_end = str + len;
+    jfb->jfb_cur = str;
+}
+
+static struct json_flat_buffer *
+json_flat(struct json_buffer *jb)
+{
+    if (jb->jb_read_next == json_flat_read_next) {
+        return (struct json_flat_buffer *)jb;
+    }
+    return NULL;
+}
+
+static bool
+json_attr_name_eq(const char *attr, const char *key, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (attr[i] == '\0' || attr[i] != key[i]) {
+            return false;
+        }
+    }
+    return attr[i] == '\0';
+}
+
+/**
+ * Finds the first attribute with the specified name.
+ *
+ * @return                      The attribute; NULL if there is none.
+ */
+static const struct json_attr_t *
+json_attr_find(const struct json_attr_t *attrs,
+               const struct json_attr_index *idx,
+               const char *key, int len, uint32_t hash)
+{
+    const struct json_attr_t *cursor;
+    unsigned int i;
+
+    if (idx == NULL) {
+        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+            if (json_attr_name_eq(cursor->attribute, key, len)) {
+                return cursor;
+            }
+        }
+        return NULL;
+    }
+
+    for (i = hash & idx->jai_mask;
+         idx->jai_slots[i] != 0;
+         i = (i + 1) & idx->jai_mask) {
+
+        cursor = &attrs[idx->jai_slots[i] - 1];
+        if (json_attr_name_eq(cursor->attribute, key, len)) {
+            return cursor;
+        }
+    }
+    return NULL;
+}
+
+int
+json_attr_index_init(struct json_attr_index *idx,
+                     const struct json_attr_t *attrs,
+                     uint8_t *slots, int num_slots)
+{
+    const struct json_attr_t *cursor;
+    uint32_t hash;
+    unsigned int mask;
+    unsigned int i;
+    int used;
+    int len;
+    int n;
+
+    if (num_slots <= 0 || num_slots > UINT16_MAX + 1 ||
+        (num_slots & (num_slots - 1)) != 0) {
+        return JSON_ERR_INDEX;
+    }
+    mask = num_slots - 1;
+    memset(slots, 0, num_slots);
+
+    used = 0;
+    for (n = 0; attrs[n].attribute != NULL; n++) {
+        if (n >= UINT8_MAX) {
+            return JSON_ERR_INDEX;
+        }
+
+        len = strlen(attrs[n].attribute);
+        hash = JSON_HASH_INIT;
+        for (i = 0; i < len; i++) {
+            hash = JSON_HASH_STEP(hash, attrs[n].attribute[i]);
+        }
+
+        /* Only the first of several specs with the same name is indexed;
+         * the decoder steps through the rest itself.
+         */
+        for (i = hash & mask; slots[i] != 0; i = (i + 1) & mask) {
+            cursor = &attrs[slots[i] - 1];
+            if (strcmp(cursor->attribute, attrs[n].attribute) == 0) {
+                break;
+            }
+        }
+        if (slots[i] == 0) {
+            /* Keep one slot free so that lookups terminate. */
+            if (++used >= num_slots) {
+                return JSON_ERR_INDEX;
+            }
+            slots[i] = n + 1;
+        }
+    }
+
+    idx->jai_attrs = attrs;
+    idx->jai_slots = slots;
+    idx->jai_mask = mask;
+
+    return 0;
+}
+
+/**
+ * Returns the maximum length of a value for the specified attribute; for
+ * types without a limit of their own, the previous limit is kept.
+ */
+static int
+json_attr_maxlen(const struct json_attr_t *cursor, int maxlen)
+{
+    if (cursor->type == t_string) {
+        maxlen = (int)cursor->len - 1;
+    } else if (cursor->type == t_check) {
+        maxlen = (int)strlen(cursor->dflt.check);
+    } else if (cursor->type == t_ignore) {
+        maxlen = JSON_VAL_MAX;
+    } else if (cursor->map != NULL) {
+        maxlen = JSON_VAL_MAX;
+    } else if (cursor->type == t_boolean) {
+        maxlen = 5; /* false */
+    }
+    return maxlen;
+}
+
 static int
 json_internal_read_object(struct json_buffer *jb,
                           const struct json_attr_t *attrs,
+                          const struct json_attr_index *idx,
                           const struct json_array_t *parent,
                           int offset)
 {
@@ -164,6 +360,10 @@ json_internal_read_object(struct json_buffer *jb,
     unsigned int u;
     const struct json_enum_t *mp;
     char *lptr;
+    struct json_flat_buffer *jfb;
+    const char *p;
+    uint32_t hash = 0;
+    bool sliced = false;
 
 #ifdef S_SPLINT_S
     /* prevents gripes about buffers not being completely defined */
@@ -212,6 +412,8 @@ json_internal_read_object(struct json_buffer *jb,
         }
     }
 
+    jfb = json_flat(jb);
+
     /* parse input JSON */
     for (c = jb->jb_read_next(jb); c != '\0'; c = jb->jb_read_next(jb)) {
         switch (state) {
@@ -230,6 +432,37 @@ json_internal_read_object(struct json_buffer *jb,
             } else if (c == '"') {
                 state = in_attr;
                 pattr = attrbuf;
+                hash = JSON_HASH_INIT;
+                if (jfb == NULL) {
+                    break;
+                }
+
+                /* Contiguous input: match the name in place. */
+                for (p = jfb->jfb_cur; p < jfb->jfb_end && *p != '"'; p++) {
+                    hash = JSON_HASH_STEP(hash, *p);
+                }
+                if (p == jfb->jfb_end) {
+                    hash = JSON_HASH_INIT;
+                    break;
+                }
+                if (p - jfb->jfb_cur > JSON_ATTR_MAX - 1) {
+                    return JSON_ERR_ATTRLEN;
+                }
+                cursor = json_attr_find(attrs, idx, jfb->jfb_cur,
+                                        p - jfb->jfb_cur, hash);
+                if (cursor == NULL) {
+                    return JSON_ERR_BADATTR;
+                }
+                /* Skip the separator, which await_value would ignore. */
+                for (p++;
+                     p < jfb->jfb_end &&
+                     (isspace((unsigned char) *p) || *p == ':');
+                     p++) {
+                }
+                jfb->jfb_cur = p;
+                state = await_value;
+                maxlen = json_attr_maxlen(cursor, maxlen);
+                pval = valbuf;
             } else if (c == '}') {
                 break;
             } else {
@@ -242,34 +475,22 @@ json_internal_read_object(struct json_buffer *jb,
                 return JSON_ERR_NULLPTR;
             }
             if (c == '"') {
-                *pattr++ = '\0';
-                for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-                    if (strcmp(cursor->attribute, attrbuf) == 0) {
-                        break;
-                    }
-                }
-                if (cursor->attribute == NULL) {
+                *pattr = '\0';
+                cursor = json_attr_find(attrs, idx, attrbuf, pattr - attrbuf,
+                                        hash);
+                if (cursor == NULL) {
                     /* don't update end here, leave at attribute start */
                     return JSON_ERR_BADATTR;
                 }
                 state = await_value;
-                if (cursor->type == t_string) {
-                    maxlen = (int)cursor->len - 1;
-                } else if (cursor->type == t_check) {
-                    maxlen = (int)strlen(cursor->dflt.check);
-                } else if (cursor->type == t_ignore) {
-                    maxlen = JSON_VAL_MAX;
-                } else if (cursor->map != NULL) {
-                    maxlen = (int)sizeof(valbuf) - 1;
-                } else if (cursor->type == t_boolean) {
-                    maxlen = 5; /* false */
-                }
+                maxlen = json_attr_maxlen(cursor, maxlen);
                 pval = valbuf;
             } else if (pattr >= attrbuf + JSON_ATTR_MAX - 1) {
                 /* don't update end here, leave at attribute start */
                 return JSON_ERR_ATTRLEN;
             } else {
                 *pattr++ = c;
+                hash = JSON_HASH_STEP(hash, c);
             }
             break;
         case await_value:
@@ -289,13 +510,84 @@ json_internal_read_object(struct json_buffer *jb,
                 return JSON_ERR_NOBRAK;
             } else if (c == '"') {
                 value_quoted = true;
+                sliced = false;
                 state = in_val_string;
                 pval = valbuf;
+                if (jfb == NULL) {
+                    break;
+                }
+
+                /* Contiguous input: take everything up to the closing quote
+                 * or the first escape at once.
+                 */
+                for (p = jfb->jfb_cur;
+                     p < jfb->jfb_end && *p != '"' && *p != '\\';
+                     p++) {
+                }
+                if (p == jfb->jfb_end) {
+                    break;
+                }
+                n = p - jfb->jfb_cur;
+                if (n > JSON_VAL_MAX || n > maxlen + 1) {
+                    return JSON_ERR_STRLONG;
+                }
+                if (*p == '"' && cursor->type == t_string &&
+                    cursor->map == NULL &&
+                    (parent == NULL ||
+                     parent->element_type == t_structobject || offset == 0)) {
+
+                    /* A plain string goes straight to its destination. */
+                    if (n > maxlen) {
+                        return JSON_ERR_STRLONG;
+                    }
+                    lptr = json_target_address(cursor, parent, offset);
+                    if (lptr != NULL) {
+                        memcpy(lptr, jfb->jfb_cur, n);
+                        lptr[n] = '\0';
+                    }
+                    valbuf[0] = '\0';
+                    sliced = true;
+                    jfb->jfb_cur = p + 1;
+                    state = post_val;
+                    break;
+                }
+                memcpy(valbuf, jfb->jfb_cur, n);
+                pval = valbuf + n;
+                if (*p == '"') {
+                    *pval = '\0';
+                    jfb->jfb_cur = p + 1;
+                    state = post_val;
+                } else {
+                    /* Leave the escape to the character loop. */
+                    jfb->jfb_cur = p;
+                }
             } else {
                 value_quoted = false;
+                sliced = false;
                 state = in_val_token;
                 pval = valbuf;
                 *pval++ = c;
+                if (jfb == NULL) {
+                    break;
+                }
+
+                for (p = jfb->jfb_cur;
+                     p < jfb->jfb_end && !isspace((unsigned char) *p) &&
+                     *p != ',' && *p != '}';
+                     p++) {
+                }
+                if (p == jfb->jfb_end) {
+                    break;
+                }
+                n = p - jfb->jfb_cur;
+                if (n > JSON_VAL_MAX - 1) {
+                    return JSON_ERR_TOKLONG;
+                }
+                memcpy(pval, jfb->jfb_cur, n);
+                pval[n] = '\0';
+                /* A ',' or '}' is left for post_val to read. */
+                jfb->jfb_cur = isspace((unsigned char) *p) ? p + 1 : p;
+                state = post_val;
             }
             break;
         case in_val_string:
@@ -385,8 +677,9 @@ json_internal_read_object(struct json_buffer *jb,
                 if (value_quoted && (cursor->type == t_string)) {
                     break;
                 }
-                if ((strcmp(valbuf, "true")==0 || strcmp(valbuf, "false")==0)
-                        && seeking == t_boolean) {
+                if (seeking == t_boolean &&
+                    (strcmp(valbuf, "true") == 0 ||
+                     strcmp(valbuf, "false") == 0)) {
                     break;
                 }
                 if (isdigit((unsigned char) valbuf[0])) {
@@ -402,7 +695,7 @@ json_internal_read_object(struct json_buffer *jb,
                 if (cursor[1].attribute==NULL) {       /* out of possiblities */
                     break;
                 }
-                if (strcmp(cursor[1].attribute, attrbuf)!=0) {
+                if (strcmp(cursor[1].attribute, cursor->attribute)!=0) {
                     break;
                 }
                 ++cursor;
@@ -458,8 +751,10 @@ json_internal_read_object(struct json_buffer *jb,
                         && offset > 0) {
                         return JSON_ERR_NOPARSTR;
                     }
-                    (void)strncpy(lptr, valbuf, cursor->len);
-                    valbuf[sizeof(valbuf)-1] = '\0';
+                    if (!sliced) {
+                        (void)strncpy(lptr, valbuf, cursor->len);
+                        valbuf[sizeof(valbuf)-1] = '\0';
+                    }
                     break;
                 case t_boolean: {
                         bool tmp = (strcmp(valbuf, "true") == 0);
@@ -560,8 +855,8 @@ json_read_array(struct json_buffer *jb, const struct json_array_t *arr)
         case t_object:
         case t_structobject:
             substatus =
-                json_internal_read_object(jb, arr->arr.objects.subtype, arr,
-                                          offset);
+                json_internal_read_object(jb, arr->arr.objects.subtype, NULL,
+                                          arr, offset);
             if (substatus != 0) {
                 return substatus;
             }
@@ -660,7 +955,14 @@ json_read_object(struct json_buffer *jb, const struct json_attr_t *attrs)
 {
     int st;
 
-    st = json_internal_read_object(jb, attrs, NULL, 0);
+    st = json_internal_read_object(jb, attrs, NULL, NULL, 0);
     return st;
 }
 
+int
+json_read_object_indexed(struct json_buffer *jb,
+                         const struct json_attr_index *idx)
+{
+    return json_internal_read_object(jb, idx->jai_attrs, idx, NULL, 0);
+}
+
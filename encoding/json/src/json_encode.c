@@ -34,109 +34,186 @@
 #define JSON_ENCODE_ARRAY_END(__e) \
     (__e)->je_write((__e)->je_arg, "]", sizeof("]")-1);
 
+/*
+ * Output is staged in je_encode_buf and passed to je_write in as few calls
+ * as possible; an object entry with a scalar value is usually written in
+ * one call.  The staging buffer is always flushed before a public function
+ * returns, so nothing is carried between calls.
+ */
+#define JSON_ENCODE_BUF_SZ(__e)     ((int)sizeof((__e)->je_encode_buf))
+
+/* Room needed for a formatted 64-bit integer or boolean. */
+#define JSON_ENCODE_NUM_MAX         24
+
+static void
+json_encode_flush(struct json_encoder *encoder, int *off)
+{
+    if (*off > 0) {
+        encoder->je_write(encoder->je_arg, encoder->je_encode_buf, *off);
+        *off = 0;
+    }
+}
+
+static void
+json_encode_stage(struct json_encoder *encoder, int *off, const char *data,
+                  int len)
+{
+    int chunk;
+
+    while (len > 0) {
+        if (*off == JSON_ENCODE_BUF_SZ(encoder)) {
+            json_encode_flush(encoder, off);
+        }
+        chunk = JSON_ENCODE_BUF_SZ(encoder) - *off;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(encoder->je_encode_buf + *off, data, chunk);
+        *off += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/**
+ * Returns the character that follows the backslash when c is escaped; 0 if
+ * c is written as is.
+ */
+static char
+json_encode_esc_char(char c)
+{
+    switch (c) {
+    case '"':
+    case '/':
+    case '\\':
+        return c;
+    case '\t':
+        return 't';
+    case '\r':
+        return 'r';
+    case '\n':
+        return 'n';
+    case '\f':
+        return 'f';
+    case '\b':
+        return 'b';
+    default:
+        return 0;
+    }
+}
+
+static void
+json_encode_string(struct json_encoder *encoder, int *off, const char *str,
+                   int len)
+{
+    char *buf;
+    char esc;
+    int i;
+
+    buf = encoder->je_encode_buf;
+
+    json_encode_stage(encoder, off, "\"", 1);
+    for (i = 0; i < len; i++) {
+        /* Leave room for an escape sequence. */
+        if (*off > JSON_ENCODE_BUF_SZ(encoder) - 2) {
+            json_encode_flush(encoder, off);
+        }
+        esc = json_encode_esc_char(str[i]);
+        if (esc != 0) {
+            buf[(*off)++] = '\\';
+            buf[(*off)++] = esc;
+        } else {
+            buf[(*off)++] = str[i];
+        }
+    }
+    json_encode_stage(encoder, off, "\"", 1);
+}
+
+static void
+json_encode_key(struct json_encoder *encoder, int *off, const char *key)
+{
+    if (encoder->je_wr_commas) {
+        json_encode_stage(encoder, off, ",", sizeof(",")-1);
+        encoder->je_wr_commas = 0;
+    }
+
+    /* Write the key entry */
+    json_encode_stage(encoder, off, "\"", sizeof("\"")-1);
+    json_encode_stage(encoder, off, key, strlen(key));
+    json_encode_stage(encoder, off, "\": ", sizeof("\": ")-1);
+}
 
 int
 json_encode_object_start(struct json_encoder *encoder)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
+        encoder->je_write(encoder->je_arg, ",{", sizeof(",{")-1);
+    } else {
+        JSON_ENCODE_OBJECT_START(encoder);
     }
-    JSON_ENCODE_OBJECT_START(encoder);
     encoder->je_wr_commas = 0;
 
     return (0);
 }
 
 static int
-json_encode_value(struct json_encoder *encoder, struct json_value *jv)
+json_encode_value(struct json_encoder *encoder, int *off,
+                  struct json_value *jv)
 {
+    char *buf;
     int rc;
     int i;
-    int len;
+
+    buf = encoder->je_encode_buf;
 
     switch (jv->jv_type) {
         case JSON_VALUE_TYPE_BOOL:
-            len = sprintf(encoder->je_encode_buf, "%s",
-                    jv->jv_val.u > 0 ? "true" : "false");
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
-            break;
         case JSON_VALUE_TYPE_UINT64:
-            len = sprintf(encoder->je_encode_buf, "%llu",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
-            break;
         case JSON_VALUE_TYPE_INT64:
-            len = sprintf(encoder->je_encode_buf, "%lld",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if (*off > JSON_ENCODE_BUF_SZ(encoder) - JSON_ENCODE_NUM_MAX) {
+                json_encode_flush(encoder, off);
+            }
+            if (jv->jv_type == JSON_VALUE_TYPE_BOOL) {
+                *off += sprintf(buf + *off, "%s",
+                        jv->jv_val.u > 0 ? "true" : "false");
+            } else if (jv->jv_type == JSON_VALUE_TYPE_UINT64) {
+                *off += sprintf(buf + *off, "%llu",
+                        (unsigned long long) jv->jv_val.u);
+            } else {
+                *off += sprintf(buf + *off, "%lld",
+                        (long long) jv->jv_val.u);
+            }
             break;
         case JSON_VALUE_TYPE_STRING:
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-            for (i = 0; i < jv->jv_len; i++) {
-                switch (jv->jv_val.str[i]) {
-                    case '"':
-                    case '/':
-                    case '\\':
-                        encoder->je_write(encoder->je_arg, "\\",
-                                sizeof("\\")-1);
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-
-                        break;
-                    case '\t':
-                        encoder->je_write(encoder->je_arg, "\\t",
-                                sizeof("\\t")-1);
-                        break;
-                    case '\r':
-                        encoder->je_write(encoder->je_arg, "\\r",
-                                sizeof("\\r")-1);
-                        break;
-                    case '\n':
-                        encoder->je_write(encoder->je_arg, "\\n",
-                                sizeof("\\n")-1);
-                        break;
-                    case '\f':
-                        encoder->je_write(encoder->je_arg, "\\f",
-                                sizeof("\\f")-1);
-                        break;
-                    case '\b':
-                        encoder->je_write(encoder->je_arg, "\\b",
-                                sizeof("\\b")-1);
-                        break;
-                   default:
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-                        break;
-                }
-
-            }
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_encode_string(encoder, off, jv->jv_val.str, jv->jv_len);
             break;
         case JSON_VALUE_TYPE_ARRAY:
-            JSON_ENCODE_ARRAY_START(encoder);
+            json_encode_stage(encoder, off, "[", sizeof("[")-1);
             for (i = 0; i < jv->jv_len; i++) {
-                rc = json_encode_value(encoder, jv->jv_val.composite.values[i]);
+                rc = json_encode_value(encoder, off,
+                                       jv->jv_val.composite.values[i]);
                 if (rc != 0) {
                     goto err;
                 }
                 if (i != jv->jv_len - 1) {
-                    encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+                    json_encode_stage(encoder, off, ",", sizeof(",")-1);
                 }
             }
-            JSON_ENCODE_ARRAY_END(encoder);
+            json_encode_stage(encoder, off, "]", sizeof("]")-1);
             break;
         case JSON_VALUE_TYPE_OBJECT:
-            JSON_ENCODE_OBJECT_START(encoder);
+            json_encode_stage(encoder, off, "{", sizeof("{")-1);
+            encoder->je_wr_commas = 0;
             for (i = 0; i < jv->jv_len; i++) {
-                rc = json_encode_object_entry(encoder,
-                        jv->jv_val.composite.keys[i],
-                        jv->jv_val.composite.values[i]);
+                json_encode_key(encoder, off, jv->jv_val.composite.keys[i]);
+                rc = json_encode_value(encoder, off,
+                                       jv->jv_val.composite.values[i]);
                 if (rc != 0) {
                     goto err;
                 }
+                encoder->je_wr_commas = 1;
             }
-            JSON_ENCODE_OBJECT_END(encoder);
+            json_encode_stage(encoder, off, "}", sizeof("}")-1);
             break;
         default:
             rc = -1;
@@ -152,15 +229,11 @@ err:
 int
 json_encode_object_key(struct json_encoder *encoder, char *key)
 {
-    if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
-    }
+    int off;
 
-    /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    off = 0;
+    json_encode_key(encoder, &off, key);
+    json_encode_flush(encoder, &off);
 
     return (0);
 }
@@ -169,18 +242,13 @@ int
 json_encode_object_entry(struct json_encoder *encoder, char *key,
         struct json_value *val)
 {
+    int off;
     int rc;
 
-    if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
-        encoder->je_wr_commas = 0;
-    }
-    /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
-
-    rc = json_encode_value(encoder, val);
+    off = 0;
+    json_encode_key(encoder, &off, key);
+    rc = json_encode_value(encoder, &off, val);
+    json_encode_flush(encoder, &off);
     if (rc != 0) {
         goto err;
     }
@@ -219,14 +287,17 @@ json_encode_array_start(struct json_encoder *encoder)
 int
 json_encode_array_value(struct json_encoder *encoder, struct json_value *jv)
 {
+    int off;
     int rc;
 
+    off = 0;
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_stage(encoder, &off, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
 
-    rc = json_encode_value(encoder, jv);
+    rc = json_encode_value(encoder, &off, jv);
+    json_encode_flush(encoder, &off);
     if (rc != 0) {
         goto err;
     }
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "json/json.h"
+
+void
+json_mbuf_writer_init(struct json_mbuf_writer *jmw,
+                      struct json_encoder *encoder, struct os_mbuf *om,
+                      uint16_t chunk_sz, json_mbuf_flush_func_t flush,
+                      void *flush_arg)
+{
+    struct os_mbuf *last;
+
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
+    jmw->jmw_om = om;
+    jmw->jmw_last = last;
+    jmw->jmw_flush = flush;
+    jmw->jmw_flush_arg = flush_arg;
+    jmw->jmw_chunk_sz = chunk_sz;
+    jmw->jmw_rc = 0;
+
+    encoder->je_write = json_mbuf_write;
+    encoder->je_arg = jmw;
+    encoder->je_wr_commas = 0;
+}
+
+/**
+ * Hands the current chain to the flush callback and starts a new one from
+ * the same pool, with the same user header length.
+ */
+static int
+json_mbuf_writer_next(struct json_mbuf_writer *jmw)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = os_mbuf_get_pkthdr(jmw->jmw_om->om_omp,
+                            OS_MBUF_USRHDR_LEN(jmw->jmw_om));
+    if (om == NULL) {
+        return OS_ENOMEM;
+    }
+
+    rc = jmw->jmw_flush(jmw->jmw_flush_arg, jmw->jmw_om);
+    jmw->jmw_om = om;
+    jmw->jmw_last = om;
+
+    return rc;
+}
+
+int
+json_mbuf_write(void *arg, char *data, int len)
+{
+    struct json_mbuf_writer *jmw;
+    struct os_mbuf *om;
+    int chunk;
+    int space;
+
+    jmw = arg;
+    if (jmw->jmw_rc != 0) {
+        return jmw->jmw_rc;
+    }
+
+    /* The chain given to json_mbuf_writer_init() may already be full. */
+    if (jmw->jmw_flush != NULL && jmw->jmw_chunk_sz != 0 &&
+        OS_MBUF_PKTLEN(jmw->jmw_om) >= jmw->jmw_chunk_sz) {
+
+        jmw->jmw_rc = json_mbuf_writer_next(jmw);
+        if (jmw->jmw_rc != 0) {
+            return jmw->jmw_rc;
+        }
+    }
+
+    while (len > 0) {
+        /* Fill the last mbuf directly rather than through os_mbuf_append(),
+         * which walks the whole chain on every call.
+         */
+        space = OS_MBUF_TRAILINGSPACE(jmw->jmw_last);
+        if (space == 0) {
+            om = os_mbuf_get(jmw->jmw_om->om_omp, 0);
+            if (om == NULL) {
+                jmw->jmw_rc = OS_ENOMEM;
+                break;
+            }
+            SLIST_NEXT(jmw->jmw_last, om_next) = om;
+            jmw->jmw_last = om;
+            continue;
+        }
+
+        chunk = len;
+        if (chunk > space) {
+            chunk = space;
+        }
+        if (jmw->jmw_flush != NULL && jmw->jmw_chunk_sz != 0 &&
+            chunk > jmw->jmw_chunk_sz - OS_MBUF_PKTLEN(jmw->jmw_om)) {
+
+            chunk = jmw->jmw_chunk_sz - OS_MBUF_PKTLEN(jmw->jmw_om);
+        }
+
+        om = jmw->jmw_last;
+        memcpy(om->om_data + om->om_len, data, chunk);
+        om->om_len += chunk;
+        OS_MBUF_PKTLEN(jmw->jmw_om) += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (jmw->jmw_flush != NULL && jmw->jmw_chunk_sz != 0 &&
+            OS_MBUF_PKTLEN(jmw->jmw_om) >= jmw->jmw_chunk_sz) {
+
+            jmw->jmw_rc = json_mbuf_writer_next(jmw);
+            if (jmw->jmw_rc != 0) {
+                break;
+            }
+        }
+    }
+
+    return jmw->jmw_rc;
+}
+
+int
+json_mbuf_writer_finish(struct json_mbuf_writer *jmw)
+{
+    int rc;
+
+    if (jmw->jmw_rc != 0) {
+        return jmw->jmw_rc;
+    }
+
+    if (jmw->jmw_flush != NULL && OS_MBUF_PKTLEN(jmw->jmw_om) > 0) {
+        rc = jmw->jmw_flush(jmw->jmw_flush_arg, jmw->jmw_om);
+        jmw->jmw_om = NULL;
+        jmw->jmw_last = NULL;
+        jmw->jmw_rc = rc;
+    }
+
+    return jmw->jmw_rc;
+}
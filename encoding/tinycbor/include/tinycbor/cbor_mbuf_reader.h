@@ -27,10 +27,18 @@
 extern "C" {
 #endif
 
+/*
+ * Reads CBOR from an mbuf chain.  The reader remembers the mbuf which held
+ * the last data accessed, so that sequential parsing does not walk the chain
+ * from the head on every access.  The chain must not be modified while it
+ * is being parsed.
+ */
 struct cbor_mbuf_reader {
     struct cbor_decoder_reader r;
     int init_off;                     /* initial offset into the data */
     struct os_mbuf *m;
+    struct os_mbuf *cur;              /* mbuf of the last access */
+    int cur_off;                      /* offset of cur within the chain */
 };
 
 void cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
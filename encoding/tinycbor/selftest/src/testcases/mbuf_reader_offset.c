@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "tinycbor_test_priv.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+
+/*
+ * Exercises a reader with a nonzero initial offset (as for a packet with a
+ * protocol header in front of the CBOR data), including out-of-order and
+ * out-of-range accesses.
+ */
+TEST_CASE_SELF(mbuf_reader_offset)
+{
+    struct cbor_mbuf_reader mreader;
+    struct cbor_buf_reader breader;
+    struct cbor_decoder_reader *m;
+    struct cbor_decoder_reader *b;
+    struct os_mbuf *om;
+    uint32_t expected;
+    uint32_t sum;
+    char buf[64];
+    int len;
+    int off;
+    int rc;
+
+    len = tinycbor_test_payload_len;
+
+    cbor_buf_reader_init(&breader, tinycbor_test_payload, len);
+    rc = tinycbor_test_walk(&breader.r, &expected);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = tinycbor_test_chain(tinycbor_test_payload, len,
+                             TINYCBOR_TEST_CHUNK_SZ, 8);
+    cbor_mbuf_reader_init(&mreader, om, 8);
+    TEST_ASSERT(mreader.r.message_size == len);
+
+    rc = tinycbor_test_walk(&mreader.r, &sum);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(sum == expected);
+
+    /* Random access, backwards and forwards, across mbuf boundaries. */
+    m = &mreader.r;
+    b = &breader.r;
+    for (off = len - 8; off >= 0; off -= 13) {
+        TEST_ASSERT(m->get8(m, off) == b->get8(b, off));
+        TEST_ASSERT(m->get16(m, off) == b->get16(b, off));
+        TEST_ASSERT(m->get32(m, off) == b->get32(b, off));
+        TEST_ASSERT(m->get64(m, off) == b->get64(b, off));
+        TEST_ASSERT(m->get32(m, len - 4 - off) == b->get32(b, len - 4 - off));
+    }
+
+    TEST_ASSERT(m->cpy(m, buf, 5, sizeof buf));
+    TEST_ASSERT(memcmp(buf, tinycbor_test_payload + 5, sizeof buf) == 0);
+    TEST_ASSERT(m->cmp(m, buf, 5, sizeof buf));
+    buf[sizeof buf - 1]++;
+    TEST_ASSERT(!m->cmp(m, buf, 5, sizeof buf));
+
+    /* Reads past the end of the chain fail. */
+    TEST_ASSERT(!m->cpy(m, buf, len - 4, 8));
+    TEST_ASSERT(!m->cmp(m, buf, len, 1));
+
+    /* The cursor is still usable after a failed read. */
+    TEST_ASSERT(m->get8(m, 0) == tinycbor_test_payload[0]);
+    TEST_ASSERT(m->get8(m, len - 1) == tinycbor_test_payload[len - 1]);
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "tinycbor_test_priv.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+
+/*
+ * Parses the payload from chains of various mbuf sizes and ensures the result
+ * matches parsing the flat buffer.
+ */
+TEST_CASE_SELF(mbuf_reader_parse)
+{
+    static const int chunks[] = { 1, 3, 7, 8, TINYCBOR_TEST_CHUNK_SZ, 31 };
+    struct cbor_mbuf_reader mreader;
+    struct cbor_buf_reader breader;
+    struct os_mbuf *om;
+    uint32_t expected;
+    uint32_t sum;
+    int rc;
+    int i;
+
+    cbor_buf_reader_init(&breader, tinycbor_test_payload,
+                         tinycbor_test_payload_len);
+    rc = tinycbor_test_walk(&breader.r, &expected);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof chunks / sizeof chunks[0]; i++) {
+        om = tinycbor_test_chain(tinycbor_test_payload,
+                                 tinycbor_test_payload_len, chunks[i], 0);
+        cbor_mbuf_reader_init(&mreader, om, 0);
+        TEST_ASSERT(mreader.r.message_size == tinycbor_test_payload_len);
+
+        rc = tinycbor_test_walk(&mreader.r, &sum);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(sum == expected);
+
+        /* Parsing again with the same reader rewinds the cursor. */
+        rc = tinycbor_test_walk(&mreader.r, &sum);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(sum == expected);
+
+        os_mbuf_free_chain(om);
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "tinycbor_test_priv.h"
+#include "tinycbor/cbor_mbuf_reader.h"
+#include "tinycbor/compilersupport_p.h"
+
+#define MBUF_READER_PERF_ITERS      200
+
+/*
+ * Reference reader which locates every access from the head of the chain, as
+ * cbor_mbuf_reader did before it kept a cursor.
+ */
+static uint8_t
+naive_get8(struct cbor_decoder_reader *d, int offset)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+    uint8_t val;
+
+    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    return val;
+}
+
+static uint16_t
+naive_get16(struct cbor_decoder_reader *d, int offset)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+    uint16_t val;
+
+    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    return cbor_ntohs(val);
+}
+
+static uint32_t
+naive_get32(struct cbor_decoder_reader *d, int offset)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+    uint32_t val;
+
+    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    return cbor_ntohl(val);
+}
+
+static uint64_t
+naive_get64(struct cbor_decoder_reader *d, int offset)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+    uint64_t val;
+
+    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    return cbor_ntohll(val);
+}
+
+static uintptr_t
+naive_cmp(struct cbor_decoder_reader *d, char *buf, int offset, size_t len)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+
+    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len) == 0;
+}
+
+static uintptr_t
+naive_cpy(struct cbor_decoder_reader *d, char *dst, int offset, size_t len)
+{
+    struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *)d;
+
+    return os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst) == 0;
+}
+
+static uint32_t
+mbuf_reader_perf_run(struct cbor_mbuf_reader *reader, uint32_t expected)
+{
+    uint32_t sum;
+    int64_t start;
+    int rc;
+    int i;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < MBUF_READER_PERF_ITERS; i++) {
+        rc = tinycbor_test_walk(&reader->r, &sum);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(sum == expected);
+    }
+
+    return os_get_uptime_usec() - start;
+}
+
+/*
+ * Parses a ~2 KB payload split into 20-byte mbufs with the cursor-based
+ * reader and with the naive one, and reports the time taken by each.
+ */
+TEST_CASE_SELF(mbuf_reader_perf)
+{
+    struct cbor_mbuf_reader reader;
+    struct cbor_mbuf_reader naive;
+    struct os_mbuf *om;
+    uint32_t expected;
+    uint32_t cursor_us;
+    uint32_t naive_us;
+    int rc;
+
+    om = tinycbor_test_chain(tinycbor_test_payload, tinycbor_test_payload_len,
+                             TINYCBOR_TEST_CHUNK_SZ, 0);
+
+    cbor_mbuf_reader_init(&reader, om, 0);
+    rc = tinycbor_test_walk(&reader.r, &expected);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    naive = reader;
+    naive.r.get8 = naive_get8;
+    naive.r.get16 = naive_get16;
+    naive.r.get32 = naive_get32;
+    naive.r.get64 = naive_get64;
+    naive.r.cmp = naive_cmp;
+    naive.r.cpy = naive_cpy;
+
+    naive_us = mbuf_reader_perf_run(&naive, expected);
+    cursor_us = mbuf_reader_perf_run(&reader, expected);
+
+    os_mbuf_free_chain(om);
+
+    TEST_PASS("%d-byte payload in %d-byte mbufs, %d parses: "
+              "naive=%lu us cursor=%lu us",
+              tinycbor_test_payload_len, TINYCBOR_TEST_CHUNK_SZ,
+              MBUF_READER_PERF_ITERS,
+              (unsigned long)naive_us, (unsigned long)cursor_us);
+}
@@ -0,0 +1,265 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "tinycbor_test_priv.h"
+#include "tinycbor/cbor_buf_writer.h"
+
+#define TINYCBOR_TEST_POOL_BUF_SIZE     \
+    (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + 32)
+/* Enough for a chain of single-byte mbufs. */
+#define TINYCBOR_TEST_POOL_BUF_COUNT    (TINYCBOR_TEST_PAYLOAD_MAX + 16)
+
+static os_membuf_t tinycbor_test_membuf[
+    OS_MEMPOOL_SIZE(TINYCBOR_TEST_POOL_BUF_COUNT, TINYCBOR_TEST_POOL_BUF_SIZE)];
+static struct os_mempool tinycbor_test_mempool;
+static struct os_mbuf_pool tinycbor_test_mbuf_pool;
+
+uint8_t tinycbor_test_payload[TINYCBOR_TEST_PAYLOAD_MAX];
+int tinycbor_test_payload_len;
+
+/*
+ * Encodes a payload resembling a batch of sensor readings: a map of records,
+ * each holding integers of various widths, text and byte strings, and an
+ * array.
+ */
+static void
+tinycbor_test_payload_fill(void)
+{
+    struct cbor_buf_writer writer;
+    CborEncoder enc;
+    CborEncoder map;
+    CborEncoder rec;
+    CborEncoder arr;
+    uint8_t raw[8];
+    char key[16];
+    int rc;
+    int i;
+    int j;
+
+    cbor_buf_writer_init(&writer, tinycbor_test_payload,
+                         sizeof tinycbor_test_payload);
+    cbor_encoder_init(&enc, &writer.enc, 0);
+
+    rc = cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 24; i++) {
+        sprintf(key, "sensor%d", i);
+        rc = cbor_encode_text_stringz(&map, key);
+        rc |= cbor_encoder_create_map(&map, &rec, 5);
+        rc |= cbor_encode_text_stringz(&rec, "id");
+        rc |= cbor_encode_uint(&rec, i);
+        rc |= cbor_encode_text_stringz(&rec, "ts");
+        rc |= cbor_encode_uint(&rec, 0x100000000ULL * (i + 1) + i);
+        rc |= cbor_encode_text_stringz(&rec, "name");
+        rc |= cbor_encode_text_stringz(&rec, "temperature-probe");
+        rc |= cbor_encode_text_stringz(&rec, "raw");
+        for (j = 0; j < sizeof raw; j++) {
+            raw[j] = i + j;
+        }
+        rc |= cbor_encode_byte_string(&rec, raw, sizeof raw);
+        rc |= cbor_encode_text_stringz(&rec, "vals");
+        rc |= cbor_encoder_create_array(&rec, &arr, 4);
+        rc |= cbor_encode_int(&arr, -i);
+        rc |= cbor_encode_int(&arr, i * 100);
+        rc |= cbor_encode_int(&arr, i * 100000);
+        rc |= cbor_encode_int(&arr, -i * 1000000);
+        rc |= cbor_encoder_close_container(&rec, &arr);
+        rc |= cbor_encoder_close_container(&map, &rec);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = cbor_encoder_close_container(&enc, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    tinycbor_test_payload_len =
+        cbor_buf_writer_buffer_size(&writer, tinycbor_test_payload);
+}
+
+void
+tinycbor_test_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&tinycbor_test_mempool, TINYCBOR_TEST_POOL_BUF_COUNT,
+                         TINYCBOR_TEST_POOL_BUF_SIZE, tinycbor_test_membuf,
+                         "tinycbor_test");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(&tinycbor_test_mbuf_pool, &tinycbor_test_mempool,
+                           TINYCBOR_TEST_POOL_BUF_SIZE,
+                           TINYCBOR_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    tinycbor_test_payload_fill();
+}
+
+/**
+ * Builds a packet holding the specified data, split into mbufs of chunk bytes
+ * each.  The packet is preceded by lead bytes of filler.
+ */
+struct os_mbuf *
+tinycbor_test_chain(const uint8_t *data, int len, int chunk, int lead)
+{
+    struct os_mbuf *prev;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int off;
+    int n;
+
+    om = os_mbuf_get_pkthdr(&tinycbor_test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    prev = NULL;
+    off = -lead;
+    while (off < len) {
+        if (prev == NULL) {
+            m = om;
+        } else {
+            m = os_mbuf_get(&tinycbor_test_mbuf_pool, 0);
+            TEST_ASSERT_FATAL(m != NULL);
+            SLIST_NEXT(prev, om_next) = m;
+        }
+
+        n = min(chunk, len - off);
+        TEST_ASSERT_FATAL(n <= OS_MBUF_TRAILINGSPACE(m));
+        if (off < 0) {
+            n = min(n, -off);
+            memset(m->om_data, 0xa5, n);
+        } else {
+            memcpy(m->om_data, data + off, n);
+        }
+        m->om_len = n;
+        OS_MBUF_PKTHDR(om)->omp_len += n;
+
+        off += n;
+        prev = m;
+    }
+
+    return om;
+}
+
+static CborError
+tinycbor_test_walk_value(CborValue *it, uint32_t *sum)
+{
+    CborValue sub;
+    uint64_t u64;
+    int64_t i64;
+    uint8_t buf[32];
+    size_t len;
+    bool match;
+    CborError err;
+    int i;
+
+    while (!cbor_value_at_end(it)) {
+        switch (cbor_value_get_type(it)) {
+        case CborIntegerType:
+            if (cbor_value_is_unsigned_integer(it)) {
+                err = cbor_value_get_uint64(it, &u64);
+                *sum += u64 + (u64 >> 32);
+            } else {
+                err = cbor_value_get_int64(it, &i64);
+                *sum += i64;
+            }
+            if (err == 0) {
+                err = cbor_value_advance_fixed(it);
+            }
+            break;
+
+        case CborTextStringType:
+            err = cbor_value_text_string_equals(it, "name", &match);
+            if (err != 0) {
+                return err;
+            }
+            *sum += match;
+            /* Fall through. */
+        case CborByteStringType:
+            len = sizeof buf;
+            if (cbor_value_is_text_string(it)) {
+                err = cbor_value_copy_text_string(it, (char *)buf, &len, it);
+            } else {
+                err = cbor_value_copy_byte_string(it, buf, &len, it);
+            }
+            for (i = 0; i < len; i++) {
+                *sum = *sum * 31 + buf[i];
+            }
+            break;
+
+        case CborArrayType:
+        case CborMapType:
+            err = cbor_value_enter_container(it, &sub);
+            if (err == 0) {
+                err = tinycbor_test_walk_value(&sub, sum);
+            }
+            if (err == 0) {
+                err = cbor_value_leave_container(it, &sub);
+            }
+            break;
+
+        default:
+            err = cbor_value_advance(it);
+            break;
+        }
+
+        if (err != 0) {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a complete CBOR item, touching every value, and returns a checksum
+ * of the contents.
+ */
+CborError
+tinycbor_test_walk(struct cbor_decoder_reader *reader, uint32_t *out_sum)
+{
+    CborParser parser;
+    CborValue root;
+    CborError err;
+
+    *out_sum = 0;
+
+    err = cbor_parser_init(reader, 0, &parser, &root);
+    if (err != 0) {
+        return err;
+    }
+
+    return tinycbor_test_walk_value(&root, out_sum);
+}
+
+TEST_SUITE(tinycbor_test_suite)
+{
+    tinycbor_test_init();
+
+    mbuf_reader_parse();
+    mbuf_reader_offset();
+    mbuf_reader_perf();
+}
+
+int
+main(int argc, char **argv)
+{
+    tinycbor_test_suite();
+    return tu_any_failed;
+}
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_TINYCBOR_TEST_PRIV_
+#define H_TINYCBOR_TEST_PRIV_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "tinycbor/cbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of each mbuf in the chains built by the tests. */
+#define TINYCBOR_TEST_CHUNK_SZ      20
+
+#define TINYCBOR_TEST_PAYLOAD_MAX   2048
+
+extern uint8_t tinycbor_test_payload[TINYCBOR_TEST_PAYLOAD_MAX];
+extern int tinycbor_test_payload_len;
+
+void tinycbor_test_init(void);
+struct os_mbuf *tinycbor_test_chain(const uint8_t *data, int len, int chunk,
+                                    int lead);
+CborError tinycbor_test_walk(struct cbor_decoder_reader *reader,
+                             uint32_t *out_sum);
+
+TEST_CASE_DECL(mbuf_reader_parse);
+TEST_CASE_DECL(mbuf_reader_offset);
+TEST_CASE_DECL(mbuf_reader_perf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
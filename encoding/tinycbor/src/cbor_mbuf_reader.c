@@ -17,47 +17,170 @@
  * under the License.
  */
 
+#include <string.h>
 #include "os/mynewt.h"
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 
+/*
+ * Finds the mbuf holding the byte at offset off within the chain.  On
+ * return, *off is the offset of that byte within the mbuf.  Sequential
+ * accesses resume from the mbuf found last time; only seeking backwards
+ * restarts from the head of the chain.
+ */
+static struct os_mbuf *
+cbor_mbuf_reader_seek(struct cbor_mbuf_reader *cb, int *off)
+{
+    struct os_mbuf *om;
+    int abs_off;
+    int base;
+
+    abs_off = *off + cb->init_off;
+    om = cb->cur;
+    base = cb->cur_off;
+    if (abs_off < base) {
+        om = cb->m;
+        base = 0;
+    }
+
+    while (om != NULL && abs_off >= base + om->om_len) {
+        base += om->om_len;
+        om = SLIST_NEXT(om, om_next);
+    }
+    if (om == NULL) {
+        return NULL;
+    }
+
+    cb->cur = om;
+    cb->cur_off = base;
+    *off = abs_off - base;
+    return om;
+}
+
+/*
+ * Copies or compares len bytes at offset off.  If dst is NULL, the data is
+ * compared against cmp instead.
+ *
+ * @return                      0 on success / match; nonzero on mismatch or
+ *                                  if the chain is too short.
+ */
+static int
+cbor_mbuf_reader_access(struct cbor_mbuf_reader *cb, int off, void *dst,
+                        const void *cmp, size_t len)
+{
+    struct os_mbuf *om;
+    uint8_t *u8dst;
+    const uint8_t *u8cmp;
+    size_t chunk;
+
+    om = cbor_mbuf_reader_seek(cb, &off);
+    if (om == NULL) {
+        return len != 0;
+    }
+
+    u8dst = dst;
+    u8cmp = cmp;
+    while (len > 0) {
+        if (om == NULL) {
+            return -1;
+        }
+        chunk = om->om_len - off;
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (u8dst != NULL) {
+            memcpy(u8dst, om->om_data + off, chunk);
+            u8dst += chunk;
+        } else {
+            if (memcmp(u8cmp, om->om_data + off, chunk) != 0) {
+                return 1;
+            }
+            u8cmp += chunk;
+        }
+        len -= chunk;
+        off = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return 0;
+}
+
+/*
+ * Returns a pointer to len contiguous bytes at offset off, or NULL if the
+ * data spans mbufs.
+ */
+static inline const uint8_t *
+cbor_mbuf_reader_ptr(struct cbor_mbuf_reader *cb, int off, int len)
+{
+    struct os_mbuf *om;
+
+    om = cbor_mbuf_reader_seek(cb, &off);
+    if (om == NULL || off + len > om->om_len) {
+        return NULL;
+    }
+    return om->om_data + off;
+}
+
 static uint8_t
 cbor_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
+    const uint8_t *p;
     uint8_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    p = cbor_mbuf_reader_ptr(cb, offset, sizeof(val));
+    if (p != NULL) {
+        return *p;
+    }
+    cbor_mbuf_reader_access(cb, offset, &val, NULL, sizeof(val));
     return val;
 }
 
 static uint16_t
 cbor_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset)
 {
+    const uint8_t *p;
     uint16_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    p = cbor_mbuf_reader_ptr(cb, offset, sizeof(val));
+    if (p != NULL) {
+        memcpy(&val, p, sizeof(val));
+    } else {
+        cbor_mbuf_reader_access(cb, offset, &val, NULL, sizeof(val));
+    }
     return cbor_ntohs(val);
 }
 
 static uint32_t
 cbor_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset)
 {
+    const uint8_t *p;
     uint32_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    p = cbor_mbuf_reader_ptr(cb, offset, sizeof(val));
+    if (p != NULL) {
+        memcpy(&val, p, sizeof(val));
+    } else {
+        cbor_mbuf_reader_access(cb, offset, &val, NULL, sizeof(val));
+    }
     return cbor_ntohl(val);
 }
 
 static uint64_t
 cbor_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset)
 {
+    const uint8_t *p;
     uint64_t val;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    p = cbor_mbuf_reader_ptr(cb, offset, sizeof(val));
+    if (p != NULL) {
+        memcpy(&val, p, sizeof(val));
+    } else {
+        cbor_mbuf_reader_access(cb, offset, &val, NULL, sizeof(val));
+    }
     return cbor_ntohll(val);
 }
 
@@ -66,21 +189,17 @@ cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
                      size_t len)
 {
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len) == 0;
+
+    return cbor_mbuf_reader_access(cb, offset, NULL, buf, len) == 0;
 }
 
 static uintptr_t
 cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
                      size_t len)
 {
-    int rc;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
-    if (rc == 0) {
-        return true;
-    }
-    return false;
+    return cbor_mbuf_reader_access(cb, offset, dst, NULL, len) == 0;
 }
 
 void
@@ -100,5 +219,7 @@ cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
     cb->init_off = initial_offset;
+    cb->cur = m;
+    cb->cur_off = 0;
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fatfs_test.h"
+
+/*
+ * A RAM-backed stand-in for an SD card, formatted as a 2 MB FAT12 volume with
+ * 4 kB clusters.
+ */
+static uint8_t
+fatfs_test_disk[FATFS_TEST_NUM_SECTORS * FATFS_TEST_SECTOR_SZ];
+
+struct fatfs_test_disk_stats fatfs_test_disk_stats;
+
+static int
+fatfs_test_disk_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    if (addr + len > sizeof fatfs_test_disk) {
+        return -1;
+    }
+
+    memcpy(buf, fatfs_test_disk + addr, len);
+    fatfs_test_disk_stats.reads++;
+    fatfs_test_disk_stats.read_bytes += len;
+    return 0;
+}
+
+static int
+fatfs_test_disk_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    if (addr + len > sizeof fatfs_test_disk) {
+        return -1;
+    }
+
+    memcpy(fatfs_test_disk + addr, buf, len);
+    fatfs_test_disk_stats.writes++;
+    fatfs_test_disk_stats.write_bytes += len;
+    return 0;
+}
+
+static int
+fatfs_test_disk_ioctl(uint8_t id, uint32_t cmd, void *arg)
+{
+    return 0;
+}
+
+static struct disk_ops fatfs_test_disk_ops = {
+    .read  = fatfs_test_disk_read,
+    .write = fatfs_test_disk_write,
+    .ioctl = fatfs_test_disk_ioctl,
+};
+
+static void
+fatfs_test_put16(uint8_t *dst, uint16_t val)
+{
+    dst[0] = val;
+    dst[1] = val >> 8;
+}
+
+/**
+ * Writes an empty FAT12 volume: boot sector, two 2-sector FATs and a
+ * 512-entry root directory, followed by 507 8-sector clusters.
+ */
+static void
+fatfs_test_format(void)
+{
+    uint8_t *bs;
+    uint8_t *fat;
+    int i;
+
+    memset(fatfs_test_disk, 0, sizeof fatfs_test_disk);
+
+    bs = fatfs_test_disk;
+    bs[0] = 0xeb;
+    bs[1] = 0x3c;
+    bs[2] = 0x90;
+    memcpy(bs + 3, "MSWIN4.1", 8);
+    fatfs_test_put16(bs + 11, FATFS_TEST_SECTOR_SZ);    /* BytsPerSec */
+    bs[13] = 8;                                         /* SecPerClus */
+    fatfs_test_put16(bs + 14, 1);                       /* RsvdSecCnt */
+    bs[16] = 2;                                         /* NumFATs */
+    fatfs_test_put16(bs + 17, 512);                     /* RootEntCnt */
+    fatfs_test_put16(bs + 19, FATFS_TEST_NUM_SECTORS);  /* TotSec16 */
+    bs[21] = 0xf8;                                      /* Media */
+    fatfs_test_put16(bs + 22, 2);                       /* FATSz16 */
+    fatfs_test_put16(bs + 24, 32);                      /* SecPerTrk */
+    fatfs_test_put16(bs + 26, 2);                       /* NumHeads */
+    bs[36] = 0x80;                                      /* DrvNum */
+    bs[38] = 0x29;                                      /* BootSig */
+    memcpy(bs + 43, "NO NAME    ", 11);
+    memcpy(bs + 54, "FAT12   ", 8);
+    bs[510] = 0x55;
+    bs[511] = 0xaa;
+
+    for (i = 0; i < 2; i++) {
+        fat = fatfs_test_disk + (1 + i * 2) * FATFS_TEST_SECTOR_SZ;
+        fat[0] = 0xf8;
+        fat[1] = 0xff;
+        fat[2] = 0xff;
+    }
+}
+
+void
+fatfs_test_disk_stats_clear(void)
+{
+    memset(&fatfs_test_disk_stats, 0, sizeof fatfs_test_disk_stats);
+}
+
+uint8_t
+fatfs_test_pattern(uint32_t off)
+{
+    return off ^ (off >> 8) ^ (off >> 16);
+}
+
+TEST_CASE_DECL(fatfs_test_throughput)
+TEST_CASE_DECL(fatfs_test_sector_cache)
+
+TEST_SUITE(fatfs_test_all)
+{
+    fatfs_test_throughput();
+    fatfs_test_sector_cache();
+}
+
+int
+main(int argc, char **argv)
+{
+    int rc;
+
+    /* The volume is mounted on first use and stays mounted, so it is only
+     * formatted once.
+     */
+    fatfs_test_format();
+    rc = disk_register(FATFS_TEST_DISK, "fatfs", &fatfs_test_disk_ops);
+    assert(rc == 0);
+
+    fatfs_test_all();
+    return tu_any_failed;
+}
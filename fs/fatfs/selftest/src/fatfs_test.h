@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _FATFS_TEST_H
+#define _FATFS_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#include "disk/disk.h"
+#include "fs/fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FATFS_TEST_DISK             "ram0"
+#define FATFS_TEST_SECTOR_SZ        512
+#define FATFS_TEST_NUM_SECTORS      4096
+
+/* Transfers seen by the RAM disk. */
+struct fatfs_test_disk_stats {
+    uint32_t reads;
+    uint32_t read_bytes;
+    uint32_t writes;
+    uint32_t write_bytes;
+};
+
+extern struct fatfs_test_disk_stats fatfs_test_disk_stats;
+
+void fatfs_test_disk_stats_clear(void);
+uint8_t fatfs_test_pattern(uint32_t off);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _FATFS_TEST_H */
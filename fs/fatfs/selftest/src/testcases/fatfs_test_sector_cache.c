@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fatfs_test.h"
+
+/* Small enough for every file's sector to stay cached. */
+#define FATFS_TEST_NUM_FILES    3
+
+static void
+fatfs_test_sector_cache_name(char *buf, int idx)
+{
+    sprintf(buf, FATFS_TEST_DISK ":/file%d.txt", idx);
+}
+
+TEST_CASE_SELF(fatfs_test_sector_cache)
+{
+    struct fs_file *file;
+    uint32_t reads_cold;
+    uint32_t bytes_read;
+    uint32_t len;
+    char name[32];
+    char buf[16];
+    int rc;
+    int i;
+
+    for (i = 0; i < FATFS_TEST_NUM_FILES; i++) {
+        fatfs_test_sector_cache_name(name, i);
+        rc = fs_open(name, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_write(file, name, strlen(name));
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_close(file);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Cached directory and FAT sectors must reflect the writes above. */
+    fatfs_test_disk_stats_clear();
+    for (i = 0; i < FATFS_TEST_NUM_FILES; i++) {
+        fatfs_test_sector_cache_name(name, i);
+        rc = fs_open(name, FS_ACCESS_READ, &file);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_filelen(file, &len);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(len == strlen(name));
+        rc = fs_read(file, sizeof buf, buf, &bytes_read);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(bytes_read == len);
+        TEST_ASSERT(memcmp(buf, name, len) == 0);
+        rc = fs_close(file);
+        TEST_ASSERT(rc == 0);
+    }
+    reads_cold = fatfs_test_disk_stats.reads;
+
+    /* The second pass is served entirely from the cache. */
+    fatfs_test_disk_stats_clear();
+    for (i = 0; i < FATFS_TEST_NUM_FILES; i++) {
+        fatfs_test_sector_cache_name(name, i);
+        rc = fs_open(name, FS_ACCESS_READ, &file);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_read(file, sizeof buf, buf, &bytes_read);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(memcmp(buf, name, bytes_read) == 0);
+        rc = fs_close(file);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(fatfs_test_disk_stats.reads == 0);
+
+    for (i = 0; i < FATFS_TEST_NUM_FILES; i++) {
+        fatfs_test_sector_cache_name(name, i);
+        rc = fs_unlink(name);
+        TEST_ASSERT(rc == 0);
+
+        rc = fs_open(name, FS_ACCESS_READ, &file);
+        TEST_ASSERT(rc == FS_ENOENT);
+    }
+
+    TEST_PASS("rereading %d files: %lu disk reads cold, 0 cached",
+              FATFS_TEST_NUM_FILES, (unsigned long)reads_cold);
+}
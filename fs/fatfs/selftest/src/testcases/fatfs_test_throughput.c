@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fatfs_test.h"
+
+#define FATFS_TEST_FILE_SZ      (256 * 1024)
+#define FATFS_TEST_CHUNK_SZ     4096
+
+static uint8_t fatfs_test_chunk[FATFS_TEST_CHUNK_SZ];
+
+TEST_CASE_SELF(fatfs_test_throughput)
+{
+    struct fs_file *file;
+    uint32_t write_usec;
+    uint32_t read_usec;
+    uint32_t write_ops;
+    uint32_t read_ops;
+    uint32_t bytes_read;
+    uint32_t off;
+    int64_t start;
+    int rc;
+    int i;
+
+    /* Sequential write. */
+    fatfs_test_disk_stats_clear();
+    start = os_get_uptime_usec();
+
+    rc = fs_open(FATFS_TEST_DISK ":/stream.bin",
+                 FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (off = 0; off < FATFS_TEST_FILE_SZ; off += FATFS_TEST_CHUNK_SZ) {
+        for (i = 0; i < FATFS_TEST_CHUNK_SZ; i++) {
+            fatfs_test_chunk[i] = fatfs_test_pattern(off + i);
+        }
+        rc = fs_write(file, fatfs_test_chunk, FATFS_TEST_CHUNK_SZ);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    write_usec = os_get_uptime_usec() - start;
+    write_ops = fatfs_test_disk_stats.writes;
+
+    /* Whole clusters go to the disk as single multi-sector transfers. */
+    TEST_ASSERT(fatfs_test_disk_stats.write_bytes >= FATFS_TEST_FILE_SZ);
+    TEST_ASSERT(write_ops < FATFS_TEST_FILE_SZ / FATFS_TEST_SECTOR_SZ / 4);
+
+    /* Sequential read. */
+    fatfs_test_disk_stats_clear();
+    start = os_get_uptime_usec();
+
+    rc = fs_open(FATFS_TEST_DISK ":/stream.bin", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (off = 0; off < FATFS_TEST_FILE_SZ; off += FATFS_TEST_CHUNK_SZ) {
+        rc = fs_read(file, FATFS_TEST_CHUNK_SZ, fatfs_test_chunk,
+                     &bytes_read);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(bytes_read == FATFS_TEST_CHUNK_SZ);
+        for (i = 0; i < FATFS_TEST_CHUNK_SZ; i++) {
+            TEST_ASSERT_FATAL(fatfs_test_chunk[i] ==
+                              fatfs_test_pattern(off + i));
+        }
+    }
+
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    read_usec = os_get_uptime_usec() - start;
+    read_ops = fatfs_test_disk_stats.reads;
+
+    TEST_ASSERT(read_ops < FATFS_TEST_FILE_SZ / FATFS_TEST_SECTOR_SZ / 4);
+
+    rc = fs_unlink(FATFS_TEST_DISK ":/stream.bin");
+    TEST_ASSERT(rc == 0);
+
+    TEST_PASS("%d kB: write %lu us / %lu disk ops, read %lu us / %lu disk ops",
+              FATFS_TEST_FILE_SZ / 1024,
+              (unsigned long)write_usec, (unsigned long)write_ops,
+              (unsigned long)read_usec, (unsigned long)read_ops);
+}
@@ -551,9 +551,119 @@ fatfs_dirent_is_dir(const struct fs_dirent *fs_dirent)
     return filinfo->fattrib & AM_DIR;
 }
 
+/* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
+#define FATFS_SECTOR_SIZE   512
+
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT) > 0
+/*
+ * Write-through cache of single sectors.  FatFs reads FAT and directory
+ * sectors one at a time and revisits them constantly, while file data in
+ * bulk arrives as multi-sector requests; only the former are cached so that
+ * streaming data does not evict them.
+ */
+struct fatfs_cached_sector {
+    DWORD sector;
+    /* Time of last use; 0 if the entry is unused. */
+    uint32_t stamp;
+    BYTE pdrv;
+    BYTE data[FATFS_SECTOR_SIZE];
+};
+
+static struct fatfs_cached_sector
+    fatfs_sector_cache[MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT)];
+static uint32_t fatfs_sector_cache_stamp;
+
+static struct fatfs_cached_sector *
+fatfs_cache_find(BYTE pdrv, DWORD sector)
+{
+    struct fatfs_cached_sector *cs;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT); i++) {
+        cs = &fatfs_sector_cache[i];
+        if (cs->stamp != 0 && cs->pdrv == pdrv && cs->sector == sector) {
+            return cs;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns an unused entry, or the least recently used one.
+ */
+static struct fatfs_cached_sector *
+fatfs_cache_victim(void)
+{
+    struct fatfs_cached_sector *victim;
+    struct fatfs_cached_sector *cs;
+    int i;
+
+    victim = &fatfs_sector_cache[0];
+    for (i = 0; i < MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT); i++) {
+        cs = &fatfs_sector_cache[i];
+        if (cs->stamp == 0) {
+            return cs;
+        }
+        if ((int32_t)(cs->stamp - victim->stamp) < 0) {
+            victim = cs;
+        }
+    }
+
+    return victim;
+}
+
+static void
+fatfs_cache_touch(struct fatfs_cached_sector *cs)
+{
+    fatfs_sector_cache_stamp++;
+    if (fatfs_sector_cache_stamp == 0) {
+        fatfs_sector_cache_stamp = 1;
+    }
+    cs->stamp = fatfs_sector_cache_stamp;
+}
+
+/**
+ * Keeps cached copies of sectors that were just written up to date.
+ */
+static void
+fatfs_cache_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    struct fatfs_cached_sector *cs;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT); i++) {
+        cs = &fatfs_sector_cache[i];
+        if (cs->stamp != 0 && cs->pdrv == pdrv &&
+            cs->sector >= sector && cs->sector - sector < count) {
+
+            memcpy(cs->data, buff + (cs->sector - sector) * FATFS_SECTOR_SIZE,
+                   FATFS_SECTOR_SIZE);
+        }
+    }
+}
+
+static void
+fatfs_cache_invalidate(BYTE pdrv)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT); i++) {
+        if (fatfs_sector_cache[i].pdrv == pdrv) {
+            fatfs_sector_cache[i].stamp = 0;
+        }
+    }
+}
+#endif
+
 DSTATUS
 disk_initialize(BYTE pdrv)
 {
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT) > 0
+    /* The medium may have been replaced. */
+    fatfs_cache_invalidate(pdrv);
+#endif
+
     /* Don't need to do anything while using hal_flash */
     return RES_OK;
 }
@@ -578,6 +688,9 @@ static struct disk_ops *dops_from_handle(BYTE pdrv)
     return NULL;
 }
 
+/**
+ * Multi-sector requests are passed to the disk driver as a single transfer.
+ */
 DRESULT
 disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
@@ -585,16 +698,39 @@ disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
     uint32_t address;
     uint32_t num_bytes;
     struct disk_ops *dops;
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT) > 0
+    struct fatfs_cached_sector *cs;
+#endif
 
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    address = (uint32_t) sector * FATFS_SECTOR_SIZE;
+    num_bytes = (uint32_t) count * FATFS_SECTOR_SIZE;
 
     dops = dops_from_handle(pdrv);
     if (dops == NULL) {
         return STA_NOINIT;
     }
 
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT) > 0
+    if (count == 1) {
+        cs = fatfs_cache_find(pdrv, sector);
+        if (cs == NULL) {
+            cs = fatfs_cache_victim();
+            cs->stamp = 0;
+
+            rc = dops->read(pdrv, address, cs->data, num_bytes);
+            if (rc < 0) {
+                return STA_NOINIT;
+            }
+            cs->pdrv = pdrv;
+            cs->sector = sector;
+        }
+
+        fatfs_cache_touch(cs);
+        memcpy(buff, cs->data, FATFS_SECTOR_SIZE);
+        return RES_OK;
+    }
+#endif
+
     rc = dops->read(pdrv, address, (void *) buff, num_bytes);
     if (rc < 0) {
         return STA_NOINIT;
@@ -611,9 +747,8 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
     uint32_t num_bytes;
     struct disk_ops *dops;
 
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    address = (uint32_t) sector * FATFS_SECTOR_SIZE;
+    num_bytes = (uint32_t) count * FATFS_SECTOR_SIZE;
 
     dops = dops_from_handle(pdrv);
     if (dops == NULL) {
@@ -621,6 +756,14 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
     }
 
     rc = dops->write(pdrv, address, (const void *) buff, num_bytes);
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_COUNT) > 0
+    if (rc < 0) {
+        /* The sectors' contents are unknown after a failed write. */
+        fatfs_cache_invalidate(pdrv);
+    } else {
+        fatfs_cache_write(pdrv, buff, sector, count);
+    }
+#endif
     if (rc < 0) {
         return STA_NOINIT;
     }
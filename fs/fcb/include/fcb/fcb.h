@@ -49,6 +49,38 @@ struct fcb_entry {
     uint16_t fe_data_len;	/* size of data area */
 };
 
+/**
+ * Table of validated elements within one sector.  Filled in by FCB.
+ */
+struct fcb_sector_cache_entry {
+    uint32_t fsce_elem_off;	/* start of entry */
+    uint16_t fsce_data_len;	/* size of data area */
+};
+
+/**
+ * Per-sector cache of validated elements.  The first time fcb_getnext()
+ * enters a sector which is no longer being written to, the CRC of every
+ * element in it is checked and the locations of the valid ones are recorded
+ * here.  Subsequent walks over that sector are served from RAM, without
+ * reading the elements from flash.
+ *
+ * A sector which contains an element with a bad CRC is not cached; this is
+ * remembered until the sector is rotated out, so that it is scanned only
+ * once.  If a sector holds more elements than fsc_max, the ones beyond are
+ * found by reading flash as usual.
+ */
+struct fcb_sector_cache {
+    /* Caller of fcb_init fills this in */
+    struct fcb_sector_cache_entry *fsc_entries;
+    uint16_t fsc_max;		/* Number of elements in fsc_entries */
+
+    /* Internal state */
+    struct flash_area *fsc_area;	/* Cached sector, NULL if unused */
+    uint16_t fsc_cnt;
+    uint8_t fsc_complete;	/* Whether all elements of sector fit */
+    uint8_t fsc_uncacheable;	/* Sector failed validation, not cached */
+};
+
 struct fcb {
     /* Caller of fcb_init fills this in */
     uint32_t f_magic;		/* As placed on the disk */
@@ -63,6 +95,11 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+
+    /* Optional, caller of fcb_init fills this in */
+    struct fcb_sector_cache *f_sector_cache; /* Array of sector caches */
+    uint8_t f_sector_cache_cnt;	/* Number of elements in cache array */
+    uint8_t f_sector_cache_next; /* Internal: next cache slot to reuse */
 };
 
 /**
@@ -102,6 +139,16 @@ typedef int (*fcb_walk_cb)(struct fcb_entry *loc, void *arg);
 int fcb_walk(struct fcb *, struct flash_area *, fcb_walk_cb cb, void *cb_arg);
 int fcb_getnext(struct fcb *, struct fcb_entry *loc);
 
+/**
+ * Reads the first len bytes of the element data at loc into buf, and
+ * verifies the CRC of the element in the same pass.  Remaining data, if len
+ * is smaller than the element, is read only to compute the CRC.
+ *
+ * Returns 0 on success, FCB_ERR_CRC if the element is corrupt.
+ */
+int fcb_read_verify(struct fcb *, struct fcb_entry *loc, void *buf,
+                    uint16_t len);
+
 /**
  * Erases the data from oldest sector.
  */
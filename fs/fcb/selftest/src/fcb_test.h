@@ -36,6 +36,8 @@ extern struct fcb test_fcb;
 
 extern struct flash_area test_fcb_area[];
 
+extern int flash_native_memset(uint32_t offset, uint8_t c, uint32_t len);
+
 struct append_arg {
     int *elem_cnts;
 };
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE_SELF(fcb_test_read_verify)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    struct fcb_entry locs[3];
+    struct fcb_sector_cache_entry entries[8];
+    struct fcb_sector_cache cache;
+    uint8_t test_data[128];
+    uint8_t buf[128];
+    uint8_t zero;
+    int rc;
+    int i;
+    int j;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < sizeof(test_data); j++) {
+            test_data[j] = fcb_test_append_data(sizeof(test_data), j) | 1;
+        }
+        rc = fcb_append(fcb, sizeof(test_data), &locs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(locs[i].fe_area, locs[i].fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &locs[i]);
+        TEST_ASSERT(rc == 0);
+    }
+
+    /*
+     * Full and partial reads both verify the whole element.
+     */
+    memset(buf, 0, sizeof(buf));
+    rc = fcb_read_verify(fcb, &locs[0], buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(buf, test_data, sizeof(test_data)));
+
+    memset(buf, 0, sizeof(buf));
+    rc = fcb_read_verify(fcb, &locs[1], buf, 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(buf, test_data, 10));
+    TEST_ASSERT(buf[10] == 0);
+
+    /*
+     * Corrupt the tail of the middle element; this is outside the part
+     * being read, but must still be detected.
+     */
+    zero = 0;
+    rc = flash_area_write(locs[1].fe_area,
+      locs[1].fe_data_off + sizeof(test_data) - 1, &zero, 1);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_read_verify(fcb, &locs[1], buf, 10);
+    TEST_ASSERT(rc == FCB_ERR_CRC);
+    rc = fcb_read_verify(fcb, &locs[2], buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Sector with corrupt element is walked from flash, skipping the bad
+     * element, and is remembered as not cacheable.
+     */
+    rc = fcb_append_to_scratch(fcb);
+    TEST_ASSERT(rc == 0);
+
+    memset(&cache, 0, sizeof(cache));
+    cache.fsc_entries = entries;
+    cache.fsc_max = 8;
+    fcb->f_sector_cache = &cache;
+    fcb->f_sector_cache_cnt = 1;
+
+    memset(&loc, 0, sizeof(loc));
+    rc = fcb_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_elem_off == locs[0].fe_elem_off);
+    rc = fcb_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_elem_off == locs[2].fe_elem_off);
+    rc = fcb_getnext(fcb, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+    TEST_ASSERT(cache.fsc_area == locs[0].fe_area);
+    TEST_ASSERT(cache.fsc_uncacheable);
+    TEST_ASSERT(cache.fsc_cnt == 0);
+
+    fcb->f_sector_cache = NULL;
+    fcb->f_sector_cache_cnt = 0;
+}
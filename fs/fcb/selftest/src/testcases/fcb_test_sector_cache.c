@@ -0,0 +1,170 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_SC_ELEMS       1200
+#define FCB_TEST_SC_WALKS       8
+
+static struct fcb_entry fcb_test_sc_locs[FCB_TEST_SC_ELEMS];
+static struct fcb_sector_cache_entry fcb_test_sc_entries0[512];
+static struct fcb_sector_cache_entry fcb_test_sc_entries1[64];
+static struct fcb_sector_cache fcb_test_sc_caches[2];
+
+/*
+ * Walk the whole FCB, and check that the elements found match the ones
+ * appended, starting from index first.
+ */
+static int
+fcb_test_sc_walk(struct fcb *fcb, int first)
+{
+    struct fcb_entry loc;
+    uint8_t data[64];
+    int rc;
+    int i;
+    int j;
+
+    memset(&loc, 0, sizeof(loc));
+    i = first;
+    while (fcb_getnext(fcb, &loc) == 0) {
+        TEST_ASSERT_FATAL(i < FCB_TEST_SC_ELEMS);
+        TEST_ASSERT(loc.fe_area == fcb_test_sc_locs[i].fe_area);
+        TEST_ASSERT(loc.fe_elem_off == fcb_test_sc_locs[i].fe_elem_off);
+        TEST_ASSERT(loc.fe_data_off == fcb_test_sc_locs[i].fe_data_off);
+        TEST_ASSERT(loc.fe_data_len == fcb_test_sc_locs[i].fe_data_len);
+
+        rc = flash_area_read(loc.fe_area, loc.fe_data_off, data,
+          loc.fe_data_len);
+        TEST_ASSERT(rc == 0);
+        for (j = 0; j < loc.fe_data_len; j++) {
+            TEST_ASSERT(data[j] == fcb_test_append_data(loc.fe_data_len, j));
+        }
+        i++;
+    }
+    return i;
+}
+
+static uint32_t
+fcb_test_sc_time_walks(struct fcb *fcb)
+{
+    int64_t start;
+    int i;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < FCB_TEST_SC_WALKS; i++) {
+        TEST_ASSERT(fcb_test_sc_walk(fcb, 0) == FCB_TEST_SC_ELEMS);
+    }
+    return os_get_uptime_usec() - start;
+}
+
+TEST_CASE_SELF(fcb_test_sector_cache)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[64];
+    uint32_t uncached;
+    uint32_t cached;
+    int len;
+    int rc;
+    int i;
+    int j;
+
+    fcb_tc_pretest(4);
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < FCB_TEST_SC_ELEMS; i++) {
+        len = (i % sizeof(test_data)) + 1;
+        for (j = 0; j < len; j++) {
+            test_data[j] = fcb_test_append_data(len, j);
+        }
+        rc = fcb_append(fcb, len, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data, len);
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+
+        loc.fe_data_len = len;
+        fcb_test_sc_locs[i] = loc;
+    }
+    /* Elements should span at least 3 sectors. */
+    TEST_ASSERT_FATAL(fcb->f_active.fe_area == &test_fcb_area[2]);
+
+    uncached = fcb_test_sc_time_walks(fcb);
+
+    /*
+     * One cache big enough for a sector, one too small to hold all
+     * elements of a sector.
+     */
+    memset(fcb_test_sc_caches, 0, sizeof(fcb_test_sc_caches));
+    fcb_test_sc_caches[0].fsc_entries = fcb_test_sc_entries0;
+    fcb_test_sc_caches[0].fsc_max = 512;
+    fcb_test_sc_caches[1].fsc_entries = fcb_test_sc_entries1;
+    fcb_test_sc_caches[1].fsc_max = 64;
+    fcb->f_sector_cache = fcb_test_sc_caches;
+    fcb->f_sector_cache_cnt = 2;
+
+    cached = fcb_test_sc_time_walks(fcb);
+
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_area == &test_fcb_area[0]);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_complete);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_area == &test_fcb_area[1]);
+    TEST_ASSERT(!fcb_test_sc_caches[1].fsc_complete);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_cnt == 64);
+
+    /*
+     * Rotating must drop the table of the erased sector.
+     */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_area == NULL);
+
+    for (i = 0; i < FCB_TEST_SC_ELEMS; i++) {
+        if (fcb_test_sc_locs[i].fe_area != &test_fcb_area[0]) {
+            break;
+        }
+    }
+    TEST_ASSERT(fcb_test_sc_walk(fcb, i) == FCB_TEST_SC_ELEMS);
+
+    /*
+     * A sector with a bad element is scanned once, and then left alone
+     * until it is rotated out.
+     */
+    j = i;
+    rc = flash_native_memset(fcb_test_sc_locs[j].fe_area->fa_off +
+                             fcb_test_sc_locs[j].fe_data_off, 0, 1);
+    TEST_ASSERT(rc == 0);
+    fcb_test_sc_caches[1].fsc_area = NULL;
+
+    memset(&loc, 0, sizeof(loc));
+    for (i = 0; fcb_getnext(fcb, &loc) == 0; i++) {
+        TEST_ASSERT(loc.fe_elem_off != fcb_test_sc_locs[j].fe_elem_off ||
+                    loc.fe_area != fcb_test_sc_locs[j].fe_area);
+    }
+    TEST_ASSERT(i == FCB_TEST_SC_ELEMS - j - 1);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_area == &test_fcb_area[1]);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_uncacheable);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_area == NULL);
+
+    fcb->f_sector_cache = NULL;
+    fcb->f_sector_cache_cnt = 0;
+
+    TEST_PASS("%d walks: uncached=%lu us cached=%lu us", FCB_TEST_SC_WALKS,
+              (unsigned long)uncached, (unsigned long)cached);
+}
@@ -82,6 +82,7 @@ fcb_init(struct fcb *fcb)
     fcb->f_active.fe_area = newest_fap;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id = newest;
+    fcb_sector_cache_invalidate(fcb, NULL);
 
     /* Require alignment to be a power of two.  Some code depends on this
      * assumption.
@@ -31,11 +31,8 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
 {
     uint8_t tmp_str[FCB_TMP_BUF_SZ];
     int cnt;
-    int blk_sz;
     uint8_t crc8;
     uint16_t len;
-    uint32_t off;
-    uint32_t end;
     int rc;
 
     if (loc->fe_elem_off + 2 > loc->fe_area->fa_size) {
@@ -55,19 +52,9 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
     crc8 = crc8_init();
     crc8 = crc8_calc(crc8, tmp_str, cnt);
 
-    off = loc->fe_data_off;
-    end = loc->fe_data_off + len;
-    for (; off < end; off += blk_sz) {
-        blk_sz = end - off;
-        if (blk_sz > sizeof(tmp_str)) {
-            blk_sz = sizeof(tmp_str);
-        }
-
-        rc = flash_area_read(loc->fe_area, off, tmp_str, blk_sz);
-        if (rc) {
-            return FCB_ERR_FLASH;
-        }
-        crc8 = crc8_calc(crc8, tmp_str, blk_sz);
+    rc = flash_area_crc8(loc->fe_area, loc->fe_data_off, len, &crc8);
+    if (rc) {
+        return FCB_ERR_FLASH;
     }
     *c8p = crc8;
 
@@ -98,3 +85,51 @@ fcb_elem_info(struct fcb *fcb, struct fcb_entry *loc)
     }
     return 0;
 }
+
+int
+fcb_read_verify(struct fcb *fcb, struct fcb_entry *loc, void *buf,
+                uint16_t len)
+{
+    uint8_t tmp_str[FCB_TMP_BUF_SZ];
+    int cnt;
+    uint8_t crc8;
+    uint8_t fl_crc8;
+    uint32_t off;
+    int rc;
+
+    if (len > loc->fe_data_len) {
+        len = loc->fe_data_len;
+    }
+
+    cnt = fcb_put_len(tmp_str, loc->fe_data_len);
+    if (cnt < 0) {
+        return cnt;
+    }
+    crc8 = crc8_init();
+    crc8 = crc8_calc(crc8, tmp_str, cnt);
+
+    if (len) {
+        rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
+        if (rc) {
+            return FCB_ERR_FLASH;
+        }
+        crc8 = crc8_calc(crc8, buf, len);
+    }
+
+    rc = flash_area_crc8(loc->fe_area, loc->fe_data_off + len,
+                         loc->fe_data_len - len, &crc8);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+
+    off = loc->fe_data_off + fcb_len_in_flash(fcb, loc->fe_data_len);
+    rc = flash_area_read(loc->fe_area, off, &fl_crc8, sizeof(fl_crc8));
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+
+    if (fl_crc8 != crc8) {
+        return FCB_ERR_CRC;
+    }
+    return 0;
+}
@@ -51,63 +51,56 @@ fcb_getnext_area(struct fcb *fcb, struct flash_area *fap)
     return fap;
 }
 
-int
-fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc)
+/*
+ * Find the element following loc within loc->fe_area by reading flash.
+ */
+static int
+fcb_getnext_in_sector(struct fcb *fcb, struct fcb_entry *loc)
 {
     int rc;
 
-    if (loc->fe_area == NULL) {
-        /*
-         * Find the first one we have in flash.
-         */
-        loc->fe_area = fcb->f_oldest;
-    }
     if (loc->fe_elem_off == 0) {
         /*
          * If offset is zero, we serve the first entry from the area.
          */
         loc->fe_elem_off = sizeof(struct fcb_disk_area);
         rc = fcb_elem_info(fcb, loc);
-    } else {
-        rc = fcb_getnext_in_area(fcb, loc);
+        if (rc != FCB_ERR_CRC) {
+            return rc;
+        }
     }
-    switch (rc) {
-    case 0:
-        return 0;
-    case FCB_ERR_CRC:
-        break;
-    default:
-        goto next_sector;
+    return fcb_getnext_in_area(fcb, loc);
+}
+
+int
+fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc)
+{
+    int rc;
+
+    if (loc->fe_area == NULL) {
+        /*
+         * Find the first one we have in flash.
+         */
+        loc->fe_area = fcb->f_oldest;
     }
-    while (rc == FCB_ERR_CRC) {
-        rc = fcb_getnext_in_area(fcb, loc);
+    while (1) {
+        rc = fcb_sector_cache_getnext(fcb, loc);
+        if (rc == FCB_SECTOR_CACHE_MISS) {
+            rc = fcb_getnext_in_sector(fcb, loc);
+        }
         if (rc == 0) {
             return 0;
         }
 
-        if (rc != FCB_ERR_CRC) {
-            /*
-             * Moving to next sector.
-             */
-next_sector:
-            if (loc->fe_area == fcb->f_active.fe_area) {
-                return FCB_ERR_NOVAR;
-            }
-            loc->fe_area = fcb_getnext_area(fcb, loc->fe_area);
-            loc->fe_elem_off = sizeof(struct fcb_disk_area);
-            rc = fcb_elem_info(fcb, loc);
-            switch (rc) {
-            case 0:
-                return 0;
-            case FCB_ERR_CRC:
-                break;
-            default:
-                goto next_sector;
-            }
+        /*
+         * Moving to next sector.
+         */
+        if (loc->fe_area == fcb->f_active.fe_area) {
+            return FCB_ERR_NOVAR;
         }
+        loc->fe_area = fcb_getnext_area(fcb, loc->fe_area);
+        loc->fe_elem_off = 0;
     }
-
-    return 0;
 }
 
 int
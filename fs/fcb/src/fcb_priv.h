@@ -54,6 +54,12 @@ int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
 int fcb_elem_info(struct fcb *, struct fcb_entry *);
 int fcb_elem_crc8(struct fcb *, struct fcb_entry *loc, uint8_t *crc8p);
 
+/* Returned by fcb_sector_cache_getnext() when flash must be read instead. */
+#define FCB_SECTOR_CACHE_MISS  1
+
+int fcb_sector_cache_getnext(struct fcb *fcb, struct fcb_entry *loc);
+void fcb_sector_cache_invalidate(struct fcb *fcb, struct flash_area *fap);
+
 int fcb_sector_hdr_init(struct fcb *, struct flash_area *fap, uint16_t id);
 int fcb_sector_hdr_read(struct fcb *, struct flash_area *fap,
   struct fcb_disk_area *fdap);
@@ -31,6 +31,7 @@ fcb_rotate(struct fcb *fcb)
         return FCB_ERR_ARGS;
     }
 
+    fcb_sector_cache_invalidate(fcb, fcb->f_oldest);
     rc = flash_area_erase(fcb->f_oldest, 0, fcb->f_oldest->fa_size);
     if (rc) {
         rc = FCB_ERR_FLASH;
@@ -0,0 +1,196 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+/*
+ * Forget cached element table for fap. If fap is NULL, all tables are
+ * dropped.
+ */
+void
+fcb_sector_cache_invalidate(struct fcb *fcb, struct flash_area *fap)
+{
+    int i;
+
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        if (!fap || fcb->f_sector_cache[i].fsc_area == fap) {
+            fcb->f_sector_cache[i].fsc_area = NULL;
+        }
+    }
+}
+
+/*
+ * Only sectors between the oldest and the active one hold data which does
+ * not change until the sector is rotated out.
+ */
+static int
+fcb_sector_cache_usable(struct fcb *fcb, struct flash_area *fap)
+{
+    int cnt;
+    int pos;
+    int active;
+
+    /*
+     * Positions relative to the oldest sector; f_sectors is contiguous.
+     */
+    cnt = fcb->f_sector_cnt;
+    pos = (fap - fcb->f_oldest + cnt) % cnt;
+    active = (fcb->f_active.fe_area - fcb->f_oldest + cnt) % cnt;
+    return pos < active;
+}
+
+/*
+ * Validate all elements within fap, and record their locations.
+ */
+static int
+fcb_sector_cache_fill(struct fcb *fcb, struct fcb_sector_cache *fsc,
+                      struct flash_area *fap)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    fsc->fsc_cnt = 0;
+    fsc->fsc_complete = 0;
+    fsc->fsc_uncacheable = 0;
+    fsc->fsc_area = fap;
+
+    loc.fe_area = fap;
+    loc.fe_elem_off = sizeof(struct fcb_disk_area);
+    while (1) {
+        rc = fcb_elem_info(fcb, &loc);
+        if (rc == FCB_ERR_NOVAR) {
+            fsc->fsc_complete = 1;
+            break;
+        }
+        if (rc) {
+            /*
+             * Bad CRC, or an element still being written. Don't cache,
+             * and don't try again until the sector is rotated out.
+             */
+            fsc->fsc_cnt = 0;
+            fsc->fsc_uncacheable = 1;
+            return rc;
+        }
+        if (fsc->fsc_cnt == fsc->fsc_max) {
+            break;
+        }
+        fsc->fsc_entries[fsc->fsc_cnt].fsce_elem_off = loc.fe_elem_off;
+        fsc->fsc_entries[fsc->fsc_cnt].fsce_data_len = loc.fe_data_len;
+        fsc->fsc_cnt++;
+
+        loc.fe_elem_off = loc.fe_data_off +
+          fcb_len_in_flash(fcb, loc.fe_data_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+    }
+    return 0;
+}
+
+static struct fcb_sector_cache *
+fcb_sector_cache_get(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_sector_cache *fsc;
+    int i;
+
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        fsc = &fcb->f_sector_cache[i];
+        if (fsc->fsc_area == fap) {
+            return fsc->fsc_uncacheable ? NULL : fsc;
+        }
+    }
+    if (!fcb_sector_cache_usable(fcb, fap)) {
+        return NULL;
+    }
+
+    /*
+     * Prefer an unused slot, otherwise reuse them in round robin order.
+     */
+    fsc = NULL;
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        if (fcb->f_sector_cache[i].fsc_area == NULL) {
+            fsc = &fcb->f_sector_cache[i];
+            break;
+        }
+    }
+    if (!fsc) {
+        if (fcb->f_sector_cache_next >= fcb->f_sector_cache_cnt) {
+            fcb->f_sector_cache_next = 0;
+        }
+        fsc = &fcb->f_sector_cache[fcb->f_sector_cache_next++];
+        fsc->fsc_area = NULL;
+    }
+    if (fcb_sector_cache_fill(fcb, fsc, fap)) {
+        return NULL;
+    }
+    return fsc;
+}
+
+/*
+ * Find the element following loc within loc->fe_area using the cached
+ * element table. Returns 0 if found, FCB_ERR_NOVAR if there are no more
+ * elements in this sector, and FCB_SECTOR_CACHE_MISS if the answer has to
+ * come from flash.
+ */
+int
+fcb_sector_cache_getnext(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_sector_cache *fsc;
+    struct fcb_sector_cache_entry *fsce;
+    uint16_t len;
+    int lo;
+    int hi;
+    int mid;
+
+    if (!fcb->f_sector_cache_cnt) {
+        return FCB_SECTOR_CACHE_MISS;
+    }
+    fsc = fcb_sector_cache_get(fcb, loc->fe_area);
+    if (!fsc) {
+        return FCB_SECTOR_CACHE_MISS;
+    }
+
+    /*
+     * Binary search for the first element past loc.
+     */
+    lo = 0;
+    hi = fsc->fsc_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (fsc->fsc_entries[mid].fsce_elem_off <= loc->fe_elem_off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == fsc->fsc_cnt) {
+        if (fsc->fsc_complete) {
+            return FCB_ERR_NOVAR;
+        }
+        return FCB_SECTOR_CACHE_MISS;
+    }
+
+    fsce = &fsc->fsc_entries[lo];
+    len = fsce->fsce_data_len;
+    loc->fe_elem_off = fsce->fsce_elem_off;
+    loc->fe_data_off = fsce->fsce_elem_off +
+      fcb_len_in_flash(fcb, len < 0x80 ? 1 : 2);
+    loc->fe_data_len = len;
+    return 0;
+}
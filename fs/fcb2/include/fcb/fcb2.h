@@ -57,6 +57,39 @@ struct fcb2_entry {
 #define FCB2_ENTRY_SIZE          6
 #define FCB2_CRC_LEN             2
 
+/**
+ * Location of a validated entry within a sector.  Filled in by FCB.
+ */
+struct fcb2_sector_cache_entry {
+    uint32_t fsce_data_off;     /* start of data in sector */
+    uint16_t fsce_data_len;     /* size of data area */
+};
+
+/**
+ * Per-sector cache of validated entries.  The first time fcb2_getnext() or
+ * fcb2_getprev() enters a sector which is no longer being written to, the
+ * CRC of every entry in it is checked and the locations of the entries are
+ * recorded here.  Subsequent walks over that sector, in either direction,
+ * are served from RAM without reading the entries from flash.
+ *
+ * A sector which contains an entry with a bad CRC is not cached; this is
+ * remembered until the sector is rotated out, so that it is scanned only
+ * once.  If a sector holds more entries than fsc_max, the ones beyond are
+ * found by reading flash as usual.
+ */
+struct fcb2_sector_cache {
+    /* Caller of fcb2_init() fills this in */
+    struct fcb2_sector_cache_entry *fsc_entries;
+    uint16_t fsc_max;           /* Number of elements in fsc_entries */
+
+    /* Internal state */
+    uint16_t fsc_sector;        /* Cached sector */
+    uint16_t fsc_cnt;           /* Entries 1..fsc_cnt are cached */
+    uint8_t fsc_valid;
+    uint8_t fsc_complete;       /* Whether all entries of sector fit */
+    uint8_t fsc_uncacheable;    /* Sector failed validation, not cached */
+};
+
 /**
  * State structure for flash circular buffer version2.
  */
@@ -74,6 +107,12 @@ struct fcb2 {
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
     struct fcb2_entry f_active;
     uint16_t f_active_id;
+
+    /* Optional, caller of fcb2_init() fills this in */
+    struct fcb2_sector_cache *f_sector_cache; /* Array of sector caches */
+    uint8_t f_sector_cache_cnt; /* Number of elements in cache array */
+    uint8_t f_sector_cache_next; /* Internal: next cache slot to reuse */
+    uint32_t *f_erase_cnts;     /* Per-sector erase counts, f_sector_cnt */
 };
 
 /**
@@ -221,6 +260,20 @@ int fcb2_getprev(struct fcb2 *fcb, struct fcb2_entry *loc);
  */
 int fcb2_read(struct fcb2_entry *loc, uint16_t off, void *buf, uint16_t len);
 
+/**
+ * Read entry data pointed by loc, and verify the CRC of the entry in the
+ * same pass.  If len is smaller than the entry, the rest of the data is
+ * read only to compute the CRC.
+ *
+ * @param loc            FCB entry to read
+ * @param buf            Pointer to area where to populate the data
+ * @param len            Number of bytes to read.
+ *
+ * @return 0 on success, FCB2_ERR_CRC if entry is corrupt. Otherwise one of
+ *         FCB2_XXX error codes.
+ */
+int fcb2_read_verify(struct fcb2_entry *loc, void *buf, uint16_t len);
+
 /**
  * Erases the data from oldest sector.
  *
@@ -230,6 +283,37 @@ int fcb2_read(struct fcb2_entry *loc, uint16_t off, void *buf, uint16_t len);
  */
 int fcb2_rotate(struct fcb2 *fcb);
 
+/**
+ * Erases the oldest sector ahead of need.  If the next append which does
+ * not fit in the active sector would fail with FCB2_ERR_NOSPACE, the oldest
+ * sector is rotated out now.  Calling this from a low priority task while
+ * the active sector fills up keeps flash erase off the append path, at the
+ * cost of dropping the oldest sector a bit earlier.
+ *
+ * Users which track data per sector must treat this like fcb2_rotate().
+ *
+ * @param fcb            FCB where to erase the sector
+ *
+ * @return 0 on success, also if there was nothing to erase. Otherwise one
+ *         of FCB2_XXX error codes.
+ */
+int fcb2_pre_erase(struct fcb2 *fcb);
+
+/**
+ * Number of times a sector has been erased.  Only available if caller set
+ * f_erase_cnts before calling fcb2_init().  Counts are kept in sector
+ * headers, and restored by fcb2_init().  For sectors which were erased and
+ * unused at that time, the highest count found is used.
+ *
+ * @param fcb            FCB to inspect
+ * @param sector         Sector number 0..f_sector_cnt
+ * @param cntp           Erase count is stored here
+ *
+ * @return 0 on success. Otherwise one of FCB2_XXX error codes.
+ */
+int fcb2_sector_erase_cnt(const struct fcb2 *fcb, int sector,
+                          uint32_t *cntp);
+
 /**
  * Start using the scratch block.
  *
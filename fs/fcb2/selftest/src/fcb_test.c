@@ -142,6 +142,10 @@ TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
 TEST_CASE_DECL(fcb_test_getprev)
+TEST_CASE_DECL(fcb_test_sector_cache)
+TEST_CASE_DECL(fcb_test_read_verify)
+TEST_CASE_DECL(fcb_test_erase_cnt)
+TEST_CASE_DECL(fcb_test_pre_erase)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -156,6 +160,10 @@ TEST_SUITE(fcb_test_all)
     fcb_test_last_of_n();
     fcb_test_area_info();
     fcb_test_getprev();
+    fcb_test_sector_cache();
+    fcb_test_read_verify();
+    fcb_test_erase_cnt();
+    fcb_test_pre_erase();
 }
 
 int
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+static uint32_t fcb_test_erase_cnts[4];
+
+static void
+fcb_test_fill(struct fcb2 *fcb)
+{
+    struct fcb2_entry loc;
+    uint8_t test_data[128];
+    int rc;
+
+    memset(test_data, 0x5a, sizeof(test_data));
+    while (1) {
+        rc = fcb2_append(fcb, sizeof(test_data), &loc);
+        if (rc == FCB2_ERR_NOSPACE) {
+            break;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb2_write(&loc, 0, test_data, sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb2_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+TEST_CASE_SELF(fcb_test_erase_cnt)
+{
+    struct fcb2 *fcb;
+    struct fcb2_entry loc;
+    uint8_t hdr[16];
+    uint32_t expected[4];
+    uint32_t max;
+    uint32_t cnt;
+    int free_sec;
+    int rc;
+    int i;
+    int j;
+
+    fcb_tc_pretest(4);
+
+    fcb = &test_fcb;
+
+    /* Not tracked unless caller gives the array. */
+    rc = fcb2_sector_erase_cnt(fcb, 0, &cnt);
+    TEST_ASSERT(rc == FCB2_ERR_ARGS);
+
+    fcb->f_erase_cnts = fcb_test_erase_cnts;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(expected, 0, sizeof(expected));
+    for (i = 0; i < 4; i++) {
+        rc = fcb2_sector_erase_cnt(fcb, i, &cnt);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(cnt == 0);
+    }
+    rc = fcb2_sector_erase_cnt(fcb, 4, &cnt);
+    TEST_ASSERT(rc == FCB2_ERR_ARGS);
+
+    /*
+     * Wrap around a few times. Each rotation erases oldest sector.
+     */
+    for (i = 0; i < 10; i++) {
+        fcb_test_fill(fcb);
+        expected[fcb->f_oldest_sec]++;
+        rc = fcb2_rotate(fcb);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    fcb_test_fill(fcb);
+
+    for (i = 0; i < 4; i++) {
+        rc = fcb2_sector_erase_cnt(fcb, i, &cnt);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(cnt == expected[i]);
+    }
+
+    /*
+     * Rotate once more, so that there is a free sector. Then restore counts
+     * from flash.
+     */
+    free_sec = fcb->f_oldest_sec;
+    expected[free_sec]++;
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(fcb_test_erase_cnts, 0xaa, sizeof(fcb_test_erase_cnts));
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    max = 0;
+    for (i = 0; i < 4; i++) {
+        if (i != free_sec && expected[i] > max) {
+            max = expected[i];
+        }
+    }
+    for (i = 0; i < 4; i++) {
+        rc = fcb2_sector_erase_cnt(fcb, i, &cnt);
+        TEST_ASSERT(rc == 0);
+        if (i == free_sec) {
+            TEST_ASSERT(cnt == max);
+        } else {
+            TEST_ASSERT(cnt == expected[i]);
+        }
+    }
+
+    /* Data is still there. */
+    rc = fcb2_area_info(fcb, FCB2_SECTOR_OLDEST, &j, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(j > 0);
+
+    fcb->f_erase_cnts = NULL;
+
+    /*
+     * With 8 byte write alignment, the header is written padded to 16
+     * bytes, and the first entry starts after the padding.
+     */
+    test_fcb_ranges[0].fsr_align = 8;
+    fcb_tc_pretest(4);
+    fcb->f_erase_cnts = fcb_test_erase_cnts;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fcb2_append(fcb, 8, &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(loc.fe_data_off % 8 == 0);
+    TEST_ASSERT(loc.fe_data_off >= 16);
+    memset(hdr, 0x5a, sizeof(hdr));
+    rc = fcb2_write(&loc, 0, hdr, 8);
+    TEST_ASSERT(rc == 0);
+    rc = fcb2_append_finish(&loc);
+    TEST_ASSERT(rc == 0);
+
+    rc = flash_area_read(&test_fcb_ranges[0].fsr_flash_area,
+                         loc.fe_sector * test_fcb_ranges[0].fsr_sector_size,
+                         hdr, sizeof(hdr));
+    TEST_ASSERT(rc == 0);
+    for (i = 12; i < 16; i++) {
+        TEST_ASSERT(hdr[i] == 0xff);
+    }
+
+    memset(&loc, 0, sizeof(loc));
+    rc = fcb2_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_data_len == 8);
+
+    fcb->f_erase_cnts = NULL;
+    test_fcb_ranges[0].fsr_align = 1;
+}
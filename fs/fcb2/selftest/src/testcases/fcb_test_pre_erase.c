@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+
+#include "fcb_test.h"
+
+#define FCB_TEST_PE_APPENDS     2000
+
+struct fcb_test_pe_stats {
+    uint32_t p999_usec;
+    uint32_t max_usec;
+    int rotations;
+};
+
+static uint32_t fcb_test_pe_usecs[FCB_TEST_PE_APPENDS];
+
+static int
+fcb_test_pe_cmp(const void *a, const void *b)
+{
+    uint32_t ua = *(const uint32_t *)a;
+    uint32_t ub = *(const uint32_t *)b;
+
+    return (ua > ub) - (ua < ub);
+}
+
+/*
+ * Append entries, rotating when full. If pre_erase is set, oldest sector
+ * is erased between appends, as a background task would do.
+ */
+static void
+fcb_test_pe_run(int pre_erase, struct fcb_test_pe_stats *stats)
+{
+    struct fcb2 *fcb;
+    struct fcb2_entry loc;
+    uint8_t test_data[64];
+    int64_t start;
+    int rc;
+    int i;
+
+    fcb_tc_pretest(4);
+
+    fcb = &test_fcb;
+    memset(stats, 0, sizeof(*stats));
+    memset(test_data, 0x3c, sizeof(test_data));
+
+    for (i = 0; i < FCB_TEST_PE_APPENDS; i++) {
+        start = os_get_uptime_usec();
+        while (1) {
+            rc = fcb2_append(fcb, sizeof(test_data), &loc);
+            if (rc != FCB2_ERR_NOSPACE) {
+                break;
+            }
+            stats->rotations++;
+            rc = fcb2_rotate(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb2_write(&loc, 0, test_data, sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb2_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+        fcb_test_pe_usecs[i] = os_get_uptime_usec() - start;
+
+        if (pre_erase) {
+            rc = fcb2_pre_erase(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+    }
+
+    qsort(fcb_test_pe_usecs, FCB_TEST_PE_APPENDS, sizeof(uint32_t),
+          fcb_test_pe_cmp);
+    stats->p999_usec = fcb_test_pe_usecs[FCB_TEST_PE_APPENDS * 999 / 1000];
+    stats->max_usec = fcb_test_pe_usecs[FCB_TEST_PE_APPENDS - 1];
+}
+
+TEST_CASE_SELF(fcb_test_pre_erase)
+{
+    struct fcb_test_pe_stats inline_erase;
+    struct fcb_test_pe_stats pre_erase;
+    struct fcb2 *fcb;
+    int oldest;
+    int rc;
+
+    fcb = &test_fcb;
+
+    /*
+     * Nothing is erased while there is room.
+     */
+    fcb_tc_pretest(4);
+    oldest = fcb->f_oldest_sec;
+    rc = fcb2_pre_erase(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_oldest_sec == oldest);
+    TEST_ASSERT(fcb2_free_sector_cnt(fcb) == 3);
+
+    fcb_test_pe_run(0, &inline_erase);
+    TEST_ASSERT(inline_erase.rotations > 0);
+
+    fcb_test_pe_run(1, &pre_erase);
+    TEST_ASSERT(pre_erase.rotations == 0);
+    TEST_ASSERT(fcb2_free_sector_cnt(fcb) >= 1);
+
+    TEST_PASS("%d appends: inline erase p99.9=%lu us max=%lu us, "
+              "pre-erase p99.9=%lu us max=%lu us", FCB_TEST_PE_APPENDS,
+              (unsigned long)inline_erase.p999_usec,
+              (unsigned long)inline_erase.max_usec,
+              (unsigned long)pre_erase.p999_usec,
+              (unsigned long)pre_erase.max_usec);
+}
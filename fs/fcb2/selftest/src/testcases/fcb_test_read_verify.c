@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE_SELF(fcb_test_read_verify)
+{
+    struct fcb2 *fcb;
+    struct fcb2_entry loc;
+    struct fcb2_entry locs[3];
+    struct fcb2_sector_cache_entry entries[8];
+    struct fcb2_sector_cache cache;
+    uint8_t test_data[128];
+    uint8_t buf[128];
+    uint8_t zero;
+    int rc;
+    int i;
+    int j;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < sizeof(test_data); j++) {
+            test_data[j] = fcb_test_append_data(sizeof(test_data), j) | 1;
+        }
+        rc = fcb2_append(fcb, sizeof(test_data), &locs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb2_write(&locs[i], 0, test_data, sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb2_append_finish(&locs[i]);
+        TEST_ASSERT(rc == 0);
+    }
+
+    /*
+     * Full and partial reads both verify the whole entry.
+     */
+    memset(buf, 0, sizeof(buf));
+    rc = fcb2_read_verify(&locs[0], buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(buf, test_data, sizeof(test_data)));
+
+    memset(buf, 0, sizeof(buf));
+    rc = fcb2_read_verify(&locs[1], buf, 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(buf, test_data, 10));
+    TEST_ASSERT(buf[10] == 0);
+
+    /*
+     * Corrupt the tail of the middle entry; this is outside the part
+     * being read, but must still be detected.
+     */
+    zero = 0;
+    rc = flash_area_write(&locs[1].fe_range->fsr_flash_area,
+      locs[1].fe_data_off + sizeof(test_data) - 1, &zero, 1);
+    TEST_ASSERT(rc == 0);
+    rc = fcb2_read_verify(&locs[1], buf, 10);
+    TEST_ASSERT(rc == FCB2_ERR_CRC);
+    rc = fcb2_read_verify(&locs[2], buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Sector with corrupt entry is walked from flash, skipping the bad
+     * entry, and is remembered as not cacheable.
+     */
+    rc = fcb2_append_to_scratch(fcb);
+    TEST_ASSERT(rc == 0);
+
+    memset(&cache, 0, sizeof(cache));
+    cache.fsc_entries = entries;
+    cache.fsc_max = 8;
+    fcb->f_sector_cache = &cache;
+    fcb->f_sector_cache_cnt = 1;
+
+    memset(&loc, 0, sizeof(loc));
+    rc = fcb2_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_entry_num == locs[0].fe_entry_num);
+    rc = fcb2_getnext(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_entry_num == locs[2].fe_entry_num);
+    rc = fcb2_getnext(fcb, &loc);
+    TEST_ASSERT(rc == FCB2_ERR_NOVAR);
+    TEST_ASSERT(cache.fsc_valid);
+    TEST_ASSERT(cache.fsc_sector == locs[0].fe_sector);
+    TEST_ASSERT(cache.fsc_uncacheable);
+    TEST_ASSERT(cache.fsc_cnt == 0);
+
+    fcb->f_sector_cache = NULL;
+    fcb->f_sector_cache_cnt = 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_SC_ELEMS       1200
+#define FCB_TEST_SC_WALKS       8
+
+static struct fcb2_entry fcb_test_sc_locs[FCB_TEST_SC_ELEMS];
+static struct fcb2_sector_cache_entry fcb_test_sc_entries0[512];
+static struct fcb2_sector_cache_entry fcb_test_sc_entries1[64];
+static struct fcb2_sector_cache fcb_test_sc_caches[2];
+
+static void
+fcb_test_sc_check(struct fcb2_entry *loc, int idx)
+{
+    uint8_t data[64];
+    int rc;
+    int j;
+
+    TEST_ASSERT_FATAL(idx >= 0 && idx < FCB_TEST_SC_ELEMS);
+    TEST_ASSERT(loc->fe_sector == fcb_test_sc_locs[idx].fe_sector);
+    TEST_ASSERT(loc->fe_entry_num == fcb_test_sc_locs[idx].fe_entry_num);
+    TEST_ASSERT(loc->fe_data_off == fcb_test_sc_locs[idx].fe_data_off);
+    TEST_ASSERT(loc->fe_data_len == fcb_test_sc_locs[idx].fe_data_len);
+
+    rc = fcb2_read(loc, 0, data, loc->fe_data_len);
+    TEST_ASSERT(rc == 0);
+    for (j = 0; j < loc->fe_data_len; j++) {
+        TEST_ASSERT(data[j] == fcb_test_append_data(loc->fe_data_len, j));
+    }
+}
+
+/*
+ * Walk the whole FCB forwards and backwards, and check that the entries
+ * found match the ones appended, starting from index first.
+ */
+static void
+fcb_test_sc_walk(struct fcb2 *fcb, int first)
+{
+    struct fcb2_entry loc;
+    int i;
+
+    memset(&loc, 0, sizeof(loc));
+    i = first;
+    while (fcb2_getnext(fcb, &loc) == 0) {
+        fcb_test_sc_check(&loc, i);
+        i++;
+    }
+    TEST_ASSERT(i == FCB_TEST_SC_ELEMS);
+
+    loc.fe_range = NULL;
+    while (fcb2_getprev(fcb, &loc) == 0) {
+        i--;
+        fcb_test_sc_check(&loc, i);
+    }
+    TEST_ASSERT(i == first);
+}
+
+static uint32_t
+fcb_test_sc_time_walks(struct fcb2 *fcb)
+{
+    int64_t start;
+    int i;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < FCB_TEST_SC_WALKS; i++) {
+        fcb_test_sc_walk(fcb, 0);
+    }
+    return os_get_uptime_usec() - start;
+}
+
+TEST_CASE_SELF(fcb_test_sector_cache)
+{
+    struct fcb2 *fcb;
+    struct fcb2_entry loc;
+    uint8_t test_data[64];
+    uint32_t uncached;
+    uint32_t cached;
+    int len;
+    int rc;
+    int i;
+    int j;
+
+    fcb_tc_pretest(4);
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < FCB_TEST_SC_ELEMS; i++) {
+        len = (i % sizeof(test_data)) + 1;
+        for (j = 0; j < len; j++) {
+            test_data[j] = fcb_test_append_data(len, j);
+        }
+        rc = fcb2_append(fcb, len, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb2_write(&loc, 0, test_data, len);
+        TEST_ASSERT(rc == 0);
+        rc = fcb2_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+
+        fcb_test_sc_locs[i] = loc;
+    }
+    /* Entries should span at least 3 sectors. */
+    TEST_ASSERT_FATAL(fcb->f_active.fe_sector == 2);
+
+    uncached = fcb_test_sc_time_walks(fcb);
+
+    /*
+     * One cache big enough for a sector, one too small to hold all
+     * entries of a sector.
+     */
+    memset(fcb_test_sc_caches, 0, sizeof(fcb_test_sc_caches));
+    fcb_test_sc_caches[0].fsc_entries = fcb_test_sc_entries0;
+    fcb_test_sc_caches[0].fsc_max = 512;
+    fcb_test_sc_caches[1].fsc_entries = fcb_test_sc_entries1;
+    fcb_test_sc_caches[1].fsc_max = 64;
+    fcb->f_sector_cache = fcb_test_sc_caches;
+    fcb->f_sector_cache_cnt = 2;
+
+    cached = fcb_test_sc_time_walks(fcb);
+
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_valid);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_sector == 0);
+    TEST_ASSERT(fcb_test_sc_caches[0].fsc_complete);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_valid);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_sector == 1);
+    TEST_ASSERT(!fcb_test_sc_caches[1].fsc_complete);
+    TEST_ASSERT(fcb_test_sc_caches[1].fsc_cnt == 64);
+
+    /*
+     * Rotating must drop the table of the erased sector.
+     */
+    rc = fcb2_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!fcb_test_sc_caches[0].fsc_valid);
+
+    for (i = 0; i < FCB_TEST_SC_ELEMS; i++) {
+        if (fcb_test_sc_locs[i].fe_sector != 0) {
+            break;
+        }
+    }
+    fcb_test_sc_walk(fcb, i);
+
+    fcb->f_sector_cache = NULL;
+    fcb->f_sector_cache_cnt = 0;
+
+    TEST_PASS("%d walks: uncached=%lu us cached=%lu us", FCB_TEST_SC_WALKS,
+              (unsigned long)uncached, (unsigned long)cached);
+}
@@ -23,6 +23,31 @@
 #include "fcb_priv.h"
 #include "string.h"
 
+/*
+ * Sectors which were free, or written by older versions, have no erase
+ * count on flash. Assume they've been erased as many times as the most worn
+ * sector.
+ */
+static void
+fcb2_erase_cnts_fill(struct fcb2 *fcb)
+{
+    uint32_t max;
+    int i;
+
+    max = 0;
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        if (fcb->f_erase_cnts[i] != FCB2_ERASE_CNT_NONE &&
+            fcb->f_erase_cnts[i] > max) {
+            max = fcb->f_erase_cnts[i];
+        }
+    }
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        if (fcb->f_erase_cnts[i] == FCB2_ERASE_CNT_NONE) {
+            fcb->f_erase_cnts[i] = max;
+        }
+    }
+}
+
 int
 fcb2_init(struct fcb2 *fcb)
 {
@@ -49,6 +74,13 @@ fcb2_init(struct fcb2 *fcb)
         if (rc < 0) {
             return rc;
         }
+        if (fcb->f_erase_cnts) {
+            fcb->f_erase_cnts[i] = FCB2_ERASE_CNT_NONE;
+            if (rc == 1 &&
+                !(fda.fd_flags & FCB2_DISK_AREA_NO_ERASE_CNT)) {
+                fcb->f_erase_cnts[i] = fda.fd_erase_cnt;
+            }
+        }
         if (rc == 0) {
             continue;
         }
@@ -67,6 +99,9 @@ fcb2_init(struct fcb2 *fcb)
             oldest_sec = i;
         }
     }
+    if (fcb->f_erase_cnts) {
+        fcb2_erase_cnts_fill(fcb);
+    }
     if (oldest < 0) {
         /*
          * No initialized areas.
@@ -86,6 +121,7 @@ fcb2_init(struct fcb2 *fcb)
         fcb2_len_in_flash(newest_srp, sizeof(struct fcb2_disk_area));
     fcb->f_active.fe_entry_num = 0;
     fcb->f_active_id = newest;
+    fcb2_sector_cache_invalidate(fcb, FCB2_SECTOR_OLDEST);
 
     while (1) {
         rc = fcb2_getnext_in_area(fcb, &fcb->f_active);
@@ -151,10 +187,14 @@ fcb2_get_sector_range(const struct fcb2 *fcb, int sector)
 int
 fcb2_sector_hdr_init(struct fcb2 *fcb, int sector, uint16_t id)
 {
-    struct fcb2_disk_area fda;
+    union {
+        struct fcb2_disk_area fda;
+        uint8_t buf[FCB2_DISK_AREA_MAX_WRITE];
+    } hdr;
     struct fcb2_sector_info info;
     struct flash_sector_range *range;
     int sector_in_range;
+    uint16_t len;
     int rc;
 
     rc = fcb2_get_sector_info(fcb, sector, &info);
@@ -164,14 +204,29 @@ fcb2_sector_hdr_init(struct fcb2 *fcb, int sector, uint16_t id)
     range = info.si_range;
     sector_in_range = sector - range->fsr_first_sector;
 
-    fda.fd_magic = fcb->f_magic;
-    fda.fd_ver = fcb->f_version;
-    fda._pad = 0xff;
-    fda.fd_id = id;
+    /*
+     * Header is written padded to the write alignment, which is also where
+     * the first entry starts.
+     */
+    len = fcb2_len_in_flash(range, sizeof(hdr.fda));
+    if (len > sizeof(hdr)) {
+        return FCB2_ERR_ARGS;
+    }
+    memset(&hdr, flash_area_erased_val(&range->fsr_flash_area), sizeof(hdr));
+
+    hdr.fda.fd_magic = fcb->f_magic;
+    hdr.fda.fd_ver = fcb->f_version;
+    hdr.fda.fd_flags = 0xff;
+    hdr.fda.fd_id = id;
+    hdr.fda.fd_erase_cnt = FCB2_ERASE_CNT_NONE;
+    if (fcb->f_erase_cnts) {
+        hdr.fda.fd_flags &= ~FCB2_DISK_AREA_NO_ERASE_CNT;
+        hdr.fda.fd_erase_cnt = fcb->f_erase_cnts[sector];
+    }
 
     assert(sector_in_range >= 0 && sector_in_range < range->fsr_sector_count);
     rc = flash_area_write(&range->fsr_flash_area,
-        sector_in_range * range->fsr_sector_size, &fda, sizeof(fda));
+        sector_in_range * range->fsr_sector_size, &hdr, len);
     if (rc) {
         return FCB2_ERR_FLASH;
     }
@@ -360,9 +415,26 @@ fcb2_sector_erase(const struct fcb2 *fcb, int sector)
         goto end;
     }
 
+    fcb2_sector_cache_invalidate(fcb, sector);
     rc = flash_area_erase(&info.si_range->fsr_flash_area,
         info.si_sector_in_range * info.si_range->fsr_sector_size,
         info.si_range->fsr_sector_size);
+    if (rc == 0 && fcb->f_erase_cnts) {
+        if (sector == FCB2_SECTOR_OLDEST) {
+            sector = fcb->f_oldest_sec;
+        }
+        fcb->f_erase_cnts[sector]++;
+    }
 end:
     return rc;
 }
+
+int
+fcb2_sector_erase_cnt(const struct fcb2 *fcb, int sector, uint32_t *cntp)
+{
+    if (!fcb->f_erase_cnts || sector < 0 || sector >= fcb->f_sector_cnt) {
+        return FCB2_ERR_ARGS;
+    }
+    *cntp = fcb->f_erase_cnts[sector];
+    return 0;
+}
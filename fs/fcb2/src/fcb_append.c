@@ -108,6 +108,17 @@ fcb2_read_from_sector(struct fcb2_entry *loc, int off, void *buf, int len)
         fcb2_sector_flash_offset(loc) + off, buf, len);
 }
 
+int
+fcb2_crc16_from_sector(struct fcb2_entry *loc, int off, int len,
+                       uint16_t *crc)
+{
+    if (off + len > loc->fe_range->fsr_sector_size) {
+        len = loc->fe_range->fsr_sector_size - off;
+    }
+    return flash_area_crc16_ccitt(&loc->fe_range->fsr_flash_area,
+        fcb2_sector_flash_offset(loc) + off, len, crc);
+}
+
 int
 fcb2_entry_location_in_range(const struct fcb2_entry *loc)
 {
@@ -29,28 +29,15 @@
 int
 fcb2_elem_crc16(struct fcb2_entry *loc, uint16_t *c16p)
 {
-    uint8_t tmp_str[FCB2_TMP_BUF_SZ];
-    int blk_sz;
     uint16_t crc16;
-    uint32_t off;
-    uint32_t end;
     int rc;
 
     crc16 = 0xFFFF;
 
-    off = loc->fe_data_off;
-    end = loc->fe_data_off + loc->fe_data_len;
-    for (; off < end; off += blk_sz) {
-        blk_sz = end - off;
-        if (blk_sz > sizeof(tmp_str)) {
-            blk_sz = sizeof(tmp_str);
-        }
-
-        rc = fcb2_read_from_sector(loc, off, tmp_str, blk_sz);
-        if (rc) {
-            return FCB2_ERR_FLASH;
-        }
-        crc16 = crc16_ccitt(crc16, tmp_str, blk_sz);
+    rc = fcb2_crc16_from_sector(loc, loc->fe_data_off, loc->fe_data_len,
+                                &crc16);
+    if (rc) {
+        return FCB2_ERR_FLASH;
     }
     *c16p = crc16;
 
@@ -86,8 +73,7 @@ fcb2_read_entry(struct fcb2_entry *loc)
     offset = (buf[0] << 16) | (buf[1] << 8) | (buf[2] << 0);
     len = (buf[3] << 8) | (buf[4] << 0);
     /* Sanity check for entry */
-    if (offset < fcb2_len_in_flash(loc->fe_range,
-                                   sizeof(struct fcb2_disk_area)) ||
+    if (offset < fcb2_len_in_flash(loc->fe_range, FCB2_DISK_AREA_MIN_SZ) ||
         len > FCB2_MAX_LEN ||
         offset + len > entry_offset) {
         /* Entry was found but data stored does not make any sense
@@ -131,3 +117,43 @@ fcb2_elem_info(struct fcb2_entry *loc)
 
     return 0;
 }
+
+int
+fcb2_read_verify(struct fcb2_entry *loc, void *buf, uint16_t len)
+{
+    uint16_t crc16;
+    uint8_t fl_crc16[2];
+    int rc;
+
+    if (len > loc->fe_data_len) {
+        len = loc->fe_data_len;
+    }
+
+    crc16 = 0xFFFF;
+
+    if (len) {
+        rc = fcb2_read_from_sector(loc, loc->fe_data_off, buf, len);
+        if (rc) {
+            return FCB2_ERR_FLASH;
+        }
+        crc16 = crc16_ccitt(crc16, buf, len);
+    }
+
+    rc = fcb2_crc16_from_sector(loc, loc->fe_data_off + len,
+                                loc->fe_data_len - len, &crc16);
+    if (rc) {
+        return FCB2_ERR_FLASH;
+    }
+
+    rc = fcb2_read_from_sector(loc,
+        loc->fe_data_off + fcb2_len_in_flash(loc->fe_range, loc->fe_data_len),
+        &fl_crc16, 2);
+    if (rc) {
+        return FCB2_ERR_FLASH;
+    }
+    if (get_be16(fl_crc16) != crc16) {
+        return FCB2_ERR_CRC;
+    }
+
+    return 0;
+}
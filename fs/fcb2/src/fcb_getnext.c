@@ -42,6 +42,27 @@ fcb2_getnext_in_area(struct fcb2 *fcb, struct fcb2_entry *loc)
     return rc;
 }
 
+/*
+ * Find the entry following loc within loc->fe_sector by reading flash.
+ */
+static int
+fcb2_getnext_in_sector(struct fcb2 *fcb, struct fcb2_entry *loc)
+{
+    int rc;
+
+    if (loc->fe_entry_num == 0) {
+        /*
+         * If offset is zero, we serve the first entry from the area.
+         */
+        loc->fe_entry_num = 1;
+        rc = fcb2_elem_info(loc);
+        if (rc != FCB2_ERR_CRC) {
+            return rc;
+        }
+    }
+    return fcb2_getnext_in_area(fcb, loc);
+}
+
 int
 fcb2_getnext_nolock(struct fcb2 *fcb, struct fcb2_entry *loc)
 {
@@ -54,53 +75,25 @@ fcb2_getnext_nolock(struct fcb2 *fcb, struct fcb2_entry *loc)
         loc->fe_sector = fcb->f_oldest_sec;
         loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
     }
-    if (loc->fe_entry_num == 0) {
-        /*
-         * If offset is zero, we serve the first entry from the area.
-         */
-        loc->fe_entry_num = 1;
-        rc = fcb2_elem_info(loc);
-    } else {
-        rc = fcb2_getnext_in_area(fcb, loc);
-    }
-    switch (rc) {
-    case 0:
-        return 0;
-    case FCB2_ERR_CRC:
-        break;
-    default:
-        goto next_sector;
-    }
-    while (rc == FCB2_ERR_CRC) {
-        rc = fcb2_getnext_in_area(fcb, loc);
+    while (1) {
+        rc = fcb2_sector_cache_getnext(fcb, loc);
+        if (rc == FCB2_SECTOR_CACHE_MISS) {
+            rc = fcb2_getnext_in_sector(fcb, loc);
+        }
         if (rc == 0) {
             return 0;
         }
 
-        if (rc != FCB2_ERR_CRC) {
-            /*
-             * Moving to next sector.
-             */
-next_sector:
-            if (loc->fe_sector == fcb->f_active.fe_sector) {
-                return FCB2_ERR_NOVAR;
-            }
-            loc->fe_sector = fcb2_getnext_sector(fcb, loc->fe_sector);
-            loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
-            loc->fe_entry_num = 1;
-            rc = fcb2_elem_info(loc);
-            switch (rc) {
-            case 0:
-                return 0;
-            case FCB2_ERR_CRC:
-                break;
-            default:
-                goto next_sector;
-            }
+        /*
+         * Moving to next sector.
+         */
+        if (loc->fe_sector == fcb->f_active.fe_sector) {
+            return FCB2_ERR_NOVAR;
         }
+        loc->fe_sector = fcb2_getnext_sector(fcb, loc->fe_sector);
+        loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
+        loc->fe_entry_num = 0;
     }
-
-    return 0;
 }
 
 int
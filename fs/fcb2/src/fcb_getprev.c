@@ -56,6 +56,27 @@ fcb2_sector_find_last(struct fcb2 *fcb, struct fcb2_entry *loc)
     return rc;
 }
 
+/*
+ * Find the entry preceding loc within loc->fe_sector by reading flash.
+ */
+static int
+fcb2_getprev_in_sector(struct fcb2 *fcb, struct fcb2_entry *loc)
+{
+    int rc;
+
+    if (loc->fe_entry_num == FCB2_ENTRY_NUM_LAST) {
+        return fcb2_sector_find_last(fcb, loc);
+    }
+    while (loc->fe_entry_num > 1) {
+        loc->fe_entry_num--;
+        rc = fcb2_elem_info(loc);
+        if (rc == 0) {
+            return 0;
+        }
+    }
+    return FCB2_ERR_NOVAR;
+}
+
 int
 fcb2_getprev(struct fcb2 *fcb, struct fcb2_entry *loc)
 {
@@ -70,32 +91,37 @@ fcb2_getprev(struct fcb2 *fcb, struct fcb2_entry *loc)
          * Find the last element.
          */
         *loc = fcb->f_active;
+    } else if (loc->fe_entry_num == 0) {
+        /*
+         * Position left by previous FCB2_ERR_NOVAR; continue from the end
+         * of the sector.
+         */
+        loc->fe_entry_num = FCB2_ENTRY_NUM_LAST;
     }
-     while (1) {
-        loc->fe_entry_num--;
-        if (loc->fe_entry_num < 1) {
-            /*
-             * Need to get from previous sector.
-             */
-            if (loc->fe_sector == fcb->f_oldest_sec) {
-                return FCB2_ERR_NOVAR;
-            }
-            if (loc->fe_sector == 0) {
-                loc->fe_sector = fcb->f_sector_cnt - 1;
-            } else {
-                loc->fe_sector--;
-            }
-            loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
-            rc = fcb2_sector_find_last(fcb, loc);
-            if (rc == 0) {
-                break;
-            }
+    while (1) {
+        rc = fcb2_sector_cache_getprev(fcb, loc);
+        if (rc == FCB2_SECTOR_CACHE_MISS) {
+            rc = fcb2_getprev_in_sector(fcb, loc);
+        }
+        if (rc == 0) {
+            break;
+        }
+
+        /*
+         * Need to get from previous sector.
+         */
+        if (loc->fe_sector == fcb->f_oldest_sec) {
+            loc->fe_entry_num = 0;
+            rc = FCB2_ERR_NOVAR;
+            break;
+        }
+        if (loc->fe_sector == 0) {
+            loc->fe_sector = fcb->f_sector_cnt - 1;
         } else {
-            rc = fcb2_elem_info(loc);
-            if (rc == 0) {
-                break;
-            }
+            loc->fe_sector--;
         }
+        loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
+        loc->fe_entry_num = FCB2_ENTRY_NUM_LAST;
     }
     os_mutex_release(&fcb->f_mtx);
     return rc;
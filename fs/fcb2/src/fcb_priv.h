@@ -19,21 +19,41 @@
 #ifndef __SYS_FCB2_PRIV_H_
 #define __SYS_FCB2_PRIV_H_
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define FCB2_TMP_BUF_SZ  32
-
 #define FCB2_ID_GT(a, b) (((int16_t)(a) - (int16_t)(b)) > 0)
 
+/* Erase count of a sector which is not known. */
+#define FCB2_ERASE_CNT_NONE     UINT32_MAX
+
+/*
+ * Bits in fd_flags; erased value is 0xff. Cleared bit means that the
+ * feature is present.
+ */
+#define FCB2_DISK_AREA_NO_ERASE_CNT     0x01
+
 struct fcb2_disk_area {
     uint32_t fd_magic;
     uint8_t  fd_ver;
-    uint8_t  _pad;
+    uint8_t  fd_flags;
     uint16_t fd_id;
+    /*
+     * Not present in sectors written by older versions; their data may
+     * start right after fd_id.
+     */
+    uint32_t fd_erase_cnt;
 };
 
+/* Smallest sector header found on flash. */
+#define FCB2_DISK_AREA_MIN_SZ   offsetof(struct fcb2_disk_area, fd_erase_cnt)
+
+/* Largest write alignment the sector header can be padded to. */
+#define FCB2_DISK_AREA_MAX_WRITE        32
+
 struct fcb2_sector_info {
     struct flash_sector_range *si_range;  /* Sector range */
     uint32_t si_sector_offset;            /* Sector offset in fcb */
@@ -50,6 +70,7 @@ fcb2_len_in_flash(const struct flash_sector_range *range, uint16_t len)
 }
 
 int fcb2_getnext_in_area(struct fcb2 *fcb, struct fcb2_entry *loc);
+int fcb2_new_sector(struct fcb2 *fcb, int cnt);
 
 static inline int
 fcb2_getnext_sector(struct fcb2 *fcb, int sector)
@@ -62,6 +83,16 @@ fcb2_getnext_sector(struct fcb2 *fcb, int sector)
 
 int fcb2_getnext_nolock(struct fcb2 *fcb, struct fcb2_entry *loc);
 
+/* Returned by fcb2_sector_cache_get{next,prev}() when flash must be read. */
+#define FCB2_SECTOR_CACHE_MISS  1
+
+/* fe_entry_num which fcb2_getprev() uses to ask for last entry of sector. */
+#define FCB2_ENTRY_NUM_LAST     UINT16_MAX
+
+int fcb2_sector_cache_getnext(struct fcb2 *fcb, struct fcb2_entry *loc);
+int fcb2_sector_cache_getprev(struct fcb2 *fcb, struct fcb2_entry *loc);
+void fcb2_sector_cache_invalidate(const struct fcb2 *fcb, int sector);
+
 int fcb2_elem_info(struct fcb2_entry *loc);
 int fcb2_elem_crc16(struct fcb2_entry *loc, uint16_t *c16p);
 int fcb2_sector_hdr_init(struct fcb2 *fcb, int sector, uint16_t id);
@@ -118,6 +149,20 @@ int fcb2_write_to_sector(struct fcb2_entry *loc, int off,
  */
 int fcb2_read_from_sector(struct fcb2_entry *loc, int off, void *buf, int len);
 
+/**
+ * @brief Continue a CRC16-CCITT over data in an fcb sector without copying
+ * it out.
+ *
+ * @param loc     location of the sector from fcb2_get_sector_loc().
+ * @param off     offset from the beginning of the sector
+ * @param len     number of bytes to include
+ * @param crc     CRC to continue from; updated on success
+ *
+ * @return 0 if read was successful non zero otherwise.
+ */
+int fcb2_crc16_from_sector(struct fcb2_entry *loc, int off, int len,
+                           uint16_t *crc);
+
 #ifdef __cplusplus
 }
 #endif
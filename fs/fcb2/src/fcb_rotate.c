@@ -61,3 +61,27 @@ out:
     os_mutex_release(&fcb->f_mtx);
     return rc;
 }
+
+int
+fcb2_pre_erase(struct fcb2 *fcb)
+{
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB2_ERR_ARGS;
+    }
+
+    /*
+     * Nothing to do if there's room to move to, or if oldest sector is the
+     * one being written to.
+     */
+    rc = 0;
+    if (fcb2_new_sector(fcb, fcb->f_scratch_cnt) < 0 &&
+        fcb->f_oldest_sec != fcb->f_active.fe_sector) {
+        rc = fcb2_rotate(fcb);
+    }
+
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+
+#include "fcb/fcb2.h"
+#include "fcb_priv.h"
+
+/*
+ * Forget cached entry table for sector. If sector is FCB2_SECTOR_OLDEST,
+ * all tables are dropped.
+ */
+void
+fcb2_sector_cache_invalidate(const struct fcb2 *fcb, int sector)
+{
+    int i;
+
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        if (sector == FCB2_SECTOR_OLDEST ||
+            fcb->f_sector_cache[i].fsc_sector == sector) {
+            fcb->f_sector_cache[i].fsc_valid = 0;
+        }
+    }
+}
+
+/*
+ * Only sectors between the oldest and the active one hold data which does
+ * not change until the sector is rotated out.
+ */
+static int
+fcb2_sector_cache_usable(struct fcb2 *fcb, int sector)
+{
+    int cnt;
+    int pos;
+    int active;
+
+    /*
+     * Positions relative to the oldest sector.
+     */
+    cnt = fcb->f_sector_cnt;
+    pos = (sector - fcb->f_oldest_sec + cnt) % cnt;
+    active = (fcb->f_active.fe_sector - fcb->f_oldest_sec + cnt) % cnt;
+    return pos < active;
+}
+
+/*
+ * Validate all entries within sector, and record their locations.
+ */
+static int
+fcb2_sector_cache_fill(struct fcb2 *fcb, struct fcb2_sector_cache *fsc,
+                       int sector)
+{
+    struct fcb2_entry loc;
+    int rc;
+
+    fsc->fsc_cnt = 0;
+    fsc->fsc_complete = 0;
+    fsc->fsc_uncacheable = 0;
+    fsc->fsc_sector = sector;
+    fsc->fsc_valid = 1;
+
+    loc.fe_range = fcb2_get_sector_range(fcb, sector);
+    loc.fe_sector = sector;
+    loc.fe_entry_num = 1;
+    while (1) {
+        rc = fcb2_elem_info(&loc);
+        if (rc == FCB2_ERR_NOVAR) {
+            fsc->fsc_complete = 1;
+            break;
+        }
+        if (rc) {
+            /*
+             * Bad CRC, or an entry still being written. Don't cache,
+             * and don't try again until the sector is rotated out.
+             */
+            fsc->fsc_cnt = 0;
+            fsc->fsc_uncacheable = 1;
+            return rc;
+        }
+        if (fsc->fsc_cnt == fsc->fsc_max) {
+            break;
+        }
+        fsc->fsc_entries[fsc->fsc_cnt].fsce_data_off = loc.fe_data_off;
+        fsc->fsc_entries[fsc->fsc_cnt].fsce_data_len = loc.fe_data_len;
+        fsc->fsc_cnt++;
+        loc.fe_entry_num++;
+    }
+    return 0;
+}
+
+static struct fcb2_sector_cache *
+fcb2_sector_cache_get(struct fcb2 *fcb, int sector)
+{
+    struct fcb2_sector_cache *fsc;
+    int i;
+
+    if (!fcb->f_sector_cache_cnt) {
+        return NULL;
+    }
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        fsc = &fcb->f_sector_cache[i];
+        if (fsc->fsc_valid && fsc->fsc_sector == sector) {
+            return fsc->fsc_uncacheable ? NULL : fsc;
+        }
+    }
+    if (!fcb2_sector_cache_usable(fcb, sector)) {
+        return NULL;
+    }
+
+    /*
+     * Prefer an unused slot, otherwise reuse them in round robin order.
+     */
+    fsc = NULL;
+    for (i = 0; i < fcb->f_sector_cache_cnt; i++) {
+        if (!fcb->f_sector_cache[i].fsc_valid) {
+            fsc = &fcb->f_sector_cache[i];
+            break;
+        }
+    }
+    if (!fsc) {
+        if (fcb->f_sector_cache_next >= fcb->f_sector_cache_cnt) {
+            fcb->f_sector_cache_next = 0;
+        }
+        fsc = &fcb->f_sector_cache[fcb->f_sector_cache_next++];
+        fsc->fsc_valid = 0;
+    }
+    if (fcb2_sector_cache_fill(fcb, fsc, sector)) {
+        return NULL;
+    }
+    return fsc;
+}
+
+static void
+fcb2_sector_cache_set(struct fcb2_sector_cache *fsc, struct fcb2_entry *loc,
+                      int entry_num)
+{
+    struct fcb2_sector_cache_entry *fsce;
+
+    fsce = &fsc->fsc_entries[entry_num - 1];
+    loc->fe_entry_num = entry_num;
+    loc->fe_data_off = fsce->fsce_data_off;
+    loc->fe_data_len = fsce->fsce_data_len;
+}
+
+/*
+ * Find the entry following loc within loc->fe_sector using the cached
+ * entry table. Returns 0 if found, FCB2_ERR_NOVAR if there are no more
+ * entries in this sector, and FCB2_SECTOR_CACHE_MISS if the answer has to
+ * come from flash.
+ */
+int
+fcb2_sector_cache_getnext(struct fcb2 *fcb, struct fcb2_entry *loc)
+{
+    struct fcb2_sector_cache *fsc;
+
+    fsc = fcb2_sector_cache_get(fcb, loc->fe_sector);
+    if (!fsc) {
+        return FCB2_SECTOR_CACHE_MISS;
+    }
+    if (loc->fe_entry_num < fsc->fsc_cnt) {
+        fcb2_sector_cache_set(fsc, loc, loc->fe_entry_num + 1);
+        return 0;
+    }
+    if (fsc->fsc_complete) {
+        return FCB2_ERR_NOVAR;
+    }
+    return FCB2_SECTOR_CACHE_MISS;
+}
+
+/*
+ * Find the entry preceding loc within loc->fe_sector using the cached
+ * entry table. Return values are as with fcb2_sector_cache_getnext().
+ */
+int
+fcb2_sector_cache_getprev(struct fcb2 *fcb, struct fcb2_entry *loc)
+{
+    struct fcb2_sector_cache *fsc;
+    int entry_num;
+
+    fsc = fcb2_sector_cache_get(fcb, loc->fe_sector);
+    if (!fsc) {
+        return FCB2_SECTOR_CACHE_MISS;
+    }
+    entry_num = loc->fe_entry_num - 1;
+    if (entry_num > fsc->fsc_cnt) {
+        if (!fsc->fsc_complete) {
+            return FCB2_SECTOR_CACHE_MISS;
+        }
+        entry_num = fsc->fsc_cnt;
+    }
+    if (entry_num < 1) {
+        return FCB2_ERR_NOVAR;
+    }
+    fcb2_sector_cache_set(fsc, loc, entry_num);
+    return 0;
+}
@@ -53,6 +53,7 @@ int fs_dirent_name(const struct fs_dirent *, size_t max_len,
   char *out_name, uint8_t *out_name_len);
 int fs_dirent_is_dir(const struct fs_dirent *);
 int fs_flush(struct fs_file *);
+int fs_setbuf(struct fs_file *, uint8_t flags);
 
 /**
  * File access flags.
@@ -62,6 +63,12 @@ int fs_flush(struct fs_file *);
 #define FS_ACCESS_APPEND        0x04
 #define FS_ACCESS_TRUNCATE      0x08
 
+/**
+ * File buffering flags (fs_setbuf).
+ */
+#define FS_BUF_READ             0x01    /* Read-ahead */
+#define FS_BUF_WRITE            0x02    /* Write-behind */
+
 /**
  * File access return codes.
  */
@@ -186,17 +186,48 @@ fops_from_file(const struct fs_file *file)
     return fs_ops_from_container((struct fops_container *) file);
 }
 
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+#define FS_FILE_BUF_DFLT_FLAGS                              \
+    ((MYNEWT_VAL(FS_FILE_READ_AHEAD) ? FS_BUF_READ : 0) |   \
+     (MYNEWT_VAL(FS_FILE_WRITE_BEHIND) ? FS_BUF_WRITE : 0))
+#endif
+
 int
 fs_open(const char *filename, uint8_t access_flags, struct fs_file **out_file)
 {
     struct fs_ops *fops = fops_from_filename(filename);
-    return fops->f_open(filename, access_flags, out_file);
+    int rc;
+
+    rc = fops->f_open(filename, access_flags, out_file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    if (rc == 0 && FS_FILE_BUF_DFLT_FLAGS != 0) {
+        /* Files that do not get a buffer are simply unbuffered. */
+        fs_filebuf_alloc(*out_file, FS_FILE_BUF_DFLT_FLAGS);
+    }
+#endif
+
+    return rc;
 }
 
 int
 fs_close(struct fs_file *file)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+    int rc;
+    int rc2;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        rc = fs_filebuf_sync(fb, fops);
+        fs_filebuf_free(fb);
+
+        rc2 = fops->f_close(file);
+        return rc != 0 ? rc : rc2;
+    }
+#endif
+
     return fops->f_close(file);
 }
 
@@ -204,6 +235,15 @@ int
 fs_read(struct fs_file *file, uint32_t len, void *out_data, uint32_t *out_len)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_read(fb, fops, len, out_data, out_len);
+    }
+#endif
+
     return fops->f_read(file, len, out_data, out_len);
 }
 
@@ -211,6 +251,15 @@ int
 fs_write(struct fs_file *file, const void *data, int len)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_write(fb, fops, data, len);
+    }
+#endif
+
     return fops->f_write(file, data, len);
 }
 
@@ -218,6 +267,15 @@ int
 fs_seek(struct fs_file *file, uint32_t offset)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_seek(fb, fops, offset);
+    }
+#endif
+
     return fops->f_seek(file, offset);
 }
 
@@ -225,6 +283,15 @@ uint32_t
 fs_getpos(const struct fs_file *file)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_getpos(fb, fops);
+    }
+#endif
+
     return fops->f_getpos(file);
 }
 
@@ -232,6 +299,15 @@ int
 fs_filelen(const struct fs_file *file, uint32_t *out_len)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_filelen(fb, fops, out_len);
+    }
+#endif
+
     return fops->f_filelen(file, out_len);
 }
 
@@ -246,5 +322,54 @@ int
 fs_flush(struct fs_file *file)
 {
     struct fs_ops *fops = fops_from_file(file);
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_filebuf *fb;
+    int rc;
+
+    /* Pass pending writes to the backend before asking it to flush. */
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+#endif
+
     return fops->f_flush(file);
 }
+
+/**
+ * Configures buffering for an open file.  Files are initially buffered
+ * according to FS_FILE_READ_AHEAD and FS_FILE_WRITE_BEHIND, provided one of
+ * the FS_FILE_BUF_COUNT buffers is free when the file is opened.
+ *
+ * @param file                  The file to configure.
+ * @param flags                 FS_BUF_[...] flags; 0 disables buffering and
+ *                                  releases the file's buffer.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOMEM if no buffer is available;
+ *                              other nonzero on failure.
+ */
+int
+fs_setbuf(struct fs_file *file, uint8_t flags)
+{
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+    struct fs_ops *fops = fops_from_file(file);
+    struct fs_filebuf *fb;
+
+    fb = fs_filebuf_find(file);
+    if (fb != NULL) {
+        return fs_filebuf_setflags(fb, fops, flags);
+    }
+
+    if (flags != 0 && fs_filebuf_alloc(file, flags) == NULL) {
+        return FS_ENOMEM;
+    }
+
+    return 0;
+#else
+    return flags == 0 ? 0 : FS_ENOMEM;
+#endif
+}
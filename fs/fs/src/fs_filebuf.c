@@ -0,0 +1,359 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Per-file read-ahead / write-behind buffering.
+ *
+ * A small pool of buffers is shared by all open files.  A file that gets a
+ * buffer uses it in one of two modes:
+ *
+ * Read:  The buffer holds file data starting at fb_off.  The backend's file
+ *        position is fb_off + fb_len; the logical position is fb_off + fb_idx.
+ *        Seeks that land inside the buffer do not touch the backend.
+ *
+ * Write: The buffer holds fb_len bytes not yet passed to the backend.  The
+ *        logical position is not tracked, since a file opened for append
+ *        writes at its end regardless of position; fs_getpos() and
+ *        fs_filelen() flush pending writes and ask the backend.
+ *
+ * Before switching modes, or before any operation that needs the backend
+ * position to match the logical one, the buffer is synced: pending writes are
+ * passed to the backend, or a read buffer is discarded and the backend is
+ * seeked back to the logical position.
+ *
+ * The read buffer is not invalidated by writes through other handles to the
+ * same file.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+
+#include <string.h>
+#include "fs/fs.h"
+#include "fs/fs_if.h"
+#include "fs_priv.h"
+
+#define FS_FILEBUF_STATE_EMPTY      0
+#define FS_FILEBUF_STATE_READ       1
+#define FS_FILEBUF_STATE_WRITE      2
+
+struct fs_filebuf {
+    /* File that owns this buffer; NULL if the buffer is free. */
+    struct fs_file *fb_file;
+
+    uint32_t fb_off;
+    uint16_t fb_len;
+    uint16_t fb_idx;
+    uint8_t fb_state;
+
+    /* FS_BUF_[...] */
+    uint8_t fb_flags;
+
+    uint8_t fb_data[MYNEWT_VAL(FS_FILE_BUF_SIZE)];
+};
+
+static struct fs_filebuf fs_filebufs[MYNEWT_VAL(FS_FILE_BUF_COUNT)];
+
+struct fs_filebuf *
+fs_filebuf_find(const struct fs_file *file)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FS_FILE_BUF_COUNT); i++) {
+        if (fs_filebufs[i].fb_file == file) {
+            return &fs_filebufs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Assigns a free buffer to the specified file.
+ *
+ * @return                      The buffer on success; NULL if all buffers are
+ *                                  in use.
+ */
+struct fs_filebuf *
+fs_filebuf_alloc(struct fs_file *file, uint8_t flags)
+{
+    struct fs_filebuf *fb;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    fb = fs_filebuf_find(NULL);
+    if (fb != NULL) {
+        fb->fb_file = file;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (fb != NULL) {
+        fb->fb_state = FS_FILEBUF_STATE_EMPTY;
+        fb->fb_flags = flags;
+    }
+
+    return fb;
+}
+
+void
+fs_filebuf_free(struct fs_filebuf *fb)
+{
+    fb->fb_file = NULL;
+}
+
+/**
+ * Brings the backend's file position in line with the logical position and
+ * empties the buffer.  Pending writes are passed to the backend.
+ *
+ * @return                      0 on success; nonzero on failure.  On failure,
+ *                                  the buffer is emptied regardless.
+ */
+int
+fs_filebuf_sync(struct fs_filebuf *fb, struct fs_ops *fops)
+{
+    int rc;
+
+    rc = 0;
+
+    switch (fb->fb_state) {
+    case FS_FILEBUF_STATE_READ:
+        if (fb->fb_idx != fb->fb_len) {
+            rc = fops->f_seek(fb->fb_file, fb->fb_off + fb->fb_idx);
+        }
+        break;
+
+    case FS_FILEBUF_STATE_WRITE:
+        rc = fops->f_write(fb->fb_file, fb->fb_data, fb->fb_len);
+        break;
+
+    default:
+        break;
+    }
+
+    fb->fb_state = FS_FILEBUF_STATE_EMPTY;
+
+    return rc;
+}
+
+int
+fs_filebuf_read(struct fs_filebuf *fb, struct fs_ops *fops, uint32_t len,
+                void *out_data, uint32_t *out_len)
+{
+    uint32_t total;
+    uint32_t chunk;
+    uint8_t *dst;
+    int rc;
+
+    if (fb->fb_state == FS_FILEBUF_STATE_WRITE) {
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    dst = out_data;
+    total = 0;
+
+    while (len > 0) {
+        if (fb->fb_state == FS_FILEBUF_STATE_READ && fb->fb_idx < fb->fb_len) {
+            chunk = fb->fb_len - fb->fb_idx;
+            if (chunk > len) {
+                chunk = len;
+            }
+            memcpy(dst, fb->fb_data + fb->fb_idx, chunk);
+            fb->fb_idx += chunk;
+            dst += chunk;
+            total += chunk;
+            len -= chunk;
+            continue;
+        }
+
+        /* Buffer exhausted.  Large reads bypass the buffer. */
+        if (!(fb->fb_flags & FS_BUF_READ) || len >= sizeof fb->fb_data) {
+            rc = fs_filebuf_sync(fb, fops);
+            if (rc == 0) {
+                rc = fops->f_read(fb->fb_file, len, dst, &chunk);
+            }
+            if (rc != 0) {
+                return rc;
+            }
+            total += chunk;
+            break;
+        }
+
+        if (fb->fb_state == FS_FILEBUF_STATE_READ) {
+            fb->fb_off += fb->fb_len;
+        } else {
+            fb->fb_off = fops->f_getpos(fb->fb_file);
+        }
+
+        rc = fops->f_read(fb->fb_file, sizeof fb->fb_data, fb->fb_data,
+                          &chunk);
+        if (rc != 0) {
+            fb->fb_state = FS_FILEBUF_STATE_EMPTY;
+            return rc;
+        }
+
+        fb->fb_state = FS_FILEBUF_STATE_READ;
+        fb->fb_len = chunk;
+        fb->fb_idx = 0;
+
+        if (chunk == 0) {
+            /* End of file. */
+            break;
+        }
+    }
+
+    if (out_len != NULL) {
+        *out_len = total;
+    }
+    return 0;
+}
+
+int
+fs_filebuf_write(struct fs_filebuf *fb, struct fs_ops *fops, const void *data,
+                 int len)
+{
+    int rc;
+
+    if (fb->fb_state == FS_FILEBUF_STATE_READ ||
+        (fb->fb_state == FS_FILEBUF_STATE_WRITE &&
+         fb->fb_len + len > sizeof fb->fb_data)) {
+
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Large writes bypass the buffer. */
+    if (!(fb->fb_flags & FS_BUF_WRITE) || len >= sizeof fb->fb_data) {
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+        return fops->f_write(fb->fb_file, data, len);
+    }
+
+    if (fb->fb_state == FS_FILEBUF_STATE_EMPTY) {
+        fb->fb_len = 0;
+        fb->fb_state = FS_FILEBUF_STATE_WRITE;
+    }
+
+    memcpy(fb->fb_data + fb->fb_len, data, len);
+    fb->fb_len += len;
+
+    if (fb->fb_len == sizeof fb->fb_data) {
+        return fs_filebuf_sync(fb, fops);
+    }
+
+    return 0;
+}
+
+int
+fs_filebuf_seek(struct fs_filebuf *fb, struct fs_ops *fops, uint32_t offset)
+{
+    int rc;
+
+    switch (fb->fb_state) {
+    case FS_FILEBUF_STATE_READ:
+        if (offset >= fb->fb_off && offset <= fb->fb_off + fb->fb_len) {
+            fb->fb_idx = offset - fb->fb_off;
+            return 0;
+        }
+
+        /* The backend is about to be seeked anyway; just drop the data. */
+        fb->fb_state = FS_FILEBUF_STATE_EMPTY;
+        break;
+
+    case FS_FILEBUF_STATE_WRITE:
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return fops->f_seek(fb->fb_file, offset);
+}
+
+uint32_t
+fs_filebuf_getpos(struct fs_filebuf *fb, struct fs_ops *fops)
+{
+    switch (fb->fb_state) {
+    case FS_FILEBUF_STATE_READ:
+        return fb->fb_off + fb->fb_idx;
+
+    case FS_FILEBUF_STATE_WRITE:
+        /* fs_getpos() cannot report a failed write; the pending data is
+         * dropped, and the position reflects what the backend holds.
+         */
+        fs_filebuf_sync(fb, fops);
+        return fops->f_getpos(fb->fb_file);
+
+    default:
+        return fops->f_getpos(fb->fb_file);
+    }
+}
+
+int
+fs_filebuf_filelen(struct fs_filebuf *fb, struct fs_ops *fops,
+                   uint32_t *out_len)
+{
+    int rc;
+
+    if (fb->fb_state == FS_FILEBUF_STATE_WRITE) {
+        rc = fs_filebuf_sync(fb, fops);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return fops->f_filelen(fb->fb_file, out_len);
+}
+
+/**
+ * Changes the buffering flags of a buffered file.  Pending writes are
+ * flushed to the backend first.  If all flags are cleared, the buffer is
+ * released.
+ */
+int
+fs_filebuf_setflags(struct fs_filebuf *fb, struct fs_ops *fops, uint8_t flags)
+{
+    int rc;
+
+    rc = fs_filebuf_sync(fb, fops);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (flags == 0) {
+        fs_filebuf_free(fb);
+    } else {
+        fb->fb_flags = flags;
+    }
+
+    return 0;
+}
+
+#endif
@@ -33,6 +33,26 @@ struct fs_ops *safe_fs_ops_for(const char *fs_name);
 void fs_cli_init(void);
 #endif
 
+#if MYNEWT_VAL(FS_FILE_BUF_COUNT) > 0
+struct fs_file;
+struct fs_filebuf;
+struct fs_filebuf *fs_filebuf_find(const struct fs_file *file);
+struct fs_filebuf *fs_filebuf_alloc(struct fs_file *file, uint8_t flags);
+void fs_filebuf_free(struct fs_filebuf *fb);
+int fs_filebuf_sync(struct fs_filebuf *fb, struct fs_ops *fops);
+int fs_filebuf_read(struct fs_filebuf *fb, struct fs_ops *fops, uint32_t len,
+                    void *out_data, uint32_t *out_len);
+int fs_filebuf_write(struct fs_filebuf *fb, struct fs_ops *fops,
+                     const void *data, int len);
+int fs_filebuf_seek(struct fs_filebuf *fb, struct fs_ops *fops,
+                    uint32_t offset);
+uint32_t fs_filebuf_getpos(struct fs_filebuf *fb, struct fs_ops *fops);
+int fs_filebuf_filelen(struct fs_filebuf *fb, struct fs_ops *fops,
+                       uint32_t *out_len);
+int fs_filebuf_setflags(struct fs_filebuf *fb, struct fs_ops *fops,
+                        uint8_t flags);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
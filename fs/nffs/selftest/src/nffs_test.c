@@ -99,6 +99,8 @@ TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_ckpt)
+TEST_CASE_DECL(nffs_test_small_records)
 TEST_CASE_DECL(nffs_test_cache_large_file)
 
 static void
@@ -129,6 +131,8 @@ nffs_test_basic_cases(void)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_ckpt();
+    nffs_test_small_records();
 }
 
 TEST_SUITE(nffs_test_suite_1_1)
@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_ckpt)
+{
+    int rc;
+
+    static const struct nffs_area_desc area_descs_two[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0, 0 },
+    };
+    static const struct nffs_area_desc ckpt_descs[] = {
+        { 0x00060000, 128 * 1024 },
+        { 0x00080000, 128 * 1024 },
+        { 0, 0 },
+    };
+    nffs_current_area_descs = (struct nffs_area_desc*)area_descs_two;
+
+    rc = nffs_checkpoint_config(ckpt_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Setup. */
+    rc = nffs_format(area_descs_two);
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/mydir/a.txt", "aaaa", 4);
+    nffs_test_util_create_file("/myfile.txt", "contents", 8);
+    nffs_test_util_append_file("/myfile.txt", "-more", 5);
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+
+    /* Write some more data after the checkpoint was taken. */
+    nffs_test_util_create_file("/mydir/b.txt", "bbbbbb", 6);
+    rc = fs_unlink("/mydir/a.txt");
+    TEST_ASSERT(rc == 0);
+
+    /* Ensure detect uses the checkpoint and replays the newer objects. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_ckpt_restored);
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "b.txt",
+                    .contents = "bbbbbb",
+                    .contents_len = 6,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = "myfile.txt",
+                .contents = "contents-more",
+                .contents_len = 13,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_assert_system(expected_system, area_descs_two);
+
+    /* Garbage collection invalidates the checkpoint; detect must fall back to
+     * a full scan.
+     */
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!nffs_ckpt_restored);
+
+    nffs_test_assert_system(expected_system, area_descs_two);
+
+    rc = nffs_checkpoint_config(NULL);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_REC_SZ        16
+#define NFFS_TEST_REC_CNT       256
+
+static void
+nffs_test_small_records_fill(uint8_t *rec, int idx)
+{
+    int i;
+
+    for (i = 0; i < NFFS_TEST_REC_SZ; i++) {
+        rec[i] = idx + i;
+    }
+}
+
+/**
+ * Writes and reads back a file one small record at a time, then re-reads it
+ * the way sys/config does: seek to the start of a record and read a large
+ * chunk, of which only one record is used.
+ *
+ * @return                      Elapsed time, in microseconds.
+ */
+static uint32_t
+nffs_test_small_records_run(uint8_t buf_flags)
+{
+    struct fs_file *file;
+    uint8_t expected[NFFS_TEST_REC_SZ];
+    uint8_t rec[NFFS_TEST_REC_SZ * 8];
+    uint32_t bytes_read;
+    uint32_t len;
+    int64_t start;
+    int rc;
+    int i;
+
+    start = os_get_uptime_usec();
+
+    rc = fs_open("/records", FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_setbuf(file, buf_flags);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < NFFS_TEST_REC_CNT; i++) {
+        nffs_test_small_records_fill(rec, i);
+        rc = fs_write(file, rec, NFFS_TEST_REC_SZ);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = fs_filelen(file, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == NFFS_TEST_REC_CNT * NFFS_TEST_REC_SZ);
+
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_open("/records", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_setbuf(file, buf_flags);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < NFFS_TEST_REC_CNT; i++) {
+        nffs_test_small_records_fill(expected, i);
+        rc = fs_read(file, NFFS_TEST_REC_SZ, rec, &bytes_read);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(bytes_read == NFFS_TEST_REC_SZ);
+        TEST_ASSERT(memcmp(rec, expected, NFFS_TEST_REC_SZ) == 0);
+    }
+
+    rc = fs_read(file, NFFS_TEST_REC_SZ, rec, &bytes_read);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(bytes_read == 0);
+
+    for (i = 0; i < NFFS_TEST_REC_CNT; i++) {
+        nffs_test_small_records_fill(expected, i);
+        rc = fs_seek(file, i * NFFS_TEST_REC_SZ);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_read(file, sizeof rec, rec, &bytes_read);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(bytes_read >= NFFS_TEST_REC_SZ);
+        TEST_ASSERT(memcmp(rec, expected, NFFS_TEST_REC_SZ) == 0);
+    }
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    return os_get_uptime_usec() - start;
+}
+
+TEST_CASE_SELF(nffs_test_small_records)
+{
+    uint32_t buffered;
+    uint32_t unbuffered;
+    int rc;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    unbuffered = nffs_test_small_records_run(0);
+    buffered = nffs_test_small_records_run(FS_BUF_READ | FS_BUF_WRITE);
+
+    TEST_PASS("small records: unbuffered=%lu us buffered=%lu us",
+              (unsigned long)unbuffered, (unsigned long)buffered);
+}
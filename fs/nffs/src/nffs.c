@@ -57,6 +57,10 @@ struct nffs_inode_entry *nffs_lost_found_dir;
 
 static struct os_mutex nffs_mutex;
 
+#if MYNEWT_VAL(NFFS_CKPT) && MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS) > 0
+static struct os_callout nffs_ckpt_timer;
+#endif
+
 static int nffs_open(const char *path, uint8_t access_flags,
   struct fs_file **out_file);
 static int nffs_close(struct fs_file *fs_file);
@@ -123,6 +127,7 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_readcnt_ckpt)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -687,6 +692,81 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+/**
+ * Configures the flash regions used to hold checkpoints of the file system.
+ * This must be called before nffs_detect() for the checkpoint to be used on
+ * detect.
+ *
+ * @param slot_descs        Up to two regions, terminated by a 0-length entry.
+ *                              Each region must consist of whole flash
+ *                              sectors, and must not overlap the nffs areas.
+ *                              Pass NULL to disable checkpoints.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_checkpoint_config(const struct nffs_area_desc *slot_descs)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_ckpt_config(slot_descs);
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Writes a checkpoint of the file system.  On the next detect, the checkpoint
+ * is loaded in place of a full scan of the flash contents; only objects
+ * written after the checkpoint need to be read.  Nothing is written if the
+ * file system has not changed since the last checkpoint.
+ *
+ * @return                  0 on success;
+ *                          FS_EACCESS if an unlinked file is still open;
+ *                          other nonzero on failure.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_ckpt_write();
+    nffs_unlock();
+
+    return rc;
+}
+
+#if MYNEWT_VAL(NFFS_CKPT)
+#if MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS) > 0
+static void
+nffs_ckpt_timer_exp(struct os_event *ev)
+{
+    os_time_t ticks;
+    int rc;
+
+    /* Failure is not fatal; the next detect falls back to a full scan. */
+    nffs_checkpoint();
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS), &ticks);
+    assert(rc == 0);
+    os_callout_reset(&nffs_ckpt_timer, ticks);
+}
+#endif
+
+/**
+ * Called on system shutdown.  Writes a checkpoint so that the next boot does
+ * not need to scan the file system.
+ */
+int
+nffs_ckpt_sysdown(int reason)
+{
+    nffs_checkpoint();
+    return 0;
+}
+#endif
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -772,6 +852,12 @@ void
 nffs_pkg_init(void)
 {
     struct nffs_area_desc descs[MYNEWT_VAL(NFFS_NUM_AREAS) + 1];
+#if MYNEWT_VAL(NFFS_CKPT)
+    struct nffs_area_desc ckpt_descs[NFFS_CKPT_MAX_SLOTS + 1];
+#if MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS) > 0
+    os_time_t ticks;
+#endif
+#endif
     int cnt;
     int rc;
 
@@ -790,6 +876,19 @@ nffs_pkg_init(void)
         MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CKPT)
+    /* Split the checkpoint flash area into two independently erasable
+     * slots.
+     */
+    cnt = NFFS_CKPT_MAX_SLOTS;
+    rc = nffs_misc_desc_from_flash_area(
+        MYNEWT_VAL(NFFS_CKPT_FLASH_AREA), &cnt, ckpt_descs);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = nffs_checkpoint_config(ckpt_descs);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
     switch (rc) {
@@ -819,4 +918,12 @@ nffs_pkg_init(void)
         SYSINIT_PANIC();
         break;
     }
+
+#if MYNEWT_VAL(NFFS_CKPT) && MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS) > 0
+    os_callout_init(&nffs_ckpt_timer, os_eventq_dflt_get(),
+                    nffs_ckpt_timer_exp, NULL);
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(NFFS_CKPT_INTERVAL_MS), &ticks);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    os_callout_reset(&nffs_ckpt_timer, ticks);
+#endif
 }
@@ -0,0 +1,838 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Checkpoints: a compact snapshot of the RAM representation (hash table and
+ * directory tree) written to a dedicated region of flash.  On detect, a valid
+ * checkpoint is loaded instead of scanning every object in every area; only
+ * the objects appended to each area after the checkpoint was taken are
+ * replayed.
+ *
+ * A checkpoint is only usable while the areas it describes have not been
+ * garbage collected.  The first garbage collection cycle that follows a
+ * checkpoint erases it; the area IDs and GC sequence numbers recorded in the
+ * checkpoint are checked on load as a second line of defence.
+ *
+ * Checkpoints alternate between up to two slots.  Each checkpoint carries a
+ * sequence number; on load, the valid checkpoint with the greatest sequence
+ * number is used.  The header, which contains the CRC, is written last so a
+ * checkpoint interrupted by a reset is never considered valid.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_flash.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+#define NFFS_CKPT_BUF_SZ    128
+
+/** Flash regions holding the checkpoint slots. */
+static struct nffs_area_desc nffs_ckpt_slots[NFFS_CKPT_MAX_SLOTS];
+uint8_t nffs_ckpt_num_slots;
+
+/** Index of the slot holding the most recent checkpoint; -1 if none. */
+static int nffs_ckpt_cur_slot;
+static uint32_t nffs_ckpt_cur_seq;
+
+/**
+ * Set if a slot may contain a valid checkpoint.  Cleared once the slots have
+ * been erased.
+ */
+static uint8_t nffs_ckpt_present;
+
+/**
+ * Signature of the area cursors at the time the current checkpoint was taken;
+ * used to skip writing a checkpoint identical to the current one.
+ */
+static uint16_t nffs_ckpt_cur_sig;
+
+/** Set if the most recent detect was served from a checkpoint. */
+uint8_t nffs_ckpt_restored;
+
+static uint8_t nffs_ckpt_buf[NFFS_CKPT_BUF_SZ];
+
+/** Buffered sequential access to a checkpoint slot. */
+struct nffs_ckpt_stream {
+    const struct nffs_area_desc *ncs_slot;
+    uint32_t ncs_off;       /* Slot offset of the start of the buffer. */
+    uint16_t ncs_buf_off;   /* Read/write position within the buffer. */
+    uint16_t ncs_buf_len;   /* Number of valid bytes in the buffer. */
+    uint16_t ncs_crc;       /* CRC of all bytes streamed so far. */
+};
+
+static void
+nffs_ckpt_stream_init(struct nffs_ckpt_stream *stream, int slot_idx)
+{
+    stream->ncs_slot = nffs_ckpt_slots + slot_idx;
+    stream->ncs_off = sizeof (struct nffs_disk_ckpt);
+    stream->ncs_buf_off = 0;
+    stream->ncs_buf_len = 0;
+    stream->ncs_crc = CRC16_INITIAL_CRC;
+}
+
+static int
+nffs_ckpt_stream_read(struct nffs_ckpt_stream *stream, void *dst, int len)
+{
+    uint32_t chunk_len;
+    int rc;
+
+    assert(len <= NFFS_CKPT_BUF_SZ);
+
+    if (stream->ncs_buf_off + len > stream->ncs_buf_len) {
+        stream->ncs_off += stream->ncs_buf_off;
+        stream->ncs_buf_off = 0;
+
+        chunk_len = stream->ncs_slot->nad_length - stream->ncs_off;
+        if (chunk_len > NFFS_CKPT_BUF_SZ) {
+            chunk_len = NFFS_CKPT_BUF_SZ;
+        }
+        if (chunk_len < len) {
+            return FS_ECORRUPT;
+        }
+
+        STATS_INC(nffs_stats, nffs_readcnt_ckpt);
+        rc = hal_flash_read(stream->ncs_slot->nad_flash_id,
+                            stream->ncs_slot->nad_offset + stream->ncs_off,
+                            nffs_ckpt_buf, chunk_len);
+        if (rc != 0) {
+            return FS_EHW;
+        }
+        stream->ncs_buf_len = chunk_len;
+    }
+
+    memcpy(dst, nffs_ckpt_buf + stream->ncs_buf_off, len);
+    stream->ncs_buf_off += len;
+    stream->ncs_crc = crc16_ccitt(stream->ncs_crc, dst, len);
+
+    return 0;
+}
+
+static int
+nffs_ckpt_stream_flush(struct nffs_ckpt_stream *stream)
+{
+    int rc;
+
+    if (stream->ncs_buf_off == 0) {
+        return 0;
+    }
+
+    STATS_INC(nffs_stats, nffs_iocnt_write);
+    rc = hal_flash_write(stream->ncs_slot->nad_flash_id,
+                         stream->ncs_slot->nad_offset + stream->ncs_off,
+                         nffs_ckpt_buf, stream->ncs_buf_off);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    stream->ncs_off += stream->ncs_buf_off;
+    stream->ncs_buf_off = 0;
+
+    return 0;
+}
+
+static int
+nffs_ckpt_stream_write(struct nffs_ckpt_stream *stream, const void *src,
+                       int len)
+{
+    int rc;
+
+    assert(len <= NFFS_CKPT_BUF_SZ);
+
+    if (stream->ncs_off + stream->ncs_buf_off + len >
+        stream->ncs_slot->nad_length) {
+
+        return FS_EFULL;
+    }
+
+    if (stream->ncs_buf_off + len > NFFS_CKPT_BUF_SZ) {
+        rc = nffs_ckpt_stream_flush(stream);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    memcpy(nffs_ckpt_buf + stream->ncs_buf_off, src, len);
+    stream->ncs_buf_off += len;
+    stream->ncs_crc = crc16_ccitt(stream->ncs_crc, src, len);
+
+    return 0;
+}
+
+/**
+ * Computes a signature of the current area layout and write positions.  Two
+ * identical signatures indicate that nothing was written in between.
+ */
+static uint16_t
+nffs_ckpt_area_sig(void)
+{
+    struct nffs_disk_ckpt_area disk_area;
+    uint16_t crc;
+    int i;
+
+    crc = CRC16_INITIAL_CRC;
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_ckpt_area_to_disk(nffs_areas + i, &disk_area);
+        crc = crc16_ccitt(crc, &disk_area, sizeof disk_area);
+    }
+
+    return crc;
+}
+
+void
+nffs_ckpt_area_to_disk(const struct nffs_area *area,
+                       struct nffs_disk_ckpt_area *out_disk_area)
+{
+    memset(out_disk_area, 0, sizeof *out_disk_area);
+    out_disk_area->ndca_offset = area->na_offset;
+    out_disk_area->ndca_length = area->na_length;
+    out_disk_area->ndca_cur = area->na_cur;
+    out_disk_area->ndca_id = area->na_id;
+    out_disk_area->ndca_gc_seq = area->na_gc_seq;
+    out_disk_area->ndca_flash_id = area->na_flash_id;
+}
+
+/**
+ * Reads and validates the checkpoint in the specified slot.  The entire
+ * checkpoint body is read to verify the CRC; the RAM representation is not
+ * modified.
+ *
+ * @param slot_idx              The slot to read.
+ * @param out_disk_ckpt         On success, the checkpoint header gets written
+ *                                  here.
+ *
+ * @return                      0 if the slot contains a valid checkpoint;
+ *                              FS_ECORRUPT if it does not;
+ *                              other nonzero on error.
+ */
+static int
+nffs_ckpt_read_hdr(int slot_idx, struct nffs_disk_ckpt *out_disk_ckpt)
+{
+    struct nffs_disk_ckpt_inode disk_inode;
+    struct nffs_disk_ckpt_block disk_block;
+    struct nffs_disk_ckpt_area disk_area;
+    struct nffs_ckpt_stream stream;
+    const struct nffs_area_desc *slot;
+    uint32_t i;
+    int rc;
+
+    slot = nffs_ckpt_slots + slot_idx;
+
+    STATS_INC(nffs_stats, nffs_readcnt_ckpt);
+    rc = hal_flash_read(slot->nad_flash_id, slot->nad_offset,
+                        out_disk_ckpt, sizeof *out_disk_ckpt);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    if (out_disk_ckpt->ndc_magic != NFFS_CKPT_MAGIC ||
+        out_disk_ckpt->ndc_ver != NFFS_CKPT_VER) {
+
+        return FS_ECORRUPT;
+    }
+
+    nffs_ckpt_stream_init(&stream, slot_idx);
+    for (i = 0; i < out_disk_ckpt->ndc_num_areas; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    for (i = 0; i < out_disk_ckpt->ndc_num_inodes; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_inode, sizeof disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    for (i = 0; i < out_disk_ckpt->ndc_num_blocks; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_block, sizeof disk_block);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (crc16_ccitt(stream.ncs_crc, out_disk_ckpt,
+                    NFFS_DISK_CKPT_OFFSET_CRC) != out_disk_ckpt->ndc_crc16) {
+
+        return FS_ECORRUPT;
+    }
+
+    return 0;
+}
+
+/**
+ * Erases every checkpoint slot.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_erase(void)
+{
+    const struct nffs_area_desc *slot;
+    int rc;
+    int i;
+
+    for (i = 0; i < nffs_ckpt_num_slots; i++) {
+        slot = nffs_ckpt_slots + i;
+        rc = hal_flash_erase(slot->nad_flash_id, slot->nad_offset,
+                             slot->nad_length);
+        if (rc != 0) {
+            return FS_EHW;
+        }
+    }
+
+    nffs_ckpt_present = 0;
+    nffs_ckpt_cur_slot = -1;
+
+    return 0;
+}
+
+/**
+ * Invalidates the current checkpoint, if any.  This must be called before any
+ * operation that rewrites an area other than by appending to it (i.e.,
+ * garbage collection).
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_invalidate(void)
+{
+    if (!nffs_ckpt_present) {
+        return 0;
+    }
+
+    return nffs_ckpt_erase();
+}
+
+/**
+ * Writes the inode records for the children of the specified directory.
+ * Children are written in list order so that the sorted child lists can be
+ * rebuilt on load without comparing filenames.
+ */
+static int
+nffs_ckpt_write_children(struct nffs_ckpt_stream *stream,
+                         struct nffs_inode_entry *dir, uint32_t *num_inodes)
+{
+    struct nffs_disk_ckpt_inode disk_inode;
+    struct nffs_inode_entry *child;
+    int rc;
+
+    SLIST_FOREACH(child, &dir->nie_child_list, nie_sibling_next) {
+        memset(&disk_inode, 0, sizeof disk_inode);
+        disk_inode.ndci_id = child->nie_hash_entry.nhe_id;
+        disk_inode.ndci_flash_loc = child->nie_hash_entry.nhe_flash_loc;
+        disk_inode.ndci_parent_id = dir->nie_hash_entry.nhe_id;
+        if (nffs_hash_id_is_file(child->nie_hash_entry.nhe_id) &&
+            child->nie_last_block_entry != NULL) {
+
+            disk_inode.ndci_lastblock_id =
+                child->nie_last_block_entry->nhe_id;
+        } else {
+            disk_inode.ndci_lastblock_id = NFFS_ID_NONE;
+        }
+
+        rc = nffs_ckpt_stream_write(stream, &disk_inode, sizeof disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+        (*num_inodes)++;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a checkpoint of the current RAM representation.  Nothing is written
+ * if the file system has not changed since the last checkpoint.
+ *
+ * @return                      0 on success;
+ *                              FS_EACCESS if an unlinked file is still open;
+ *                              FS_EFULL if the checkpoint does not fit in a
+ *                                  slot;
+ *                              other nonzero on error.
+ */
+int
+nffs_ckpt_write(void)
+{
+    struct nffs_disk_ckpt_inode disk_inode;
+    struct nffs_disk_ckpt_block disk_block;
+    struct nffs_disk_ckpt_area disk_area;
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_ckpt_stream stream;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_disk_ckpt disk_ckpt;
+    const struct nffs_area_desc *slot;
+    uint32_t num_inodes;
+    uint32_t num_blocks;
+    uint16_t largest_data_len;
+    uint16_t sig;
+    int slot_idx;
+    int rc;
+    int i;
+
+    if (nffs_ckpt_num_slots == 0) {
+        return 0;
+    }
+
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    sig = nffs_ckpt_area_sig();
+    if (nffs_ckpt_cur_slot != -1 && sig == nffs_ckpt_cur_sig) {
+        return 0;
+    }
+
+    /* Every inode must be reachable from the root directory.  An unlinked file
+     * that is still open cannot be captured: its blocks cannot be told apart
+     * from live ones without reading them from flash.
+     */
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_entry_is_dummy(entry)) {
+            return FS_EUNEXP;
+        }
+        if (nffs_hash_id_is_inode(entry->nhe_id)) {
+            inode_entry = (struct nffs_inode_entry *)entry;
+            if (inode_entry != nffs_root_dir &&
+                !nffs_inode_getflags(inode_entry, NFFS_INODE_FLAG_INTREE)) {
+
+                return FS_EACCESS;
+            }
+        }
+    }
+
+    /* Alternate between slots so that the previous checkpoint survives a
+     * reset during the write.
+     */
+    if (nffs_ckpt_cur_slot == -1) {
+        slot_idx = 0;
+    } else {
+        slot_idx = (nffs_ckpt_cur_slot + 1) % nffs_ckpt_num_slots;
+    }
+    slot = nffs_ckpt_slots + slot_idx;
+
+    rc = hal_flash_erase(slot->nad_flash_id, slot->nad_offset,
+                         slot->nad_length);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+    if (slot_idx == nffs_ckpt_cur_slot) {
+        nffs_ckpt_cur_slot = -1;
+    }
+    nffs_ckpt_present = 1;
+
+    nffs_ckpt_stream_init(&stream, slot_idx);
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_ckpt_area_to_disk(nffs_areas + i, &disk_area);
+        rc = nffs_ckpt_stream_write(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Root directory first, then the children of each directory. */
+    memset(&disk_inode, 0, sizeof disk_inode);
+    disk_inode.ndci_id = nffs_root_dir->nie_hash_entry.nhe_id;
+    disk_inode.ndci_flash_loc = nffs_root_dir->nie_hash_entry.nhe_flash_loc;
+    disk_inode.ndci_parent_id = NFFS_ID_NONE;
+    disk_inode.ndci_lastblock_id = NFFS_ID_NONE;
+    rc = nffs_ckpt_stream_write(&stream, &disk_inode, sizeof disk_inode);
+    if (rc != 0) {
+        return rc;
+    }
+    num_inodes = 1;
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_id_is_dir(entry->nhe_id)) {
+            rc = nffs_ckpt_write_children(&stream,
+                                          (struct nffs_inode_entry *)entry,
+                                          &num_inodes);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    num_blocks = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_id_is_block(entry->nhe_id)) {
+            memset(&disk_block, 0, sizeof disk_block);
+            disk_block.ndcb_id = entry->nhe_id;
+            disk_block.ndcb_flash_loc = entry->nhe_flash_loc;
+            rc = nffs_ckpt_stream_write(&stream, &disk_block,
+                                        sizeof disk_block);
+            if (rc != 0) {
+                return rc;
+            }
+            num_blocks++;
+        }
+    }
+
+    rc = nffs_ckpt_stream_flush(&stream);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* The maximum block size is never lowered below the largest existing
+     * block, so the current maximum is a safe bound on restore.
+     */
+    largest_data_len = nffs_block_max_data_sz;
+
+    memset(&disk_ckpt, 0, sizeof disk_ckpt);
+    disk_ckpt.ndc_magic = NFFS_CKPT_MAGIC;
+    disk_ckpt.ndc_seq = nffs_ckpt_cur_seq + 1;
+    disk_ckpt.ndc_next_file_id = nffs_hash_next_file_id;
+    disk_ckpt.ndc_next_dir_id = nffs_hash_next_dir_id;
+    disk_ckpt.ndc_next_block_id = nffs_hash_next_block_id;
+    disk_ckpt.ndc_num_inodes = num_inodes;
+    disk_ckpt.ndc_num_blocks = num_blocks;
+    disk_ckpt.ndc_largest_block_data_len = largest_data_len;
+    disk_ckpt.ndc_ver = NFFS_CKPT_VER;
+    disk_ckpt.ndc_num_areas = nffs_num_areas;
+    disk_ckpt.ndc_crc16 = crc16_ccitt(stream.ncs_crc, &disk_ckpt,
+                                      NFFS_DISK_CKPT_OFFSET_CRC);
+
+    STATS_INC(nffs_stats, nffs_iocnt_write);
+    rc = hal_flash_write(slot->nad_flash_id, slot->nad_offset, &disk_ckpt,
+                         sizeof disk_ckpt);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    nffs_ckpt_cur_slot = slot_idx;
+    nffs_ckpt_cur_seq = disk_ckpt.ndc_seq;
+    nffs_ckpt_cur_sig = sig;
+
+    return 0;
+}
+
+/**
+ * Inserts an inode entry read from a checkpoint into the hash table.  The
+ * entry is not linked into the directory tree yet.
+ */
+static int
+nffs_ckpt_restore_inode(const struct nffs_disk_ckpt_inode *disk_inode)
+{
+    struct nffs_inode_entry *inode_entry;
+
+    if (!nffs_hash_id_is_inode(disk_inode->ndci_id) ||
+        nffs_hash_find(disk_inode->ndci_id) != NULL) {
+
+        return FS_ECORRUPT;
+    }
+
+    inode_entry = nffs_inode_entry_alloc();
+    if (inode_entry == NULL) {
+        return FS_ENOMEM;
+    }
+
+    inode_entry->nie_hash_entry.nhe_id = disk_inode->ndci_id;
+    inode_entry->nie_hash_entry.nhe_flash_loc = disk_inode->ndci_flash_loc;
+    inode_entry->nie_refcnt = 1;
+    if (nffs_hash_id_is_dir(disk_inode->ndci_id)) {
+        SLIST_INIT(&inode_entry->nie_child_list);
+    } else {
+        inode_entry->nie_last_block_entry = NULL;
+    }
+
+    nffs_hash_insert(&inode_entry->nie_hash_entry);
+
+    return 0;
+}
+
+static int
+nffs_ckpt_restore_block(const struct nffs_disk_ckpt_block *disk_block)
+{
+    struct nffs_hash_entry *entry;
+
+    if (!nffs_hash_id_is_block(disk_block->ndcb_id) ||
+        nffs_hash_find(disk_block->ndcb_id) != NULL) {
+
+        return FS_ECORRUPT;
+    }
+
+    entry = nffs_block_entry_alloc();
+    if (entry == NULL) {
+        return FS_ENOMEM;
+    }
+
+    entry->nhe_id = disk_block->ndcb_id;
+    entry->nhe_flash_loc = disk_block->ndcb_flash_loc;
+    nffs_hash_insert(entry);
+
+    return 0;
+}
+
+/**
+ * Links an inode restored from a checkpoint to its parent directory and, if
+ * it is a file, to its last data block.
+ *
+ * @param disk_inode            The checkpoint record of the inode to link.
+ * @param prev_sibling          The most recently linked inode; children of a
+ *                                  directory are contiguous in a checkpoint,
+ *                                  so this is the new inode's predecessor if
+ *                                  they share a parent.
+ */
+static int
+nffs_ckpt_link_inode(const struct nffs_disk_ckpt_inode *disk_inode,
+                     struct nffs_inode_entry **prev_sibling,
+                     uint32_t *prev_parent_id)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *parent;
+
+    inode_entry = nffs_hash_find_inode(disk_inode->ndci_id);
+    assert(inode_entry != NULL);
+
+    if (nffs_hash_id_is_file(disk_inode->ndci_id) &&
+        disk_inode->ndci_lastblock_id != NFFS_ID_NONE) {
+
+        inode_entry->nie_last_block_entry =
+            nffs_hash_find_block(disk_inode->ndci_lastblock_id);
+        if (inode_entry->nie_last_block_entry == NULL) {
+            return FS_ECORRUPT;
+        }
+    }
+
+    if (disk_inode->ndci_parent_id == NFFS_ID_NONE) {
+        if (disk_inode->ndci_id != NFFS_ID_ROOT_DIR) {
+            return FS_ECORRUPT;
+        }
+        nffs_root_dir = inode_entry;
+        nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+        return 0;
+    }
+
+    parent = nffs_hash_find_inode(disk_inode->ndci_parent_id);
+    if (parent == NULL || !nffs_hash_id_is_dir(disk_inode->ndci_parent_id)) {
+        return FS_ECORRUPT;
+    }
+
+    if (*prev_sibling != NULL && *prev_parent_id == disk_inode->ndci_parent_id) {
+        SLIST_INSERT_AFTER(*prev_sibling, inode_entry, nie_sibling_next);
+    } else {
+        if (!SLIST_EMPTY(&parent->nie_child_list)) {
+            return FS_ECORRUPT;
+        }
+        SLIST_INSERT_HEAD(&parent->nie_child_list, inode_entry,
+                          nie_sibling_next);
+    }
+    nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+
+    *prev_sibling = inode_entry;
+    *prev_parent_id = disk_inode->ndci_parent_id;
+
+    return 0;
+}
+
+/**
+ * Loads the most recent valid checkpoint into the RAM representation.  The
+ * areas must already have been detected (nffs_areas populated from the area
+ * headers) and the hash table must be empty.  On success, the write position
+ * of each area is set to the position recorded in the checkpoint; objects
+ * beyond that position need to be replayed by the caller.
+ *
+ * @param out_largest_block_data_len    On success, the size of the largest
+ *                                          data block in the checkpoint gets
+ *                                          written here.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no usable checkpoint;
+ *                              FS_ECORRUPT if the checkpoint is invalid;
+ *                              other nonzero on error.  On failure, the RAM
+ *                              representation must be reset by the caller.
+ */
+int
+nffs_ckpt_restore(uint16_t *out_largest_block_data_len)
+{
+    struct nffs_disk_ckpt_inode disk_inode;
+    struct nffs_disk_ckpt_block disk_block;
+    struct nffs_disk_ckpt_area disk_area;
+    struct nffs_disk_ckpt_area cur_area;
+    struct nffs_inode_entry *prev_sibling;
+    struct nffs_ckpt_stream stream;
+    struct nffs_disk_ckpt disk_ckpt;
+    struct nffs_disk_ckpt tmp_ckpt;
+    uint32_t prev_parent_id;
+    uint32_t inodes_off;
+    uint32_t i;
+    int slot_idx;
+    int rc;
+
+    nffs_ckpt_restored = 0;
+
+    /* Select the valid checkpoint with the greatest sequence number. */
+    slot_idx = -1;
+    for (i = 0; i < nffs_ckpt_num_slots; i++) {
+        rc = nffs_ckpt_read_hdr(i, &tmp_ckpt);
+        if (rc == FS_ECORRUPT) {
+            continue;
+        }
+        if (rc != 0) {
+            return rc;
+        }
+        if (slot_idx == -1 || tmp_ckpt.ndc_seq > disk_ckpt.ndc_seq) {
+            slot_idx = i;
+            disk_ckpt = tmp_ckpt;
+        }
+    }
+    if (slot_idx == -1) {
+        return FS_ENOENT;
+    }
+
+    /* The checkpoint only applies to the exact set of areas it was taken
+     * from, none of which may have been garbage collected since.
+     */
+    if (disk_ckpt.ndc_num_areas != nffs_num_areas) {
+        return FS_ENOENT;
+    }
+
+    nffs_ckpt_stream_init(&stream, slot_idx);
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+
+        nffs_ckpt_area_to_disk(nffs_areas + i, &cur_area);
+        if (disk_area.ndca_offset != cur_area.ndca_offset ||
+            disk_area.ndca_length != cur_area.ndca_length ||
+            disk_area.ndca_flash_id != cur_area.ndca_flash_id ||
+            disk_area.ndca_id != cur_area.ndca_id ||
+            disk_area.ndca_gc_seq != cur_area.ndca_gc_seq ||
+            disk_area.ndca_cur > disk_area.ndca_length) {
+
+            return FS_ENOENT;
+        }
+    }
+    inodes_off = stream.ncs_off + stream.ncs_buf_off;
+
+    /* Insert every object into the hash table. */
+    for (i = 0; i < disk_ckpt.ndc_num_inodes; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_inode, sizeof disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = nffs_ckpt_restore_inode(&disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    for (i = 0; i < disk_ckpt.ndc_num_blocks; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_block, sizeof disk_block);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = nffs_ckpt_restore_block(&disk_block);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Now that all objects are present, rebuild the directory tree. */
+    nffs_ckpt_stream_init(&stream, slot_idx);
+    stream.ncs_off = inodes_off;
+    prev_sibling = NULL;
+    prev_parent_id = NFFS_ID_NONE;
+    for (i = 0; i < disk_ckpt.ndc_num_inodes; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_inode, sizeof disk_inode);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = nffs_ckpt_link_inode(&disk_inode, &prev_sibling,
+                                  &prev_parent_id);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (nffs_root_dir == NULL) {
+        return FS_ECORRUPT;
+    }
+
+    /* Resume each area at the position recorded in the checkpoint. */
+    nffs_ckpt_stream_init(&stream, slot_idx);
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_ckpt_stream_read(&stream, &disk_area, sizeof disk_area);
+        if (rc != 0) {
+            return rc;
+        }
+        if (i != nffs_scratch_area_idx) {
+            nffs_areas[i].na_cur = disk_area.ndca_cur;
+        }
+    }
+
+    nffs_hash_next_file_id = disk_ckpt.ndc_next_file_id;
+    nffs_hash_next_dir_id = disk_ckpt.ndc_next_dir_id;
+    nffs_hash_next_block_id = disk_ckpt.ndc_next_block_id;
+    *out_largest_block_data_len = disk_ckpt.ndc_largest_block_data_len;
+
+    nffs_ckpt_cur_slot = slot_idx;
+    nffs_ckpt_cur_seq = disk_ckpt.ndc_seq;
+    nffs_ckpt_cur_sig = nffs_ckpt_area_sig();
+    nffs_ckpt_restored = 1;
+
+    return 0;
+}
+
+/**
+ * Configures the flash regions that hold checkpoints.
+ *
+ * @param slot_descs            Up to NFFS_CKPT_MAX_SLOTS regions, terminated
+ *                                  by a 0-length entry.  Each region must be
+ *                                  independently erasable.  Pass NULL to
+ *                                  disable checkpoints.
+ *
+ * @return                      0 on success; FS_EINVAL if no slot was
+ *                                  specified.
+ */
+int
+nffs_ckpt_config(const struct nffs_area_desc *slot_descs)
+{
+    int i;
+
+    nffs_ckpt_num_slots = 0;
+    nffs_ckpt_cur_slot = -1;
+    nffs_ckpt_cur_seq = 0;
+    nffs_ckpt_present = 0;
+
+    if (slot_descs == NULL) {
+        return 0;
+    }
+
+    for (i = 0; slot_descs[i].nad_length != 0; i++) {
+        if (i >= NFFS_CKPT_MAX_SLOTS) {
+            break;
+        }
+        nffs_ckpt_slots[i] = slot_descs[i];
+    }
+    if (i == 0) {
+        return FS_EINVAL;
+    }
+
+    nffs_ckpt_num_slots = i;
+
+    /* Assume stale data until the slots are known to be erased. */
+    nffs_ckpt_present = 1;
+
+    return 0;
+}
@@ -113,6 +113,14 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     /* Start from a clean state. */
     nffs_misc_reset();
 
+    /* A checkpoint of the previous file system must not be applied to the new
+     * one.
+     */
+    rc = nffs_ckpt_erase();
+    if (rc != 0) {
+        goto err;
+    }
+
     /* Select largest area to be the initial scratch area. */
     nffs_scratch_area_idx = 0;
     for (i = 1; area_descs[i].nad_length != 0; i++) {
@@ -457,6 +457,14 @@ nffs_gc(uint8_t *out_area_idx)
     int rc;
     int i;
 
+    /* Garbage collection rewrites an area; any checkpoint of the current
+     * contents becomes unusable.
+     */
+    rc = nffs_ckpt_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+
     from_area_idx = nffs_gc_select_area();
     from_area = nffs_areas + from_area_idx;
     to_area = nffs_areas + nffs_scratch_area_idx;
@@ -65,6 +65,10 @@ extern "C" {
 #define NFFS_DETECT_FAIL_IGNORE     1
 #define NFFS_DETECT_FAIL_FORMAT     2
 
+#define NFFS_CKPT_MAGIC              0x4e434b50
+#define NFFS_CKPT_VER                0
+#define NFFS_CKPT_MAX_SLOTS          2
+
 /** On-disk representation of an area header. */
 struct nffs_disk_area {
     uint32_t nda_magic[4];  /* NFFS_AREA_MAGIC{0,1,2,3} */
@@ -106,6 +110,50 @@ struct nffs_disk_block {
 
 #define NFFS_DISK_BLOCK_OFFSET_CRC  18
 
+/** On-disk representation of a checkpoint header. */
+struct nffs_disk_ckpt {
+    uint32_t ndc_magic;         /* NFFS_CKPT_MAGIC */
+    uint32_t ndc_seq;           /* Sequence number; greater supersedes
+                                   lesser. */
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_block_id;
+    uint32_t ndc_num_inodes;    /* Number of inode records. */
+    uint32_t ndc_num_blocks;    /* Number of block records. */
+    uint16_t ndc_largest_block_data_len;
+    uint8_t ndc_ver;            /* NFFS_CKPT_VER */
+    uint8_t ndc_num_areas;      /* Number of area records. */
+    uint16_t reserved16;
+    uint16_t ndc_crc16;         /* Covers records and rest of header. */
+    /* Followed by area, inode and block records, in that order. */
+};
+
+#define NFFS_DISK_CKPT_OFFSET_CRC   34
+
+/** Checkpoint record of an area's state. */
+struct nffs_disk_ckpt_area {
+    uint32_t ndca_offset;       /* Flash offset of start of area. */
+    uint32_t ndca_length;       /* Size of area, in bytes. */
+    uint32_t ndca_cur;          /* Write position when checkpoint taken. */
+    uint16_t ndca_id;
+    uint8_t ndca_gc_seq;
+    uint8_t ndca_flash_id;
+};
+
+/** Checkpoint record of an inode; children follow their siblings. */
+struct nffs_disk_ckpt_inode {
+    uint32_t ndci_id;
+    uint32_t ndci_flash_loc;
+    uint32_t ndci_parent_id;    /* NFFS_ID_NONE for the root directory. */
+    uint32_t ndci_lastblock_id; /* NFFS_ID_NONE if directory or empty. */
+};
+
+/** Checkpoint record of a data block. */
+struct nffs_disk_ckpt_block {
+    uint32_t ndcb_id;
+    uint32_t ndcb_flash_loc;
+};
+
 /**
  * What gets stored in the hash table.  Each entry represents a data block or
  * an inode.
@@ -267,6 +315,7 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_readcnt_ckpt)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -359,6 +408,18 @@ int nffs_crc_disk_inode_validate(const struct nffs_disk_inode *disk_inode,
 void nffs_crc_disk_inode_fill(struct nffs_disk_inode *disk_inode,
                               const char *filename);
 
+/* @ckpt */
+extern uint8_t nffs_ckpt_num_slots;
+extern uint8_t nffs_ckpt_restored;
+int nffs_ckpt_config(const struct nffs_area_desc *slot_descs);
+int nffs_ckpt_write(void);
+int nffs_ckpt_restore(uint16_t *out_largest_block_data_len);
+int nffs_ckpt_invalidate(void);
+int nffs_ckpt_erase(void);
+void nffs_ckpt_area_to_disk(const struct nffs_area *area,
+                            struct nffs_disk_ckpt_area *out_disk_area);
+int nffs_ckpt_sysdown(int reason);
+
 /* @config */
 void nffs_config_init(void);
 
@@ -32,6 +32,9 @@
  */
 static uint16_t nffs_restore_largest_block_data_len;
 
+/** The number of objects read from flash during the current restore. */
+static uint32_t nffs_restore_num_objects;
+
 /**
  * Checks that each block a chain of data blocks was properly restored.
  *
@@ -1030,7 +1033,8 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's current write position; the
+ * caller sets this to the first object to restore.
  *
  * @param area_idx              The index of the area to read.
  *
@@ -1045,7 +1049,6 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
@@ -1064,6 +1067,7 @@ nffs_restore_area_contents(int area_idx)
                 area->na_cur++;
             } else {
                 STATS_INC(nffs_stats, nffs_object_count); /* restored objects */
+                nffs_restore_num_objects++;
                 area->na_cur += nffs_restore_disk_object_size(&disk_object);
             }
             break;
@@ -1185,6 +1189,7 @@ nffs_restore_corrupt_scratch(void)
     /* Now that the objects in the scratch area have been invalidated, reload
      * everything from the good area.
      */
+    nffs_areas[good_idx].na_cur = sizeof (struct nffs_disk_area);
     rc = nffs_restore_area_contents(good_idx);
     if (rc != 0) {
         return rc;
@@ -1274,20 +1279,16 @@ nffs_log_contents(void)
 }
 
 /**
- * Searches for a valid nffs file system among the specified areas.  This
- * function succeeds if a file system is detected among any subset of the
- * supplied areas.  If the area set does not contain a valid file system,
- * a new one can be created via a call to nffs_format().
+ * Reads the header of each of the specified areas and populates the nffs area
+ * table.  Area contents are not read.
  *
  * @param area_descs        The area set to search.  This array must be
  *                              terminated with a 0-length area.
  *
- * @return                  0 on success;
- *                          FS_ECORRUPT if no valid file system was detected;
- *                          other nonzero on error.
+ * @return                  0 on success; nonzero on failure.
  */
-int
-nffs_restore_full(const struct nffs_area_desc *area_descs)
+static int
+nffs_restore_areas(const struct nffs_area_desc *area_descs)
 {
     struct nffs_disk_area disk_area;
     int cur_area_idx;
@@ -1295,19 +1296,9 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     int rc;
     int i;
 
-    /* Start from a clean state. */
-    rc = nffs_misc_reset();
-    if (rc) {
-        return rc;
-    }
-    nffs_restore_largest_block_data_len = 0;
-    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
-
-    /* Read each area from flash. */
     for (i = 0; area_descs[i].nad_length != 0; i++) {
         if (i > NFFS_MAX_AREAS) {
-            rc = FS_EINVAL;
-            goto err;
+            return FS_EINVAL;
         }
 
         rc = nffs_restore_detect_one_area(area_descs[i].nad_flash_id,
@@ -1324,7 +1315,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             break;
 
         default:
-            goto err;
+            return rc;
         }
 
         if (use_area) {
@@ -1342,7 +1333,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
 
             rc = nffs_misc_set_num_areas(nffs_num_areas + 1);
             if (rc != 0) {
-                goto err;
+                return rc;
             }
 
             nffs_areas[cur_area_idx].na_offset = area_descs[i].nad_offset;
@@ -1357,7 +1348,74 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Restores the nffs RAM representation from the specified areas.
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ * @param use_ckpt          Whether to start from a checkpoint.  If set, the
+ *                              RAM representation is loaded from the most
+ *                              recent checkpoint, and only the objects
+ *                              written to each area since are read.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          FS_ENOENT if use_ckpt was specified, but there
+ *                              is no usable checkpoint;
+ *                          other nonzero on error.
+ */
+static int
+nffs_restore(const struct nffs_area_desc *area_descs, int use_ckpt)
+{
+    int rc;
+    int i;
+
+    /* Start from a clean state. */
+    rc = nffs_misc_reset();
+    if (rc) {
+        return rc;
+    }
+    nffs_restore_largest_block_data_len = 0;
+    nffs_restore_num_objects = 0;
+    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
+
+    /* Read each area header from flash. */
+    rc = nffs_restore_areas(area_descs);
+    if (rc != 0) {
+        goto err;
+    }
+
+    if (use_ckpt) {
+        /* A checkpoint can only be taken from a consistent file system; one
+         * without a scratch area requires a full restore.
+         */
+        if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+            rc = FS_ENOENT;
+            goto err;
+        }
+
+        rc = nffs_ckpt_restore(&nffs_restore_largest_block_data_len);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    /* Read the contents of each area, starting from the end of the area
+     * header or, if a checkpoint was loaded, from the end of the checkpointed
+     * region.
+     */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            rc = nffs_restore_area_contents(i);
+            if (rc != 0 && use_ckpt) {
+                goto err;
             }
         }
     }
@@ -1396,9 +1454,12 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     }
 
     /* Delete from RAM any objects that were invalidated when subsequent areas
-     * were restored.
+     * were restored.  A checkpoint is taken from a swept file system; if
+     * nothing was written since, there is nothing to sweep.
      */
-    nffs_restore_sweep();
+    if (!use_ckpt || nffs_restore_num_objects != 0) {
+        nffs_restore_sweep();
+    }
 
     /* Set the maximum data block size according to the size of the smallest
      * area.
@@ -1417,3 +1478,36 @@ err:
     nffs_misc_reset();
     return rc;
 }
+
+/**
+ * Searches for a valid nffs file system among the specified areas.  This
+ * function succeeds if a file system is detected among any subset of the
+ * supplied areas.  If the area set does not contain a valid file system,
+ * a new one can be created via a call to nffs_format().
+ *
+ * If a valid checkpoint is available, it is used in place of a full scan of
+ * the areas.  Any failure to restore from the checkpoint falls back to a full
+ * scan.
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_full(const struct nffs_area_desc *area_descs)
+{
+    int rc;
+
+    if (nffs_ckpt_num_slots != 0) {
+        rc = nffs_restore(area_descs, 1);
+        if (rc == 0) {
+            return 0;
+        }
+    }
+
+    nffs_ckpt_restored = 0;
+    return nffs_restore(area_descs, 0);
+}
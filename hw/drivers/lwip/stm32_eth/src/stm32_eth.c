@@ -286,10 +286,10 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
             reg |= ETH_DMATXDESC_LS;
         }
         sed->desc.Status = reg;
-        sed->desc.ControlBufferSize = p->len;
-        sed->desc.Buffer1Addr = (uint32_t)p->payload;
-        sed->p = p;
-        pbuf_ref(p);
+        sed->desc.ControlBufferSize = q->len;
+        sed->desc.Buffer1Addr = (uint32_t)q->payload;
+        sed->p = q;
+        pbuf_ref(q);
         sed->desc.Status = reg | ETH_DMATXDESC_OWN;
         ses->st_tx_head++;
         if (ses->st_tx_head >= STM32_ETH_TX_DESC_SZ) {
@@ -22,6 +22,7 @@
 #include <disk/disk.h>
 #include <mmc/mmc.h>
 #include <stdio.h>
+#include <string.h>
 
 #define MIN(n, m) (((n) < (m)) ? (n) : (m))
 
@@ -63,6 +64,14 @@
 
 #define BLOCK_LEN           (512)
 
+/*
+ * Number of bytes to poll for a token or for the end of busy state before
+ * sleeping.  Between the blocks of a multi-block transfer the card is usually
+ * ready again within a few bytes, so sleeping right away would cost a tick
+ * per block.
+ */
+#define POLL_SPIN_BYTES     (256)
+
 static uint8_t g_block_buf[BLOCK_LEN];
 
 static struct hal_spi_settings mmc_settings = {
@@ -349,6 +358,14 @@ wait_busy(struct mmc_cfg *mmc)
 {
     os_time_t timeout;
     uint8_t res;
+    int n;
+
+    for (n = 0; n < POLL_SPIN_BYTES; n++) {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res) {
+            return res;
+        }
+    }
 
     timeout = os_time_get() + OS_TICKS_PER_SEC / 2;
     do {
@@ -361,6 +378,105 @@ wait_busy(struct mmc_cfg *mmc)
 }
 
 /**
+ * 7.3.3 Control tokens
+ *   Wait up to 200ms for control token.
+ */
+static uint8_t
+wait_token(struct mmc_cfg *mmc)
+{
+    os_time_t timeout;
+    uint8_t res;
+    int n;
+
+    for (n = 0; n < POLL_SPIN_BYTES; n++) {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xff) {
+            return res;
+        }
+    }
+
+    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
+    do {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xff) break;
+        os_time_delay(OS_TICKS_PER_SEC / 20);
+    } while (os_time_get() < timeout);
+
+    return res;
+}
+
+/**
+ * Receives one data block, including its start token and CRC.  A whole block
+ * is clocked straight into the destination in one SPI transfer; anything else
+ * goes through g_block_buf a byte at a time.
+ */
+static int
+read_block(struct mmc_cfg *mmc, uint8_t *dst, size_t offset, size_t amount)
+{
+    uint32_t n;
+    int rc;
+
+    /**
+     * 7.3.3.2 Start Block Tokens and Stop Tran Token
+     *   Every block of a CMD18 transfer has its own start token.
+     */
+    if (wait_token(mmc) != START_BLOCK) {
+        return MMC_TIMEOUT;
+    }
+
+    if (offset == 0 && amount == BLOCK_LEN && dst != g_block_buf) {
+        /* g_block_buf supplies the 0xff filler clocked out to the card. */
+        memset(g_block_buf, 0xff, BLOCK_LEN);
+        rc = hal_spi_txrx(mmc->spi_num, g_block_buf, dst, BLOCK_LEN);
+        if (rc) {
+            return MMC_READ_ERROR;
+        }
+    } else {
+        for (n = 0; n < BLOCK_LEN; n++) {
+            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
+        }
+        memcpy(dst, &g_block_buf[offset], amount);
+    }
+
+    /* TODO: CRC-16 not used here but would be cool to have */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+    return MMC_OK;
+}
+
+/**
+ * Sends one data block and returns the card's data response token.
+ */
+static uint8_t
+write_block(struct mmc_cfg *mmc, uint8_t token, const uint8_t *src)
+{
+    int rc;
+
+    /**
+     * 7.3.3.2 Start Block Tokens and Stop Tran Token
+     */
+    hal_spi_tx_val(mmc->spi_num, token);
+
+    rc = hal_spi_txrx(mmc->spi_num, (void *)src, NULL, BLOCK_LEN);
+    if (rc) {
+        return 0;
+    }
+
+    /* CRC */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+    /**
+     * 7.3.3.1 Data Response Token
+     */
+    return hal_spi_tx_val(mmc->spi_num, 0xff);
+}
+
+/**
+ * Reads use CMD18 (READ_MULTIPLE_BLOCK) whenever more than one block is
+ * involved, so a multi-sector read costs a single command round trip.
+ *
  * @return 0 on success, non-zero on failure
  */
 int
@@ -369,10 +485,7 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
     uint8_t cmd;
     uint8_t res;
     int rc;
-    uint32_t n;
-    size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
@@ -384,12 +497,13 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         return (MMC_DEVICE_ERROR);
     }
 
-    rc = MMC_OK;
+    if (len == 0) {
+        return (MMC_OK);
+    }
 
-    block_len = (len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
-    block_count = block_len / BLOCK_LEN;
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
+    block_count = (offset + len + BLOCK_LEN - 1) / BLOCK_LEN;
 
     hal_gpio_write(mmc->ss_pin, 0);
 
@@ -400,38 +514,15 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         goto out;
     }
 
-    /**
-     * 7.3.3 Control tokens
-     *   Wait up to 200ms for control token.
-     */
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res != 0xFF) break;
-        os_time_delay(OS_TICKS_PER_SEC / 20);
-    } while (os_time_get() < timeout);
-
-    /**
-     * 7.3.3.2 Start Block Tokens and Stop Tran Token
-     */
-    if (res != START_BLOCK) {
-        rc = MMC_TIMEOUT;
-        goto out;
-    }
-
+    rc = MMC_OK;
     index = 0;
     while (block_count--) {
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
-        }
-
-        /* TODO: CRC-16 not used here but would be cool to have */
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-
         amount = MIN(BLOCK_LEN - offset, len);
 
-        memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        rc = read_block(mmc, (uint8_t *)buf + index, offset, amount);
+        if (rc) {
+            break;
+        }
 
         offset = 0;
         len -= amount;
@@ -449,6 +540,9 @@ out:
 }
 
 /**
+ * Writes use CMD25 (WRITE_MULTIPLE_BLOCK) whenever more than one block is
+ * involved.  Whole blocks are sent straight from the caller's buffer.
+ *
  * @return 0 on success, non-zero on failure
  */
 int
@@ -456,14 +550,13 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
 {
     uint8_t cmd;
     uint8_t res;
-    uint32_t n;
-    size_t block_len;
+    uint8_t token;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    const uint8_t *src;
     int rc;
     struct mmc_cfg *mmc;
 
@@ -472,10 +565,13 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
         return (MMC_DEVICE_ERROR);
     }
 
-    block_len = (len + BLOCK_LEN - 1) & ~(BLOCK_LEN - 1);
-    block_count = block_len / BLOCK_LEN;
+    if (len == 0) {
+        return (MMC_OK);
+    }
+
     block_addr = addr / BLOCK_LEN;
     offset = addr - (block_addr * BLOCK_LEN);
+    block_count = (offset + len + BLOCK_LEN - 1) / BLOCK_LEN;
 
     hal_gpio_write(mmc->ss_pin, 0);
 
@@ -494,29 +590,17 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             goto out;
         }
 
-        timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-        do {
-            res = hal_spi_tx_val(mmc->spi_num, 0xff);
-            if (res != 0xff) break;
-            os_time_delay(OS_TICKS_PER_SEC / 20);
-        } while (os_time_get() < timeout);
-
-        if (res != START_BLOCK) {
+        rc = read_block(mmc, g_block_buf, 0, BLOCK_LEN);
+        if (rc) {
             rc = MMC_CARD_ERROR;
             goto out;
         }
-
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
-        }
-
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
     }
 
     /* now start write */
 
     cmd = (block_count == 1) ? CMD24 : CMD25;
+    token = (block_count == 1) ? START_BLOCK : START_BLOCK_TOKEN;
     res = send_mmc_cmd(mmc, cmd, block_addr);
     if (res) {
         rc = error_by_response(res);
@@ -525,30 +609,16 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
 
     index = 0;
     while (block_count--) {
-        /**
-         * 7.3.3.2 Start Block Tokens and Stop Tran Token
-         */
-        if (cmd == CMD24) {
-            hal_spi_tx_val(mmc->spi_num, START_BLOCK);
-        } else {
-            hal_spi_tx_val(mmc->spi_num, START_BLOCK_TOKEN);
-        }
-
         amount = MIN(BLOCK_LEN - offset, len);
-        memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
 
-        for (n = 0; n < BLOCK_LEN; n++) {
-            hal_spi_tx_val(mmc->spi_num, g_block_buf[n]);
+        if (amount == BLOCK_LEN) {
+            src = (const uint8_t *)buf + index;
+        } else {
+            memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+            src = g_block_buf;
         }
 
-        /* CRC */
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-
-        /**
-         * 7.3.3.1 Data Response Token
-         */
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        res = write_block(mmc, token, src);
         if ((res & 0x1f) != 0x05) {
             break;
         }
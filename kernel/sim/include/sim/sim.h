@@ -48,6 +48,24 @@ void sim_restore_sr(os_sr_t osr);
 int sim_in_critical(void);
 void sim_tick_idle(os_time_t ticks);
 
+/** Callback invoked, with interrupts disabled, when an I/O source is ready. */
+typedef void sim_io_fn(void *arg);
+
+/**
+ * Registers a host file descriptor as an interrupt source.  The callback is
+ * invoked whenever the descriptor is readable, including while the idle task
+ * is waiting for the next tick.  Only supported on Linux hosts.
+ *
+ * @param fd                    The descriptor to watch.
+ * @param fn                    The callback to invoke when it is readable.
+ * @param arg                   Argument to pass to the callback.
+ *
+ * @return                      0 on success;
+ *                              OS_ENOMEM if too many sources are registered;
+ *                              OS_ENOENT if the host is not supported.
+ */
+int sim_io_src_add(int fd, sim_io_fn *fn, void *arg);
+
 /**
  * Prints information about a crash to stdout.  This functionality is defined
  * as a macro rather than a function to ensure that it gets inlined, enforcing
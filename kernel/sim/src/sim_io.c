@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Host file descriptors as interrupt sources.
+ *
+ * A package registers a descriptor along with a callback.  Whenever the
+ * descriptor becomes readable, the callback is invoked as if it were an
+ * interrupt handler: with interrupts disabled, from the idle task or from the
+ * tick handler.  The idle task waits for registered descriptors in addition to
+ * signals, so readiness wakes the simulated MCU immediately instead of on the
+ * next tick.
+ *
+ * The callback is responsible for clearing the readiness condition (or for
+ * waking a task that does so); otherwise it keeps getting invoked.
+ *
+ * Only Linux hosts support this; elsewhere, sim_io_src_add() fails and the
+ * idle task waits for signals only.
+ */
+
+#ifdef MN_LINUX
+#define _GNU_SOURCE
+#endif
+
+#include "os/mynewt.h"
+
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include <assert.h>
+#include "sim/sim.h"
+#include "sim_priv.h"
+
+#define SIM_IO_MAX_SRCS     4
+
+struct sim_io_src {
+    sim_io_fn *fn;
+    void *arg;
+};
+
+static struct sim_io_src sim_io_srcs[SIM_IO_MAX_SRCS];
+static struct pollfd sim_io_pfds[SIM_IO_MAX_SRCS];
+static int sim_io_cnt;
+
+/**
+ * Unregisters all I/O sources.  Called when the OS is initialized.
+ */
+void
+sim_io_init(void)
+{
+    sim_io_cnt = 0;
+}
+
+int
+sim_io_src_add(int fd, sim_io_fn *fn, void *arg)
+{
+#ifdef MN_LINUX
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (sim_io_cnt >= SIM_IO_MAX_SRCS) {
+        rc = OS_ENOMEM;
+    } else {
+        sim_io_srcs[sim_io_cnt].fn = fn;
+        sim_io_srcs[sim_io_cnt].arg = arg;
+        sim_io_pfds[sim_io_cnt].fd = fd;
+        sim_io_pfds[sim_io_cnt].events = POLLIN;
+        sim_io_pfds[sim_io_cnt].revents = 0;
+        sim_io_cnt++;
+        rc = OS_OK;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+#else
+    return OS_ENOENT;
+#endif
+}
+
+/**
+ * Waits until a signal is delivered or a registered descriptor becomes
+ * readable.  The signal mask is replaced by 'mask' for the duration of the
+ * wait, as with sigsuspend().  Ready descriptors are recorded; their callbacks
+ * are invoked by sim_io_dispatch().
+ */
+void
+sim_io_wait(const sigset_t *mask)
+{
+#ifdef MN_LINUX
+    if (sim_io_cnt > 0) {
+        if (ppoll(sim_io_pfds, sim_io_cnt, NULL, mask) < 0) {
+            assert(errno == EINTR);
+        }
+        return;
+    }
+#endif
+
+    sigsuspend(mask);
+}
+
+/**
+ * Invokes the callbacks of the descriptors found ready by the last
+ * sim_io_wait() or sim_io_poll().
+ */
+void
+sim_io_dispatch(void)
+{
+    bool ticked;
+    int i;
+
+    OS_ASSERT_CRITICAL();
+
+    ticked = false;
+    for (i = 0; i < sim_io_cnt; i++) {
+        if (sim_io_pfds[i].revents != 0) {
+            /* The wakeup may have come between ticks; bring OS time up to
+             * date before the handler runs.
+             */
+            if (!ticked) {
+                sim_tick();
+                ticked = true;
+            }
+
+            sim_io_pfds[i].revents = 0;
+            sim_io_srcs[i].fn(sim_io_srcs[i].arg);
+        }
+    }
+}
+
+/**
+ * Checks registered descriptors without blocking and invokes the callbacks
+ * of the ready ones.  Used while the idle task is not running.
+ */
+void
+sim_io_poll(void)
+{
+    OS_ASSERT_CRITICAL();
+
+    if (sim_io_cnt > 0 && poll(sim_io_pfds, sim_io_cnt, 0) > 0) {
+        sim_io_dispatch();
+    }
+}
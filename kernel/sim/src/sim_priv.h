@@ -21,6 +21,7 @@
 #define H_SIM_PRIV_
 
 #include <sys/types.h>
+#include <signal.h>
 #include "os/mynewt.h"
 
 #ifdef __cplusplus
@@ -33,6 +34,10 @@ void sim_switch_tasks(void);
 void sim_tick(void);
 void sim_signals_init(void);
 void sim_signals_cleanup(void);
+void sim_io_init(void);
+void sim_io_wait(const sigset_t *mask);
+void sim_io_dispatch(void);
+void sim_io_poll(void);
 
 extern pid_t sim_pid;
 
@@ -239,6 +239,7 @@ sim_os_init(void)
     TAILQ_INIT(&g_os_sleep_list);
 
     sim_signals_init();
+    sim_io_init();
 
     os_init_idle_task();
 
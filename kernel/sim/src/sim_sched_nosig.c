@@ -175,7 +175,7 @@ sim_tick_idle(os_time_t ticks)
     unblock_timer();
 
     sigemptyset(&suspsigs);
-    sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
+    sim_io_wait(&nosigs);       /* Wait for a signal or I/O to wake us up */
 
     block_timer();
 
@@ -187,6 +187,7 @@ sim_tick_idle(os_time_t ticks)
     if (sigismember(&suspsigs, SIGALRM)) {
         sim_tick();
     }
+    sim_io_dispatch();
 
     if (ticks > 0) {
         /*
@@ -149,6 +149,7 @@ timer_handler(int sig)
         sigaddset(&suspsigs, sig);
     } else {
         sim_tick();
+        sim_io_poll();
     }
 }
 
@@ -186,7 +187,7 @@ sim_tick_idle(os_time_t ticks)
 
     suspended = true;
     sigemptyset(&suspsigs);
-    sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
+    sim_io_wait(&nosigs);       /* Wait for a signal or I/O to wake us up */
     suspended = false;
 
     /*
@@ -204,6 +205,7 @@ sim_tick_idle(os_time_t ticks)
             handler(sig);
         }
     }
+    sim_io_dispatch();
 
     if (ticks > 0) {
         /*
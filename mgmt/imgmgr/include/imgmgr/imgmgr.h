@@ -33,6 +33,7 @@ extern "C" {
 #define IMGMGR_NMGR_ID_CORELOAD     4
 #define IMGMGR_NMGR_ID_ERASE	    5
 #define IMGMGR_NMGR_ID_ERASE_STATE  6
+#define IMGMGR_NMGR_ID_UPLOAD_WIN   7
 
 #define IMGMGR_NMGR_MAX_NAME		64
 #define IMGMGR_NMGR_MAX_VER         25  /* 255.255.65535.4294967295\0 */
@@ -142,6 +143,66 @@ typedef int imgr_upload_fn(uint32_t offset, uint32_t size, void *arg);
  */
 void imgr_set_upload_cb(imgr_upload_fn *cb, void *arg);
 
+/**
+ * Starts a windowed image upload into the best available slot.  Any upload
+ * in progress is abandoned.  Nothing is erased yet; sectors are erased on the
+ * upload's event queue as the upload advances.
+ *
+ * @param size                  The total size of the image, in bytes.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOENT if no slot is available;
+ *                              SYS_EINVAL if the image does not fit;
+ *                              SYS_EIO on flash error.
+ */
+int imgr_upload_start(uint32_t size);
+
+/**
+ * Passes a chunk of the image being uploaded.  A chunk at the write pointer
+ * is written to flash, followed by any buffered chunks that it makes
+ * contiguous.  A chunk past the write pointer, but within the window, is
+ * buffered.  Data that has already been written is ignored, so
+ * retransmissions are harmless.
+ *
+ * @param off                   The chunk's offset within the image.
+ * @param data                  The chunk contents.
+ * @param len                   The chunk length; at most
+ *                                  IMGMGR_MAX_CHUNK_SIZE.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if no upload is in progress or
+ *                                  the chunk is invalid;
+ *                              SYS_ENOMEM if the chunk lies past the window
+ *                                  or no buffer is free;
+ *                              SYS_EIO on flash error.
+ */
+int imgr_upload_write(uint32_t off, const void *data, uint32_t len);
+
+struct os_eventq;
+
+/**
+ * Sets the event queue that sectors are erased on during an upload.  This
+ * must be the queue that image management requests are processed on, since
+ * erases are not serialized with writes in any other way; an application
+ * that binds MGMT_GROUP_ID_IMAGE with smp_group_evq_set() passes the same
+ * queue here.  Upload calls from any other task trigger an assert.
+ *
+ * @param evq                   The event queue; NULL for the default one.
+ */
+void imgr_upload_evq_set(struct os_eventq *evq);
+
+/**
+ * Returns the number of bytes of the image written to flash so far.  All
+ * chunks below this offset are acknowledged.
+ */
+uint32_t imgr_upload_off(void);
+
+/**
+ * Returns the number of bytes past imgr_upload_off() that the uploader can
+ * buffer.
+ */
+uint32_t imgr_upload_win_size(void);
+
 /** @brief Generic callback function for events */
 typedef void (*imgmgr_dfu_cb)(void);
 
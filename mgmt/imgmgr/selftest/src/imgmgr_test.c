@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "imgmgr_test_priv.h"
+
+uint8_t
+imgmgr_test_img_byte(uint32_t off)
+{
+    return (off * 7) ^ (off >> 8);
+}
+
+/**
+ * Returns the slot that an upload is written to.
+ */
+const struct flash_area *
+imgmgr_test_area(void)
+{
+    const struct flash_area *fa;
+    int rc;
+
+    rc = flash_area_open(imgmgr_find_best_area_id(), &fa);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return fa;
+}
+
+/**
+ * Erases the start of the area and fills it with non-erased bytes, so that
+ * the tests can tell which parts an upload has erased.
+ */
+void
+imgmgr_test_scribble(const struct flash_area *fa, uint32_t len)
+{
+    uint8_t buf[64];
+    uint32_t off;
+    int rc;
+
+    rc = flash_area_erase(fa, 0, len);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(buf, 0x5a, sizeof buf);
+    for (off = 0; off < len; off += sizeof buf) {
+        rc = flash_area_write(fa, off, buf, min(sizeof buf, len - off));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+/**
+ * Runs the events queued by the uploader; in a real system, the default
+ * task does this between requests.
+ */
+void
+imgmgr_test_run_events(void)
+{
+    struct os_event *ev;
+
+    while ((ev = os_eventq_get_no_wait(os_eventq_dflt_get())) != NULL) {
+        ev->ev_cb(ev);
+    }
+}
+
+/**
+ * Passes the chunk of the test image at the specified offset to the
+ * uploader.
+ */
+int
+imgmgr_test_write_chunk(uint32_t off, uint32_t img_size)
+{
+    uint8_t buf[IMGMGR_TEST_CHUNK_SZ];
+    uint32_t len;
+    uint32_t i;
+
+    len = min(IMGMGR_TEST_CHUNK_SZ, img_size - off);
+    for (i = 0; i < len; i++) {
+        buf[i] = imgmgr_test_img_byte(off + i);
+    }
+
+    return imgr_upload_write(off, buf, len);
+}
+
+void
+imgmgr_test_verify(const struct flash_area *fa, uint32_t len)
+{
+    uint8_t buf[64];
+    uint32_t off;
+    uint32_t i;
+    int chunk;
+    int rc;
+
+    for (off = 0; off < len; off += chunk) {
+        chunk = min(sizeof buf, len - off);
+        rc = flash_area_read(fa, off, buf, chunk);
+        TEST_ASSERT_FATAL(rc == 0);
+        for (i = 0; i < chunk; i++) {
+            TEST_ASSERT_FATAL(buf[i] == imgmgr_test_img_byte(off + i),
+                              "mismatch at offset %lu",
+                              (unsigned long)(off + i));
+        }
+    }
+}
+
+TEST_SUITE(imgmgr_test_suite)
+{
+    imgmgr_test_upload_inorder();
+    imgmgr_test_upload_window();
+    imgmgr_test_upload_erase_ahead();
+    imgmgr_test_upload_perf();
+}
+
+int
+main(int argc, char **argv)
+{
+    imgmgr_test_suite();
+
+    return tu_any_failed;
+}
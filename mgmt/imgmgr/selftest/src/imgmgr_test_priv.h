@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_IMGMGR_TEST_PRIV_
+#define H_IMGMGR_TEST_PRIV_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "flash_map/flash_map.h"
+#include "imgmgr/imgmgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMGMGR_TEST_CHUNK_SZ    MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)
+
+TEST_CASE_DECL(imgmgr_test_upload_inorder);
+TEST_CASE_DECL(imgmgr_test_upload_window);
+TEST_CASE_DECL(imgmgr_test_upload_erase_ahead);
+TEST_CASE_DECL(imgmgr_test_upload_perf);
+
+/* Byte of the test image at the specified offset. */
+uint8_t imgmgr_test_img_byte(uint32_t off);
+
+const struct flash_area *imgmgr_test_area(void);
+void imgmgr_test_scribble(const struct flash_area *fa, uint32_t len);
+void imgmgr_test_run_events(void);
+int imgmgr_test_write_chunk(uint32_t off, uint32_t img_size);
+void imgmgr_test_verify(const struct flash_area *fa, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "imgmgr_test_priv.h"
+
+/* How far past the write pointer the uploader keeps the slot erased. */
+#define IMGMGR_TEST_AHEAD                                       \
+    (MYNEWT_VAL(IMGMGR_UPLOAD_WIN_CHUNKS) * IMGMGR_TEST_CHUNK_SZ + \
+     MYNEWT_VAL(IMGMGR_UPLOAD_ERASE_AHEAD))
+
+static struct os_eventq imgmgr_test_evq;
+
+static int
+imgmgr_test_is_erased(const struct flash_area *fa, uint32_t off)
+{
+    uint8_t byte;
+    int rc;
+
+    rc = flash_area_read(fa, off, &byte, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return byte == flash_area_erased_val(fa);
+}
+
+/**
+ * Returns the offset of the first sector that starts at or after off, or the
+ * size of the area if there is none.
+ */
+static uint32_t
+imgmgr_test_next_sector(const struct flash_area *fa, uint32_t off)
+{
+    struct flash_area sector;
+    int sec_id;
+
+    sec_id = -1;
+    while (flash_area_getnext_sector(fa->fa_id, &sec_id, &sector) == 0) {
+        if (sector.fa_off - fa->fa_off >= off) {
+            return sector.fa_off - fa->fa_off;
+        }
+    }
+
+    return fa->fa_size;
+}
+
+TEST_CASE_SELF(imgmgr_test_upload_erase_ahead)
+{
+    const struct flash_area *fa;
+    struct os_event *ev;
+    uint32_t img_size;
+    uint32_t sector;
+    uint32_t off;
+    int rc;
+
+    fa = imgmgr_test_area();
+
+    /* Make the image extend at least two sectors past the erase target. */
+    sector = imgmgr_test_next_sector(fa, IMGMGR_TEST_AHEAD +
+                                     IMGMGR_TEST_CHUNK_SZ);
+    img_size = imgmgr_test_next_sector(fa, sector + 1);
+    TEST_ASSERT_FATAL(img_size < fa->fa_size);
+    img_size += IMGMGR_TEST_CHUNK_SZ;
+
+    imgmgr_test_scribble(fa, img_size);
+
+    /*** Starting an upload erases nothing by itself. */
+    rc = imgr_upload_start(img_size);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!imgmgr_test_is_erased(fa, 0));
+
+    /*** The first chunk erases what it needs... */
+    rc = imgmgr_test_write_chunk(0, img_size);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!imgmgr_test_is_erased(fa, sector));
+
+    /* ...and the rest of the lookahead is erased in the background, but not
+     * the sector past it.
+     */
+    imgmgr_test_run_events();
+    TEST_ASSERT(imgmgr_test_is_erased(fa, IMGMGR_TEST_AHEAD));
+    TEST_ASSERT(!imgmgr_test_is_erased(fa, sector));
+
+    /*** The erased region keeps ahead of the write pointer. */
+    for (off = IMGMGR_TEST_CHUNK_SZ; off < img_size;
+         off += IMGMGR_TEST_CHUNK_SZ) {
+
+        TEST_ASSERT_FATAL(imgmgr_test_is_erased(fa, off));
+
+        rc = imgmgr_test_write_chunk(off, img_size);
+        TEST_ASSERT_FATAL(rc == 0);
+        imgmgr_test_run_events();
+
+        if (imgr_upload_off() + IMGMGR_TEST_AHEAD < img_size) {
+            TEST_ASSERT_FATAL(imgmgr_test_is_erased(
+                fa, imgr_upload_off() + IMGMGR_TEST_AHEAD - 1));
+        }
+    }
+
+    imgmgr_test_verify(fa, img_size);
+
+    /*** Erases are posted to the queue set for the image group. */
+    os_eventq_init(&imgmgr_test_evq);
+    imgr_upload_evq_set(&imgmgr_test_evq);
+    imgmgr_test_scribble(fa, img_size);
+    rc = imgr_upload_start(img_size);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = imgmgr_test_write_chunk(0, img_size);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_ASSERT(os_eventq_get_no_wait(os_eventq_dflt_get()) == NULL);
+    ev = os_eventq_get_no_wait(&imgmgr_test_evq);
+    TEST_ASSERT_FATAL(ev != NULL);
+    do {
+        ev->ev_cb(ev);
+    } while ((ev = os_eventq_get_no_wait(&imgmgr_test_evq)) != NULL);
+    TEST_ASSERT(imgmgr_test_is_erased(fa, IMGMGR_TEST_AHEAD - 1));
+
+    imgr_upload_evq_set(NULL);
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "imgmgr_test_priv.h"
+
+#define IMGMGR_TEST_INORDER_SZ  (20 * 1024 + 100)
+
+TEST_CASE_SELF(imgmgr_test_upload_inorder)
+{
+    const struct flash_area *fa;
+    uint32_t off;
+    int rc;
+
+    fa = imgmgr_test_area();
+    imgmgr_test_scribble(fa, IMGMGR_TEST_INORDER_SZ);
+
+    /* No upload in progress. */
+    rc = imgmgr_test_write_chunk(0, IMGMGR_TEST_INORDER_SZ);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    rc = imgr_upload_start(0);
+    TEST_ASSERT(rc == SYS_EINVAL);
+    rc = imgr_upload_start(fa->fa_size + 1);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    rc = imgr_upload_start(IMGMGR_TEST_INORDER_SZ);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == 0);
+
+    for (off = 0; off < IMGMGR_TEST_INORDER_SZ; off += IMGMGR_TEST_CHUNK_SZ) {
+        rc = imgmgr_test_write_chunk(off, IMGMGR_TEST_INORDER_SZ);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(imgr_upload_off() ==
+                    min(off + IMGMGR_TEST_CHUNK_SZ, IMGMGR_TEST_INORDER_SZ));
+
+        /* Every other chunk, let the background erase run. */
+        if (off / IMGMGR_TEST_CHUNK_SZ % 2 == 0) {
+            imgmgr_test_run_events();
+        }
+    }
+
+    /* Writes past the end of the image are rejected. */
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_INORDER_SZ - 1,
+                                 IMGMGR_TEST_INORDER_SZ + 1);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+    imgmgr_test_run_events();
+    imgmgr_test_verify(fa, IMGMGR_TEST_INORDER_SZ);
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "imgmgr_test_priv.h"
+
+#define IMGMGR_TEST_PERF_SZ     (192 * 1024)
+
+/**
+ * Compares the windowed uploader against the one-chunk-at-a-time scheme,
+ * which erases the whole slot on the first chunk.  What matters on a slow
+ * link is the time spent handling each request, since the client waits for
+ * it; background erases run while responses are in transit.
+ */
+TEST_CASE_SELF(imgmgr_test_upload_perf)
+{
+    const struct flash_area *fa;
+    uint8_t buf[IMGMGR_TEST_CHUNK_SZ];
+    int64_t first_sync;
+    int64_t first_win;
+    int64_t total_sync;
+    int64_t total_win;
+    int64_t bg_win;
+    int64_t start;
+    uint32_t off;
+    uint32_t len;
+    uint32_t i;
+    int rc;
+
+    fa = imgmgr_test_area();
+    TEST_ASSERT_FATAL(fa->fa_size >= IMGMGR_TEST_PERF_SZ);
+
+    /*** Synchronous: erase the slot, then write each chunk. */
+    total_sync = 0;
+    first_sync = 0;
+    for (off = 0; off < IMGMGR_TEST_PERF_SZ; off += len) {
+        len = min(sizeof buf, IMGMGR_TEST_PERF_SZ - off);
+        for (i = 0; i < len; i++) {
+            buf[i] = imgmgr_test_img_byte(off + i);
+        }
+
+        start = os_get_uptime_usec();
+        if (off == 0) {
+            rc = flash_area_erase(fa, 0, fa->fa_size);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        rc = flash_area_write(fa, off, buf, len);
+        TEST_ASSERT_FATAL(rc == 0);
+        total_sync += os_get_uptime_usec() - start;
+        if (off == 0) {
+            first_sync = total_sync;
+        }
+    }
+    imgmgr_test_verify(fa, IMGMGR_TEST_PERF_SZ);
+
+    /*** Windowed: time in requests and in the background, separately. */
+    imgmgr_test_scribble(fa, IMGMGR_TEST_PERF_SZ);
+
+    total_win = 0;
+    first_win = 0;
+    bg_win = 0;
+    for (off = 0; off < IMGMGR_TEST_PERF_SZ; off += len) {
+        len = min(sizeof buf, IMGMGR_TEST_PERF_SZ - off);
+        for (i = 0; i < len; i++) {
+            buf[i] = imgmgr_test_img_byte(off + i);
+        }
+
+        start = os_get_uptime_usec();
+        if (off == 0) {
+            rc = imgr_upload_start(IMGMGR_TEST_PERF_SZ);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        rc = imgr_upload_write(off, buf, len);
+        TEST_ASSERT_FATAL(rc == 0);
+        total_win += os_get_uptime_usec() - start;
+        if (off == 0) {
+            first_win = total_win;
+        }
+
+        start = os_get_uptime_usec();
+        imgmgr_test_run_events();
+        bg_win += os_get_uptime_usec() - start;
+    }
+    TEST_ASSERT(imgr_upload_off() == IMGMGR_TEST_PERF_SZ);
+    imgmgr_test_verify(fa, IMGMGR_TEST_PERF_SZ);
+
+    TEST_PASS("%d KiB: first chunk sync=%lu us windowed=%lu us; "
+              "in requests sync=%lu us windowed=%lu us (+%lu us background)",
+              IMGMGR_TEST_PERF_SZ / 1024,
+              (unsigned long)first_sync, (unsigned long)first_win,
+              (unsigned long)total_sync, (unsigned long)total_win,
+              (unsigned long)bg_win);
+}
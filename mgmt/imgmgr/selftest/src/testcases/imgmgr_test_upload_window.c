@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "imgmgr_test_priv.h"
+
+#define IMGMGR_TEST_WIN_CHUNKS  MYNEWT_VAL(IMGMGR_UPLOAD_WIN_CHUNKS)
+#define IMGMGR_TEST_WIN_SZ      (16 * IMGMGR_TEST_CHUNK_SZ + 10)
+
+#define IMGMGR_TEST_CHUNK(n)    ((n) * IMGMGR_TEST_CHUNK_SZ)
+
+TEST_CASE_SELF(imgmgr_test_upload_window)
+{
+    const struct flash_area *fa;
+    uint8_t buf[IMGMGR_TEST_CHUNK_SZ];
+    uint32_t off;
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(IMGMGR_TEST_WIN_CHUNKS >= 2);
+    TEST_ASSERT(imgr_upload_win_size() ==
+                IMGMGR_TEST_WIN_CHUNKS * IMGMGR_TEST_CHUNK_SZ);
+
+    fa = imgmgr_test_area();
+    imgmgr_test_scribble(fa, IMGMGR_TEST_WIN_SZ);
+
+    rc = imgr_upload_start(IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Chunks ahead of the write pointer are buffered, not acknowledged. */
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_CHUNK(2), IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_CHUNK(1), IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == 0);
+
+    /* A retransmission of a buffered chunk takes no extra buffer. */
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_CHUNK(2), IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+
+    /* Beyond the window. */
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_CHUNK(IMGMGR_TEST_WIN_CHUNKS),
+                                 IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == SYS_ENOMEM);
+
+    /*** Filling the gap acknowledges everything buffered behind it. */
+    rc = imgmgr_test_write_chunk(0, IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == IMGMGR_TEST_CHUNK(3));
+
+    /* Retransmission of written data is ignored. */
+    rc = imgmgr_test_write_chunk(IMGMGR_TEST_CHUNK(1), IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == IMGMGR_TEST_CHUNK(3));
+
+    /*** A chunk overlapping the write pointer only writes its new part. */
+    off = IMGMGR_TEST_CHUNK(3) - 10;
+    for (i = 0; i < sizeof buf; i++) {
+        buf[i] = imgmgr_test_img_byte(off + i);
+    }
+    rc = imgr_upload_write(off, buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == off + sizeof buf);
+
+    /*** Chunks that are not aligned to each other. */
+    off = imgr_upload_off();
+    for (i = 0; i < sizeof buf; i++) {
+        buf[i] = imgmgr_test_img_byte(off + 100 + i);
+    }
+    rc = imgr_upload_write(off + 100, buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < 200; i++) {
+        buf[i] = imgmgr_test_img_byte(off + i);
+    }
+    rc = imgr_upload_write(off, buf, 200);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() == off + 100 + sizeof buf);
+
+    /*** Fill the window in reverse, then finish in order. */
+    off = imgr_upload_off();
+    for (i = IMGMGR_TEST_WIN_CHUNKS - 1; i > 0; i--) {
+        rc = imgmgr_test_write_chunk(off + IMGMGR_TEST_CHUNK(i),
+                                     IMGMGR_TEST_WIN_SZ);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(imgr_upload_off() == off);
+    imgmgr_test_run_events();
+    rc = imgmgr_test_write_chunk(off, IMGMGR_TEST_WIN_SZ);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_upload_off() ==
+                off + IMGMGR_TEST_CHUNK(IMGMGR_TEST_WIN_CHUNKS));
+
+    for (off = imgr_upload_off(); off < IMGMGR_TEST_WIN_SZ;
+         off += IMGMGR_TEST_CHUNK_SZ) {
+
+        rc = imgmgr_test_write_chunk(off, IMGMGR_TEST_WIN_SZ);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(imgr_upload_off() == IMGMGR_TEST_WIN_SZ);
+
+    imgmgr_test_verify(fa, IMGMGR_TEST_WIN_SZ);
+}
@@ -84,6 +84,10 @@ imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
 
 static int
 imgr_erase_state(struct mgmt_ctxt *ctxt);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WIN)
+static int
+imgr_upload_win(struct mgmt_ctxt *ctxt);
+#endif
 
 static const struct mgmt_handler imgr_mgmt_handlers[] = {
     [IMGMGR_NMGR_ID_CORELIST] = {
@@ -108,6 +112,12 @@ static const struct mgmt_handler imgr_mgmt_handlers[] = {
         .mh_read = NULL,
         .mh_write = imgr_erase_state,
     },
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WIN)
+    [IMGMGR_NMGR_ID_UPLOAD_WIN] = {
+        .mh_read = NULL,
+        .mh_write = imgr_upload_win,
+    },
+#endif
 };
 
 #define IMGR_HANDLER_CNT                                                \
@@ -273,6 +283,119 @@ imgr_erase_state(struct mgmt_ctxt *ctxt)
     return 0;
 }
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WIN)
+/*
+ * Windowed image upload.  Unlike the upload command, several requests may be
+ * in flight at once.  The response always carries the cumulative offset;
+ * every chunk below it is in flash.  A chunk that cannot be buffered is
+ * rejected with MGMT_ERR_ENOMEM, and the client resends from the offset in
+ * the response.
+ *
+ * Request:
+ * {
+ *      "off":<offset>,
+ *      "len":<img_size>        inspected when off = 0
+ *      "data":<binary>
+ * }
+ *
+ * Response:
+ * {
+ *      "rc":<status>,
+ *      "off":<offset written so far>,
+ *      "win":<bytes that can be in flight>     only when off = 0
+ * }
+ */
+static int
+imgr_upload_win(struct mgmt_ctxt *ctxt)
+{
+    uint8_t data[MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)];
+    unsigned long long size = UINT_MAX;
+    unsigned long long off = UINT_MAX;
+    size_t data_len = 0;
+    const struct cbor_attr_t upload_attr[4] = {
+        [0] = {
+            .attribute = "data",
+            .type = CborAttrByteStringType,
+            .addr.bytestring.data = data,
+            .addr.bytestring.len = &data_len,
+            .len = sizeof(data)
+        },
+        [1] = {
+            .attribute = "len",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &size,
+            .nodefault = true
+        },
+        [2] = {
+            .attribute = "off",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &off,
+            .nodefault = true
+        },
+        [3] = { 0 },
+    };
+    CborError g_err = CborNoError;
+    int rc;
+
+    rc = cbor_read_object(&ctxt->it, upload_attr);
+    if (rc != 0 || off == UINT_MAX) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (off == 0) {
+        if (size == UINT_MAX) {
+            return MGMT_ERR_EINVAL;
+        }
+        if (imgr_upload_cb != NULL) {
+            rc = imgr_upload_cb(off, size, imgr_upload_arg);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+        rc = imgr_upload_start(size);
+    } else {
+        rc = 0;
+    }
+
+    if (rc == 0) {
+        rc = imgr_upload_write(off, data, data_len);
+    }
+
+    switch (rc) {
+    case 0:
+        rc = MGMT_ERR_EOK;
+        break;
+    case SYS_ENOENT:
+        rc = MGMT_ERR_ENOENT;
+        break;
+    case SYS_ENOMEM:
+        rc = MGMT_ERR_ENOMEM;
+        break;
+    case SYS_EINVAL:
+        rc = MGMT_ERR_EINVAL;
+        break;
+    default:
+        rc = MGMT_ERR_EUNKNOWN;
+        break;
+    }
+
+    g_err |= cbor_encode_text_stringz(&ctxt->encoder, "rc");
+    g_err |= cbor_encode_int(&ctxt->encoder, rc);
+    g_err |= cbor_encode_text_stringz(&ctxt->encoder, "off");
+    g_err |= cbor_encode_uint(&ctxt->encoder, imgr_upload_off());
+    if (off == 0) {
+        g_err |= cbor_encode_text_stringz(&ctxt->encoder, "win");
+        g_err |= cbor_encode_uint(&ctxt->encoder, imgr_upload_win_size());
+    }
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+#endif
+
 void
 imgmgr_module_init(void)
 {
@@ -0,0 +1,352 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Windowed image upload.
+ *
+ * The image is written in order.  Chunks that arrive ahead of the write
+ * pointer are buffered, up to IMGMGR_UPLOAD_WIN_CHUNKS of them, and written
+ * once the gap before them is filled.  The write pointer doubles as a
+ * cumulative acknowledgement: every byte below it is in flash.
+ *
+ * Rather than erasing the whole slot when the upload starts, sectors are
+ * erased one at a time, by an event on the upload's event queue, until the
+ * erased region extends IMGMGR_UPLOAD_ERASE_AHEAD bytes past the window.
+ * Image management requests must be processed on the same queue (the
+ * default one, unless set with imgr_upload_evq_set()), so erases run between
+ * requests, while responses are in transit, and never race with writes.  A
+ * write that gets ahead of the erase frontier erases what it needs itself.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WIN)
+
+#include <assert.h>
+#include <string.h>
+
+#include "flash_map/flash_map.h"
+#include "imgmgr/imgmgr.h"
+
+#define IMGR_UPLOAD_CHUNK_SZ    MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)
+#define IMGR_UPLOAD_WIN_CHUNKS  MYNEWT_VAL(IMGMGR_UPLOAD_WIN_CHUNKS)
+#define IMGR_UPLOAD_WIN_SZ      (IMGR_UPLOAD_WIN_CHUNKS * IMGR_UPLOAD_CHUNK_SZ)
+
+struct imgr_upload_chunk {
+    uint32_t iuc_off;
+    /* 0 if the buffer is free. */
+    uint16_t iuc_len;
+    uint8_t iuc_data[IMGR_UPLOAD_CHUNK_SZ];
+};
+
+static struct {
+    const struct flash_area *iu_fa;
+    uint32_t iu_size;
+
+    /* Everything below this offset has been written. */
+    uint32_t iu_off;
+
+    /* Everything below this offset has been erased or written. */
+    uint32_t iu_erased;
+
+    /* Index of the last sector erased, for flash_area_getnext_sector(). */
+    int iu_sec_id;
+
+    struct imgr_upload_chunk iu_chunks[IMGR_UPLOAD_WIN_CHUNKS];
+} imgr_upload;
+
+static void imgr_upload_erase_ev_cb(struct os_event *ev);
+
+static struct os_event imgr_upload_erase_ev = {
+    .ev_cb = imgr_upload_erase_ev_cb,
+};
+
+static struct os_eventq *imgr_upload_evq;
+
+static struct os_eventq *
+imgr_upload_evq_get(void)
+{
+    if (imgr_upload_evq == NULL) {
+        return os_eventq_dflt_get();
+    }
+    return imgr_upload_evq;
+}
+
+/**
+ * Checks that the caller is the task that runs the erase events, i.e. that
+ * the image group has not been moved to another queue behind our back.
+ */
+static bool
+imgr_upload_on_evq(void)
+{
+    struct os_task *owner;
+
+    owner = imgr_upload_evq_get()->evq_owner;
+    return owner == NULL || owner == os_sched_get_current_task();
+}
+
+static int
+imgr_upload_erase_next(void)
+{
+    struct flash_area sector;
+    uint32_t end;
+    int rc;
+
+    rc = flash_area_getnext_sector(imgr_upload.iu_fa->fa_id,
+                                   &imgr_upload.iu_sec_id, &sector);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+
+    rc = flash_area_erase(imgr_upload.iu_fa,
+                          sector.fa_off - imgr_upload.iu_fa->fa_off,
+                          sector.fa_size);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+
+    end = sector.fa_off - imgr_upload.iu_fa->fa_off + sector.fa_size;
+    if (end > imgr_upload.iu_fa->fa_size) {
+        end = imgr_upload.iu_fa->fa_size;
+    }
+    imgr_upload.iu_erased = end;
+
+    return 0;
+}
+
+/**
+ * Returns the offset up to which the slot should be erased ahead of time.
+ */
+static uint32_t
+imgr_upload_erase_target(void)
+{
+    uint32_t target;
+
+    target = imgr_upload.iu_off + IMGR_UPLOAD_WIN_SZ +
+             MYNEWT_VAL(IMGMGR_UPLOAD_ERASE_AHEAD);
+    if (target > imgr_upload.iu_size) {
+        target = imgr_upload.iu_size;
+    }
+
+    return target;
+}
+
+static void
+imgr_upload_erase_ev_cb(struct os_event *ev)
+{
+    if (imgr_upload.iu_fa == NULL ||
+        imgr_upload.iu_erased >= imgr_upload_erase_target()) {
+        return;
+    }
+
+    /* On failure, stop; the next write retries and reports the error. */
+    if (imgr_upload_erase_next() == 0) {
+        os_eventq_put(imgr_upload_evq_get(), &imgr_upload_erase_ev);
+    }
+}
+
+static int
+imgr_upload_flash_write(const void *data, uint32_t len)
+{
+    int rc;
+
+    while (imgr_upload.iu_erased < imgr_upload.iu_off + len) {
+        rc = imgr_upload_erase_next();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    rc = flash_area_write(imgr_upload.iu_fa, imgr_upload.iu_off, data, len);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+    imgr_upload.iu_off += len;
+
+    return 0;
+}
+
+/**
+ * Writes buffered chunks that have become contiguous with the write pointer,
+ * and frees those that are entirely below it.
+ */
+static int
+imgr_upload_drain(void)
+{
+    struct imgr_upload_chunk *chunk;
+    uint32_t skip;
+    bool progress;
+    int rc;
+    int i;
+
+    do {
+        progress = false;
+        for (i = 0; i < IMGR_UPLOAD_WIN_CHUNKS; i++) {
+            chunk = &imgr_upload.iu_chunks[i];
+            if (chunk->iuc_len == 0 || chunk->iuc_off > imgr_upload.iu_off) {
+                continue;
+            }
+
+            skip = imgr_upload.iu_off - chunk->iuc_off;
+            if (skip < chunk->iuc_len) {
+                rc = imgr_upload_flash_write(chunk->iuc_data + skip,
+                                             chunk->iuc_len - skip);
+                if (rc != 0) {
+                    return rc;
+                }
+                progress = true;
+            }
+            chunk->iuc_len = 0;
+        }
+    } while (progress);
+
+    return 0;
+}
+
+static int
+imgr_upload_buffer(uint32_t off, const void *data, uint32_t len)
+{
+    struct imgr_upload_chunk *free_chunk;
+    struct imgr_upload_chunk *chunk;
+    int i;
+
+    if (off + len > imgr_upload.iu_off + IMGR_UPLOAD_WIN_SZ) {
+        return SYS_ENOMEM;
+    }
+
+    free_chunk = NULL;
+    for (i = 0; i < IMGR_UPLOAD_WIN_CHUNKS; i++) {
+        chunk = &imgr_upload.iu_chunks[i];
+        if (chunk->iuc_len == 0) {
+            if (free_chunk == NULL) {
+                free_chunk = chunk;
+            }
+        } else if (chunk->iuc_off == off && chunk->iuc_len >= len) {
+            /* Retransmission of a buffered chunk. */
+            return 0;
+        }
+    }
+
+    if (free_chunk == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    free_chunk->iuc_off = off;
+    free_chunk->iuc_len = len;
+    memcpy(free_chunk->iuc_data, data, len);
+
+    return 0;
+}
+
+int
+imgr_upload_start(uint32_t size)
+{
+    const struct flash_area *fa;
+    int area_id;
+    int rc;
+
+    assert(imgr_upload_on_evq());
+
+    imgr_upload.iu_fa = NULL;
+
+    area_id = imgmgr_find_best_area_id();
+    if (area_id < 0) {
+        return SYS_ENOENT;
+    }
+
+    rc = flash_area_open(area_id, &fa);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+
+    if (size == 0 || size > fa->fa_size) {
+        flash_area_close(fa);
+        return SYS_EINVAL;
+    }
+
+    memset(&imgr_upload, 0, sizeof imgr_upload);
+    imgr_upload.iu_fa = fa;
+    imgr_upload.iu_size = size;
+    imgr_upload.iu_sec_id = -1;
+
+    os_eventq_put(imgr_upload_evq_get(), &imgr_upload_erase_ev);
+    imgmgr_dfu_started();
+
+    return 0;
+}
+
+int
+imgr_upload_write(uint32_t off, const void *data, uint32_t len)
+{
+    uint32_t skip;
+    int rc;
+
+    assert(imgr_upload_on_evq());
+
+    if (imgr_upload.iu_fa == NULL || len == 0 ||
+        len > IMGR_UPLOAD_CHUNK_SZ || off > imgr_upload.iu_size ||
+        len > imgr_upload.iu_size - off) {
+
+        return SYS_EINVAL;
+    }
+
+    if (off + len <= imgr_upload.iu_off) {
+        /* Already written. */
+        return 0;
+    }
+
+    if (off > imgr_upload.iu_off) {
+        return imgr_upload_buffer(off, data, len);
+    }
+
+    skip = imgr_upload.iu_off - off;
+    rc = imgr_upload_flash_write((const uint8_t *)data + skip, len - skip);
+    if (rc == 0) {
+        rc = imgr_upload_drain();
+    }
+
+    if (imgr_upload.iu_off == imgr_upload.iu_size) {
+        flash_area_close(imgr_upload.iu_fa);
+        imgmgr_dfu_pending();
+    } else {
+        os_eventq_put(imgr_upload_evq_get(), &imgr_upload_erase_ev);
+    }
+
+    return rc;
+}
+
+void
+imgr_upload_evq_set(struct os_eventq *evq)
+{
+    imgr_upload_evq = evq;
+}
+
+uint32_t
+imgr_upload_off(void)
+{
+    return imgr_upload.iu_off;
+}
+
+uint32_t
+imgr_upload_win_size(void)
+{
+    return IMGR_UPLOAD_WIN_SZ;
+}
+
+#endif
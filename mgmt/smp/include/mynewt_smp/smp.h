@@ -60,6 +60,25 @@ struct smp_transport {
     struct os_mqueue st_imq;
     smp_transport_out_func_t st_output;
     smp_transport_get_mtu_func_t st_get_mtu;
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    /* Requests for bound groups; indexed like the binding table. */
+    struct os_mqueue st_gq[MYNEWT_VAL(SMP_GROUP_QUEUE_CNT)];
+
+    /* Keeps fragments of responses from different queues apart. */
+    struct os_mutex st_tx_lock;
+#endif
+};
+
+/** Request processing time statistics for one command group. */
+struct smp_group_stats {
+    /* Number of requests processed. */
+    uint32_t sgs_req_cnt;
+
+    /* Longest processing time, in microseconds. */
+    uint32_t sgs_time_max;
+
+    /* Sum of all processing times, in microseconds. */
+    uint64_t sgs_time_sum;
 };
 
 void smp_event_put(struct os_event *ev);
@@ -69,6 +88,50 @@ int smp_transport_init(struct smp_transport *st,
 int smp_rx_req(struct smp_transport *st, struct os_mbuf *req);
 struct os_eventq *mgmt_evq_get(void);
 
+/**
+ * Routes requests for the specified command group to their own event queue.
+ * Requests of a group are processed in order; requests of different groups
+ * may complete out of order.  Responses sent over a transport are never
+ * interleaved.  Handlers of a bound group run in the context of the task
+ * serving the event queue and must not rely on being serialized with
+ * handlers of other groups.
+ *
+ * Bindings are meant to be set up during initialization, before requests
+ * arrive.  Binding a group again replaces its event queue.  The image
+ * group's background erases must run on the same queue as its requests; see
+ * imgr_upload_evq_set().
+ *
+ * @param group_id              The command group (MGMT_GROUP_ID_[...]).
+ * @param evq                   The event queue to process the group's
+ *                                  requests on.
+ *
+ * @return                      0 on success;
+ *                              MGMT_ERR_ENOMEM if SMP_GROUP_QUEUE_CNT
+ *                                  groups are already bound;
+ *                              MGMT_ERR_EINVAL on bad arguments.
+ */
+int smp_group_evq_set(uint16_t group_id, struct os_eventq *evq);
+
+/**
+ * Retrieves the request processing time statistics of a command group.
+ * Processing time is measured from when a request is taken off its queue
+ * until its response has been passed to the transport.  Only the first
+ * SMP_GROUP_STATS_CNT groups that receive requests are tracked.
+ *
+ * @param group_id              The command group (MGMT_GROUP_ID_[...]).
+ * @param out_stats             On success, the group's statistics are
+ *                                  written here.
+ *
+ * @return                      0 on success;
+ *                              MGMT_ERR_ENOENT if the group is not tracked.
+ */
+int smp_group_stats_get(uint16_t group_id, struct smp_group_stats *out_stats);
+
+/**
+ * Clears the statistics of all command groups.
+ */
+void smp_group_stats_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,55 @@ extern "C" {
 #define SMP_ID_MPSTATS         3
 #define SMP_ID_DATETIME_STR    4
 #define SMP_ID_RESET           5
+#define SMP_ID_STATSNAP        16
+
+/*
+ * Statistics snapshot ("statsnap") format.  The response carries the
+ * snapshot as a byte string; all fields are little-endian.
+ *
+ * Header:
+ *     u8  version          SMP_OS_SNAP_VERSION
+ *     u8  flags            SMP_OS_SNAP_F_[...]
+ *     u8  task_cnt         Number of task records
+ *     u8  pool_cnt         Number of pool records
+ *     u8  task_rec_sz      Size of a task record
+ *     u8  pool_rec_sz      Size of a pool record
+ *     u16 seq              Sequence number of this snapshot
+ *     u16 base_seq         Snapshot this one is relative to (delta only)
+ *     u16 reserved
+ *     u32 time_ms          Uptime when the snapshot was taken
+ *
+ * Task record:
+ *     u8  taskid
+ *     u8  prio
+ *     u8  state
+ *     u8  reserved
+ *     u16 stksize          Stack size, in stack words
+ *     u16 stkuse           Stack high-water mark, in stack words
+ *     u32 runtime          Run time, as reported by taskstat
+ *     u32 cswcnt           Context switch count
+ *
+ * Pool record:
+ *     u8  index            Position of the pool in mpstat's listing
+ *     u8  reserved
+ *     u16 blksize
+ *     u16 nblks
+ *     u16 nfree
+ *     u16 min
+ *
+ * In a delta snapshot, runtime and cswcnt are increments since the base
+ * snapshot, and records that have not changed are left out.  Readers
+ * should step through records using the record sizes in the header, so
+ * that fields appended in later versions can be skipped.
+ */
+#define SMP_OS_SNAP_VERSION    1
+
+#define SMP_OS_SNAP_F_DELTA    0x01 /* Delta against base_seq */
+#define SMP_OS_SNAP_F_TRUNC    0x02 /* Some tasks or pools left out */
+
+#define SMP_OS_SNAP_HDR_SZ     16
+#define SMP_OS_SNAP_TASK_SZ    16
+#define SMP_OS_SNAP_POOL_SZ    10
 
 void smp_os_groups_register(void);
 
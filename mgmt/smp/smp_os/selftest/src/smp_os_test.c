@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "mgmt/mgmt.h"
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "tinycbor/cbor_buf_writer.h"
+#include "smp_os_test_priv.h"
+
+#define SMP_OS_TEST_REQ_SZ      32
+#define SMP_OS_TEST_RSP_SZ      1024
+
+/**
+ * Runs the statsnap command handler, as the SMP server would.
+ *
+ * @param base                  Sequence number to send as "base"; -1 to
+ *                                  leave it out.
+ * @param buf                   Buffer to copy the snapshot into.
+ * @param buf_sz                Size of the buffer.
+ *
+ * @return                      The length of the snapshot.
+ */
+int
+smp_os_test_statsnap_run(int base, uint8_t *buf, int buf_sz)
+{
+    static uint8_t req_buf[SMP_OS_TEST_REQ_SZ];
+    static uint8_t rsp_buf[SMP_OS_TEST_RSP_SZ];
+    const struct mgmt_handler *handler;
+    struct cbor_buf_writer writer;
+    struct cbor_buf_reader reader;
+    struct mgmt_ctxt ctxt;
+    CborEncoder enc;
+    CborEncoder map;
+    CborParser parser;
+    CborValue root;
+    CborValue val;
+    size_t len;
+    int rsp_rc;
+    int rc;
+
+    handler = mgmt_find_handler(MGMT_GROUP_ID_OS, SMP_ID_STATSNAP);
+    TEST_ASSERT_FATAL(handler != NULL && handler->mh_read != NULL);
+
+    cbor_buf_writer_init(&writer, req_buf, sizeof req_buf);
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    if (base >= 0) {
+        rc |= cbor_encode_text_stringz(&map, "base");
+        rc |= cbor_encode_int(&map, base);
+    }
+    rc |= cbor_encoder_close_container(&enc, &map);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(&ctxt, 0, sizeof ctxt);
+    cbor_buf_reader_init(&reader, req_buf,
+                         cbor_buf_writer_buffer_size(&writer, req_buf));
+    rc = cbor_parser_init(&reader.r, 0, &ctxt.parser, &ctxt.it);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The handler encodes into the response map the server opened. */
+    cbor_buf_writer_init(&writer, rsp_buf, sizeof rsp_buf);
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    rc = cbor_encoder_create_map(&enc, &ctxt.encoder, CborIndefiniteLength);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = handler->mh_read(&ctxt);
+    TEST_ASSERT_FATAL(rc == 0, "rc=%d", rc);
+    rc = cbor_encoder_close_container(&enc, &ctxt.encoder);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    cbor_buf_reader_init(&reader, rsp_buf,
+                         cbor_buf_writer_buffer_size(&writer, rsp_buf));
+    rc = cbor_parser_init(&reader.r, 0, &parser, &root);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = cbor_value_map_find_value(&root, "rc", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_integer(&val));
+    rc = cbor_value_get_int(&val, &rsp_rc);
+    TEST_ASSERT_FATAL(rc == 0 && rsp_rc == 0);
+
+    rc = cbor_value_map_find_value(&root, "snap", &val);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_byte_string(&val));
+    len = buf_sz;
+    rc = cbor_value_copy_byte_string(&val, buf, &len, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return len;
+}
+
+/**
+ * Decodes a snapshot header, checking it against the snapshot length.
+ */
+void
+smp_os_test_snap_parse(const uint8_t *buf, int len,
+                       struct smp_os_test_snap *snap)
+{
+    TEST_ASSERT_FATAL(len >= SMP_OS_SNAP_HDR_SZ);
+    TEST_ASSERT_FATAL(buf[0] == SMP_OS_SNAP_VERSION);
+
+    snap->flags = buf[1];
+    snap->num_tasks = buf[2];
+    snap->num_pools = buf[3];
+    snap->task_sz = buf[4];
+    snap->pool_sz = buf[5];
+    snap->seq = get_le16(buf + 6);
+    snap->base_seq = get_le16(buf + 8);
+
+    TEST_ASSERT_FATAL(snap->task_sz >= SMP_OS_SNAP_TASK_SZ);
+    TEST_ASSERT_FATAL(snap->pool_sz >= SMP_OS_SNAP_POOL_SZ);
+    TEST_ASSERT_FATAL(len == SMP_OS_SNAP_HDR_SZ +
+                             snap->num_tasks * snap->task_sz +
+                             snap->num_pools * snap->pool_sz);
+
+    snap->tasks = buf + SMP_OS_SNAP_HDR_SZ;
+    snap->pools = snap->tasks + snap->num_tasks * snap->task_sz;
+}
+
+/**
+ * Returns the record of the specified task; NULL if there is none.
+ */
+const uint8_t *
+smp_os_test_snap_task(const struct smp_os_test_snap *snap, uint8_t tid)
+{
+    const uint8_t *rec;
+    int i;
+
+    for (i = 0; i < snap->num_tasks; i++) {
+        rec = snap->tasks + i * snap->task_sz;
+        if (rec[0] == tid) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns the record of the pool at the specified position in the pool
+ * list; NULL if there is none.
+ */
+const uint8_t *
+smp_os_test_snap_pool(const struct smp_os_test_snap *snap, uint8_t idx)
+{
+    const uint8_t *rec;
+    int i;
+
+    for (i = 0; i < snap->num_pools; i++) {
+        rec = snap->pools + i * snap->pool_sz;
+        if (rec[0] == idx) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+TEST_SUITE(smp_os_test_suite)
+{
+    smp_os_test_statsnap();
+}
+
+int
+main(int argc, char **argv)
+{
+    smp_os_test_suite();
+
+    return tu_any_failed;
+}
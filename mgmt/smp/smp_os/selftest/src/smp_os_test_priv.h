@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_SMP_OS_TEST_PRIV_
+#define H_SMP_OS_TEST_PRIV_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "smp_os/smp_os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TEST_CASE_DECL(smp_os_test_statsnap);
+
+/** A decoded statistics snapshot; records point into the raw snapshot. */
+struct smp_os_test_snap {
+    uint8_t flags;
+    int num_tasks;
+    int num_pools;
+    int task_sz;
+    int pool_sz;
+    uint16_t seq;
+    uint16_t base_seq;
+    const uint8_t *tasks;
+    const uint8_t *pools;
+};
+
+int smp_os_test_statsnap_run(int base, uint8_t *buf, int buf_sz);
+void smp_os_test_snap_parse(const uint8_t *buf, int len,
+                            struct smp_os_test_snap *snap);
+const uint8_t *smp_os_test_snap_task(const struct smp_os_test_snap *snap,
+                                     uint8_t tid);
+const uint8_t *smp_os_test_snap_pool(const struct smp_os_test_snap *snap,
+                                     uint8_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
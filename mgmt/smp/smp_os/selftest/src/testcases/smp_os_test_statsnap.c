@@ -0,0 +1,241 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "smp_os_test_priv.h"
+
+#define SOT_SNAP_SZ                                                 \
+    (SMP_OS_SNAP_HDR_SZ +                                           \
+     MYNEWT_VAL(SMP_OS_STATSNAP_MAX_TASKS) * SMP_OS_SNAP_TASK_SZ +  \
+     MYNEWT_VAL(SMP_OS_STATSNAP_MAX_POOLS) * SMP_OS_SNAP_POOL_SZ)
+
+#define SOT_WORKER_PRIO     10
+#define SOT_STACK_SIZE      OS_STACK_ALIGN(1024)
+#define SOT_WAKES           3
+
+#define SOT_BLOCK_CNT       4
+#define SOT_BLOCK_SZ        32
+
+static struct os_task sot_worker[2];
+static os_stack_t sot_stack[2][SOT_STACK_SIZE];
+static struct os_sem sot_sem[2];
+
+static struct os_mempool sot_pool[2];
+static os_membuf_t sot_pool_mem[2][OS_MEMPOOL_SIZE(SOT_BLOCK_CNT,
+                                                  SOT_BLOCK_SZ)];
+
+static uint8_t sot_full_buf[SOT_SNAP_SZ];
+static uint8_t sot_buf[SOT_SNAP_SZ];
+
+/* Switched in once each time its semaphore is released. */
+static void
+sot_worker_handler(void *arg)
+{
+    while (1) {
+        os_sem_pend(arg, OS_TIMEOUT_NEVER);
+    }
+}
+
+static void
+sot_worker_start(int i)
+{
+    int rc;
+
+    rc = os_sem_init(&sot_sem[i], 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_task_init(&sot_worker[i], "sot_worker", sot_worker_handler,
+                      &sot_sem[i], SOT_WORKER_PRIO + i, OS_WAIT_FOREVER,
+                      sot_stack[i], SOT_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Creates a test pool.
+ *
+ * @return                      The position of the pool in the pool list.
+ */
+static int
+sot_pool_start(int i)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    int idx;
+    int rc;
+
+    rc = os_mempool_init(&sot_pool[i], SOT_BLOCK_CNT, SOT_BLOCK_SZ,
+                         sot_pool_mem[i], "sot_pool");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    idx = 0;
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != &sot_pool[i]) {
+        TEST_ASSERT_FATAL(mp != NULL);
+        idx++;
+    }
+    return idx;
+}
+
+static int
+sot_num_tasks(void)
+{
+    struct os_task_info oti;
+    struct os_task *t;
+    int cnt;
+
+    cnt = 0;
+    t = NULL;
+    while ((t = os_task_info_get_next(t, &oti)) != NULL) {
+        cnt++;
+    }
+    return cnt;
+}
+
+static int
+sot_num_pools(void)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    int cnt;
+
+    cnt = 0;
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ * Checks that a snapshot is a full one listing every task and pool.
+ */
+static void
+sot_check_full(const struct smp_os_test_snap *snap)
+{
+    TEST_ASSERT(!(snap->flags & SMP_OS_SNAP_F_DELTA));
+    TEST_ASSERT(!(snap->flags & SMP_OS_SNAP_F_TRUNC));
+    TEST_ASSERT(snap->seq != 0);
+    TEST_ASSERT(snap->base_seq == 0);
+    TEST_ASSERT(snap->num_tasks == sot_num_tasks());
+    TEST_ASSERT(snap->num_pools == sot_num_pools());
+}
+
+TEST_CASE_TASK(smp_os_test_statsnap)
+{
+    struct smp_os_test_snap full;
+    struct smp_os_test_snap snap;
+    const uint8_t *base_rec;
+    const uint8_t *rec;
+    uint8_t tid;
+    void *blk;
+    int pool_idx;
+    int len;
+    int i;
+
+    sot_worker_start(0);
+    tid = sot_worker[0].t_taskid;
+    pool_idx = sot_pool_start(0);
+
+    /*** A full snapshot lists every task and pool, with absolute counts. */
+    len = smp_os_test_statsnap_run(-1, sot_full_buf, sizeof sot_full_buf);
+    smp_os_test_snap_parse(sot_full_buf, len, &full);
+    sot_check_full(&full);
+
+    rec = smp_os_test_snap_task(&full, tid);
+    TEST_ASSERT_FATAL(rec != NULL);
+    TEST_ASSERT(rec[1] == SOT_WORKER_PRIO);
+    TEST_ASSERT(get_le16(rec + 4) == SOT_STACK_SIZE);
+    TEST_ASSERT(get_le32(rec + 12) == sot_worker[0].t_ctx_sw_cnt);
+
+    rec = smp_os_test_snap_pool(&full, pool_idx);
+    TEST_ASSERT_FATAL(rec != NULL);
+    TEST_ASSERT(get_le16(rec + 2) == SOT_BLOCK_SZ);
+    TEST_ASSERT(get_le16(rec + 4) == SOT_BLOCK_CNT);
+    TEST_ASSERT(get_le16(rec + 6) == SOT_BLOCK_CNT);
+    TEST_ASSERT(get_le16(rec + 8) == SOT_BLOCK_CNT);
+
+    /*** A delta holds increments, for changed tasks and pools only. */
+    for (i = 0; i < SOT_WAKES; i++) {
+        os_sem_release(&sot_sem[0]);
+    }
+    blk = os_memblock_get(&sot_pool[0]);
+    TEST_ASSERT_FATAL(blk != NULL);
+
+    len = smp_os_test_statsnap_run(full.seq, sot_buf, sizeof sot_buf);
+    smp_os_test_snap_parse(sot_buf, len, &snap);
+    TEST_ASSERT_FATAL(snap.flags & SMP_OS_SNAP_F_DELTA);
+    TEST_ASSERT(snap.base_seq == full.seq);
+    TEST_ASSERT(snap.seq != full.seq);
+    TEST_ASSERT(snap.num_tasks < full.num_tasks);
+
+    rec = smp_os_test_snap_task(&snap, tid);
+    TEST_ASSERT_FATAL(rec != NULL);
+    TEST_ASSERT(get_le32(rec + 12) == SOT_WAKES);
+
+    rec = smp_os_test_snap_pool(&snap, pool_idx);
+    TEST_ASSERT_FATAL(rec != NULL);
+    TEST_ASSERT(get_le16(rec + 6) == SOT_BLOCK_CNT - 1);
+    TEST_ASSERT(get_le16(rec + 8) == SOT_BLOCK_CNT - 1);
+
+    for (i = 0; i < snap.num_tasks; i++) {
+        rec = snap.tasks + i * snap.task_sz;
+        base_rec = smp_os_test_snap_task(&full, rec[0]);
+        TEST_ASSERT_FATAL(base_rec != NULL);
+        TEST_ASSERT(rec[1] != base_rec[1] || rec[2] != base_rec[2] ||
+                    get_le16(rec + 6) != get_le16(base_rec + 6) ||
+                    get_le32(rec + 8) != 0 || get_le32(rec + 12) != 0,
+                    "task %d unchanged", rec[0]);
+    }
+    for (i = 0; i < snap.num_pools; i++) {
+        rec = snap.pools + i * snap.pool_sz;
+        base_rec = smp_os_test_snap_pool(&full, rec[0]);
+        TEST_ASSERT_FATAL(base_rec != NULL);
+        TEST_ASSERT(get_le16(rec + 6) != get_le16(base_rec + 6) ||
+                    get_le16(rec + 8) != get_le16(base_rec + 8),
+                    "pool %d unchanged", rec[0]);
+    }
+
+    /*** A stale base gets a full snapshot. */
+    len = smp_os_test_statsnap_run(full.seq, sot_buf, sizeof sot_buf);
+    smp_os_test_snap_parse(sot_buf, len, &snap);
+    sot_check_full(&snap);
+    rec = smp_os_test_snap_task(&snap, tid);
+    TEST_ASSERT_FATAL(rec != NULL);
+    TEST_ASSERT(get_le32(rec + 12) == sot_worker[0].t_ctx_sw_cnt);
+
+    /*** So does a change in the set of tasks... */
+    sot_worker_start(1);
+    len = smp_os_test_statsnap_run(snap.seq, sot_buf, sizeof sot_buf);
+    smp_os_test_snap_parse(sot_buf, len, &snap);
+    sot_check_full(&snap);
+    TEST_ASSERT(smp_os_test_snap_task(&snap,
+                                      sot_worker[1].t_taskid) != NULL);
+
+    /*** ...or of pools. */
+    pool_idx = sot_pool_start(1);
+    len = smp_os_test_statsnap_run(snap.seq, sot_buf, sizeof sot_buf);
+    smp_os_test_snap_parse(sot_buf, len, &snap);
+    sot_check_full(&snap);
+    TEST_ASSERT(smp_os_test_snap_pool(&snap, pool_idx) != NULL);
+
+    /*** With the set unchanged again, deltas resume. */
+    len = smp_os_test_statsnap_run(snap.seq, sot_buf, sizeof sot_buf);
+    smp_os_test_snap_parse(sot_buf, len, &snap);
+    TEST_ASSERT(snap.flags & SMP_OS_SNAP_F_DELTA);
+
+    os_memblock_put(&sot_pool[0], blk);
+}
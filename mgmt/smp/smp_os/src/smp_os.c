@@ -35,6 +35,7 @@
 #endif
 
 #include "smp_os/smp_os.h"
+#include "smp_os_priv.h"
 
 #include <tinycbor/cbor.h>
 #include <cborattr/cborattr.h>
@@ -43,6 +44,9 @@ static int smp_def_console_echo(struct mgmt_ctxt *cb);
 static int smp_def_mpstat_read(struct mgmt_ctxt *cb);
 static int smp_datetime_get(struct mgmt_ctxt *cb);
 static int smp_datetime_set(struct mgmt_ctxt *cb);
+#if MYNEWT_VAL(SMP_OS_STATSNAP)
+static int smp_def_statsnap_read(struct mgmt_ctxt *cb);
+#endif
 
 static const struct mgmt_handler smp_def_group_handlers[] = {
     [SMP_ID_CONS_ECHO_CTRL] = {
@@ -54,6 +58,11 @@ static const struct mgmt_handler smp_def_group_handlers[] = {
     [SMP_ID_DATETIME_STR] = {
         smp_datetime_get, smp_datetime_set
     },
+#if MYNEWT_VAL(SMP_OS_STATSNAP)
+    [SMP_ID_STATSNAP] = {
+        smp_def_statsnap_read, NULL
+    },
+#endif
 };
 
 #define SMP_DEF_GROUP_SZ                                               \
@@ -136,6 +145,47 @@ smp_def_mpstat_read(struct mgmt_ctxt *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(SMP_OS_STATSNAP)
+static int
+smp_def_statsnap_read(struct mgmt_ctxt *cb)
+{
+    static uint8_t buf[SMP_OS_SNAP_MAX_SZ];
+    long long int base = -1;
+    CborError g_err = CborNoError;
+    int len;
+    int rc;
+    struct cbor_attr_t attrs[2] = {
+        [0] = {
+            .attribute = "base",
+            .type = CborAttrIntegerType,
+            .addr.integer = &base,
+            .nodefault = 1
+        },
+        [1] = { 0 },
+    };
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (base < 0 || base > UINT16_MAX) {
+        base = -1;
+    }
+
+    len = smp_os_snap_build(base, buf);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "snap");
+    g_err |= cbor_encode_byte_string(&cb->encoder, buf, len);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+#endif
+
 static int
 smp_datetime_get(struct mgmt_ctxt *cb)
 {
@@ -0,0 +1,40 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_SMP_OS_PRIV_
+#define H_SMP_OS_PRIV_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SMP_OS_SNAP_MAX_SZ                                      \
+    (SMP_OS_SNAP_HDR_SZ +                                       \
+     MYNEWT_VAL(SMP_OS_STATSNAP_MAX_TASKS) * SMP_OS_SNAP_TASK_SZ + \
+     MYNEWT_VAL(SMP_OS_STATSNAP_MAX_POOLS) * SMP_OS_SNAP_POOL_SZ)
+
+int smp_os_snap_build(int base_seq, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
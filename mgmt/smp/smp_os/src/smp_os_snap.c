@@ -0,0 +1,269 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(SMP_OS_STATSNAP)
+
+#include <string.h>
+#include "smp_os/smp_os.h"
+#include "smp_os_priv.h"
+
+#define SMP_OS_SNAP_MAX_TASKS   MYNEWT_VAL(SMP_OS_STATSNAP_MAX_TASKS)
+#define SMP_OS_SNAP_MAX_POOLS   MYNEWT_VAL(SMP_OS_STATSNAP_MAX_POOLS)
+
+struct smp_os_snap_task {
+    uint8_t tid;
+    uint8_t prio;
+    uint8_t state;
+    uint16_t stksize;
+    uint16_t stkuse;
+    uint32_t runtime;
+    uint32_t cswcnt;
+};
+
+struct smp_os_snap_pool {
+    uint16_t blksize;
+    uint16_t nblks;
+    uint16_t nfree;
+    uint16_t min;
+};
+
+/**
+ * The statistics of one snapshot.  Two are kept: the one being taken, and
+ * the last one sent, which deltas are computed against.
+ */
+struct smp_os_snap {
+    struct smp_os_snap_task tasks[SMP_OS_SNAP_MAX_TASKS];
+    struct smp_os_snap_pool pools[SMP_OS_SNAP_MAX_POOLS];
+    uint8_t num_tasks;
+    uint8_t num_pools;
+    uint8_t trunc;
+};
+
+static struct smp_os_snap smp_os_snaps[2];
+
+/* Index of the last snapshot sent in smp_os_snaps[]. */
+static uint8_t smp_os_snap_last;
+
+/* Sequence number of the last snapshot sent; 0 if none. */
+static uint16_t smp_os_snap_seq;
+
+static uint16_t
+smp_os_snap_clamp16(int val)
+{
+    if (val < 0) {
+        return 0;
+    }
+    if (val > UINT16_MAX) {
+        return UINT16_MAX;
+    }
+    return val;
+}
+
+static void
+smp_os_snap_take(struct smp_os_snap *snap)
+{
+    struct smp_os_snap_task *task;
+    struct smp_os_snap_pool *pool;
+    struct os_task_info oti;
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    struct os_task *t;
+
+    memset(snap, 0, sizeof *snap);
+
+    t = NULL;
+    while ((t = os_task_info_get_next(t, &oti)) != NULL) {
+        if (snap->num_tasks == SMP_OS_SNAP_MAX_TASKS) {
+            snap->trunc = 1;
+            break;
+        }
+        task = &snap->tasks[snap->num_tasks++];
+        task->tid = oti.oti_taskid;
+        task->prio = oti.oti_prio;
+        task->state = oti.oti_state;
+        task->stksize = oti.oti_stksize;
+        task->stkuse = oti.oti_stkusage;
+        task->runtime = oti.oti_runtime;
+        task->cswcnt = oti.oti_cswcnt;
+    }
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (snap->num_pools == SMP_OS_SNAP_MAX_POOLS) {
+            snap->trunc = 1;
+            break;
+        }
+        pool = &snap->pools[snap->num_pools++];
+        pool->blksize = smp_os_snap_clamp16(omi.omi_block_size);
+        pool->nblks = smp_os_snap_clamp16(omi.omi_num_blocks);
+        pool->nfree = smp_os_snap_clamp16(omi.omi_num_free);
+        pool->min = smp_os_snap_clamp16(omi.omi_min_free);
+    }
+}
+
+/**
+ * A delta can only be expressed if both snapshots list the same tasks and
+ * pools in the same order; otherwise a removed entry would be
+ * indistinguishable from an unchanged one.
+ */
+static bool
+smp_os_snap_comparable(const struct smp_os_snap *cur,
+                       const struct smp_os_snap *base)
+{
+    int i;
+
+    if (cur->num_tasks != base->num_tasks ||
+        cur->num_pools != base->num_pools) {
+        return false;
+    }
+
+    for (i = 0; i < cur->num_tasks; i++) {
+        if (cur->tasks[i].tid != base->tasks[i].tid) {
+            return false;
+        }
+    }
+
+    for (i = 0; i < cur->num_pools; i++) {
+        if (cur->pools[i].blksize != base->pools[i].blksize ||
+            cur->pools[i].nblks != base->pools[i].nblks) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Takes a statistics snapshot and encodes it in the format described in
+ * smp_os.h.  The snapshot becomes the base for the next delta.
+ *
+ * @param base_seq              Sequence number of the snapshot the client
+ *                                  holds; -1 to request a full snapshot.
+ *                                  If this is not the last snapshot sent,
+ *                                  a full snapshot is produced.
+ * @param buf                   Buffer of SMP_OS_SNAP_MAX_SZ bytes to encode
+ *                                  into.
+ *
+ * @return                      The encoded length.
+ */
+int
+smp_os_snap_build(int base_seq, uint8_t *buf)
+{
+    const struct smp_os_snap_task *bt;
+    const struct smp_os_snap_pool *bp;
+    const struct smp_os_snap_task *t;
+    const struct smp_os_snap_pool *p;
+    const struct smp_os_snap *base;
+    struct smp_os_snap *cur;
+    uint8_t num_tasks;
+    uint8_t num_pools;
+    uint8_t flags;
+    uint8_t *dst;
+    bool delta;
+    int i;
+
+    base = &smp_os_snaps[smp_os_snap_last];
+    cur = &smp_os_snaps[smp_os_snap_last ^ 1];
+
+    smp_os_snap_take(cur);
+
+    delta = smp_os_snap_seq != 0 && base_seq == smp_os_snap_seq &&
+            smp_os_snap_comparable(cur, base);
+
+    flags = 0;
+    if (delta) {
+        flags |= SMP_OS_SNAP_F_DELTA;
+    }
+    if (cur->trunc) {
+        flags |= SMP_OS_SNAP_F_TRUNC;
+    }
+
+    dst = buf + SMP_OS_SNAP_HDR_SZ;
+
+    num_tasks = 0;
+    for (i = 0; i < cur->num_tasks; i++) {
+        t = &cur->tasks[i];
+        bt = &base->tasks[i];
+        if (delta &&
+            t->prio == bt->prio && t->state == bt->state &&
+            t->stkuse == bt->stkuse && t->runtime == bt->runtime &&
+            t->cswcnt == bt->cswcnt) {
+
+            continue;
+        }
+
+        dst[0] = t->tid;
+        dst[1] = t->prio;
+        dst[2] = t->state;
+        dst[3] = 0;
+        put_le16(dst + 4, t->stksize);
+        put_le16(dst + 6, t->stkuse);
+        if (delta) {
+            put_le32(dst + 8, t->runtime - bt->runtime);
+            put_le32(dst + 12, t->cswcnt - bt->cswcnt);
+        } else {
+            put_le32(dst + 8, t->runtime);
+            put_le32(dst + 12, t->cswcnt);
+        }
+        dst += SMP_OS_SNAP_TASK_SZ;
+        num_tasks++;
+    }
+
+    num_pools = 0;
+    for (i = 0; i < cur->num_pools; i++) {
+        p = &cur->pools[i];
+        bp = &base->pools[i];
+        if (delta && p->nfree == bp->nfree && p->min == bp->min) {
+            continue;
+        }
+
+        dst[0] = i;
+        dst[1] = 0;
+        put_le16(dst + 2, p->blksize);
+        put_le16(dst + 4, p->nblks);
+        put_le16(dst + 6, p->nfree);
+        put_le16(dst + 8, p->min);
+        dst += SMP_OS_SNAP_POOL_SZ;
+        num_pools++;
+    }
+
+    /* Sequence number 0 means "no snapshot". */
+    smp_os_snap_seq++;
+    if (smp_os_snap_seq == 0) {
+        smp_os_snap_seq = 1;
+    }
+    smp_os_snap_last ^= 1;
+
+    buf[0] = SMP_OS_SNAP_VERSION;
+    buf[1] = flags;
+    buf[2] = num_tasks;
+    buf[3] = num_pools;
+    buf[4] = SMP_OS_SNAP_TASK_SZ;
+    buf[5] = SMP_OS_SNAP_POOL_SZ;
+    put_le16(buf + 6, smp_os_snap_seq);
+    put_le16(buf + 8, delta ? base_seq : 0);
+    put_le16(buf + 10, 0);
+    put_le32(buf + 12, os_get_uptime_usec() / 1000);
+
+    return dst - buf;
+}
+
+#endif
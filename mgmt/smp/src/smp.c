@@ -39,6 +39,28 @@ static mgmt_init_reader_fn smp_init_reader;
 static mgmt_init_writer_fn smp_init_writer;
 static mgmt_free_buf_fn smp_free_buf;
 
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+struct smp_group_queue {
+    uint16_t sgq_group;
+    struct os_eventq *sgq_evq;
+};
+
+static struct smp_group_queue
+    smp_group_queues[MYNEWT_VAL(SMP_GROUP_QUEUE_CNT)];
+static int smp_num_group_queues;
+#endif
+
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+struct smp_group_stats_entry {
+    uint16_t sgse_group;
+    struct smp_group_stats sgse_stats;
+};
+
+static struct smp_group_stats_entry
+    smp_group_stats[MYNEWT_VAL(SMP_GROUP_STATS_CNT)];
+static int smp_num_group_stats;
+#endif
+
 const struct mgmt_streamer_cfg g_smp_cbor_cfg = {
     .alloc_rsp = smp_alloc_rsp,
     .trim_front = smp_trim_front,
@@ -216,37 +238,210 @@ smp_tx_rsp(struct smp_streamer *ns, void *rsp, void *arg)
         return MGMT_ERR_EUNKNOWN;
     }
 
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    os_mutex_pend(&st->st_tx_lock, OS_TIMEOUT_NEVER);
+#endif
+
+    rc = 0;
     while (m != NULL) {
         frag = mem_split_frag(&m, mtu, smp_rsp_frag_alloc, rsp);
         if (frag == NULL) {
-            return MGMT_ERR_ENOMEM;
+            rc = MGMT_ERR_ENOMEM;
+            break;
         }
 
         rc = st->st_output(frag);
         if (rc != 0) {
-            return MGMT_ERR_EUNKNOWN;
+            rc = MGMT_ERR_EUNKNOWN;
+            break;
         }
     }
 
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    os_mutex_release(&st->st_tx_lock);
+#endif
+
+    return rc;
+}
+
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0 || \
+    MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+/**
+ * Reads the command group of the first request in a packet.
+ */
+static int
+smp_req_group(struct os_mbuf *req, uint16_t *out_group)
+{
+    struct mgmt_hdr hdr;
+    int rc;
+
+    rc = os_mbuf_copydata(req, 0, sizeof hdr, &hdr);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    *out_group = ntohs(hdr.nh_group);
     return 0;
 }
+#endif
+
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+static int
+smp_group_queue_find(uint16_t group)
+{
+    int i;
+
+    for (i = 0; i < smp_num_group_queues; i++) {
+        if (smp_group_queues[i].sgq_group == group) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+#endif
+
+int
+smp_group_evq_set(uint16_t group_id, struct os_eventq *evq)
+{
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    if (evq == NULL) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    i = smp_group_queue_find(group_id);
+    if (i < 0) {
+        if (smp_num_group_queues >= MYNEWT_VAL(SMP_GROUP_QUEUE_CNT)) {
+            rc = MGMT_ERR_ENOMEM;
+        } else {
+            i = smp_num_group_queues;
+            smp_group_queues[i].sgq_group = group_id;
+        }
+    }
+    if (rc == 0) {
+        smp_group_queues[i].sgq_evq = evq;
+        if (i == smp_num_group_queues) {
+            /* Publish the entry only once it is complete. */
+            smp_num_group_queues++;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+#else
+    return MGMT_ERR_ENOMEM;
+#endif
+}
+
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+static void
+smp_group_stats_record(uint16_t group, uint32_t time_us)
+{
+    struct smp_group_stats *stats;
+    os_sr_t sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+
+    stats = NULL;
+    for (i = 0; i < smp_num_group_stats; i++) {
+        if (smp_group_stats[i].sgse_group == group) {
+            stats = &smp_group_stats[i].sgse_stats;
+            break;
+        }
+    }
+    if (stats == NULL &&
+        smp_num_group_stats < MYNEWT_VAL(SMP_GROUP_STATS_CNT)) {
+
+        i = smp_num_group_stats++;
+        smp_group_stats[i].sgse_group = group;
+        stats = &smp_group_stats[i].sgse_stats;
+        memset(stats, 0, sizeof *stats);
+    }
+
+    if (stats != NULL) {
+        stats->sgs_req_cnt++;
+        stats->sgs_time_sum += time_us;
+        if (time_us > stats->sgs_time_max) {
+            stats->sgs_time_max = time_us;
+        }
+    }
+
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
+int
+smp_group_stats_get(uint16_t group_id, struct smp_group_stats *out_stats)
+{
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    rc = MGMT_ERR_ENOENT;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < smp_num_group_stats; i++) {
+        if (smp_group_stats[i].sgse_group == group_id) {
+            *out_stats = smp_group_stats[i].sgse_stats;
+            rc = 0;
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+#else
+    return MGMT_ERR_ENOENT;
+#endif
+}
+
+void
+smp_group_stats_clear(void)
+{
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    smp_num_group_stats = 0;
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
 
 /**
- * Processes a single SMP packet and sends the corresponding response(s).
+ * Processes the SMP packets queued on one of a transport's queues and sends
+ * the corresponding response(s).
  */
 static int
-smp_process_packet(struct smp_transport *st)
+smp_process_packet(struct smp_transport *st, struct os_mqueue *mq)
 {
     struct cbor_mbuf_reader reader;
     struct cbor_mbuf_writer writer;
+    struct smp_streamer streamer;
     struct os_mbuf *m;
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+    int64_t start;
+    uint16_t group;
+    int grc;
+#endif
     int rc;
 
     if (!st) {
         return MGMT_ERR_EINVAL;
     }
 
-    st->st_streamer = (struct smp_streamer) {
+    /* Requests of different groups may be processed concurrently on behalf
+     * of the same transport, so each queue uses its own streamer.
+     */
+    streamer = (struct smp_streamer) {
         .mgmt_stmr = {
             .cfg = &g_smp_cbor_cfg,
             .reader = &reader.r,
@@ -257,12 +452,24 @@ smp_process_packet(struct smp_transport *st)
     };
 
     while (1) {
-        m = os_mqueue_get(&st->st_imq);
+        m = os_mqueue_get(mq);
         if (!m) {
             break;
         }
 
-        rc = smp_process_request_packet(&st->st_streamer, m);
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+        grc = smp_req_group(m, &group);
+        start = os_get_uptime_usec();
+#endif
+
+        rc = smp_process_request_packet(&streamer, m);
+
+#if MYNEWT_VAL(SMP_GROUP_STATS_CNT) > 0
+        if (grc == 0) {
+            smp_group_stats_record(group, os_get_uptime_usec() - start);
+        }
+#endif
+
         if (rc) {
             return rc;
         }
@@ -274,9 +481,28 @@ smp_process_packet(struct smp_transport *st)
 int
 smp_rx_req(struct smp_transport *st, struct os_mbuf *req)
 {
+    struct os_eventq *evq;
+    struct os_mqueue *mq;
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    uint16_t group;
+    int i;
+#endif
     int rc;
+
+    mq = &st->st_imq;
+    evq = os_eventq_dflt_get();
+
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    if (smp_req_group(req, &group) == 0) {
+        i = smp_group_queue_find(group);
+        if (i >= 0) {
+            mq = &st->st_gq[i];
+            evq = smp_group_queues[i].sgq_evq;
+        }
+    }
+#endif
     
-    rc = os_mqueue_put(&st->st_imq, os_eventq_dflt_get(), req);
+    rc = os_mqueue_put(mq, evq, req);
     if (rc) {
         goto err;
     }
@@ -290,7 +516,7 @@ err:
 static void
 smp_event_data_in(struct os_event *ev)
 {
-    smp_process_packet(ev->ev_arg);
+    smp_process_packet(ev->ev_arg, CONTAINER_OF(ev, struct os_mqueue, mq_ev));
 }
 
 int
@@ -298,6 +524,9 @@ smp_transport_init(struct smp_transport *st,
                    smp_transport_out_func_t output_func,
                    smp_transport_get_mtu_func_t get_mtu_func)
 {
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    int i;
+#endif
     int rc;
 
     st->st_output = output_func;
@@ -308,6 +537,20 @@ smp_transport_init(struct smp_transport *st,
         goto err;
     }
 
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    for (i = 0; i < MYNEWT_VAL(SMP_GROUP_QUEUE_CNT); i++) {
+        rc = os_mqueue_init(&st->st_gq[i], smp_event_data_in, st);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    rc = os_mutex_init(&st->st_tx_lock);
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
     return 0;
 err:
     return rc;
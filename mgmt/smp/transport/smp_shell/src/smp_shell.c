@@ -54,6 +54,10 @@ err:
 static int
 smp_shell_in(struct os_mbuf *m, void *arg)
 {
+#if MYNEWT_VAL(SMP_GROUP_QUEUE_CNT) > 0
+    /* Let the SMP core route the request to its group's queue. */
+    return smp_rx_req(&g_smp_shell_transport, m);
+#else
     struct cbor_mbuf_reader cmr;
     struct cbor_mbuf_writer cmw;
 
@@ -68,6 +72,7 @@ smp_shell_in(struct os_mbuf *m, void *arg)
     };
 
     return smp_process_request_packet(&g_smp_shell_transport.st_streamer, m);
+#endif
 }
 
 void
@@ -0,0 +1,205 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "uart/uart.h"
+#include "smp_uart_test_priv.h"
+
+/*
+ * Loopback UART.  Nothing is sent on its own: the tests pull characters
+ * from the transport's transmit callback and feed them to its receive
+ * callback.
+ */
+static struct uart_dev smp_uart_test_dev;
+static struct uart_conf smp_uart_test_conf;
+
+static int
+smp_uart_test_dev_open(struct os_dev *odev, uint32_t wait, void *arg)
+{
+    smp_uart_test_conf = *(struct uart_conf *)arg;
+    return 0;
+}
+
+static void
+smp_uart_test_dev_start(struct uart_dev *dev)
+{
+}
+
+static void
+smp_uart_test_dev_blocking_tx(struct uart_dev *dev, uint8_t byte)
+{
+}
+
+static int
+smp_uart_test_dev_init(struct os_dev *odev, void *arg)
+{
+    struct uart_dev *dev;
+
+    dev = (struct uart_dev *)odev;
+    OS_DEV_SETHANDLERS(odev, smp_uart_test_dev_open, NULL);
+    dev->ud_funcs.uf_start_tx = smp_uart_test_dev_start;
+    dev->ud_funcs.uf_start_rx = smp_uart_test_dev_start;
+    dev->ud_funcs.uf_blocking_tx = smp_uart_test_dev_blocking_tx;
+
+    return 0;
+}
+
+void
+smp_uart_test_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    /* Self tests restart the OS after the kernel stage devices have been
+     * initialized, so initialize the device here.
+     */
+    rc = os_dev_create(&smp_uart_test_dev.ud_dev, MYNEWT_VAL(SMP_UART),
+                       OS_DEV_INIT_KERNEL, 0, smp_uart_test_dev_init, NULL);
+    assert(rc == 0);
+    rc = os_dev_initialize_all(OS_DEV_INIT_KERNEL);
+    assert(rc == 0);
+}
+
+/**
+ * Returns the transport opened on the loopback UART.
+ */
+struct smp_transport *
+smp_uart_test_transport(void)
+{
+    /* The transport state starts with its smp_transport. */
+    TEST_ASSERT_FATAL(smp_uart_test_conf.uc_cb_arg != NULL);
+    return smp_uart_test_conf.uc_cb_arg;
+}
+
+uint8_t
+smp_uart_test_byte(int off)
+{
+    return off * 13 + (off >> 8);
+}
+
+/**
+ * Allocates a packet of the specified length filled with test bytes.
+ */
+struct os_mbuf *
+smp_uart_test_pkt(int len)
+{
+    struct os_mbuf *om;
+    uint8_t byte;
+    int rc;
+    int i;
+
+    om = os_msys_get_pkthdr(len, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    for (i = 0; i < len; i++) {
+        byte = smp_uart_test_byte(i);
+        rc = os_mbuf_append(om, &byte, 1);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    return om;
+}
+
+/**
+ * Sends a packet through the transport and passes its output back to the
+ * receive side a character at a time, processing each frame as the mgmt
+ * task would.  Expects nothing else to hold msys blocks.
+ *
+ * @return                      The reassembled packet; NULL if none was
+ *                                  received.
+ */
+struct os_mbuf *
+smp_uart_test_loop(struct os_mbuf *om, struct smp_uart_test_stats *stats)
+{
+    struct smp_transport *st;
+    struct uart_conf *uc;
+    struct os_eventq *evq;
+    struct os_event *ev;
+    int64_t start;
+    int used;
+    int rc;
+    int c;
+
+    memset(stats, 0, sizeof *stats);
+
+    uc = &smp_uart_test_conf;
+    st = smp_uart_test_transport();
+    evq = mgmt_evq_get();
+
+    start = os_get_uptime_usec();
+    rc = st->st_output(om);
+    stats->sut_tx_us = os_get_uptime_usec() - start;
+    TEST_ASSERT_FATAL(rc == 0);
+    stats->sut_tx_blocks = os_msys_count() - os_msys_num_free();
+
+    while ((c = uc->uc_tx_char(uc->uc_cb_arg)) >= 0) {
+        start = os_get_uptime_usec();
+        uc->uc_rx_char(uc->uc_cb_arg, c);
+        if (c == '\n') {
+            while ((ev = os_eventq_get_no_wait(evq)) != NULL) {
+                /* Keep the reassembled packet rather than processing it as
+                 * a request.
+                 */
+                if (ev != &st->st_imq.mq_ev) {
+                    ev->ev_cb(ev);
+                }
+            }
+        }
+        stats->sut_rx_us += os_get_uptime_usec() - start;
+
+        used = os_msys_count() - os_msys_num_free();
+        if (used > stats->sut_rx_blocks) {
+            stats->sut_rx_blocks = used;
+        }
+    }
+
+    return os_mqueue_get(&st->st_imq);
+}
+
+/**
+ * Discards whatever the transport has queued for transmission.
+ */
+void
+smp_uart_test_discard(void)
+{
+    struct uart_conf *uc;
+
+    uc = &smp_uart_test_conf;
+    while (uc->uc_tx_char(uc->uc_cb_arg) >= 0) {
+    }
+}
+
+TEST_SUITE(smp_uart_test_suite)
+{
+    smp_uart_test_loopback();
+    smp_uart_test_crc_split();
+    smp_uart_test_perf();
+}
+
+int
+main(int argc, char **argv)
+{
+    smp_uart_test_suite();
+
+    return tu_any_failed;
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_SMP_UART_TEST_PRIV_
+#define H_SMP_UART_TEST_PRIV_
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "mynewt_smp/smp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TEST_CASE_DECL(smp_uart_test_loopback);
+TEST_CASE_DECL(smp_uart_test_crc_split);
+TEST_CASE_DECL(smp_uart_test_perf);
+
+/** Loopback results for one packet. */
+struct smp_uart_test_stats {
+    /* Time spent encoding the packet, in microseconds. */
+    int64_t sut_tx_us;
+
+    /* Time spent in the per-character receive path and in decoding frames,
+     * in microseconds.
+     */
+    int64_t sut_rx_us;
+
+    /* Msys blocks holding the encoded packet. */
+    int sut_tx_blocks;
+
+    /* Most msys blocks held at once while the packet is looped back. */
+    int sut_rx_blocks;
+};
+
+/* Byte of the test packet at the specified offset. */
+uint8_t smp_uart_test_byte(int off);
+
+struct smp_transport *smp_uart_test_transport(void);
+struct os_mbuf *smp_uart_test_pkt(int len);
+struct os_mbuf *smp_uart_test_loop(struct os_mbuf *om,
+                                   struct smp_uart_test_stats *stats);
+void smp_uart_test_discard(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "smp_uart_test_priv.h"
+
+/**
+ * Allocates a single-mbuf packet with room for exactly the CRC after its
+ * data, so that appending anything more takes another block.
+ */
+static struct os_mbuf *
+smp_uart_test_tight_pkt(int len)
+{
+    struct os_mbuf *om;
+    uint8_t byte;
+    int rc;
+    int i;
+
+    om = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_TRAILINGSPACE(om) >= len + 2);
+    om->om_data += OS_MBUF_TRAILINGSPACE(om) - len - 2;
+
+    for (i = 0; i < len; i++) {
+        byte = smp_uart_test_byte(i);
+        rc = os_mbuf_append(om, &byte, 1);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT_FATAL(OS_MBUF_TRAILINGSPACE(om) == 2);
+
+    return om;
+}
+
+/**
+ * Sends a packet with only the specified number of msys blocks free.
+ *
+ * @return                      The transport's return code.
+ */
+static int
+smp_uart_test_send_short(int len, int nfree)
+{
+    struct os_mbuf *hog;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int rc;
+
+    om = smp_uart_test_tight_pkt(len);
+
+    hog = NULL;
+    while (os_msys_num_free() > nfree) {
+        m = os_msys_get(0, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        if (hog == NULL) {
+            hog = m;
+        } else {
+            os_mbuf_concat(hog, m);
+        }
+    }
+
+    rc = smp_uart_test_transport()->st_output(om);
+    smp_uart_test_discard();
+
+    os_mbuf_free_chain(hog);
+    TEST_ASSERT_FATAL(os_msys_num_free() == os_msys_count());
+
+    return rc;
+}
+
+/**
+ * The CRC is appended to the packet exactly once, even when it straddles an
+ * encoding chunk or a frame: a packet one byte longer, whose CRC is split,
+ * needs no more msys than one whose CRC is not.
+ */
+TEST_CASE_SELF(smp_uart_test_crc_split)
+{
+    /* CRC split by a 24-byte chunk, and by the first 90-byte frame. */
+    static const int lens[] = { 21, 87 };
+    int nfree;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof lens / sizeof lens[0]; i++) {
+        nfree = 0;
+        while (smp_uart_test_send_short(lens[i] - 1, nfree) != 0) {
+            nfree++;
+            TEST_ASSERT_FATAL(nfree < os_msys_count());
+        }
+
+        rc = smp_uart_test_send_short(lens[i], nfree);
+        TEST_ASSERT(rc == 0, "len=%d nfree=%d", lens[i], nfree);
+    }
+}
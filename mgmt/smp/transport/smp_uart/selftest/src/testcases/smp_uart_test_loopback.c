@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "smp_uart_test_priv.h"
+
+/* Packet lengths around the frame boundaries; a frame carries 90 bytes,
+ * and the first one also carries the 2-byte length.  Lengths 21, 45 and 69
+ * split the CRC across two 24-byte encoding chunks.
+ */
+static const int smp_uart_test_lens[] = {
+    1, 2, 3, 21, 45, 69, 85, 86, 87, 88, 89, 90, 91, 176, 177, 178, 1000,
+    2000,
+};
+
+static void
+smp_uart_test_check(struct os_mbuf *om, int len)
+{
+    uint8_t byte;
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == len);
+    for (i = 0; i < len; i++) {
+        rc = os_mbuf_copydata(om, i, 1, &byte);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(byte == smp_uart_test_byte(i), "off=%d", i);
+    }
+}
+
+TEST_CASE_SELF(smp_uart_test_loopback)
+{
+    struct smp_uart_test_stats stats;
+    struct os_mbuf *hog;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(os_msys_num_free() == os_msys_count());
+
+    /*** Packets of all sizes come back intact, with no blocks leaked. */
+    for (i = 0; i < sizeof smp_uart_test_lens / sizeof smp_uart_test_lens[0];
+         i++) {
+
+        om = smp_uart_test_pkt(smp_uart_test_lens[i]);
+        om = smp_uart_test_loop(om, &stats);
+        smp_uart_test_check(om, smp_uart_test_lens[i]);
+        os_mbuf_free_chain(om);
+        TEST_ASSERT(os_msys_num_free() == os_msys_count());
+    }
+
+    /*** Running out of mbufs while encoding drops the packet cleanly. */
+    om = smp_uart_test_pkt(500);
+
+    /* Leave one block for the length prefix and one for the first frame. */
+    hog = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(hog != NULL);
+    while (os_msys_num_free() > 2) {
+        m = os_msys_get(0, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        os_mbuf_concat(hog, m);
+    }
+
+    rc = smp_uart_test_transport()->st_output(om);
+    TEST_ASSERT(rc != 0);
+
+    os_mbuf_free_chain(hog);
+    TEST_ASSERT(os_msys_num_free() == os_msys_count());
+}
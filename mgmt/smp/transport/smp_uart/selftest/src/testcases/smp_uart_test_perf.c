@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "smp_uart_test_priv.h"
+
+#define SMP_UART_TEST_PERF_LEN      2000
+#define SMP_UART_TEST_FRAME_DATA    90
+
+#ifdef ARCH_sim
+#define SMP_UART_TEST_PERF_ITERS    500
+#else
+#define SMP_UART_TEST_PERF_ITERS    20
+#endif
+
+/**
+ * Reports the CPU time and msys blocks that a large packet takes through
+ * the transport and back.
+ */
+TEST_CASE_SELF(smp_uart_test_perf)
+{
+    struct smp_uart_test_stats stats;
+    struct os_mbuf *om;
+    int64_t tx_us;
+    int64_t rx_us;
+    int tx_blocks;
+    int rx_blocks;
+    int frames;
+    int i;
+
+    tx_us = 0;
+    rx_us = 0;
+    tx_blocks = 0;
+    rx_blocks = 0;
+    for (i = 0; i < SMP_UART_TEST_PERF_ITERS; i++) {
+        om = smp_uart_test_pkt(SMP_UART_TEST_PERF_LEN);
+        om = smp_uart_test_loop(om, &stats);
+        TEST_ASSERT_FATAL(om != NULL);
+        TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == SMP_UART_TEST_PERF_LEN);
+        os_mbuf_free_chain(om);
+
+        tx_us += stats.sut_tx_us;
+        rx_us += stats.sut_rx_us;
+        tx_blocks = max(tx_blocks, stats.sut_tx_blocks);
+        rx_blocks = max(rx_blocks, stats.sut_rx_blocks);
+    }
+    TEST_ASSERT(os_msys_num_free() == os_msys_count());
+
+    /* The packet is sent with its length and CRC. */
+    frames = (SMP_UART_TEST_PERF_LEN + 4 + SMP_UART_TEST_FRAME_DATA - 1) /
+             SMP_UART_TEST_FRAME_DATA;
+
+    TEST_PASS("%d byte packet, %d frames: tx=%lu us rx=%lu us per packet; "
+              "%d msys blocks encoded, %d peak",
+              SMP_UART_TEST_PERF_LEN, frames,
+              (unsigned long)(tx_us / SMP_UART_TEST_PERF_ITERS),
+              (unsigned long)(rx_us / SMP_UART_TEST_PERF_ITERS),
+              tx_blocks, rx_blocks);
+}
@@ -43,6 +43,15 @@
 #define SHELL_NLIP_PKT          0x0609
 #define SHELL_NLIP_DATA         0x0414
 
+/* Source bytes carried by one frame.  A multiple of 3, so that only the last
+ * frame of a packet ends in padding; base64 encoded, plus the frame header
+ * and newline, it fits in MGMT_NLIP_MAX_FRAME.
+ */
+#define SMP_UART_FRAME_DATA_MAX 90
+
+/* Source bytes encoded per contiguous piece of the output chain. */
+#define SMP_UART_ENC_CHUNK      24
+
 #define NUS_EV_TO_STATE(ptr)                                            \
     (struct smp_uart_state *)((uint8_t *)ptr -                         \
       (int)&(((struct smp_uart_state *)0)->sus_cb_ev))
@@ -54,6 +63,7 @@ struct smp_uart_state {
     struct os_mbuf *sus_tx;
     int sus_tx_off;
     struct os_mbuf_pkthdr *sus_rx_pkt;
+    uint16_t sus_rx_crc;
     struct os_mbuf_pkthdr *sus_rx_q;
     struct os_mbuf_pkthdr *sus_rx;
 };
@@ -74,101 +84,172 @@ smp_uart_mtu(struct os_mbuf *m)
     return MGMT_MAX_MTU;
 }
 
+/**
+ * Reserves len bytes at the end of a chain, given its last mbuf.  Unlike
+ * os_mbuf_extend(), this does not walk the chain.
+ *
+ * @return                      Pointer to the reserved bytes; NULL if no
+ *                                  mbuf is available.
+ */
+static void *
+smp_uart_tx_reserve(struct os_mbuf **tail, int len)
+{
+    struct os_mbuf *m;
+    void *dst;
+
+    m = *tail;
+    if (OS_MBUF_TRAILINGSPACE(m) < len) {
+        m = os_msys_get(MGMT_NLIP_MAX_FRAME, 0);
+        if (!m) {
+            return NULL;
+        }
+        if (OS_MBUF_TRAILINGSPACE(m) < len) {
+            os_mbuf_free(m);
+            return NULL;
+        }
+        SLIST_NEXT(*tail, om_next) = m;
+        *tail = m;
+    }
+
+    dst = m->om_data + m->om_len;
+    m->om_len += len;
+
+    return dst;
+}
+
+/**
+ * Frees the mbufs between the head of a packet and the specified mbuf; they
+ * have been encoded already.  The head carries the packet header, and is
+ * kept.
+ */
+static void
+smp_uart_tx_trim(struct os_mbuf *m, struct os_mbuf *src)
+{
+    struct os_mbuf *done;
+
+    if (src == m) {
+        return;
+    }
+
+    while ((done = SLIST_NEXT(m, om_next)) != src) {
+        SLIST_NEXT(m, om_next) = SLIST_NEXT(done, om_next);
+        os_mbuf_free(done);
+    }
+}
+
 /**
  * Called by mgmt to queue packet out to UART.
+ *
+ * The packet is walked once: each piece is added to the CRC and base64
+ * encoded straight into the output chain, and source mbufs are freed as soon
+ * as they have been encoded.
  */
 static int
 smp_uart_out(struct os_mbuf *m)
 {
     struct smp_uart_state *sus = &smp_uart_state;
-    struct os_mbuf_pkthdr *mpkt;
+    struct os_mbuf *tail;
+    struct os_mbuf *src;
     struct os_mbuf *n;
-    uint16_t tmp_buf[6];
+    uint16_t src_off;
+    uint16_t crc;
+    uint16_t tmp;
     char *dst;
+    int frame_end;
+    int crc_start;
+    int crc_end;
+    int data_end;
+    int totlen;
     int off;
-    int boff;
-    int slen;
+    int len;
     int sr;
     int rc;
-    int last;
-    int tx_sz;
 
     assert(OS_MBUF_IS_PKTHDR(m));
-    mpkt = OS_MBUF_PKTHDR(m);
+
+    n = NULL;
 
     /*
-     * Compute CRC-16 and append it to end.
+     * The first frame carries the length of the full packet, CRC included,
+     * ahead of the data; it is base64 encoded along with it.
      */
-    off = 0;
-    tmp_buf[0] = CRC16_INITIAL_CRC;
-    for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-        tmp_buf[0] = crc16_ccitt(tmp_buf[0], n->om_data, n->om_len);
-    }
-    tmp_buf[0] = htons(tmp_buf[0]);
-    dst = os_mbuf_extend(m, sizeof(uint16_t));
-    if (!dst) {
+    tmp = htons(OS_MBUF_PKTLEN(m) + sizeof(crc));
+    m = os_mbuf_prepend(m, sizeof(uint16_t));
+    if (!m) {
         goto err;
     }
-    memcpy(dst, tmp_buf, sizeof(uint16_t));
+    memcpy(m->om_data, &tmp, sizeof(uint16_t));
+
+    data_end = OS_MBUF_PKTLEN(m);
+    totlen = data_end + sizeof(crc);
+    crc = CRC16_INITIAL_CRC;
 
-    /*
-     * Create another mbuf chain with base64 encoded data.
-     */
     n = os_msys_get(MGMT_NLIP_MAX_FRAME, 0);
-    if (!n || OS_MBUF_TRAILINGSPACE(n) < 32) {
+    if (!n) {
         goto err;
     }
+    tail = n;
 
-    while (off < mpkt->omp_len) {
+    src = m;
+    src_off = 0;
+    for (off = 0; off < totlen; off = frame_end) {
         /*
-         * First fragment has a different header, and length of the full frame
-         * (need to base64 encode that).
+         * First fragment has a different header.
          */
         if (off == 0) {
-            tmp_buf[0] = htons(SHELL_NLIP_PKT);
+            tmp = htons(SHELL_NLIP_PKT);
         } else {
-            tmp_buf[0] = htons(SHELL_NLIP_DATA);
+            tmp = htons(SHELL_NLIP_DATA);
         }
-        rc = os_mbuf_append(n, tmp_buf, sizeof(uint16_t));
-        if (rc) {
+        dst = smp_uart_tx_reserve(&tail, sizeof(uint16_t));
+        if (!dst) {
             goto err;
         }
-        tx_sz = 2;
-
-        if (off == 0) {
-            tmp_buf[0] = htons(mpkt->omp_len);
-            boff = sizeof(uint16_t);
-        } else {
-            boff = 0;
-        }
-
-        while (off < mpkt->omp_len) {
-            slen = mpkt->omp_len - off;
-            last = 1;
-            if (slen > sizeof(tmp_buf) + boff) {
-                slen = sizeof(tmp_buf) - boff;
-                last = 0;
+        memcpy(dst, &tmp, sizeof(uint16_t));
+
+        frame_end = min(off + SMP_UART_FRAME_DATA_MAX, totlen);
+        while (off < frame_end) {
+            len = min(frame_end - off, SMP_UART_ENC_CHUNK);
+
+            /* The length prefix is not covered by the CRC. */
+            crc_start = max(off, (int)sizeof(uint16_t));
+            crc_end = min(off + len, data_end);
+            if (crc_start < crc_end) {
+                crc16_ccitt_mbuf(src, src_off + crc_start - off,
+                                 crc_end - crc_start, &crc);
             }
-            if (tx_sz + BASE64_ENCODE_SIZE(slen + boff) >= 124) {
-                break;
-            }
-            rc = os_mbuf_copydata(m, off, slen, (uint8_t *)tmp_buf + boff);
-            assert(rc == 0);
 
-            off += slen;
-            slen += boff;
+            /* The CRC goes in once it is complete: in the piece that
+             * reaches past the data.
+             */
+            if (off <= data_end && off + len > data_end) {
+                crc = htons(crc);
+                dst = os_mbuf_extend(m, sizeof(crc));
+                if (!dst) {
+                    goto err;
+                }
+                memcpy(dst, &crc, sizeof(crc));
+            }
 
-            dst = os_mbuf_extend(n, BASE64_ENCODE_SIZE(slen));
+            dst = smp_uart_tx_reserve(&tail, BASE64_ENCODE_SIZE(len));
             if (!dst) {
                 goto err;
             }
-            tx_sz += base64_encode(tmp_buf, slen, dst, last);
-            boff = 0;
+
+            /* Only the final chunk of the packet can need padding. */
+            rc = base64_encode_mbuf(src, src_off, len, dst, 1);
+            assert(rc == BASE64_ENCODE_SIZE(len));
+            off += len;
+
+            src = os_mbuf_off(src, src_off + len, &src_off);
+            smp_uart_tx_trim(m, src);
         }
 
-        if (os_mbuf_append(n, "\n", 1)) {
+        dst = smp_uart_tx_reserve(&tail, 1);
+        if (!dst) {
             goto err;
         }
+        *dst = '\n';
     }
 
     os_mbuf_free_chain(m);
@@ -220,7 +301,7 @@ smp_uart_tx_char(void *arg)
         }
     }
 
-    os_mbuf_copydata(sus->sus_tx, sus->sus_tx_off++, 1, &ch);
+    ch = sus->sus_tx->om_data[sus->sus_tx_off++];
 
     return ch;
 }
@@ -232,8 +313,10 @@ static void
 smp_uart_rx_pkt(struct smp_uart_state *sus, struct os_mbuf_pkthdr *rxm)
 {
     struct os_mbuf *m;
+    struct os_mbuf *tail;
     struct smp_ser_hdr *nsh;
     uint16_t crc;
+    int len;
     int rc;
 
     m = OS_MBUF_PKTHDR_TO_MBUF(rxm);
@@ -259,39 +342,63 @@ smp_uart_rx_pkt(struct smp_uart_state *sus, struct os_mbuf_pkthdr *rxm)
         goto err;
     }
 
-    if (os_mbuf_append(m, "\0", 1)) {
-        /*
-         * Null-terminate the line for base64_decode's sake.
-         */
-        goto err;
-    }
-    m = os_mbuf_pullup(m, rxm->omp_len);
-    if (!m) {
-        /*
-         * Make data contiguous for base64_decode's sake.
-         */
-        goto err;
-    }
-    rxm = OS_MBUF_PKTHDR(m);
-    rc = base64_decode((char *)m->om_data + 2, (char *)m->om_data + 2);
+    /*
+     * Decode the frame body in place, across however many mbufs hold it.
+     * The CRC is accumulated a frame at a time, over everything but the
+     * packet length.
+     */
+    rc = base64_decode_mbuf(m, sizeof(uint16_t));
     if (rc < 0) {
         goto err;
     }
-    rxm->omp_len = m->om_len = rc + 2;
     if (sus->sus_rx_pkt) {
         os_mbuf_adj(m, 2);
-        os_mbuf_concat(OS_MBUF_PKTHDR_TO_MBUF(sus->sus_rx_pkt), m);
+        crc16_ccitt_mbuf(m, 0, OS_MBUF_PKTLEN(m), &sus->sus_rx_crc);
+
+        /*
+         * A decoded frame is ~3/4 of its encoded size, so chaining every
+         * frame mbuf would hold most of each block empty until the packet
+         * completes.  Pack it into the tail of the packet when it fits.
+         */
+        tail = OS_MBUF_PKTHDR_TO_MBUF(sus->sus_rx_pkt);
+        while (SLIST_NEXT(tail, om_next)) {
+            tail = SLIST_NEXT(tail, om_next);
+        }
+        len = OS_MBUF_PKTLEN(m);
+        if (OS_MBUF_TRAILINGSPACE(tail) >= len) {
+            os_mbuf_copydata(m, 0, len, tail->om_data + tail->om_len);
+            tail->om_len += len;
+            sus->sus_rx_pkt->omp_len += len;
+            os_mbuf_free_chain(m);
+        } else {
+            os_mbuf_concat(OS_MBUF_PKTHDR_TO_MBUF(sus->sus_rx_pkt), m);
+        }
     } else {
-        sus->sus_rx_pkt = rxm;
+        /*
+         * Frame header and packet length must be contiguous.
+         */
+        m = os_mbuf_pullup(m, sizeof(*nsh));
+        if (!m) {
+            return;
+        }
+        sus->sus_rx_pkt = OS_MBUF_PKTHDR(m);
+        sus->sus_rx_crc = CRC16_INITIAL_CRC;
+        crc16_ccitt_mbuf(m, sizeof(*nsh), OS_MBUF_PKTLEN(m) - sizeof(*nsh),
+                         &sus->sus_rx_crc);
     }
 
     m = OS_MBUF_PKTHDR_TO_MBUF(sus->sus_rx_pkt);
     nsh = (struct smp_ser_hdr *)m->om_data;
     if (sus->sus_rx_pkt->omp_len - sizeof(*nsh) == ntohs(nsh->nsh_len)) {
+        sus->sus_rx_pkt = NULL;
+
+        /* A packet followed by its CRC has a CRC of 0. */
+        if (sus->sus_rx_crc != 0) {
+            goto err;
+        }
         os_mbuf_adj(m, 4);
         os_mbuf_adj(m, -2);
         smp_rx_req(&sus->sus_transport, m);
-        sus->sus_rx_pkt = NULL;
     }
     return;
 err:
@@ -325,7 +432,6 @@ smp_uart_rx_char(void *arg, uint8_t data)
 {
     struct smp_uart_state *sus = (struct smp_uart_state *)arg;
     struct os_mbuf *m;
-    int rc;
 
     if (!sus->sus_rx) {
         m = os_msys_get_pkthdr(MGMT_NLIP_MAX_FRAME, 0);
@@ -353,17 +459,18 @@ smp_uart_rx_char(void *arg, uint8_t data)
         sus->sus_rx = NULL;
         os_eventq_put(mgmt_evq_get(), &sus->sus_cb_ev);
         return 0;
-    } else {
-        rc = os_mbuf_append(m, &data, 1);
-        if (rc == 0) {
-            return 0;
-        }
+    } else if (OS_MBUF_TRAILINGSPACE(m) > 0) {
+        /*
+         * A frame fits in the first mbuf; store the byte directly rather
+         * than through os_mbuf_append().
+         */
+        m->om_data[m->om_len++] = data;
+        sus->sus_rx->omp_len++;
+        return 0;
     }
-    /* failed */
+    /* failed; line too long */
     sus->sus_rx->omp_len = 0;
     m->om_len = 0;
-    os_mbuf_free_chain(SLIST_NEXT(m, om_next));
-    SLIST_NEXT(m, om_next) = NULL;
     return 0;
 }
 
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __LWIP_MN_LWIP_MBUF_H__
+#define __LWIP_MN_LWIP_MBUF_H__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_mbuf;
+struct pbuf;
+
+/**
+ * Passes an mbuf chain to lwIP without copying it.  Each mbuf is wrapped in
+ * a PBUF_REF pbuf pointing at its data; the mbuf is freed along with the
+ * pbuf.
+ *
+ * Network interface drivers which receive into mbufs use this to hand
+ * packets to netif->input().  Packets handed over this way reach mn_socket
+ * consumers without being copied.
+ *
+ * @param om                    The mbuf chain to wrap.  On success, the
+ *                                  chain belongs to the returned pbuf.
+ *
+ * @return                      The pbuf chain on success;
+ *                              NULL if no wrappers are available
+ *                                  (LWIP_MBUF_PBUF_COUNT).  The mbuf chain
+ *                                  still belongs to the caller.
+ */
+struct pbuf *lwip_mbuf_to_pbuf(struct os_mbuf *om);
+
+/**
+ * Converts a pbuf chain into an mbuf chain.  Pbufs created by
+ * lwip_mbuf_to_pbuf(), and not referenced elsewhere, give their mbufs back
+ * without copying; the data of other pbufs is copied into msys mbufs.
+ *
+ * @param p                     The pbuf chain to convert.  Freed by this
+ *                                  function, whether it succeeds or not.
+ * @param usrhdr_len            The size of the user header to reserve in the
+ *                                  packet header mbuf.
+ *
+ * @return                      The packet on success;
+ *                              NULL if msys is exhausted.
+ */
+struct os_mbuf *lwip_pbuf_to_mbuf(struct pbuf *p, uint16_t usrhdr_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LWIP_MN_LWIP_MBUF_H__ */
@@ -25,6 +25,7 @@ extern "C" {
 
 #define MEM_LIBC_MALLOC			1	/* use platform malloc */
 #define LWIP_NETIF_TX_SINGLE_PBUF 	1
+#define LWIP_SUPPORT_CUSTOM_PBUF	1	/* mbufs passed by reference */
 #define LWIP_NETIF_LOOPBACK		1	/* yes loopback interface */
 
 #define TCPIP_THREAD_PRIO		5
@@ -30,10 +30,16 @@ int lwip_itf_getnext(struct mn_itf *mi);
 int lwip_itf_addr_getnext(struct mn_itf *mi, struct mn_itf_addr *mia);
 
 int lwip_socket_init(void);
+int lwip_mbuf_init(void);
 void lwip_cli_init(void);
 
 int lwip_err_to_mn_err(int rc);
 
+struct os_mbuf;
+struct pbuf;
+struct pbuf *lwip_mbuf_pbuf_borrow(struct os_mbuf *om);
+void lwip_mbuf_pbuf_own(struct pbuf *p);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,294 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Packets cross between mbufs and pbufs by reference.
+ *
+ * An mbuf is lent to lwIP as a custom PBUF_REF pbuf whose payload is the
+ * mbuf's data.  lwIP treats PBUF_REF data as volatile: anything it keeps past
+ * the call it was given the pbuf in is copied first, so the mbuf can be
+ * reclaimed as soon as the pbuf is no longer referenced.
+ *
+ * A wrapper either owns its mbuf, in which case the mbuf is freed with the
+ * pbuf, or merely borrows it.  Sends borrow the chain, and take ownership
+ * only once lwIP has accepted it; on failure, the chain is still the
+ * sender's, as mn_socket requires.
+ */
+
+#include "os/mynewt.h"
+
+#include <lwip/pbuf.h>
+#include "lwip_mn/lwip_mbuf.h"
+#include "ip_priv.h"
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "lwip_mn requires LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+
+struct lwip_mbuf_pbuf {
+    /* Must be first; lwIP sees a struct pbuf. */
+    struct pbuf_custom lmp_pc;
+    struct os_mbuf *lmp_om;
+
+    /* Free lmp_om along with the pbuf. */
+    uint8_t lmp_owned;
+};
+
+static os_membuf_t lwip_mbuf_pbuf_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(LWIP_MBUF_PBUF_COUNT),
+                    sizeof(struct lwip_mbuf_pbuf))
+];
+static struct os_mempool lwip_mbuf_pbuf_pool;
+
+static void
+lwip_mbuf_pbuf_free(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp;
+
+    lmp = (struct lwip_mbuf_pbuf *)p;
+    if (lmp->lmp_owned) {
+        os_mbuf_free(lmp->lmp_om);
+    }
+    os_memblock_put(&lwip_mbuf_pbuf_pool, lmp);
+}
+
+static struct lwip_mbuf_pbuf *
+lwip_mbuf_pbuf_from_pbuf(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp;
+
+    if (!(p->flags & PBUF_FLAG_IS_CUSTOM)) {
+        return NULL;
+    }
+    lmp = (struct lwip_mbuf_pbuf *)p;
+    if (lmp->lmp_pc.custom_free_function != lwip_mbuf_pbuf_free) {
+        return NULL;
+    }
+    return lmp;
+}
+
+struct pbuf *
+lwip_mbuf_pbuf_borrow(struct os_mbuf *om)
+{
+    struct lwip_mbuf_pbuf *lmp;
+    struct pbuf *head;
+    struct pbuf *tail;
+    struct pbuf *p;
+    uint32_t tot_len;
+
+    head = NULL;
+    tail = NULL;
+    tot_len = 0;
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        tot_len += om->om_len;
+        if (tot_len > UINT16_MAX) {
+            goto err;
+        }
+
+        lmp = os_memblock_get(&lwip_mbuf_pbuf_pool);
+        if (lmp == NULL) {
+            goto err;
+        }
+        lmp->lmp_om = om;
+        lmp->lmp_owned = 0;
+        lmp->lmp_pc.custom_free_function = lwip_mbuf_pbuf_free;
+        p = pbuf_alloced_custom(PBUF_RAW, om->om_len, PBUF_REF, &lmp->lmp_pc,
+                                om->om_data, om->om_len);
+        assert(p != NULL);
+
+        if (head == NULL) {
+            head = p;
+        } else {
+            tail->next = p;
+        }
+        tail = p;
+    }
+
+    /* Each pbuf's tot_len covers the rest of the chain. */
+    for (p = head; p != NULL; p = p->next) {
+        p->tot_len = tot_len;
+        tot_len -= p->len;
+    }
+
+    return head;
+
+err:
+    if (head != NULL) {
+        pbuf_free(head);
+    }
+    return NULL;
+}
+
+void
+lwip_mbuf_pbuf_own(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp;
+
+    for (; p != NULL; p = p->next) {
+        lmp = lwip_mbuf_pbuf_from_pbuf(p);
+        assert(lmp != NULL);
+        lmp->lmp_owned = 1;
+    }
+}
+
+struct pbuf *
+lwip_mbuf_to_pbuf(struct os_mbuf *om)
+{
+    struct pbuf *p;
+
+    p = lwip_mbuf_pbuf_borrow(om);
+    if (p != NULL) {
+        lwip_mbuf_pbuf_own(p);
+    }
+    return p;
+}
+
+/**
+ * Takes the mbuf back from a pbuf created by lwip_mbuf_to_pbuf(), with its
+ * data trimmed to the pbuf's payload.  This is only possible if the pbuf is
+ * referenced by nothing but its predecessor in the chain (or the caller, for
+ * the first pbuf).
+ *
+ * @return                      The mbuf on success; NULL if the pbuf's data
+ *                                  must be copied instead.
+ */
+static struct os_mbuf *
+lwip_mbuf_pbuf_take(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp;
+    struct os_mbuf *om;
+    uint8_t *start;
+    uint8_t *end;
+
+    lmp = lwip_mbuf_pbuf_from_pbuf(p);
+    if (lmp == NULL || !lmp->lmp_owned || p->ref != 1) {
+        return NULL;
+    }
+
+    om = lmp->lmp_om;
+    start = om->om_databuf + om->om_pkthdr_len;
+    end = om->om_databuf + om->om_omp->omp_databuf_len;
+    if ((uint8_t *)p->payload < start ||
+        (uint8_t *)p->payload + p->len > end) {
+        return NULL;
+    }
+
+    lmp->lmp_owned = 0;
+    om->om_data = p->payload;
+    om->om_len = p->len;
+    SLIST_NEXT(om, om_next) = NULL;
+    return om;
+}
+
+/**
+ * Turns a reclaimed mbuf into the packet header mbuf of a new packet, using
+ * the space in front of its data (where lwIP's headers were).
+ *
+ * @return                      0 on success; -1 if there is not enough room.
+ */
+static int
+lwip_mbuf_make_pkthdr(struct os_mbuf *om, uint16_t usrhdr_len)
+{
+    struct os_mbuf_pkthdr *omp;
+    int hdr_len;
+
+    hdr_len = sizeof(struct os_mbuf_pkthdr) + usrhdr_len;
+    if (om->om_data - om->om_databuf < hdr_len || hdr_len > UINT8_MAX) {
+        return -1;
+    }
+
+    om->om_pkthdr_len = hdr_len;
+    omp = OS_MBUF_PKTHDR(om);
+    omp->omp_len = om->om_len;
+    omp->omp_flags = 0;
+    STAILQ_NEXT(omp, omp_next) = NULL;
+    return 0;
+}
+
+struct os_mbuf *
+lwip_pbuf_to_mbuf(struct pbuf *p, uint16_t usrhdr_len)
+{
+    struct os_mbuf *head;
+    struct os_mbuf *last;
+    struct os_mbuf *om;
+    struct pbuf *q;
+    int rc;
+
+    head = NULL;
+    last = NULL;
+    for (q = p; q != NULL; q = q->next) {
+        om = lwip_mbuf_pbuf_take(q);
+        if (om != NULL) {
+            if (head == NULL) {
+                if (lwip_mbuf_make_pkthdr(om, usrhdr_len) == 0) {
+                    head = om;
+                    last = om;
+                    continue;
+                }
+                head = os_msys_get_pkthdr(0, usrhdr_len);
+                if (head == NULL) {
+                    os_mbuf_free(om);
+                    goto err;
+                }
+                last = head;
+            }
+            SLIST_NEXT(last, om_next) = om;
+            last = om;
+            OS_MBUF_PKTHDR(head)->omp_len += om->om_len;
+        } else {
+            if (head == NULL) {
+                head = os_msys_get_pkthdr(q->tot_len, usrhdr_len);
+                if (head == NULL) {
+                    goto err;
+                }
+                last = head;
+            }
+            rc = os_mbuf_append(head, q->payload, q->len);
+            if (rc != 0) {
+                goto err;
+            }
+            while (SLIST_NEXT(last, om_next) != NULL) {
+                last = SLIST_NEXT(last, om_next);
+            }
+        }
+    }
+
+    pbuf_free(p);
+    return head;
+
+err:
+    os_mbuf_free_chain(head);
+    pbuf_free(p);
+    return NULL;
+}
+
+int
+lwip_mbuf_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&lwip_mbuf_pbuf_pool,
+                         MYNEWT_VAL(LWIP_MBUF_PBUF_COUNT),
+                         sizeof(struct lwip_mbuf_pbuf), lwip_mbuf_pbuf_mem,
+                         "lwip_mbuf");
+    if (rc != 0) {
+        return -1;
+    }
+    return 0;
+}
@@ -28,6 +28,7 @@
 #include <lwip/tcp.h>
 #include <lwip/igmp.h>
 #include <lwip/mld6.h>
+#include "lwip_mn/lwip_mbuf.h"
 #include "ip_priv.h"
 
 static int lwip_sock_create(struct mn_socket **sp, uint8_t domain,
@@ -184,21 +185,13 @@ lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
-    m = os_msys_get_pkthdr(p->tot_len, sizeof(struct mn_sockaddr_in6));
+    m = lwip_pbuf_to_mbuf(p, sizeof(struct mn_sockaddr_in6));
     if (!m) {
-        pbuf_free(p);
         return;
     }
     lwip_addr_to_mn_addr((struct mn_sockaddr *)OS_MBUF_USRHDR(m),
       addr, port);
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
-    }
-    pbuf_free(p);
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
     mn_socket_readable(&s->ls_sock, 0);
 }
@@ -210,8 +203,6 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
     if (!p) {
         /*
@@ -220,14 +211,15 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
         mn_socket_readable(&s->ls_sock, MN_ECONNABORTED);
         return ERR_OK;
     }
-    m = os_msys_get_pkthdr(p->tot_len, 0);
-    assert(m);
-    /* XXX fix this */
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
+    m = lwip_pbuf_to_mbuf(p, 0);
+    if (!m) {
+        /*
+         * The data is gone; the stream cannot continue.
+         */
+        tcp_abort(pcb);
+        mn_socket_readable(&s->ls_sock, MN_ENOBUFS);
+        return ERR_ABRT;
     }
-    pbuf_free(p);
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
     mn_socket_readable(&s->ls_sock, 0);
 
@@ -499,10 +491,8 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
 {
     struct lwip_sock *s = (struct lwip_sock *)ms;
     struct pbuf *p;
-    struct os_mbuf *n;
     ip_addr_t ip_addr;
     uint16_t port;
-    int off;
     int rc;
 
     switch (s->ls_type) {
@@ -515,20 +505,15 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
         if (rc) {
             return rc;
         }
-        off = 0;
-        for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-            off += n->om_len;
-        }
-        p = pbuf_alloc(PBUF_TRANSPORT, off, PBUF_RAM);
+        /*
+         * The mbufs are passed by reference.  They become lwIP's once the
+         * datagram has been accepted; until then, they are still ours to
+         * return on failure.
+         */
+        p = lwip_mbuf_pbuf_borrow(m);
         if (!p) {
             return MN_ENOBUFS;
         }
-
-        off = 0;
-        for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-            pbuf_take_at(p, n->om_data, n->om_len, off);
-            off += n->om_len;
-        }
         LOCK_TCPIP_CORE();
         rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
         UNLOCK_TCPIP_CORE();
@@ -537,7 +522,7 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
             pbuf_free(p);
             return rc;
         }
-        os_mbuf_free_chain(m);
+        lwip_mbuf_pbuf_own(p);
         pbuf_free(p);
         return 0;
 #endif
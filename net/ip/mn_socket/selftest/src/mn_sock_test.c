@@ -36,6 +36,7 @@ TEST_CASE_DECL(inet_pton_test)
 TEST_CASE_DECL(inet6_pton_test)
 TEST_CASE_DECL(inet_ntop_test)
 TEST_CASE_DECL(socket_tests)
+TEST_CASE_DECL(socket_perf_test)
 
 static void
 mn_socket_test_init(void *arg)
@@ -47,9 +48,11 @@ mn_socket_test_init(void *arg)
     TEST_ASSERT_FATAL(rc == 0);
 
     rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mpool,
-                           MB_CNT, MB_CNT);
+                           MB_SZ, MB_CNT);
     TEST_ASSERT_FATAL(rc == 0);
 
+    /* The tests count free blocks; use this pool only. */
+    os_msys_reset();
     rc = os_msys_register(&test_mbuf_pool);
     TEST_ASSERT_FATAL(rc == 0);
 }
@@ -62,6 +65,7 @@ TEST_SUITE(mn_socket_test_all)
     inet6_pton_test();
     inet_ntop_test();
     socket_tests();
+    socket_perf_test();
 }
 
 int
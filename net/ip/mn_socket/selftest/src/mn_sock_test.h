@@ -33,6 +33,8 @@ void sock_open_close(void);
 void sock_listen(void);
 void sock_tcp_connect(void);
 void sock_udp_data(void);
+void sock_udp_chain(void);
+void sock_udp_low_msys(void);
 void sock_tcp_data(void);
 void sock_itf_list(void);
 void sock_udp_ll(void);
@@ -277,6 +277,184 @@ sock_udp_data(void)
     mn_close(sock2);
 }
 
+/*
+ * Datagrams of different sizes, most larger than one mbuf, sent back to
+ * back.
+ */
+void
+sock_udp_chain(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_sockaddr_in msin;
+    struct mn_sockaddr_in msin2;
+    int rc;
+    union mn_socket_cb sock_cbs = {
+        .socket.readable = sud_readable
+    };
+    struct os_mbuf *m;
+    static const int lens[] = { 1200, 64, 2000 };
+    uint8_t data[2000];
+    uint8_t rx[sizeof(data)];
+    int i;
+    int j;
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    mn_socket_set_cbs(sock1, NULL, &sock_cbs);
+
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = 0;
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+    rc = mn_getsockname(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < lens[i]; j++) {
+            data[j] = i + j;
+        }
+        m = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        rc = os_mbuf_append(m, data, lens[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = mn_sendto(sock2, m, (struct mn_sockaddr *)&msin);
+        TEST_ASSERT(rc == 0);
+    }
+
+    for (i = 0; i < 3; i++) {
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = mn_recvfrom(sock1, &m, (struct mn_sockaddr *)&msin2);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(msin2.msin_family == MN_AF_INET);
+        TEST_ASSERT(msin2.msin_port != 0);
+
+        TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(m) == lens[i]);
+        rc = os_mbuf_copydata(m, 0, lens[i], rx);
+        TEST_ASSERT(rc == 0);
+        for (j = 0; j < lens[i]; j++) {
+            data[j] = i + j;
+        }
+        TEST_ASSERT(memcmp(rx, data, lens[i]) == 0);
+        os_mbuf_free_chain(m);
+    }
+
+    mn_close(sock1);
+    mn_close(sock2);
+}
+
+/*
+ * Small datagrams are received while msys is nearly exhausted; receive
+ * buffers are sized to the datagram.
+ */
+void
+sock_udp_low_msys(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_sockaddr_in msin;
+    struct mn_sockaddr_in msin2;
+    int rc;
+    union mn_socket_cb sock_cbs = {
+        .socket.readable = sud_readable
+    };
+    struct os_mbuf *hog;
+    struct os_mbuf *m;
+    char data[] = "1234567890";
+    int i;
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    mn_socket_set_cbs(sock1, NULL, &sock_cbs);
+
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = 0;
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+    rc = mn_getsockname(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < 3; i++) {
+        m = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        rc = os_mbuf_append(m, data, sizeof(data));
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = mn_sendto(sock2, m, (struct mn_sockaddr *)&msin);
+        TEST_ASSERT(rc == 0);
+    }
+
+    /* Leave a single block free. */
+    hog = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(hog != NULL);
+    while (os_msys_num_free() > 1) {
+        m = os_msys_get(0, 0);
+        TEST_ASSERT_FATAL(m != NULL);
+        os_mbuf_concat(hog, m);
+    }
+
+    for (i = 0; i < 3; i++) {
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = mn_recvfrom(sock1, &m, (struct mn_sockaddr *)&msin2);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(OS_MBUF_PKTLEN(m) == sizeof(data));
+        TEST_ASSERT(os_mbuf_cmpf(m, 0, data, sizeof(data)) == 0);
+        os_mbuf_free_chain(m);
+    }
+
+    /*
+     * With msys exhausted, the receive fails.  The socket is not reported
+     * again right away, but once the receive is retried.
+     */
+    m = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    rc = os_mbuf_append(m, data, sizeof(data));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = mn_sendto(sock2, m, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    m = os_msys_get(0, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    os_mbuf_concat(hog, m);
+    TEST_ASSERT_FATAL(os_msys_num_free() == 0);
+
+    rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = mn_recvfrom(sock1, &m, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT(rc == MN_ENOBUFS);
+
+    rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC / 50);
+    TEST_ASSERT(rc == OS_TIMEOUT);
+
+    os_mbuf_free_chain(hog);
+
+    rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = mn_recvfrom(sock1, &m, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_cmpf(m, 0, data, sizeof(data)) == 0);
+    os_mbuf_free_chain(m);
+
+    mn_close(sock1);
+    mn_close(sock2);
+}
+
 void
 std_writable(void *cb_arg, int err)
 {
@@ -799,6 +977,8 @@ mn_socket_test_handler(void *arg)
     sock_listen();
     sock_tcp_connect();
     sock_udp_data();
+    sock_udp_chain();
+    sock_udp_low_msys();
     sock_tcp_data();
     sock_itf_list();
     sock_udp_ll();
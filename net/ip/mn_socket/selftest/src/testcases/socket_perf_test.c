@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "mn_sock_test.h"
+
+#define SPT_RTT_CNT         200
+#define SPT_BURST_CNT       8
+#define SPT_BURST_TOTAL     800
+#define SPT_DATA_SZ         256
+
+struct spt_peer {
+    struct mn_socket *sock;
+    struct mn_sockaddr_in addr;
+
+    /* Echo received datagrams back to the sender. */
+    int echo;
+
+    /* Number of datagrams received. */
+    int rx_cnt;
+
+    /* Release test_sem when rx_cnt reaches this value. */
+    int rx_target;
+};
+
+static void
+spt_readable(void *cb_arg, int err)
+{
+    struct spt_peer *peer;
+    struct mn_sockaddr_in from;
+    struct os_mbuf *m;
+    int rc;
+
+    peer = cb_arg;
+
+    rc = mn_recvfrom(peer->sock, &m, (struct mn_sockaddr *)&from);
+    if (rc != 0) {
+        return;
+    }
+    TEST_ASSERT(OS_MBUF_PKTLEN(m) == SPT_DATA_SZ);
+
+    peer->rx_cnt++;
+    if (peer->echo) {
+        rc = mn_sendto(peer->sock, m, (struct mn_sockaddr *)&from);
+        TEST_ASSERT(rc == 0);
+    } else {
+        os_mbuf_free_chain(m);
+    }
+
+    if (peer->rx_cnt == peer->rx_target) {
+        os_sem_release(&test_sem);
+    }
+}
+
+static union mn_socket_cb spt_cbs = {
+    .socket.readable = spt_readable,
+};
+
+static void
+spt_open(struct spt_peer *peer)
+{
+    int rc;
+
+    rc = mn_socket(&peer->sock, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    mn_socket_set_cbs(peer->sock, peer, &spt_cbs);
+
+    peer->addr.msin_family = MN_AF_INET;
+    peer->addr.msin_len = sizeof(peer->addr);
+    peer->addr.msin_port = 0;
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &peer->addr.msin_addr);
+
+    rc = mn_bind(peer->sock, (struct mn_sockaddr *)&peer->addr);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = mn_getsockname(peer->sock, (struct mn_sockaddr *)&peer->addr);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+spt_send(struct spt_peer *from, struct spt_peer *to)
+{
+    static uint8_t data[SPT_DATA_SZ];
+    struct os_mbuf *m;
+    int rc;
+
+    m = os_msys_get_pkthdr(sizeof(data), 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    rc = os_mbuf_copyinto(m, 0, data, sizeof(data));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = mn_sendto(from->sock, m, (struct mn_sockaddr *)&to->addr);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Measures UDP round trips over loopback, and one-way throughput in bursts of
+ * SPT_BURST_CNT datagrams.  Received data is reported as soon as the host
+ * socket is readable, so the timings reflect the socket backend rather than a
+ * polling interval.
+ */
+TEST_CASE_TASK(socket_perf_test)
+{
+    struct spt_peer a = { 0 };
+    struct spt_peer b = { 0 };
+    uint32_t rtt_us;
+    uint32_t burst_us;
+    int64_t start;
+    int rc;
+    int i;
+    int j;
+
+    os_sem_init(&test_sem, 0);
+
+    spt_open(&a);
+    spt_open(&b);
+
+    /* Round trips: a sends, b echoes. */
+    b.echo = 1;
+    start = os_get_uptime_usec();
+    for (i = 0; i < SPT_RTT_CNT; i++) {
+        a.rx_target = i + 1;
+        spt_send(&a, &b);
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rtt_us = os_get_uptime_usec() - start;
+    TEST_ASSERT(a.rx_cnt == SPT_RTT_CNT);
+    TEST_ASSERT(b.rx_cnt == SPT_RTT_CNT);
+
+    /* Throughput: a sends bursts to b. */
+    b.echo = 0;
+    b.rx_cnt = 0;
+    start = os_get_uptime_usec();
+    for (i = 0; i < SPT_BURST_TOTAL; i += SPT_BURST_CNT) {
+        b.rx_target = i + SPT_BURST_CNT;
+        for (j = 0; j < SPT_BURST_CNT; j++) {
+            spt_send(&a, &b);
+        }
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    burst_us = os_get_uptime_usec() - start;
+    TEST_ASSERT(b.rx_cnt == SPT_BURST_TOTAL);
+
+    mn_close(a.sock);
+    mn_close(b.sock);
+
+    TEST_PASS("udp loopback: rtt=%lu us; %d x %d B in %lu us",
+              (unsigned long)(rtt_us / SPT_RTT_CNT), SPT_BURST_TOTAL,
+              SPT_DATA_SZ, (unsigned long)burst_us);
+}
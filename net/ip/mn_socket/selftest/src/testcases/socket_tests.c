@@ -27,6 +27,8 @@ TEST_CASE_TASK(socket_tests)
     sock_listen();
     sock_tcp_connect();
     sock_udp_data();
+    sock_udp_chain();
+    sock_udp_low_msys();
     sock_tcp_data();
     sock_itf_list();
     sock_udp_ll();
@@ -17,6 +17,10 @@
  * under the License.
  */
 
+#ifdef MN_LINUX
+#define _GNU_SOURCE             /* recvmmsg() */
+#endif
+
 #include <sys/socket.h>
 #include <unistd.h>
 #include <errno.h>
@@ -27,22 +31,49 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <stdio.h>
 #include <signal.h>
+#ifdef MN_LINUX
+#include <sys/epoll.h>
+#endif
 
 #include "os/mynewt.h"
 #include "mn_socket/mn_socket.h"
 #include "mn_socket/mn_socket_ops.h"
 #include "native_sockets/native_sock.h"
+#ifdef MN_LINUX
+#include "sim/sim.h"
+#endif
 
 #include "native_sock_priv.h"
 
+#define NATIVE_SOCK_IOV_MAX     MYNEWT_VAL(NATIVE_SOCKETS_IOV_MAX)
+#define NATIVE_SOCK_RX_MAX      MYNEWT_VAL(NATIVE_SOCKETS_MAX_UDP)
+#define NATIVE_SOCK_RX_SLOT     MYNEWT_VAL(NATIVE_SOCKETS_RX_SLOT_SIZE)
+
+#ifdef MN_LINUX
+#define NATIVE_SOCK_RX_BATCH    MYNEWT_VAL(NATIVE_SOCKETS_RX_BATCH)
+typedef struct mmsghdr native_sock_mmsg_t;
+#else
+/* recvmmsg() is Linux-only; elsewhere datagrams are received one at a time. */
+#define NATIVE_SOCK_RX_BATCH    1
+typedef struct {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+} native_sock_mmsg_t;
+#endif
+
 static struct native_sock {
     struct mn_socket ns_sock;
     int ns_fd;
     unsigned int ns_connect:1;  /* Non-blocking connect in progress. */
     unsigned int ns_poll:1;
     unsigned int ns_listen:1;
+    unsigned int ns_readable:1; /* Readable reported; not read since. */
+    unsigned int ns_rx_stalled:1; /* Read failed for lack of msys. */
+    unsigned int ns_epoll:1;    /* Registered with the epoll instance. */
+    uint8_t ns_events;          /* POLLIN/POLLOUT currently waited for. */
     uint8_t ns_type;
     uint8_t ns_pf;
     struct os_sem ns_sem;
@@ -51,12 +82,24 @@ static struct native_sock {
 } native_socks[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
 
 static struct native_sock_state {
+#ifdef MN_LINUX
+    int epoll_fd;
+    struct os_sem epoll_sem;    /* Released when epoll_fd is readable. */
+#else
     struct pollfd poll_fds[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
     int poll_fd_cnt;
+#endif
     struct os_mutex mtx;
     struct os_task task;
+    os_time_t rx_retry_time;    /* When to retry stalled sockets. */
 } native_sock_state;
 
+/* A socket reported ready by native_sock_poll_wait(). */
+struct native_sock_ready {
+    struct native_sock *ns;
+    int revents;
+};
+
 static const struct mn_socket_ops native_sock_ops = {
     .mso_create = native_sock_create,
     .mso_close = native_sock_close,
@@ -87,14 +130,223 @@ native_get_sock(void)
     for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
         if (native_socks[i].ns_fd < 0) {
             ns = &native_socks[i];
+            ns->ns_connect = 0;
             ns->ns_poll = 0;
             ns->ns_listen = 0;
+            ns->ns_readable = 0;
+            ns->ns_rx_stalled = 0;
+            ns->ns_epoll = 0;
+            ns->ns_events = 0;
+            ns->ns_tx = NULL;
             return ns;
         }
     }
     return NULL;
 }
 
+/*
+ * Returns the events the socket task waits for on a socket.  Readability is
+ * reported once; the socket is not waited for again until the application
+ * reads from it.  This keeps unread data from waking the socket task
+ * repeatedly.  Nor is it waited for while received datagrams are queued;
+ * the socket task reports those directly.
+ */
+static int
+native_sock_poll_events(const struct native_sock *ns)
+{
+    int events;
+
+    events = 0;
+    if (ns->ns_fd < 0) {
+        return 0;
+    }
+    if (ns->ns_poll && !ns->ns_readable && STAILQ_EMPTY(&ns->ns_rx)) {
+        events |= POLLIN;
+    }
+    if (ns->ns_connect || ns->ns_tx != NULL) {
+        events |= POLLOUT;
+    }
+    return events;
+}
+
+static bool
+native_sock_rx_stalled(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
+        if (native_socks[i].ns_fd >= 0 && native_socks[i].ns_rx_stalled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef MN_LINUX
+
+/*
+ * Sockets are registered with a single epoll instance, which the sim watches
+ * as an interrupt source.  Every socket is armed with EPOLLONESHOT: once it
+ * is reported, it is not reported again until the socket task has handled it
+ * and rearmed it.
+ *
+ * Must be called with the state mutex held.
+ */
+static void
+native_sock_poll_update(struct native_sock *ns)
+{
+    struct native_sock_state *nss = &native_sock_state;
+    struct epoll_event ev;
+    int events;
+    int op;
+    int rc;
+
+    events = native_sock_poll_events(ns);
+    if (events == ns->ns_events) {
+        return;
+    }
+
+    if (events == 0) {
+        rc = epoll_ctl(nss->epoll_fd, EPOLL_CTL_DEL, ns->ns_fd, NULL);
+        assert(rc == 0);
+        ns->ns_epoll = 0;
+    } else {
+        ev.events = EPOLLONESHOT;
+        if (events & POLLIN) {
+            ev.events |= EPOLLIN;
+        }
+        if (events & POLLOUT) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.ptr = ns;
+
+        if (ns->ns_epoll) {
+            op = EPOLL_CTL_MOD;
+        } else {
+            op = EPOLL_CTL_ADD;
+        }
+        rc = epoll_ctl(nss->epoll_fd, op, ns->ns_fd, &ev);
+        assert(rc == 0);
+        ns->ns_epoll = 1;
+    }
+    ns->ns_events = events;
+}
+
+/*
+ * Called by the sim, with interrupts disabled, while the epoll instance has
+ * sockets to report.
+ */
+static void
+native_sock_io_ready(void *arg)
+{
+    struct native_sock_state *nss = arg;
+
+    if (os_sem_get_count(&nss->epoll_sem) == 0) {
+        os_sem_release(&nss->epoll_sem);
+    }
+}
+
+/*
+ * Makes the socket task look for sockets with queued datagrams.
+ */
+static void
+native_sock_poll_kick(struct native_sock_state *nss)
+{
+    if (os_sem_get_count(&nss->epoll_sem) == 0) {
+        os_sem_release(&nss->epoll_sem);
+    }
+}
+
+/*
+ * Returns how long the socket task may wait for events: until sockets that
+ * ran out of msys are due to be retried, or indefinitely.
+ */
+static os_time_t
+native_sock_poll_timeout(struct native_sock_state *nss)
+{
+    os_stime_t left;
+
+    if (!native_sock_rx_stalled()) {
+        return OS_TIMEOUT_NEVER;
+    }
+    left = (os_stime_t)(nss->rx_retry_time - os_time_get());
+    return max(left, 0);
+}
+
+/*
+ * Blocks until at least one socket is ready, until the socket task is
+ * kicked, or until stalled receives are due to be retried.  Called with the
+ * state mutex held; the mutex is released while waiting.
+ *
+ * @return                      The number of entries filled in 'ready'.
+ */
+static int
+native_sock_poll_wait(struct native_sock_state *nss,
+                      struct native_sock_ready *ready)
+{
+    struct epoll_event evs[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
+    struct native_sock *ns;
+    os_time_t timeout;
+    int revents;
+    int cnt;
+    int i;
+
+    timeout = native_sock_poll_timeout(nss);
+    os_mutex_release(&nss->mtx);
+    os_sem_pend(&nss->epoll_sem, timeout);
+    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+
+    cnt = epoll_wait(nss->epoll_fd, evs, MYNEWT_VAL(NATIVE_SOCKETS_MAX), 0);
+    if (cnt < 0) {
+        return 0;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        ns = evs[i].data.ptr;
+
+        /* Errors and hangups satisfy whatever the socket waited for. */
+        if (evs[i].events & (EPOLLERR | EPOLLHUP)) {
+            revents = ns->ns_events;
+        } else {
+            revents = 0;
+            if (evs[i].events & EPOLLIN) {
+                revents |= POLLIN;
+            }
+            if (evs[i].events & EPOLLOUT) {
+                revents |= POLLOUT;
+            }
+        }
+
+        /* EPOLLONESHOT disarmed the socket. */
+        ns->ns_events = 0;
+
+        ready[i].ns = ns;
+        ready[i].revents = revents;
+    }
+
+    return cnt;
+}
+
+static int
+native_sock_poll_init(struct native_sock_state *nss)
+{
+    int rc;
+
+    nss->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (nss->epoll_fd < 0) {
+        return -1;
+    }
+    os_sem_init(&nss->epoll_sem, 0);
+
+    rc = sim_io_src_add(nss->epoll_fd, native_sock_io_ready, nss);
+    if (rc != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
 static struct native_sock *
 native_find_sock(int fd)
 {
@@ -108,31 +360,95 @@ native_find_sock(int fd)
     return NULL;
 }
 
+/*
+ * Hosts without epoll: the socket task polls every socket at a fixed
+ * interval.
+ *
+ * Must be called with the state mutex held.
+ */
 static void
-native_sock_poll_rebuild(struct native_sock_state *nss)
+native_sock_poll_update(struct native_sock *ns)
 {
-    struct native_sock *ns;
+    struct native_sock_state *nss = &native_sock_state;
+    int events;
     int i;
     int j;
 
-    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+    (void)ns;
+
     for (i = 0, j = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
-        ns = &native_socks[i];
-        if (ns->ns_fd < 0) {
-            continue;
-        }
-        if (!ns->ns_poll) {
+        events = native_sock_poll_events(&native_socks[i]);
+        if (events == 0) {
             continue;
         }
-        nss->poll_fds[j].fd = ns->ns_fd;
-        nss->poll_fds[j].events = POLLIN | POLLOUT;
+        nss->poll_fds[j].fd = native_socks[i].ns_fd;
+        nss->poll_fds[j].events = events;
         nss->poll_fds[j].revents = 0;
         j++;
     }
     nss->poll_fd_cnt = j;
+}
+
+/*
+ * Queued datagrams are picked up at the next interval.
+ */
+static void
+native_sock_poll_kick(struct native_sock_state *nss)
+{
+}
+
+static int
+native_sock_poll_wait(struct native_sock_state *nss,
+                      struct native_sock_ready *ready)
+{
+    struct native_sock *ns;
+    int revents;
+    int cnt;
+    int rc;
+    int i;
+
     os_mutex_release(&nss->mtx);
+    os_time_delay(os_time_ms_to_ticks32(
+        MYNEWT_VAL(NATIVE_SOCKETS_POLL_INTERVAL_MS)));
+    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+
+    if (nss->poll_fd_cnt == 0) {
+        return 0;
+    }
+    rc = poll(nss->poll_fds, nss->poll_fd_cnt, 0);
+    if (rc <= 0) {
+        return 0;
+    }
+
+    cnt = 0;
+    for (i = 0; i < nss->poll_fd_cnt; i++) {
+        revents = nss->poll_fds[i].revents;
+        if (revents == 0) {
+            continue;
+        }
+        nss->poll_fds[i].revents = 0;
+
+        ns = native_find_sock(nss->poll_fds[i].fd);
+        assert(ns);
+
+        if (revents & (POLLERR | POLLHUP)) {
+            revents = nss->poll_fds[i].events;
+        }
+        ready[cnt].ns = ns;
+        ready[cnt].revents = revents & (POLLIN | POLLOUT);
+        cnt++;
+    }
+    return cnt;
 }
 
+static int
+native_sock_poll_init(struct native_sock_state *nss)
+{
+    return 0;
+}
+
+#endif
+
 int
 native_sock_err_to_mn_err(int err)
 {
@@ -323,8 +639,11 @@ native_sock_close(struct mn_socket *s)
     struct os_mbuf_pkthdr *m;
 
     os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+    /* Closing the descriptor also removes it from the epoll instance. */
     close(ns->ns_fd);
     ns->ns_fd = -1;
+    ns->ns_epoll = 0;
+    ns->ns_events = 0;
 
     /*
      * When socket is closed, we must free all mbufs which might be
@@ -335,7 +654,8 @@ native_sock_close(struct mn_socket *s)
         os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(m));
     }
     os_mbuf_free_chain(ns->ns_tx);
-    native_sock_poll_rebuild(nss);
+    ns->ns_tx = NULL;
+    native_sock_poll_update(ns);
     os_mutex_release(&nss->mtx);
     return 0;
 }
@@ -369,7 +689,7 @@ native_sock_connect(struct mn_socket *s, struct mn_sockaddr *addr)
         }
     }
     ns->ns_poll = 1;
-    native_sock_poll_rebuild(nss);
+    native_sock_poll_update(ns);
     os_mutex_release(&nss->mtx);
 
     /* Indicate writability if connection fully established. */
@@ -413,7 +733,7 @@ native_sock_bind(struct mn_socket *s, struct mn_sockaddr *addr)
     }
     if (ns->ns_type == SOCK_DGRAM) {
         ns->ns_poll = 1;
-        native_sock_poll_rebuild(nss);
+        native_sock_poll_update(ns);
     }
     os_mutex_release(&nss->mtx);
     return 0;
@@ -438,45 +758,108 @@ native_sock_listen(struct mn_socket *s, uint8_t qlen)
     }
     ns->ns_poll = 1;
     ns->ns_listen = 1;
-    native_sock_poll_rebuild(nss);
+    native_sock_poll_update(ns);
     os_mutex_release(&nss->mtx);
     return 0;
 }
 
+/*
+ * Size of the source address stored ahead of each received datagram.
+ */
+static int
+native_sock_addr_len(const struct native_sock *ns)
+{
+    if (ns->ns_pf == PF_LOCAL) {
+        return sizeof(struct sockaddr_un);
+    }
+    return sizeof(struct sockaddr_in6);
+}
+
+/*
+ * Removes the first queued datagram from a socket.
+ *
+ * @return                      0 on success; MN_EAGAIN if none is queued.
+ */
+static int
+native_sock_rx_dequeue(struct native_sock *ns, struct os_mbuf **mp)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    omp = STAILQ_FIRST(&ns->ns_rx);
+    if (omp == NULL) {
+        return MN_EAGAIN;
+    }
+    STAILQ_REMOVE_HEAD(&ns->ns_rx, omp_next);
+
+    *mp = OS_MBUF_PKTHDR_TO_MBUF(omp);
+    return 0;
+}
+
+/*
+ * Fills 'iov' with the data of an mbuf chain, skipping empty mbufs.
+ *
+ * @return                      The number of entries filled;
+ *                              -1 if the chain has more than
+ *                                  NATIVE_SOCKETS_IOV_MAX non-empty mbufs.
+ */
+static int
+native_sock_fill_iov(struct os_mbuf *m, struct iovec *iov, size_t *len)
+{
+    int cnt;
+
+    cnt = 0;
+    *len = 0;
+    for (; m != NULL; m = SLIST_NEXT(m, om_next)) {
+        if (m->om_len == 0) {
+            continue;
+        }
+        if (cnt == NATIVE_SOCK_IOV_MAX) {
+            return -1;
+        }
+        iov[cnt].iov_base = m->om_data;
+        iov[cnt].iov_len = m->om_len;
+        *len += m->om_len;
+        cnt++;
+    }
+    return cnt;
+}
+
 /*
  * TX routine for stream sockets (TCP). The data to send is pointed
  * by ns_tx.
- * Keep sending mbufs until socket says that it can't take anymore.
- * then wait for send event notification before continuing.
+ * Keep sending until socket says that it can't take anymore, then wait for
+ * send event notification before continuing.  Each write covers up to
+ * NATIVE_SOCKETS_IOV_MAX mbufs.
  */
 static int
 native_sock_stream_tx(struct native_sock *ns, int notify)
 {
     struct native_sock_state *nss = &native_sock_state;
+    struct iovec iov[NATIVE_SOCK_IOV_MAX];
     struct os_mbuf *m;
     struct os_mbuf *n;
+    size_t len;
+    ssize_t sent;
+    int iov_cnt;
     int rc;
 
     rc = 0;
 
     os_mutex_pend(&nss->mtx, OS_TIMEOUT_NEVER);
-    while (ns->ns_tx && rc == 0) {
-        m = ns->ns_tx;
-        n = SLIST_NEXT(m, om_next);
+    while (ns->ns_tx) {
+        iov_cnt = native_sock_fill_iov(ns->ns_tx, iov, &len);
+        if (iov_cnt < 0) {
+            /* More mbufs than iovecs; send what fits. */
+            iov_cnt = NATIVE_SOCK_IOV_MAX;
+        }
+        if (iov_cnt == 0) {
+            os_mbuf_free_chain(ns->ns_tx);
+            ns->ns_tx = NULL;
+            break;
+        }
 
-        errno = 0;
-        rc = write(ns->ns_fd, m->om_data, m->om_len);
-        if (rc == m->om_len) {
-            /* Complete write. */
-            ns->ns_tx = n;
-            os_mbuf_free(m);
-            rc = 0;
-        } else if (rc != -1) {
-            /* Partial write. */
-            os_mbuf_adj(m, m->om_len - rc);
-            rc = 0;
-        } else {
-            /* Error. */
+        sent = writev(ns->ns_fd, iov, iov_cnt);
+        if (sent < 0) {
             rc = errno;
             if (rc == EAGAIN) {
                 rc = 0;
@@ -490,7 +873,21 @@ native_sock_stream_tx(struct native_sock *ns, int notify)
             }
             break;
         }
+
+        /* Release what was written. */
+        m = ns->ns_tx;
+        while (m != NULL && sent >= m->om_len) {
+            sent -= m->om_len;
+            n = SLIST_NEXT(m, om_next);
+            os_mbuf_free(m);
+            m = n;
+        }
+        if (m != NULL && sent > 0) {
+            os_mbuf_adj(m, sent);
+        }
+        ns->ns_tx = m;
     }
+    native_sock_poll_update(ns);
     os_mutex_release(&nss->mtx);
     if (notify) {
         mn_socket_writable(&ns->ns_sock, rc);
@@ -523,10 +920,11 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
     struct native_sock *ns = (struct native_sock *)s;
     struct sockaddr_storage ss;
     struct sockaddr *sa = (struct sockaddr *)&ss;
-    uint8_t tmpbuf[MYNEWT_VAL(NATIVE_SOCKETS_MAX_UDP)];
-    struct os_mbuf *o;
+    struct iovec iov[NATIVE_SOCK_IOV_MAX];
+    struct msghdr msg;
+    size_t len;
+    int iov_cnt;
     int sa_len;
-    int off;
     int rc;
 
     if (ns->ns_type == SOCK_DGRAM) {
@@ -534,16 +932,21 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
         if (rc) {
             return rc;
         }
-        off = 0;
-        for (o = m; o; o = SLIST_NEXT(o, om_next)) {
-            if (off + o->om_len > sizeof(tmpbuf)) {
-                return MN_ENOBUFS;
-            }
-            os_mbuf_copydata(o, 0, o->om_len, &tmpbuf[off]);
-            off += o->om_len;
+
+        /* The chain is handed to the kernel as is; no flattening. */
+        iov_cnt = native_sock_fill_iov(m, iov, &len);
+        if (iov_cnt < 0) {
+            return MN_ENOBUFS;
         }
-        rc = sendto(ns->ns_fd, tmpbuf, off, 0, sa, sa_len);
-        if (rc != off) {
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = sa;
+        msg.msg_namelen = sa_len;
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_cnt;
+
+        rc = sendmsg(ns->ns_fd, &msg, 0);
+        if (rc < 0) {
             return native_sock_err_to_mn_err(errno);
         }
         os_mbuf_free_chain(m);
@@ -559,41 +962,303 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
     }
 }
 
+/*
+ * Returns the number of bytes that can be read from a stream socket.
+ *
+ * @return                      0 on success; MN_[...] error code on failure.
+ */
+static int
+native_sock_rx_pending(struct native_sock *ns, int *len)
+{
+    int rc;
+
+    rc = ioctl(ns->ns_fd, FIONREAD, len);
+    if (rc < 0) {
+        return native_sock_err_to_mn_err(errno);
+    }
+    return 0;
+}
+
+/*
+ * Allocates a packet with room for 'len' bytes of data, up to
+ * NATIVE_SOCKETS_MAX_UDP, in at most 'iov_max' mbufs, and 'addr_len' bytes
+ * of leading space to receive the source address into.  If msys runs short,
+ * the packet has less room.  'iov' is filled with the data space.
+ *
+ * @return                      The packet; NULL if msys is exhausted.
+ */
+static struct os_mbuf *
+native_sock_rx_alloc(int addr_len, int len, int iov_max, struct iovec *iov,
+                     int *iov_cnt)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *m;
+    struct os_mbuf *n;
+    int space;
+    int cnt;
+
+    len = min(max(len, 1), NATIVE_SOCK_RX_MAX);
+
+    m = os_msys_get_pkthdr(len + addr_len, 0);
+    if (!m) {
+        return NULL;
+    }
+    if (OS_MBUF_TRAILINGSPACE(m) <= addr_len) {
+        os_mbuf_free_chain(m);
+        return NULL;
+    }
+    m->om_data += addr_len;
+
+    iov[0].iov_base = m->om_data;
+    iov[0].iov_len = OS_MBUF_TRAILINGSPACE(m);
+    space = iov[0].iov_len;
+    cnt = 1;
+
+    last = m;
+    while (space < len && cnt < iov_max) {
+        n = os_msys_get(len - space, 0);
+        if (!n) {
+            break;
+        }
+        SLIST_NEXT(last, om_next) = n;
+        last = n;
+
+        iov[cnt].iov_base = n->om_data;
+        iov[cnt].iov_len = OS_MBUF_TRAILINGSPACE(n);
+        space += iov[cnt].iov_len;
+        cnt++;
+    }
+
+    *iov_cnt = cnt;
+    return m;
+}
+
+/*
+ * Sets the mbuf lengths of a packet allocated by native_sock_rx_alloc() after
+ * 'len' bytes were received into it.  Unused mbufs are freed.
+ */
+static void
+native_sock_rx_trim(struct os_mbuf *m, int len)
+{
+    struct os_mbuf *cur;
+    struct os_mbuf *last;
+    int chunk;
+
+    OS_MBUF_PKTHDR(m)->omp_len = len;
+
+    last = NULL;
+    for (cur = m; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        chunk = min(len, OS_MBUF_TRAILINGSPACE(cur));
+        cur->om_len = chunk;
+        len -= chunk;
+        if (len == 0) {
+            last = cur;
+            break;
+        }
+    }
+    assert(last != NULL);
+
+    os_mbuf_free_chain(SLIST_NEXT(last, om_next));
+    SLIST_NEXT(last, om_next) = NULL;
+}
+
+/*
+ * Receives up to NATIVE_SOCKETS_RX_BATCH datagrams with one system call.
+ * Each datagram is received into up to NATIVE_SOCKETS_RX_SLOT_SIZE bytes of
+ * mbufs, allocated as msys allows; the rest of it, up to
+ * NATIVE_SOCKETS_MAX_UDP, lands in a spill buffer and is copied into the
+ * packet.  The first datagram is returned; the rest are queued on ns_rx.
+ * The source address of each datagram is kept in the leading space of its
+ * first mbuf.
+ *
+ * Must be called with the state mutex held.
+ *
+ * @return                      0 on success; MN_[...] error code on failure.
+ */
+static int
+native_sock_dgram_rx(struct native_sock *ns, int addr_len, struct os_mbuf **mp)
+{
+    /* Kept off the stack; protected by the state mutex. */
+    static struct os_mbuf *pkts[NATIVE_SOCK_RX_BATCH];
+    static int space[NATIVE_SOCK_RX_BATCH];
+    static struct iovec iov[NATIVE_SOCK_RX_BATCH][NATIVE_SOCK_IOV_MAX];
+    static native_sock_mmsg_t msgs[NATIVE_SOCK_RX_BATCH];
+    static uint8_t spill[NATIVE_SOCK_RX_BATCH][NATIVE_SOCK_RX_MAX];
+    struct msghdr *hdr;
+    int iov_cnt;
+    int pkt_cnt;
+    int rx_cnt;
+    int len;
+    int rc;
+    int i;
+    int j;
+
+    /* Allocate as many packets as msys allows; at least one is needed. */
+    for (pkt_cnt = 0; pkt_cnt < NATIVE_SOCK_RX_BATCH; pkt_cnt++) {
+        pkts[pkt_cnt] = native_sock_rx_alloc(addr_len, NATIVE_SOCK_RX_SLOT,
+                                             NATIVE_SOCK_IOV_MAX - 1,
+                                             iov[pkt_cnt], &iov_cnt);
+        if (!pkts[pkt_cnt]) {
+            break;
+        }
+
+        space[pkt_cnt] = 0;
+        for (j = 0; j < iov_cnt; j++) {
+            space[pkt_cnt] += iov[pkt_cnt][j].iov_len;
+        }
+        if (space[pkt_cnt] < NATIVE_SOCK_RX_MAX) {
+            iov[pkt_cnt][iov_cnt].iov_base = spill[pkt_cnt];
+            iov[pkt_cnt][iov_cnt].iov_len = NATIVE_SOCK_RX_MAX -
+                                            space[pkt_cnt];
+            iov_cnt++;
+        }
+
+        hdr = &msgs[pkt_cnt].msg_hdr;
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->msg_name = pkts[pkt_cnt]->om_data - addr_len;
+        hdr->msg_namelen = addr_len;
+        hdr->msg_iov = iov[pkt_cnt];
+        hdr->msg_iovlen = iov_cnt;
+    }
+    if (pkt_cnt == 0) {
+        return MN_ENOBUFS;
+    }
+
+#ifdef MN_LINUX
+    rx_cnt = recvmmsg(ns->ns_fd, msgs, pkt_cnt, MSG_DONTWAIT, NULL);
+#else
+    rx_cnt = recvmsg(ns->ns_fd, &msgs[0].msg_hdr, MSG_DONTWAIT);
+    if (rx_cnt >= 0) {
+        msgs[0].msg_len = rx_cnt;
+        rx_cnt = 1;
+    }
+#endif
+    if (rx_cnt < 0) {
+        rc = native_sock_err_to_mn_err(errno);
+    } else {
+        rc = MN_EAGAIN;
+    }
+
+    /* Free what is not needed before copying spilled data into msys. */
+    for (i = 0; i < pkt_cnt; i++) {
+        if (i >= rx_cnt || msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            /* Unused, or larger than NATIVE_SOCKETS_MAX_UDP. */
+            os_mbuf_free_chain(pkts[i]);
+            pkts[i] = NULL;
+        }
+    }
+
+    for (i = 0; i < pkt_cnt; i++) {
+        if (!pkts[i]) {
+            continue;
+        }
+
+        len = msgs[i].msg_len;
+        native_sock_rx_trim(pkts[i], min(len, space[i]));
+        if (len > space[i] &&
+            os_mbuf_append(pkts[i], spill[i], len - space[i]) != 0) {
+            /* Out of msys; dropped, as the host stack would. */
+            os_mbuf_free_chain(pkts[i]);
+            rc = MN_ENOBUFS;
+            continue;
+        }
+        STAILQ_INSERT_TAIL(&ns->ns_rx, OS_MBUF_PKTHDR(pkts[i]), omp_next);
+    }
+
+    /* An error only matters if nothing was received. */
+    if (native_sock_rx_dequeue(ns, mp) == 0) {
+        return 0;
+    }
+    return rc;
+}
+
 int
 native_sock_recvfrom(struct mn_socket *s, struct os_mbuf **mp,
   struct mn_sockaddr *addr)
 {
+    struct native_sock_state *nss = &native_sock_state;
     struct native_sock *ns = (struct native_sock *)s;
     struct sockaddr_storage ss;
     struct sockaddr *sa = (struct sockaddr *)&ss;
-    uint8_t tmpbuf[MYNEWT_VAL(NATIVE_SOCKETS_MAX_UDP)];
+    struct iovec iov[NATIVE_SOCK_IOV_MAX];
     struct os_mbuf *m;
     socklen_t slen;
+    int addr_len;
+    int iov_cnt;
+    int len;
     int rc;
 
-    slen = sizeof(ss);
+    m = NULL;
+
+    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
     if (ns->ns_type == SOCK_DGRAM) {
-        rc = recvfrom(ns->ns_fd, tmpbuf, sizeof(tmpbuf), 0, sa, &slen);
+        addr_len = native_sock_addr_len(ns);
+        rc = native_sock_rx_dequeue(ns, &m);
+        if (rc != 0) {
+            rc = native_sock_dgram_rx(ns, addr_len, &m);
+        }
+        if (rc == 0) {
+            memcpy(sa, m->om_data - addr_len, addr_len);
+        }
     } else {
+        slen = sizeof(ss);
         rc = getpeername(ns->ns_fd, sa, &slen);
+        if (rc != 0) {
+            rc = native_sock_err_to_mn_err(errno);
+        } else {
+            rc = native_sock_rx_pending(ns, &len);
+        }
         if (rc == 0) {
-            rc = read(ns->ns_fd, tmpbuf, sizeof(tmpbuf));
+            m = native_sock_rx_alloc(0, len, NATIVE_SOCK_IOV_MAX, iov,
+                                     &iov_cnt);
+            if (!m) {
+                rc = MN_ENOBUFS;
+            } else {
+                rc = readv(ns->ns_fd, iov, iov_cnt);
+                if (rc < 0) {
+                    rc = native_sock_err_to_mn_err(errno);
+                } else if (rc == 0) {
+                    ns->ns_poll = 0;
+                    rc = MN_ECONNABORTED;
+                } else {
+                    native_sock_rx_trim(m, rc);
+                    rc = 0;
+                }
+                if (rc != 0) {
+                    os_mbuf_free_chain(m);
+                }
+            }
         }
     }
-    if (rc < 0) {
-        return native_sock_err_to_mn_err(errno);
+
+    /*
+     * The application has read; report further data when it arrives, or
+     * right away if datagrams are already queued.  If msys ran out, the data
+     * is still there; the socket task reports it again after
+     * NATIVE_SOCKETS_RX_RETRY_MS instead of right away.
+     */
+    if (rc == MN_ENOBUFS) {
+        if (!native_sock_rx_stalled()) {
+            nss->rx_retry_time = os_time_get() + os_time_ms_to_ticks32(
+                MYNEWT_VAL(NATIVE_SOCKETS_RX_RETRY_MS));
+        }
+        ns->ns_rx_stalled = 1;
+
+        /* Have the socket task pick up the retry timeout. */
+        native_sock_poll_kick(nss);
+    } else {
+        ns->ns_readable = 0;
     }
-    if (ns->ns_type == SOCK_STREAM && rc == 0) {
-        ns->ns_poll = 0;
-        native_sock_poll_rebuild(&native_sock_state);
-        return MN_ECONNABORTED;
+    native_sock_poll_update(ns);
+    if (!STAILQ_EMPTY(&ns->ns_rx)) {
+        native_sock_poll_kick(&native_sock_state);
     }
+    os_mutex_release(&nss->mtx);
 
-    m = os_msys_get_pkthdr(rc, 0);
-    if (!m) {
-        return MN_ENOBUFS;
+    if (rc != 0) {
+        return rc;
     }
-    os_mbuf_copyinto(m, 0, tmpbuf, rc);
+
     *mp = m;
     if (addr) {
         native_sock_addr_to_mn_addr(sa, addr);
@@ -735,76 +1400,102 @@ native_sock_getpeername(struct mn_socket *s, struct mn_sockaddr *addr)
     return 0;
 }
 
-/*
- * XXX should do this task with SIGIO as well.
- */
 static void
 socket_task(void *arg)
 {
+    struct native_sock_ready ready[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
     struct native_sock_state *nss = arg;
     struct native_sock *ns, *new_ns;
     struct sockaddr_storage ss;
     struct sockaddr *sa = (struct sockaddr *)&ss;
     int revents;
+    int cnt;
     int i;
+    int j;
     socklen_t slen;
     int sock_err;
     int rc;
 
     os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
     while (1) {
-        os_mutex_release(&nss->mtx);
-        os_time_delay(os_time_ms_to_ticks32(MYNEWT_VAL(NATIVE_SOCKETS_POLL_INTERVAL_MS)));
-        os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
-        if (nss->poll_fd_cnt) {
-            rc = poll(nss->poll_fds, nss->poll_fd_cnt, 0);
-        } else {
-            rc = 0;
-        }
-        if (rc == 0) {
-            continue;
+        cnt = native_sock_poll_wait(nss, ready);
+
+        /*
+         * Once due, poll sockets that ran out of msys again; they are
+         * reported if their data is still there.
+         */
+        if (native_sock_rx_stalled() &&
+            OS_TIME_TICK_GEQ(os_time_get(), nss->rx_retry_time)) {
+
+            for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
+                ns = &native_socks[i];
+                if (ns->ns_fd >= 0 && ns->ns_rx_stalled) {
+                    ns->ns_rx_stalled = 0;
+                    ns->ns_readable = 0;
+                    native_sock_poll_update(ns);
+                }
+            }
         }
-        for (i = 0; i < nss->poll_fd_cnt; i++) {
-            if (nss->poll_fds[i].revents == 0) {
+
+        /* Datagrams left queued by a batched receive are readable too. */
+        for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
+            ns = &native_socks[i];
+            if (ns->ns_fd < 0 || ns->ns_readable ||
+                STAILQ_EMPTY(&ns->ns_rx)) {
                 continue;
             }
+            for (j = 0; j < cnt; j++) {
+                if (ready[j].ns == ns) {
+                    break;
+                }
+            }
+            if (j == cnt) {
+                ready[cnt].ns = ns;
+                ready[cnt].revents = 0;
+                cnt++;
+            }
+            ready[j].revents |= POLLIN;
+        }
 
-            revents = nss->poll_fds[i].revents;
-            nss->poll_fds[i].revents = 0;
+        for (i = 0; i < cnt; i++) {
+            ns = ready[i].ns;
+            revents = ready[i].revents;
 
-            ns = native_find_sock(nss->poll_fds[i].fd);
-            assert(ns);
+            /* Closed while the mutex was released for a callback. */
+            if (ns->ns_fd < 0) {
+                continue;
+            }
 
             if (revents & POLLIN) {
                 if (ns->ns_listen) {
                     new_ns = native_get_sock();
-                    if (!new_ns) {
-                        continue;
-                    }
-                    slen = sizeof(ss);
-                    new_ns->ns_fd = accept(ns->ns_fd, sa, &slen);
-                    if (new_ns->ns_fd < 0) {
-                        continue;
+                    if (new_ns) {
+                        slen = sizeof(ss);
+                        new_ns->ns_fd = accept(ns->ns_fd, sa, &slen);
                     }
-                    new_ns->ns_type = ns->ns_type;
-                    new_ns->ns_sock.ms_ops = &native_sock_ops;
-                    native_sock_set_nonblocking(new_ns);
-
-                    os_mutex_release(&nss->mtx);
-                    if (mn_socket_newconn(&ns->ns_sock, &new_ns->ns_sock)) {
-                        /*
-                         * should close
-                         */
+                    if (new_ns && new_ns->ns_fd >= 0) {
+                        new_ns->ns_type = ns->ns_type;
+                        new_ns->ns_sock.ms_ops = &native_sock_ops;
+                        native_sock_set_nonblocking(new_ns);
+
+                        os_mutex_release(&nss->mtx);
+                        if (mn_socket_newconn(&ns->ns_sock,
+                                              &new_ns->ns_sock)) {
+                            /*
+                             * should close
+                             */
+                        }
+                        os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+                        new_ns->ns_poll = 1;
+                        native_sock_poll_update(new_ns);
                     }
-                    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
-                    new_ns->ns_poll = 1;
-                    native_sock_poll_rebuild(nss);
                 } else {
+                    ns->ns_readable = 1;
                     mn_socket_readable(&ns->ns_sock, 0);
                 }
             }
 
-            if (revents & POLLOUT) {
+            if (revents & POLLOUT && ns->ns_fd >= 0) {
                 if (ns->ns_connect) {
                     /*
                      * The connection attempt has completed.  Report whether it
@@ -825,6 +1516,11 @@ socket_task(void *arg)
                     native_sock_stream_tx(ns, 1);
                 }
             }
+
+            /* Wait for whatever the socket still needs. */
+            if (ns->ns_fd >= 0) {
+                native_sock_poll_update(ns);
+            }
         }
     }
 }
@@ -848,6 +1544,10 @@ native_sock_init(void)
         return -1;
     }
     os_mutex_init(&nss->mtx);
+    i = native_sock_poll_init(nss);
+    if (i) {
+        return -1;
+    }
     i = os_task_init(&nss->task, "socket", socket_task, &native_sock_state,
       MYNEWT_VAL(NATIVE_SOCKETS_PRIO), OS_WAIT_FOREVER, sp,
       MYNEWT_VAL(NATIVE_SOCKETS_STACK_SZ));
@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LORA_CRYPTO_TEST_
+#define H_LORA_CRYPTO_TEST_
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "node/mac/LoRaMacCrypto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LORA_CRYPTO_TEST_KEY_SLOTS  MYNEWT_VAL(LORA_NODE_CRYPTO_KEY_SLOTS)
+
+/* Largest PHYPayload, less the MIC. */
+#define LORA_CRYPTO_TEST_MAX_LEN    251
+
+TEST_CASE_DECL(lora_crypto_ref);
+TEST_CASE_DECL(lora_crypto_perf);
+
+void lora_crypto_test_fill(uint8_t *buf, int len, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
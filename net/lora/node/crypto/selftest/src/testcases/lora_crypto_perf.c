@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "lora_crypto_test.h"
+
+/*
+ * Data frames are encrypted and MICed, as on transmit, with the session
+ * keys and with the keys changing from one call to the next, which costs
+ * a key expansion each time as the MAC used to.
+ */
+#define LCP_ITERS               2000
+#define LCP_HDR_LEN             9
+#define LCP_ADDR                0x260112ab
+
+static const int lcp_lens[] = { 12, 51, 222 };
+#define LCP_NUM_LENS            (int)(sizeof(lcp_lens) / sizeof(lcp_lens[0]))
+
+static uint8_t lcp_keys[LORA_CRYPTO_TEST_KEY_SLOTS + 1][16];
+
+static uint32_t
+lcp_run(int len, int rotate)
+{
+    uint8_t frame[LORA_CRYPTO_TEST_MAX_LEN];
+    const uint8_t *nwk_skey;
+    const uint8_t *app_skey;
+    uint32_t mic;
+    int64_t start;
+    int k;
+    int i;
+
+    lora_crypto_test_fill(frame, LCP_HDR_LEN + len, len);
+    nwk_skey = lcp_keys[0];
+    app_skey = lcp_keys[1];
+    k = 0;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < LCP_ITERS; i++) {
+        if (rotate) {
+            /* One key more than there are slots; every lookup misses. */
+            app_skey = lcp_keys[k];
+            k = (k + 1) % (LORA_CRYPTO_TEST_KEY_SLOTS + 1);
+            nwk_skey = lcp_keys[k];
+            k = (k + 1) % (LORA_CRYPTO_TEST_KEY_SLOTS + 1);
+        }
+        LoRaMacPayloadEncrypt(frame + LCP_HDR_LEN, len, app_skey, LCP_ADDR,
+                              0, i, frame + LCP_HDR_LEN);
+        LoRaMacComputeMic(frame, LCP_HDR_LEN + len, nwk_skey, LCP_ADDR, 0, i,
+                          &mic);
+    }
+
+    return os_get_uptime_usec() - start;
+}
+
+TEST_CASE_SELF(lora_crypto_perf)
+{
+    uint32_t ref_us[LCP_NUM_LENS];
+    uint32_t cached_us[LCP_NUM_LENS];
+    int i;
+
+    for (i = 0; i <= LORA_CRYPTO_TEST_KEY_SLOTS; i++) {
+        lora_crypto_test_fill(lcp_keys[i], 16, 0x5e55 + i);
+    }
+
+    for (i = 0; i < LCP_NUM_LENS; i++) {
+        ref_us[i] = lcp_run(lcp_lens[i], 1);
+        cached_us[i] = lcp_run(lcp_lens[i], 0);
+    }
+
+    TEST_PASS("%d frames encrypt+mic, key per call / cached: "
+              "%d B %lu/%lu us, %d B %lu/%lu us, %d B %lu/%lu us", LCP_ITERS,
+              lcp_lens[0], (unsigned long)ref_us[0],
+              (unsigned long)cached_us[0],
+              lcp_lens[1], (unsigned long)ref_us[1],
+              (unsigned long)cached_us[1],
+              lcp_lens[2], (unsigned long)ref_us[2],
+              (unsigned long)cached_us[2]);
+}
@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "lora_crypto_test.h"
+#include "tinycrypt/aes.h"
+#include "tinycrypt/cmac_mode.h"
+
+static uint32_t
+lcr_mic(const uint8_t *key, const uint8_t *b0, const uint8_t *data, int len)
+{
+    struct tc_aes_key_sched_struct sched;
+    struct tc_cmac_struct state;
+    uint8_t tag[16];
+
+    tc_cmac_setup(&state, key, &sched);
+    tc_cmac_init(&state);
+    if (b0 != NULL) {
+        tc_cmac_update(&state, b0, 16);
+    }
+    tc_cmac_update(&state, data, len);
+    tc_cmac_final(tag, &state);
+
+    return get_le32(tag);
+}
+
+static void
+lcr_block(uint8_t *block, uint8_t first, uint32_t addr, uint8_t dir,
+          uint32_t seq)
+{
+    memset(block, 0, 16);
+    block[0] = first;
+    block[5] = dir;
+    put_le32(block + 6, addr);
+    put_le32(block + 10, seq);
+}
+
+static void
+lcr_ctr(const uint8_t *key, uint32_t addr, uint8_t dir, uint32_t seq,
+        uint8_t *data, int len)
+{
+    struct tc_aes_key_sched_struct sched;
+    uint8_t a[16];
+    uint8_t s[16];
+    int off;
+    int i;
+
+    tc_aes128_set_encrypt_key(&sched, key);
+    lcr_block(a, 0x01, addr, dir, seq);
+    for (off = 0; off < len; off += 16) {
+        a[15] = off / 16 + 1;
+        tc_aes_encrypt(s, a, &sched);
+        for (i = 0; i < 16 && off + i < len; i++) {
+            data[off + i] ^= s[i];
+        }
+    }
+}
+
+/* Checks a frame against the reference, with 'key' already held or not. */
+static void
+lcr_check(const uint8_t *key, const uint8_t *frame, int len, uint32_t seq)
+{
+    uint8_t enc[LORA_CRYPTO_TEST_MAX_LEN];
+    uint8_t ref[LORA_CRYPTO_TEST_MAX_LEN];
+    uint8_t b0[16];
+    uint32_t addr;
+    uint32_t mic;
+    uint8_t dir;
+
+    addr = 0x26010000 + len;
+    dir = len & 1;
+
+    lcr_block(b0, 0x49, addr, dir, seq);
+    b0[15] = len;
+    LoRaMacComputeMic(frame, len, key, addr, dir, seq, &mic);
+    TEST_ASSERT(mic == lcr_mic(key, b0, frame, len), "mic len %d", len);
+
+    LoRaMacJoinComputeMic(frame, len, key, &mic);
+    TEST_ASSERT(mic == lcr_mic(key, NULL, frame, len), "join mic len %d",
+                len);
+
+    memcpy(ref, frame, len);
+    lcr_ctr(key, addr, dir, seq, ref, len);
+    LoRaMacPayloadEncrypt(frame, len, key, addr, dir, seq, enc);
+    TEST_ASSERT(memcmp(enc, ref, len) == 0, "enc len %d", len);
+
+    /* In place, as the MAC does on transmit. */
+    LoRaMacPayloadDecrypt(enc, len, key, addr, dir, seq, enc);
+    TEST_ASSERT(memcmp(enc, frame, len) == 0, "dec len %d", len);
+}
+
+TEST_CASE_SELF(lora_crypto_ref)
+{
+    /* RFC 4493, example 2. */
+    static const uint8_t rfc_key[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+    };
+    static const uint8_t rfc_msg[16] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+        0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    };
+    uint8_t keys[LORA_CRYPTO_TEST_KEY_SLOTS + 1][16];
+    uint8_t frame[LORA_CRYPTO_TEST_MAX_LEN];
+    uint8_t nwk_skey[16];
+    uint8_t app_skey[16];
+    uint8_t nonce[16];
+    uint8_t dec[32];
+    uint8_t ref[16];
+    uint8_t app_nonce[6];
+    struct tc_aes_key_sched_struct sched;
+    uint32_t mic;
+    int len;
+    int k;
+
+    LoRaMacJoinComputeMic(rfc_msg, sizeof(rfc_msg), rfc_key, &mic);
+    TEST_ASSERT(mic == 0xb4160a07, "mic 0x%08lx", (unsigned long)mic);
+
+    for (k = 0; k <= LORA_CRYPTO_TEST_KEY_SLOTS; k++) {
+        lora_crypto_test_fill(keys[k], 16, 0x10ad + k);
+    }
+
+    /* Keys held, then one key more than there are slots for. */
+    for (len = 0; len <= LORA_CRYPTO_TEST_MAX_LEN; len++) {
+        lora_crypto_test_fill(frame, len, len);
+        lcr_check(keys[0], frame, len, 0x10000 + len);
+        lcr_check(keys[len % (LORA_CRYPTO_TEST_KEY_SLOTS + 1)], frame, len,
+                  len);
+    }
+
+    /* The session keys, and the join accept decryption. */
+    lora_crypto_test_fill(app_nonce, sizeof(app_nonce), 0xa990);
+    LoRaMacJoinComputeSKeys(keys[1], app_nonce, 0x1234, nwk_skey, app_skey);
+    tc_aes128_set_encrypt_key(&sched, keys[1]);
+    memset(nonce, 0, sizeof(nonce));
+    nonce[0] = 0x01;
+    memcpy(nonce + 1, app_nonce, 6);
+    put_le16(nonce + 7, 0x1234);
+    tc_aes_encrypt(ref, nonce, &sched);
+    TEST_ASSERT(memcmp(nwk_skey, ref, 16) == 0);
+    nonce[0] = 0x02;
+    tc_aes_encrypt(ref, nonce, &sched);
+    TEST_ASSERT(memcmp(app_skey, ref, 16) == 0);
+
+    /* With a CFList. */
+    lora_crypto_test_fill(frame, 32, 0x7ac);
+    LoRaMacJoinDecrypt(frame, 32, keys[1], dec);
+    tc_aes_encrypt(ref, frame, &sched);
+    TEST_ASSERT(memcmp(dec, ref, 16) == 0);
+    tc_aes_encrypt(ref, frame + 16, &sched);
+    TEST_ASSERT(memcmp(dec + 16, ref, 16) == 0);
+}
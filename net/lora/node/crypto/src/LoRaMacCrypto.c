@@ -0,0 +1,335 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+    (C)2013 Semtech
+ ___ _____ _   ___ _  _____ ___  ___  ___ ___
+/ __|_   _/_\ / __| |/ / __/ _ \| _ \/ __| __|
+\__ \ | |/ _ \ (__| ' <| _| (_) |   / (__| _|
+|___/ |_/_/ \_\___|_|\_\_| \___/|_|_\\___|___|
+embedded.connectivity.solutions===============
+
+Description: LoRa MAC layer implementation
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+
+Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jäckle ( STACKFORCE )
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "syscfg/syscfg.h"
+
+#include "aes.h"
+
+#include "node/mac/LoRaMacCrypto.h"
+
+/*!
+ * CMAC/AES Message Integrity Code (MIC) Block B0 size
+ */
+#define LORAMAC_MIC_BLOCK_B0_SIZE                   16
+
+/*!
+ * Number of expanded keys kept
+ */
+#define LORAMAC_CRYPTO_KEY_SLOTS                    MYNEWT_VAL( LORA_NODE_CRYPTO_KEY_SLOTS )
+
+/*!
+ * Expanded AES key, along with the CMAC subkeys derived from it
+ */
+typedef struct sLoRaMacCryptoKey
+{
+    /*!
+     * Key the schedule was expanded from
+     */
+    uint8_t Key[16];
+    /*!
+     * AES key schedule
+     */
+    aes_context Aes;
+    /*!
+     * CMAC subkeys K1 and K2
+     */
+    uint8_t K1[16];
+    uint8_t K2[16];
+    /*!
+     * Value of KeyClock when the key was last used; 0 if the slot is free
+     */
+    uint32_t LastUse;
+}LoRaMacCryptoKey_t;
+
+/*!
+ * Expanded keys, reused for as long as the same keys keep being passed in.
+ * Keys are matched by value, so a new session, an ABP key set through the
+ * MIB or a multicast key needs no explicit invalidation.
+ */
+static LoRaMacCryptoKey_t KeySlots[LORAMAC_CRYPTO_KEY_SLOTS];
+
+/*!
+ * Incremented on each key lookup, to find the least recently used slot
+ */
+static uint32_t KeyClock;
+
+/*!
+ * \brief Doubles a value in GF(2^128), for CMAC subkey generation
+ */
+static void CmacDouble( const uint8_t *in, uint8_t *out )
+{
+    uint8_t carry;
+    int8_t i;
+
+    carry = in[0] >> 7;
+    for( i = 0; i < 15; i++ )
+    {
+        out[i] = ( in[i] << 1 ) | ( in[i + 1] >> 7 );
+    }
+    out[15] = ( in[15] << 1 ) ^ ( carry ? 0x87 : 0x00 );
+}
+
+/*!
+ * \brief Returns the expanded form of a key, expanding it into the least
+ *        recently used slot if it is not held
+ *
+ * \param [IN]  key             AES key
+ * \retval                      Expanded key
+ */
+static const LoRaMacCryptoKey_t *LoRaMacCryptoGetKey( const uint8_t *key )
+{
+    LoRaMacCryptoKey_t *slot;
+    uint8_t i;
+
+    KeyClock++;
+    if( KeyClock == 0 )
+    {
+        /* Wrapped; start the usage history over. */
+        for( i = 0; i < LORAMAC_CRYPTO_KEY_SLOTS; i++ )
+        {
+            KeySlots[i].LastUse = 0;
+        }
+        KeyClock = 1;
+    }
+
+    slot = &KeySlots[0];
+    for( i = 0; i < LORAMAC_CRYPTO_KEY_SLOTS; i++ )
+    {
+        if( KeySlots[i].LastUse != 0 &&
+            memcmp( KeySlots[i].Key, key, 16 ) == 0 )
+        {
+            KeySlots[i].LastUse = KeyClock;
+            return &KeySlots[i];
+        }
+        if( KeySlots[i].LastUse < slot->LastUse )
+        {
+            slot = &KeySlots[i];
+        }
+    }
+
+    memcpy( slot->Key, key, 16 );
+    memset( &slot->Aes, 0, sizeof( slot->Aes ) );
+    aes_set_key( key, 16, &slot->Aes );
+
+    /* K1 and K2 from L = AES(K, 0^128), per RFC 4493. */
+    memset( slot->K1, 0, 16 );
+    aes_encrypt( slot->K1, slot->K1, &slot->Aes );
+    CmacDouble( slot->K1, slot->K1 );
+    CmacDouble( slot->K1, slot->K2 );
+
+    slot->LastUse = KeyClock;
+    return slot;
+}
+
+/*!
+ * \brief Computes the AES-CMAC of a message
+ *
+ * \param [IN]  key             Expanded key
+ * \param [IN]  b0              Block prepended to the message; NULL if none
+ * \param [IN]  buffer          Message
+ * \param [IN]  size            Message size
+ * \param [OUT] mac             Computed CMAC
+ */
+static void LoRaMacCmac( const LoRaMacCryptoKey_t *key, const uint8_t *b0, const uint8_t *buffer, uint16_t size, uint8_t *mac )
+{
+    uint8_t x[16];
+    uint8_t i;
+
+    memset( x, 0, sizeof( x ) );
+    if( b0 != NULL )
+    {
+        if( size == 0 )
+        {
+            /* B0 is the last, complete, block. */
+            buffer = b0;
+            size = 16;
+        }
+        else
+        {
+            aes_encrypt( b0, x, &key->Aes );
+        }
+    }
+
+    while( size > 16 )
+    {
+        for( i = 0; i < 16; i++ )
+        {
+            x[i] ^= buffer[i];
+        }
+        aes_encrypt( x, x, &key->Aes );
+        buffer += 16;
+        size -= 16;
+    }
+
+    if( size == 16 )
+    {
+        for( i = 0; i < 16; i++ )
+        {
+            x[i] ^= buffer[i] ^ key->K1[i];
+        }
+    }
+    else
+    {
+        for( i = 0; i < size; i++ )
+        {
+            x[i] ^= buffer[i];
+        }
+        x[size] ^= 0x80;
+        for( i = 0; i < 16; i++ )
+        {
+            x[i] ^= key->K2[i];
+        }
+    }
+    aes_encrypt( x, mac, &key->Aes );
+}
+
+/*!
+ * \brief Fills in the address, direction and sequence counter of a B0 or
+ *        A block
+ */
+static void LoRaMacCryptoBlock( uint8_t *block, uint8_t first, uint32_t address, uint8_t dir, uint32_t sequenceCounter )
+{
+    block[0] = first;
+    block[1] = 0x00;
+    block[2] = 0x00;
+    block[3] = 0x00;
+    block[4] = 0x00;
+    block[5] = dir;
+
+    block[6] = ( address ) & 0xFF;
+    block[7] = ( address >> 8 ) & 0xFF;
+    block[8] = ( address >> 16 ) & 0xFF;
+    block[9] = ( address >> 24 ) & 0xFF;
+
+    block[10] = ( sequenceCounter ) & 0xFF;
+    block[11] = ( sequenceCounter >> 8 ) & 0xFF;
+    block[12] = ( sequenceCounter >> 16 ) & 0xFF;
+    block[13] = ( sequenceCounter >> 24 ) & 0xFF;
+
+    block[14] = 0x00;
+    block[15] = 0x00;
+}
+
+/*!
+ * \brief Computes the LoRaMAC frame MIC field
+ *
+ * \param [IN]  buffer          Data buffer
+ * \param [IN]  size            Data buffer size
+ * \param [IN]  key             AES key to be used
+ * \param [IN]  address         Frame address
+ * \param [IN]  dir             Frame direction [0: uplink, 1: downlink]
+ * \param [IN]  sequenceCounter Frame sequence counter
+ * \param [OUT] mic Computed MIC field
+ */
+void LoRaMacComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint32_t *mic )
+{
+    uint8_t micBlockB0[LORAMAC_MIC_BLOCK_B0_SIZE];
+    uint8_t cmac[16];
+
+    LoRaMacCryptoBlock( micBlockB0, 0x49, address, dir, sequenceCounter );
+    micBlockB0[15] = size & 0xFF;
+
+    LoRaMacCmac( LoRaMacCryptoGetKey( key ), micBlockB0, buffer, size & 0xFF, cmac );
+
+    *mic = ( uint32_t )( ( uint32_t )cmac[3] << 24 | ( uint32_t )cmac[2] << 16 | ( uint32_t )cmac[1] << 8 | ( uint32_t )cmac[0] );
+}
+
+void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint8_t *encBuffer )
+{
+    const LoRaMacCryptoKey_t *k;
+    uint8_t aBlock[16];
+    uint8_t sBlock[16];
+    uint8_t ctr;
+    uint8_t n;
+    uint8_t i;
+
+    k = LoRaMacCryptoGetKey( key );
+
+    /*
+     * The whole payload is run through one key schedule, with only the
+     * counter byte of the A block changing from one block to the next.
+     * The buffers may be the same.
+     */
+    LoRaMacCryptoBlock( aBlock, 0x01, address, dir, sequenceCounter );
+    for( ctr = 1; size > 0; ctr++ )
+    {
+        aBlock[15] = ctr;
+        aes_encrypt( aBlock, sBlock, &k->Aes );
+
+        n = ( size < 16 ) ? size : 16;
+        for( i = 0; i < n; i++ )
+        {
+            encBuffer[i] = buffer[i] ^ sBlock[i];
+        }
+        buffer += n;
+        encBuffer += n;
+        size -= n;
+    }
+}
+
+void LoRaMacPayloadDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint8_t *decBuffer )
+{
+    LoRaMacPayloadEncrypt( buffer, size, key, address, dir, sequenceCounter, decBuffer );
+}
+
+void LoRaMacJoinComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t *mic )
+{
+    uint8_t cmac[16];
+
+    LoRaMacCmac( LoRaMacCryptoGetKey( key ), NULL, buffer, size & 0xFF, cmac );
+
+    *mic = ( uint32_t )( ( uint32_t )cmac[3] << 24 | ( uint32_t )cmac[2] << 16 | ( uint32_t )cmac[1] << 8 | ( uint32_t )cmac[0] );
+}
+
+void LoRaMacJoinDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint8_t *decBuffer )
+{
+    const LoRaMacCryptoKey_t *k;
+
+    k = LoRaMacCryptoGetKey( key );
+    aes_encrypt( buffer, decBuffer, &k->Aes );
+    // Check if optional CFList is included
+    if( size >= 16 )
+    {
+        aes_encrypt( buffer + 16, decBuffer + 16, &k->Aes );
+    }
+}
+
+void LoRaMacJoinComputeSKeys( const uint8_t *key, const uint8_t *appNonce, uint16_t devNonce, uint8_t *nwkSKey, uint8_t *appSKey )
+{
+    const LoRaMacCryptoKey_t *k;
+    uint8_t nonce[16];
+    uint8_t *pDevNonce = ( uint8_t * )&devNonce;
+
+    k = LoRaMacCryptoGetKey( key );
+
+    memset( nonce, 0, sizeof( nonce ) );
+    nonce[0] = 0x01;
+    memcpy( nonce + 1, appNonce, 6 );
+    memcpy( nonce + 7, pDevNonce, 2 );
+    aes_encrypt( nonce, nwkSKey, &k->Aes );
+
+    memset( nonce, 0, sizeof( nonce ) );
+    nonce[0] = 0x02;
+    memcpy( nonce + 1, appNonce, 6 );
+    memcpy( nonce + 7, pDevNonce, 2 );
+    aes_encrypt( nonce, appSKey, &k->Aes );
+}
@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __MQTT_CLIENT_H__
+#define __MQTT_CLIENT_H__
+
+#include "os/mynewt.h"
+#include "mqtt/MQTTPacket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MQTT client over an mn_socket TCP connection.
+ *
+ * Packets are kept in mbuf chains from end to end.  A payload to publish is
+ * handed over as a chain, and the headers are prepended to it; a received
+ * publish is passed up in the chain it was read into.  Neither needs a
+ * buffer the size of the packet.
+ *
+ * The client runs from the default event queue; its functions must be
+ * called from there too.  Sessions are not persisted: messages in flight
+ * when the connection goes down are not sent again.
+ */
+
+struct mn_socket;
+struct mn_sockaddr;
+struct mqtt_client;
+
+/*
+ * A received PUBLISH.
+ */
+struct mqtt_client_msg {
+    /* Points into mcm_om. */
+    MQTTString mcm_topic;
+
+    /*
+     * The whole packet; the payload is mcm_len bytes at offset mcm_off.
+     * The receive callback can keep the chain by setting this to NULL;
+     * otherwise it is freed when the callback returns.
+     */
+    struct os_mbuf *mcm_om;
+    int mcm_off;
+    int mcm_len;
+
+    int mcm_qos;
+    unsigned short mcm_packetid;
+    unsigned char mcm_dup;
+    unsigned char mcm_retained;
+};
+
+struct mqtt_client_cbs {
+    /*
+     * The connection attempt is over.  'rc' is the CONNACK return code; 0
+     * if the connection was accepted.  If the TCP connection could not be
+     * set up, 'rc' is a negated MN_E* error.
+     */
+    void (*mcc_connected)(void *arg, int rc);
+
+    /*
+     * The connection was lost; 'err' is an MN_E* error.  MN_ETIMEDOUT if
+     * the server did not answer a ping, MN_EINVAL if it sent a malformed
+     * packet, or one larger than MQTT_CLIENT_RX_MAX.
+     */
+    void (*mcc_disconnected)(void *arg, int err);
+
+    /* A PUBLISH was received. */
+    void (*mcc_publish)(void *arg, struct mqtt_client_msg *msg);
+
+    /*
+     * A publish or subscription completed.  'type' is PUBACK or PUBCOMP
+     * for QoS 1 and 2 publishes, SUBACK for subscriptions.  For SUBACK,
+     * 'rc' is the granted QoS, or 0x80 on failure; it is 0 otherwise.
+     */
+    void (*mcc_ack)(void *arg, int type, unsigned short packetid, int rc);
+};
+
+struct mqtt_client {
+    struct mn_socket *mc_sock;
+    const struct mqtt_client_cbs *mc_cbs;
+    void *mc_arg;
+
+    /* Received data not yet making up a whole packet. */
+    struct os_mbuf *mc_rx;
+
+    /* Packets waiting for the socket to take them. */
+    STAILQ_HEAD(, os_mbuf_pkthdr) mc_txq;
+
+    struct os_event mc_rx_ev;
+    struct os_event mc_tx_ev;
+    struct os_callout mc_ping_timer;
+    int mc_tx_err;
+
+    uint16_t mc_keepalive;
+    uint16_t mc_packetid;
+    uint8_t mc_state;
+    uint8_t mc_ping_sent;       /* PINGREQ sent, PINGRESP not yet received */
+};
+
+/**
+ * Initializes a client.
+ *
+ * @param mc                    The client to initialize.
+ * @param cbs                   Callbacks for events on the connection.
+ * @param arg                   Argument to pass to the callbacks.
+ */
+void mqtt_client_init(struct mqtt_client *mc,
+                      const struct mqtt_client_cbs *cbs, void *arg);
+
+/**
+ * Connects to a server.  Completion is reported through the mcc_connected
+ * callback.
+ *
+ * @param mc                    The client.
+ * @param addr                  The address of the server.
+ * @param opts                  The contents of the CONNECT packet.  The
+ *                                  keep alive interval is also how often the
+ *                                  client pings the server; if the server
+ *                                  does not answer within the interval, the
+ *                                  connection is dropped with MN_ETIMEDOUT.
+ *
+ * @return                      0 if the connection is under way;
+ *                              MN_EINVAL if the client is already connected,
+ *                                  or the CONNECT packet is larger than
+ *                                  MQTT_CLIENT_CTRL_MAX;
+ *                              other MN_E* errors from the socket layer.
+ */
+int mqtt_client_connect(struct mqtt_client *mc, struct mn_sockaddr *addr,
+                        MQTTPacket_connectData *opts);
+
+/**
+ * Publishes a message.  The headers are prepended to the payload chain,
+ * which is sent as is.
+ *
+ * @param mc                    The client.
+ * @param topic                 The topic to publish to.
+ * @param qos                   The QoS level; 0, 1 or 2.
+ * @param retained              Whether the server should retain the message.
+ * @param om                    The payload.  Consumed, whether this succeeds
+ *                                  or not.
+ * @param packetid              On success, the identifier reported in the
+ *                                  mcc_ack callback for QoS 1 and 2.  Can be
+ *                                  NULL.
+ *
+ * @return                      0 on success;
+ *                              MN_ENOTCONN if the client is not connected;
+ *                              MN_EINVAL if the packet would be too large;
+ *                              MN_ENOBUFS if out of mbufs.
+ */
+int mqtt_client_publish(struct mqtt_client *mc, MQTTString topic, int qos,
+                        unsigned char retained, struct os_mbuf *om,
+                        unsigned short *packetid);
+
+/**
+ * Subscribes to a topic filter.  The granted QoS is reported through the
+ * mcc_ack callback.
+ *
+ * @return                      0 on success;
+ *                              MN_ENOTCONN if the client is not connected;
+ *                              MN_EINVAL if the SUBSCRIBE packet is larger
+ *                                  than MQTT_CLIENT_CTRL_MAX;
+ *                              MN_ENOBUFS if out of mbufs.
+ */
+int mqtt_client_subscribe(struct mqtt_client *mc, MQTTString topic, int qos,
+                          unsigned short *packetid);
+
+/**
+ * Sends DISCONNECT and closes the connection.  Packets still queued are
+ * dropped.  The mcc_disconnected callback is not called.
+ */
+void mqtt_client_disconnect(struct mqtt_client *mc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MQTT_CLIENT_H__ */
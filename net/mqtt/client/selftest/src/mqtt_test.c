@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "mqtt_test.h"
+
+#define MB_CNT 160
+#define MB_SZ  320
+static uint8_t test_mbuf_area[MB_CNT * MB_SZ];
+static struct os_mempool test_mbuf_mpool;
+static struct os_mbuf_pool test_mbuf_pool;
+
+TEST_CASE_DECL(mqtt_mbuf_test)
+TEST_CASE_DECL(mqtt_client_test)
+TEST_CASE_DECL(mqtt_client_rx_max_test)
+TEST_CASE_DECL(mqtt_client_ping_test)
+
+/*
+ * Builds a payload in a chain of msys mbufs, with 'leading' bytes of leading
+ * space in the first one.
+ */
+struct os_mbuf *
+mqtt_test_payload(int seq, int len, int leading)
+{
+    struct os_mbuf *om;
+    uint8_t b;
+    int i;
+
+    om = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    om->om_data += leading;
+    for (i = 0; i < len; i++) {
+        b = MQTT_TEST_BYTE(seq, i);
+        TEST_ASSERT_FATAL(os_mbuf_append(om, &b, 1) == 0);
+    }
+    return om;
+}
+
+int
+mqtt_test_payload_check(const struct os_mbuf *om, int off, int seq, int len)
+{
+    uint8_t buf[64];
+    int chunk;
+    int i;
+    int j;
+
+    for (i = 0; i < len; i += chunk) {
+        chunk = min(len - i, sizeof(buf));
+        if (os_mbuf_copydata(om, off + i, chunk, buf)) {
+            return -1;
+        }
+        for (j = 0; j < chunk; j++) {
+            if (buf[j] != MQTT_TEST_BYTE(seq, i + j)) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void
+mqtt_test_init(void *arg)
+{
+    int rc;
+
+    rc = os_mempool_init(&test_mbuf_mpool, MB_CNT, MB_SZ,
+                         test_mbuf_area, "mb");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(&test_mbuf_pool, &test_mbuf_mpool,
+                           MB_SZ, MB_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_msys_register(&test_mbuf_pool);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_SUITE(mqtt_test_all)
+{
+    tu_suite_set_pre_test_cb(mqtt_test_init, NULL);
+
+    mqtt_mbuf_test();
+    mqtt_client_test();
+    mqtt_client_rx_max_test();
+    mqtt_client_ping_test();
+}
+
+int
+main(int argc, char **argv)
+{
+    mqtt_test_all();
+    return tu_any_failed;
+}
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _MQTT_TEST_H
+#define _MQTT_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+
+#include "mqtt/MQTTPacket.h"
+#include "mqtt/MQTTMbuf.h"
+
+/*
+ * Payload byte at offset 'off' in test message 'seq'.
+ */
+#define MQTT_TEST_BYTE(seq, off)        ((uint8_t)((seq) * 31 + (off)))
+
+struct os_mbuf *mqtt_test_payload(int seq, int len, int leading);
+int mqtt_test_payload_check(const struct os_mbuf *om, int off, int seq,
+                            int len);
+
+#endif /* _MQTT_TEST_H */
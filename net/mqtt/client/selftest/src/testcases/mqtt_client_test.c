@@ -0,0 +1,449 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <limits.h>
+
+#include "mqtt_test.h"
+#include "mn_socket/mn_socket.h"
+#include "mqtt_client/mqtt_client.h"
+
+/*
+ * The client subscribes to a topic, and publishes messages of different
+ * sizes to it, through a minimal broker on a loopback TCP connection.  The
+ * broker acknowledges each publish and sends it back.  The largest message
+ * is many times the size of an mbuf.
+ *
+ * Then the connection is dropped by the client when the broker sends a
+ * packet larger than MQTT_CLIENT_RX_MAX, and when it stops answering pings.
+ */
+#define MCT_PORT                12883
+
+static const int mct_lens[] = { 10, 1000, 16000 };
+#define MCT_MSGS                (sizeof(mct_lens) / sizeof(mct_lens[0]))
+
+static char mct_topic[] = "mqtt/test";
+
+static struct os_sem mct_sem;
+static struct mqtt_client mct_client;
+static int mct_connected;
+static int mct_subscribed;
+static int mct_acked;
+static int mct_rcvd;
+static int mct_err;
+static const struct mqtt_client_cbs *mct_start_cbs;
+static int mct_start_keepalive;
+
+/* broker */
+static struct mn_socket *mct_listen;
+static struct mn_socket *mct_conn;
+static struct os_mbuf *mct_rx;
+static int mct_pingreqs;
+static int mct_pingresp_max;            /* PINGREQs answered */
+static STAILQ_HEAD(, os_mbuf_pkthdr) mct_txq =
+    STAILQ_HEAD_INITIALIZER(mct_txq);
+static void mct_broker_rx(struct os_event *ev);
+static void mct_broker_tx(struct os_event *ev);
+static struct os_event mct_rx_ev = {
+    .ev_cb = mct_broker_rx,
+};
+static struct os_event mct_tx_ev = {
+    .ev_cb = mct_broker_tx,
+};
+
+static void
+mct_broker_tx(struct os_event *ev)
+{
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    int rc;
+
+    while ((omp = STAILQ_FIRST(&mct_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&mct_txq, omp_next);
+        om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+        rc = mn_sendto(mct_conn, om, NULL);
+        if (rc == MN_EAGAIN) {
+            STAILQ_INSERT_HEAD(&mct_txq, omp, omp_next);
+            return;
+        }
+        TEST_ASSERT_FATAL(rc == 0, "broker send %d", rc);
+    }
+}
+
+static void
+mct_broker_send(struct os_mbuf *om)
+{
+    STAILQ_INSERT_TAIL(&mct_txq, OS_MBUF_PKTHDR(om), omp_next);
+    mct_broker_tx(NULL);
+}
+
+static void
+mct_broker_send_flat(const void *data, int len)
+{
+    struct os_mbuf *om;
+
+    om = os_msys_get_pkthdr(len, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT_FATAL(os_mbuf_append(om, data, len) == 0);
+    mct_broker_send(om);
+}
+
+static void
+mct_broker_packet(struct os_mbuf *om, int hdr_len)
+{
+    uint8_t buf[5];
+    uint8_t b0;
+    int topic_len;
+
+    os_mbuf_copydata(om, 0, 1, &b0);
+    switch (b0 >> 4) {
+    case CONNECT:
+        mct_broker_send_flat("\x20\x02\x00\x00", 4);
+        break;
+    case SUBSCRIBE:
+        /* packet identifier, then the one topic filter and its QoS */
+        buf[0] = SUBACK << 4;
+        buf[1] = 3;
+        os_mbuf_copydata(om, hdr_len, 2, buf + 2);
+        os_mbuf_copydata(om, OS_MBUF_PKTLEN(om) - 1, 1, buf + 4);
+        mct_broker_send_flat(buf, 5);
+        break;
+    case PUBLISH:
+        if ((b0 >> 1) & 3) {
+            os_mbuf_copydata(om, hdr_len, 2, buf);
+            topic_len = (buf[0] << 8) | buf[1];
+            buf[0] = PUBACK << 4;
+            buf[1] = 2;
+            os_mbuf_copydata(om, hdr_len + 2 + topic_len, 2, buf + 2);
+            mct_broker_send_flat(buf, 4);
+        }
+        /* Back to the subscriber. */
+        mct_broker_send(om);
+        return;
+    case PINGREQ:
+        if (++mct_pingreqs <= mct_pingresp_max) {
+            mct_broker_send_flat("\xd0\x00", 2);
+        }
+        break;
+    default:
+        break;
+    }
+    os_mbuf_free_chain(om);
+}
+
+static void
+mct_broker_rx(struct os_event *ev)
+{
+    struct os_mbuf *om;
+    int hdr_len;
+    int rem_len;
+    int rc;
+
+    while (mn_recvfrom(mct_conn, &om, NULL) == 0) {
+        if (mct_rx) {
+            os_mbuf_concat(mct_rx, om);
+        } else {
+            mct_rx = om;
+        }
+    }
+
+    while (mct_rx) {
+        hdr_len = MQTTPacket_decode_mbuf(mct_rx, &rem_len);
+        TEST_ASSERT_FATAL(hdr_len >= 0);
+        if (hdr_len == 0 || OS_MBUF_PKTLEN(mct_rx) < hdr_len + rem_len) {
+            break;
+        }
+        om = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        rc = os_mbuf_appendfrom(om, mct_rx, 0, hdr_len + rem_len);
+        TEST_ASSERT_FATAL(rc == 0);
+        os_mbuf_adj(mct_rx, hdr_len + rem_len);
+        if (OS_MBUF_PKTLEN(mct_rx) == 0) {
+            os_mbuf_free_chain(mct_rx);
+            mct_rx = NULL;
+        }
+        mct_broker_packet(om, hdr_len);
+    }
+}
+
+static void
+mct_broker_readable(void *arg, int err)
+{
+    os_eventq_put(os_eventq_dflt_get(), &mct_rx_ev);
+}
+
+static void
+mct_broker_writable(void *arg, int err)
+{
+    os_eventq_put(os_eventq_dflt_get(), &mct_tx_ev);
+}
+
+static const union mn_socket_cb mct_broker_cbs = {
+    .socket.readable = mct_broker_readable,
+    .socket.writable = mct_broker_writable,
+};
+
+static int
+mct_broker_newconn(void *arg, struct mn_socket *new)
+{
+    mct_conn = new;
+    mn_socket_set_cbs(new, NULL, &mct_broker_cbs);
+    return 0;
+}
+
+static const union mn_socket_cb mct_listen_cbs = {
+    .listen.newconn = mct_broker_newconn,
+};
+
+/* client */
+static void
+mct_done_check(void)
+{
+    if (mct_acked == MCT_MSGS && mct_rcvd == MCT_MSGS) {
+        mqtt_client_disconnect(&mct_client);
+        os_sem_release(&mct_sem);
+    }
+}
+
+static void
+mct_connected_cb(void *arg, int rc)
+{
+    MQTTString topic = MQTTString_initializer;
+
+    TEST_ASSERT_FATAL(rc == 0, "connect %d", rc);
+    mct_connected = 1;
+
+    topic.cstring = mct_topic;
+    rc = mqtt_client_subscribe(&mct_client, topic, 1, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+mct_disconnected_cb(void *arg, int err)
+{
+    TEST_ASSERT_FATAL(0, "disconnected %d", err);
+}
+
+static void
+mct_publish_cb(void *arg, struct mqtt_client_msg *msg)
+{
+    int i;
+
+    TEST_ASSERT(msg->mcm_topic.lenstring.len == strlen(mct_topic));
+    TEST_ASSERT(!memcmp(msg->mcm_topic.lenstring.data, mct_topic,
+                        strlen(mct_topic)));
+    TEST_ASSERT(msg->mcm_qos == 1);
+
+    /* Messages come back in order. */
+    i = mct_rcvd++;
+    TEST_ASSERT_FATAL(i < MCT_MSGS);
+    TEST_ASSERT(msg->mcm_len == mct_lens[i], "msg %d len %d", i,
+                msg->mcm_len);
+    TEST_ASSERT(mqtt_test_payload_check(msg->mcm_om, msg->mcm_off, i,
+                                        mct_lens[i]) == 0, "msg %d", i);
+    mct_done_check();
+}
+
+static void
+mct_ack_cb(void *arg, int type, unsigned short packetid, int rc)
+{
+    MQTTString topic = MQTTString_initializer;
+    struct os_mbuf *om;
+    int i;
+
+    switch (type) {
+    case SUBACK:
+        TEST_ASSERT_FATAL(rc == 1, "granted %d", rc);
+        mct_subscribed = 1;
+
+        /* All at once; they queue up behind each other. */
+        topic.cstring = mct_topic;
+        for (i = 0; i < MCT_MSGS; i++) {
+            om = mqtt_test_payload(i, mct_lens[i], i * 16);
+            rc = mqtt_client_publish(&mct_client, topic, 1, 0, om, NULL);
+            TEST_ASSERT_FATAL(rc == 0, "publish %d", rc);
+        }
+        break;
+    case PUBACK:
+        mct_acked++;
+        mct_done_check();
+        break;
+    default:
+        TEST_ASSERT(0, "ack %d", type);
+        break;
+    }
+}
+
+static const struct mqtt_client_cbs mct_cbs = {
+    .mcc_connected = mct_connected_cb,
+    .mcc_disconnected = mct_disconnected_cb,
+    .mcc_publish = mct_publish_cb,
+    .mcc_ack = mct_ack_cb,
+};
+
+static void
+mct_start(struct os_event *ev)
+{
+    MQTTPacket_connectData opts = MQTTPacket_connectData_initializer;
+    struct mn_sockaddr_in msin;
+    int rc;
+
+    memset(&msin, 0, sizeof(msin));
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = htons(MCT_PORT);
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+
+    rc = mn_socket(&mct_listen, MN_PF_INET, MN_SOCK_STREAM, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    mn_socket_set_cbs(mct_listen, NULL, &mct_listen_cbs);
+    rc = mn_bind(mct_listen, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = mn_listen(mct_listen, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    mqtt_client_init(&mct_client, mct_start_cbs, NULL);
+    opts.clientID.cstring = "mct";
+    if (mct_start_keepalive) {
+        opts.keepAliveInterval = mct_start_keepalive;
+    }
+    rc = mqtt_client_connect(&mct_client, (struct mn_sockaddr *)&msin,
+                             &opts);
+    TEST_ASSERT_FATAL(rc == 0, "connect %d", rc);
+}
+
+/*
+ * Sets up the broker, and has the client connect to it.
+ */
+static void
+mct_run(const struct mqtt_client_cbs *cbs, int keepalive, int pingresp_max)
+{
+    static struct os_event start_ev = {
+        .ev_cb = mct_start,
+    };
+
+    os_sem_init(&mct_sem, 0);
+    mct_connected = 0;
+    mct_err = 0;
+    mct_pingreqs = 0;
+    mct_pingresp_max = pingresp_max;
+    mct_start_cbs = cbs;
+    mct_start_keepalive = keepalive;
+    os_eventq_put(os_eventq_dflt_get(), &start_ev);
+}
+
+static void
+mct_stop(void)
+{
+    if (mct_conn) {
+        mn_close(mct_conn);
+        mct_conn = NULL;
+    }
+    mn_close(mct_listen);
+    os_mbuf_free_chain(mct_rx);
+    mct_rx = NULL;
+}
+
+TEST_CASE_TASK(mqtt_client_test)
+{
+    int rc;
+
+    mct_run(&mct_cbs, 0, INT_MAX);
+
+    rc = os_sem_pend(&mct_sem, OS_TICKS_PER_SEC * 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(mct_connected);
+    TEST_ASSERT(mct_subscribed);
+    TEST_ASSERT(mct_acked == MCT_MSGS, "acked %d", mct_acked);
+    TEST_ASSERT(mct_rcvd == MCT_MSGS, "received %d", mct_rcvd);
+
+    mct_stop();
+}
+
+static void
+mct_fail_connected_cb(void *arg, int rc)
+{
+    TEST_ASSERT_FATAL(rc == 0, "connect %d", rc);
+    mct_connected = 1;
+}
+
+static void
+mct_fail_disconnected_cb(void *arg, int err)
+{
+    mct_err = err;
+    os_sem_release(&mct_sem);
+}
+
+static void
+mct_big_connected_cb(void *arg, int rc)
+{
+    uint8_t buf[8];
+    int len;
+
+    mct_fail_connected_cb(arg, rc);
+
+    /* Only the header and the topic length; the rest never comes. */
+    buf[0] = PUBLISH << 4;
+    len = 1 + MQTTPacket_encode(buf + 1, MYNEWT_VAL(MQTT_CLIENT_RX_MAX));
+    buf[len++] = 0;
+    buf[len++] = 1;
+    mct_broker_send_flat(buf, len);
+}
+
+static const struct mqtt_client_cbs mct_big_cbs = {
+    .mcc_connected = mct_big_connected_cb,
+    .mcc_disconnected = mct_fail_disconnected_cb,
+};
+
+TEST_CASE_TASK(mqtt_client_rx_max_test)
+{
+    int rc;
+
+    mct_run(&mct_big_cbs, 0, INT_MAX);
+
+    rc = os_sem_pend(&mct_sem, OS_TICKS_PER_SEC * 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(mct_connected);
+    TEST_ASSERT(mct_err == MN_EINVAL, "err %d", mct_err);
+
+    mct_stop();
+}
+
+static const struct mqtt_client_cbs mct_ping_cbs = {
+    .mcc_connected = mct_fail_connected_cb,
+    .mcc_disconnected = mct_fail_disconnected_cb,
+};
+
+TEST_CASE_TASK(mqtt_client_ping_test)
+{
+    os_time_t start;
+    int rc;
+
+    /* Pinged every second; the third ping is not answered. */
+    start = os_time_get();
+    mct_run(&mct_ping_cbs, 1, 2);
+
+    rc = os_sem_pend(&mct_sem, OS_TICKS_PER_SEC * 10);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(mct_connected);
+    TEST_ASSERT(mct_err == MN_ETIMEDOUT, "err %d", mct_err);
+    TEST_ASSERT(mct_pingreqs == 3, "%d pings", mct_pingreqs);
+    TEST_ASSERT(os_time_get() - start >= OS_TICKS_PER_SEC * 3);
+
+    mct_stop();
+}
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "mqtt_test.h"
+
+#define MQTT_MBUF_TEST_MAX      2100
+
+static unsigned char mqtt_mbuf_test_flat[MQTT_MBUF_TEST_MAX];
+static unsigned char mqtt_mbuf_test_payload[MQTT_MBUF_TEST_MAX];
+
+/*
+ * A PUBLISH serialized into a chain matches the one serialized into a flat
+ * buffer, and parses back to what went in.
+ */
+static void
+mqtt_mbuf_test_one(int qos, int len, int leading, char *topic)
+{
+    MQTTString topic_name = MQTTString_initializer;
+    MQTTString parsed_topic;
+    unsigned short packetid;
+    unsigned char retained;
+    unsigned char dup;
+    struct os_mbuf *om;
+    int payloadoff;
+    int payloadlen;
+    int parsed_qos;
+    int flat_len;
+    int rem_len;
+    int rc;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        mqtt_mbuf_test_payload[i] = MQTT_TEST_BYTE(len, i);
+    }
+    topic_name.cstring = topic;
+    flat_len = MQTTSerialize_publish(mqtt_mbuf_test_flat,
+                                     sizeof(mqtt_mbuf_test_flat), 0, qos, 1,
+                                     0x1234, topic_name,
+                                     mqtt_mbuf_test_payload, len);
+    TEST_ASSERT_FATAL(flat_len > 0);
+
+    om = mqtt_test_payload(len, len, leading);
+    rc = MQTTSerialize_publish_mbuf(&om, 0, qos, 1, 0x1234, topic_name);
+    TEST_ASSERT_FATAL(rc == flat_len, "rc %d, expected %d", rc, flat_len);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == flat_len);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, mqtt_mbuf_test_flat, flat_len) == 0,
+                "qos %d len %d leading %d", qos, len, leading);
+
+    /* The fixed header gives the length of the packet. */
+    rc = MQTTPacket_decode_mbuf(om, &rem_len);
+    TEST_ASSERT(rc > 1 && rc + rem_len == flat_len);
+
+    rc = MQTTDeserialize_publish_mbuf(&dup, &parsed_qos, &retained, &packetid,
+                                      &parsed_topic, &payloadoff, &payloadlen,
+                                      &om);
+    TEST_ASSERT_FATAL(rc == 1);
+    TEST_ASSERT(dup == 0);
+    TEST_ASSERT(parsed_qos == qos);
+    TEST_ASSERT(retained == 1);
+    if (qos > 0) {
+        TEST_ASSERT(packetid == 0x1234);
+    }
+    TEST_ASSERT(parsed_topic.lenstring.len == strlen(topic));
+    TEST_ASSERT(!memcmp(parsed_topic.lenstring.data, topic, strlen(topic)));
+    TEST_ASSERT(payloadlen == len);
+    TEST_ASSERT(mqtt_test_payload_check(om, payloadoff, len, len) == 0);
+
+    os_mbuf_free_chain(om);
+}
+
+TEST_CASE_SELF(mqtt_mbuf_test)
+{
+    static const int lens[] = { 0, 1, 100, 126, 127, 300, 2000 };
+    struct os_mbuf *om;
+    unsigned char b;
+    int rem_len;
+    int i;
+
+    for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        /* Headers in leading space, or in an mbuf of their own. */
+        mqtt_mbuf_test_one(0, lens[i], 32, "a/b");
+        mqtt_mbuf_test_one(1, lens[i], 32, "sensors/temperature");
+        mqtt_mbuf_test_one(1, lens[i], 0, "sensors/temperature");
+        mqtt_mbuf_test_one(2, lens[i], 4, "x");
+    }
+
+    /* Incomplete and malformed remaining lengths. */
+    om = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(MQTTPacket_decode_mbuf(om, &rem_len) == 0);
+    b = 0x30;
+    os_mbuf_append(om, &b, 1);
+    TEST_ASSERT(MQTTPacket_decode_mbuf(om, &rem_len) == 0);
+    b = 0x80;
+    os_mbuf_append(om, &b, 1);
+    TEST_ASSERT(MQTTPacket_decode_mbuf(om, &rem_len) == 0);
+    b = 0x01;
+    os_mbuf_append(om, &b, 1);
+    TEST_ASSERT(MQTTPacket_decode_mbuf(om, &rem_len) == 3);
+    TEST_ASSERT(rem_len == 128);
+    os_mbuf_adj(om, -1);
+    b = 0x80;
+    for (i = 0; i < 3; i++) {
+        os_mbuf_append(om, &b, 1);
+    }
+    TEST_ASSERT(MQTTPacket_decode_mbuf(om, &rem_len) ==
+                MQTTPACKET_READ_ERROR);
+
+    /* Not a PUBLISH. */
+    os_mbuf_adj(om, OS_MBUF_PKTLEN(om));
+    os_mbuf_append(om, "\x40\x02\x12\x34", 4);
+    TEST_ASSERT(MQTTDeserialize_publish_mbuf(&b, &i, &b, NULL, NULL, NULL,
+                                             NULL, &om) == 0);
+    TEST_ASSERT(om != NULL);
+    os_mbuf_free_chain(om);
+}
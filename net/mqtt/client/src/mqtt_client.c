@@ -0,0 +1,628 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "mn_socket/mn_socket.h"
+#include "mqtt/MQTTPacket.h"
+#include "mqtt/MQTTMbuf.h"
+#include "mqtt_client/mqtt_client.h"
+
+#define MQTT_CLIENT_CTRL_MAX    MYNEWT_VAL(MQTT_CLIENT_CTRL_MAX)
+#define MQTT_CLIENT_RX_MAX      MYNEWT_VAL(MQTT_CLIENT_RX_MAX)
+
+enum {
+    MQTT_CLIENT_IDLE = 0,
+    MQTT_CLIENT_TCP_CONNECTING,         /* waiting for writable */
+    MQTT_CLIENT_MQTT_CONNECTING,        /* waiting for CONNACK */
+    MQTT_CLIENT_CONNECTED,
+};
+
+static void mqtt_client_readable(void *arg, int err);
+static void mqtt_client_writable(void *arg, int err);
+
+static const union mn_socket_cb mqtt_client_sock_cbs = {
+    .socket.readable = mqtt_client_readable,
+    .socket.writable = mqtt_client_writable,
+};
+
+static void
+mqtt_client_close(struct mqtt_client *mc)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    os_callout_stop(&mc->mc_ping_timer);
+    mc->mc_ping_sent = 0;
+    if (mc->mc_sock) {
+        mn_close(mc->mc_sock);
+        mc->mc_sock = NULL;
+    }
+    os_mbuf_free_chain(mc->mc_rx);
+    mc->mc_rx = NULL;
+    while ((omp = STAILQ_FIRST(&mc->mc_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    mc->mc_state = MQTT_CLIENT_IDLE;
+}
+
+/*
+ * The connection failed or was lost.
+ */
+static void
+mqtt_client_fail(struct mqtt_client *mc, int err)
+{
+    int state;
+
+    state = mc->mc_state;
+    mqtt_client_close(mc);
+    if (state == MQTT_CLIENT_CONNECTED) {
+        if (mc->mc_cbs->mcc_disconnected) {
+            mc->mc_cbs->mcc_disconnected(mc->mc_arg, err);
+        }
+    } else if (mc->mc_cbs->mcc_connected) {
+        mc->mc_cbs->mcc_connected(mc->mc_arg, -err);
+    }
+}
+
+/*
+ * Hands queued packets to the socket, until it takes no more.  The socket
+ * reports when it can take more through the writable callback.
+ */
+static void
+mqtt_client_flush(struct mqtt_client *mc)
+{
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    int rc;
+
+    if (mc->mc_state < MQTT_CLIENT_MQTT_CONNECTING) {
+        return;
+    }
+    while ((omp = STAILQ_FIRST(&mc->mc_txq)) != NULL) {
+        STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+        om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+        rc = mn_sendto(mc->mc_sock, om, NULL);
+        if (rc == MN_EAGAIN) {
+            STAILQ_INSERT_HEAD(&mc->mc_txq, omp, omp_next);
+            return;
+        }
+        if (rc != 0) {
+            os_mbuf_free_chain(om);
+            mqtt_client_fail(mc, rc);
+            return;
+        }
+    }
+}
+
+static void
+mqtt_client_tx(struct mqtt_client *mc, struct os_mbuf *om)
+{
+    STAILQ_INSERT_TAIL(&mc->mc_txq, OS_MBUF_PKTHDR(om), omp_next);
+    mqtt_client_flush(mc);
+}
+
+/*
+ * Sends a packet which was serialized into a flat buffer.
+ */
+static int
+mqtt_client_tx_flat(struct mqtt_client *mc, const unsigned char *buf, int len)
+{
+    struct os_mbuf *om;
+
+    if (len <= 0) {
+        return MN_EINVAL;
+    }
+    om = os_msys_get_pkthdr(len, 0);
+    if (!om) {
+        return MN_ENOBUFS;
+    }
+    if (os_mbuf_append(om, buf, len)) {
+        os_mbuf_free_chain(om);
+        return MN_ENOBUFS;
+    }
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+static void
+mqtt_client_tx_ack(struct mqtt_client *mc, unsigned char type,
+                   unsigned short packetid)
+{
+    unsigned char buf[4];
+    int len;
+
+    len = MQTTSerialize_ack(buf, sizeof(buf), type, 0, packetid);
+    if (mqtt_client_tx_flat(mc, buf, len)) {
+        mqtt_client_fail(mc, MN_ENOBUFS);
+    }
+}
+
+static unsigned short
+mqtt_client_packetid(struct mqtt_client *mc)
+{
+    if (++mc->mc_packetid == 0) {
+        mc->mc_packetid = 1;
+    }
+    return mc->mc_packetid;
+}
+
+static void
+mqtt_client_ping(struct os_event *ev)
+{
+    struct mqtt_client *mc;
+    unsigned char buf[2];
+    int len;
+
+    mc = ev->ev_arg;
+    if (mc->mc_state != MQTT_CLIENT_CONNECTED) {
+        return;
+    }
+    if (mc->mc_ping_sent) {
+        /* No PINGRESP to the last ping within the keep alive interval. */
+        mqtt_client_fail(mc, MN_ETIMEDOUT);
+        return;
+    }
+    len = MQTTSerialize_pingreq(buf, sizeof(buf));
+    if (mqtt_client_tx_flat(mc, buf, len)) {
+        mqtt_client_fail(mc, MN_ENOBUFS);
+        return;
+    }
+    mc->mc_ping_sent = 1;
+    os_callout_reset(&mc->mc_ping_timer,
+                     mc->mc_keepalive * OS_TICKS_PER_SEC);
+}
+
+/*
+ * Splits the chain after the first 'len' bytes.
+ *
+ * @return                      0 on success, with the rest of the data in
+ *                                  'rest' (NULL if there is none);
+ *                              MN_ENOBUFS if out of mbufs.
+ */
+static int
+mqtt_client_split(struct os_mbuf *om, int len, struct os_mbuf **rest)
+{
+    struct os_mbuf *prev;
+    struct os_mbuf *m;
+    struct os_mbuf *n;
+    int pkt_len;
+    int total;
+
+    pkt_len = len;
+    total = OS_MBUF_PKTLEN(om);
+    *rest = NULL;
+    if (total == len) {
+        return 0;
+    }
+
+    n = os_msys_get_pkthdr(0, 0);
+    if (!n) {
+        return MN_ENOBUFS;
+    }
+
+    /* Find the mbuf where the rest starts. */
+    prev = NULL;
+    m = om;
+    while (len >= m->om_len) {
+        len -= m->om_len;
+        prev = m;
+        m = SLIST_NEXT(m, om_next);
+    }
+
+    if (len == 0) {
+        /* On an mbuf boundary; move the mbufs over. */
+        SLIST_NEXT(prev, om_next) = NULL;
+        SLIST_NEXT(n, om_next) = m;
+    } else {
+        /* Copy the tail of the mbuf, and move the ones after it. */
+        if (os_mbuf_append(n, m->om_data + len, m->om_len - len)) {
+            os_mbuf_free_chain(n);
+            return MN_ENOBUFS;
+        }
+        prev = n;
+        while (SLIST_NEXT(prev, om_next)) {
+            prev = SLIST_NEXT(prev, om_next);
+        }
+        SLIST_NEXT(prev, om_next) = SLIST_NEXT(m, om_next);
+        SLIST_NEXT(m, om_next) = NULL;
+        m->om_len = len;
+    }
+    OS_MBUF_PKTHDR(n)->omp_len = total - pkt_len;
+    OS_MBUF_PKTHDR(om)->omp_len = pkt_len;
+
+    *rest = n;
+    return 0;
+}
+
+static void
+mqtt_client_rx_publish(struct mqtt_client *mc, struct os_mbuf *om)
+{
+    struct mqtt_client_msg msg;
+    int rc;
+
+    rc = MQTTDeserialize_publish_mbuf(&msg.mcm_dup, &msg.mcm_qos,
+                                      &msg.mcm_retained, &msg.mcm_packetid,
+                                      &msg.mcm_topic, &msg.mcm_off,
+                                      &msg.mcm_len, &om);
+    if (rc != 1) {
+        /* A failed pullup frees the packet. */
+        rc = om ? MN_EINVAL : MN_ENOBUFS;
+        os_mbuf_free_chain(om);
+        mqtt_client_fail(mc, rc);
+        return;
+    }
+
+    /* Acknowledge first; the callback may keep the packet. */
+    if (msg.mcm_qos == 1) {
+        mqtt_client_tx_ack(mc, PUBACK, msg.mcm_packetid);
+    } else if (msg.mcm_qos == 2) {
+        mqtt_client_tx_ack(mc, PUBREC, msg.mcm_packetid);
+    }
+    if (mc->mc_state != MQTT_CLIENT_CONNECTED) {
+        os_mbuf_free_chain(om);
+        return;
+    }
+
+    msg.mcm_om = om;
+    if (mc->mc_cbs->mcc_publish) {
+        mc->mc_cbs->mcc_publish(mc->mc_arg, &msg);
+    }
+    os_mbuf_free_chain(msg.mcm_om);
+}
+
+/*
+ * Handles a packet other than PUBLISH.  These are small, and are parsed
+ * from a flat copy.
+ */
+static void
+mqtt_client_rx_ctrl(struct mqtt_client *mc, int type, struct os_mbuf *om)
+{
+    unsigned char buf[MQTT_CLIENT_CTRL_MAX];
+    unsigned char session_present;
+    unsigned char connack_rc;
+    unsigned short packetid;
+    unsigned char ptype;
+    unsigned char dup;
+    int granted;
+    int count;
+    int len;
+
+    len = OS_MBUF_PKTLEN(om);
+    if (len > sizeof(buf)) {
+        os_mbuf_free_chain(om);
+        mqtt_client_fail(mc, MN_EINVAL);
+        return;
+    }
+    os_mbuf_copydata(om, 0, len, buf);
+    os_mbuf_free_chain(om);
+
+    switch (type) {
+    case CONNACK:
+        if (mc->mc_state != MQTT_CLIENT_MQTT_CONNECTING ||
+            MQTTDeserialize_connack(&session_present, &connack_rc,
+                                    buf, len) != 1) {
+            break;
+        }
+        if (connack_rc != 0) {
+            mqtt_client_close(mc);
+        } else {
+            mc->mc_state = MQTT_CLIENT_CONNECTED;
+            if (mc->mc_keepalive) {
+                os_callout_reset(&mc->mc_ping_timer,
+                                 mc->mc_keepalive * OS_TICKS_PER_SEC);
+            }
+        }
+        if (mc->mc_cbs->mcc_connected) {
+            mc->mc_cbs->mcc_connected(mc->mc_arg, connack_rc);
+        }
+        return;
+    case PUBACK:
+    case PUBREC:
+    case PUBREL:
+    case PUBCOMP:
+    case UNSUBACK:
+        if (MQTTDeserialize_ack(&ptype, &dup, &packetid, buf, len) != 1) {
+            break;
+        }
+        if (type == PUBREC) {
+            mqtt_client_tx_ack(mc, PUBREL, packetid);
+        } else if (type == PUBREL) {
+            mqtt_client_tx_ack(mc, PUBCOMP, packetid);
+        } else if (mc->mc_cbs->mcc_ack) {
+            mc->mc_cbs->mcc_ack(mc->mc_arg, type, packetid, 0);
+        }
+        return;
+    case SUBACK:
+        if (MQTTDeserialize_suback(&packetid, 1, &count, &granted,
+                                   buf, len) != 1) {
+            break;
+        }
+        if (mc->mc_cbs->mcc_ack) {
+            mc->mc_cbs->mcc_ack(mc->mc_arg, type, packetid, granted);
+        }
+        return;
+    case PINGRESP:
+        mc->mc_ping_sent = 0;
+        return;
+    default:
+        break;
+    }
+    mqtt_client_fail(mc, MN_EINVAL);
+}
+
+/*
+ * Passes up the whole packets at the head of the receive chain.
+ */
+static void
+mqtt_client_rx_packets(struct mqtt_client *mc)
+{
+    struct os_mbuf *om;
+    MQTTHeader header;
+    int hdr_len;
+    int rem_len;
+    int rc;
+
+    while (mc->mc_rx && mc->mc_state != MQTT_CLIENT_IDLE) {
+        hdr_len = MQTTPacket_decode_mbuf(mc->mc_rx, &rem_len);
+        if (hdr_len < 0) {
+            mqtt_client_fail(mc, MN_EINVAL);
+            return;
+        }
+        if (hdr_len == 0) {
+            return;
+        }
+        if (hdr_len + rem_len > MQTT_CLIENT_RX_MAX) {
+            mqtt_client_fail(mc, MN_EINVAL);
+            return;
+        }
+        if (OS_MBUF_PKTLEN(mc->mc_rx) < hdr_len + rem_len) {
+            return;
+        }
+
+        om = mc->mc_rx;
+        rc = mqtt_client_split(om, hdr_len + rem_len, &mc->mc_rx);
+        if (rc) {
+            mqtt_client_fail(mc, rc);
+            return;
+        }
+
+        header.byte = om->om_data[0];
+        if (header.bits.type == PUBLISH) {
+            mqtt_client_rx_publish(mc, om);
+        } else {
+            mqtt_client_rx_ctrl(mc, header.bits.type, om);
+        }
+    }
+}
+
+static void
+mqtt_client_rx_event(struct os_event *ev)
+{
+    struct mqtt_client *mc;
+    struct os_mbuf *om;
+    int rc;
+
+    mc = ev->ev_arg;
+    while (mc->mc_state != MQTT_CLIENT_IDLE) {
+        rc = mn_recvfrom(mc->mc_sock, &om, NULL);
+        if (rc == MN_EAGAIN) {
+            break;
+        }
+        if (rc != 0) {
+            mqtt_client_fail(mc, rc);
+            return;
+        }
+        if (mc->mc_rx) {
+            os_mbuf_concat(mc->mc_rx, om);
+        } else {
+            mc->mc_rx = om;
+        }
+
+        /*
+         * Pass packets up as they complete, so that one larger than
+         * MQTT_CLIENT_RX_MAX is refused before the rest of it is read.
+         */
+        mqtt_client_rx_packets(mc);
+    }
+}
+
+static void
+mqtt_client_tx_event(struct os_event *ev)
+{
+    struct mqtt_client *mc;
+
+    mc = ev->ev_arg;
+    switch (mc->mc_state) {
+    case MQTT_CLIENT_IDLE:
+        return;
+    case MQTT_CLIENT_TCP_CONNECTING:
+        if (mc->mc_tx_err) {
+            mqtt_client_fail(mc, mc->mc_tx_err);
+            return;
+        }
+        /* The CONNECT packet is queued. */
+        mc->mc_state = MQTT_CLIENT_MQTT_CONNECTING;
+        break;
+    default:
+        if (mc->mc_tx_err) {
+            mqtt_client_fail(mc, mc->mc_tx_err);
+            return;
+        }
+        break;
+    }
+    mqtt_client_flush(mc);
+}
+
+/*
+ * Socket callbacks come from the socket provider's context; the work is
+ * done from the event queue.
+ */
+static void
+mqtt_client_readable(void *arg, int err)
+{
+    struct mqtt_client *mc = arg;
+
+    os_eventq_put(os_eventq_dflt_get(), &mc->mc_rx_ev);
+}
+
+static void
+mqtt_client_writable(void *arg, int err)
+{
+    struct mqtt_client *mc = arg;
+
+    mc->mc_tx_err = err;
+    os_eventq_put(os_eventq_dflt_get(), &mc->mc_tx_ev);
+}
+
+void
+mqtt_client_init(struct mqtt_client *mc, const struct mqtt_client_cbs *cbs,
+                 void *arg)
+{
+    memset(mc, 0, sizeof(*mc));
+    mc->mc_cbs = cbs;
+    mc->mc_arg = arg;
+    STAILQ_INIT(&mc->mc_txq);
+    mc->mc_rx_ev.ev_cb = mqtt_client_rx_event;
+    mc->mc_rx_ev.ev_arg = mc;
+    mc->mc_tx_ev.ev_cb = mqtt_client_tx_event;
+    mc->mc_tx_ev.ev_arg = mc;
+    os_callout_init(&mc->mc_ping_timer, os_eventq_dflt_get(),
+                    mqtt_client_ping, mc);
+}
+
+int
+mqtt_client_connect(struct mqtt_client *mc, struct mn_sockaddr *addr,
+                    MQTTPacket_connectData *opts)
+{
+    unsigned char buf[MQTT_CLIENT_CTRL_MAX];
+    int len;
+    int rc;
+
+    if (mc->mc_state != MQTT_CLIENT_IDLE) {
+        return MN_EINVAL;
+    }
+    len = MQTTSerialize_connect(buf, sizeof(buf), opts);
+    if (len <= 0) {
+        return MN_EINVAL;
+    }
+
+    rc = mn_socket(&mc->mc_sock, addr->msa_family == MN_AF_INET6 ?
+                   MN_PF_INET6 : MN_PF_INET, MN_SOCK_STREAM, 0);
+    if (rc) {
+        mc->mc_sock = NULL;
+        return rc;
+    }
+    mn_socket_set_cbs(mc->mc_sock, mc, &mqtt_client_sock_cbs);
+
+    mc->mc_keepalive = opts->keepAliveInterval;
+    mc->mc_tx_err = 0;
+    mc->mc_state = MQTT_CLIENT_TCP_CONNECTING;
+
+    /* Sent once the connection is up. */
+    rc = mqtt_client_tx_flat(mc, buf, len);
+    if (rc == 0) {
+        rc = mn_connect(mc->mc_sock, addr);
+    }
+    if (rc) {
+        mqtt_client_close(mc);
+    }
+    return rc;
+}
+
+int
+mqtt_client_publish(struct mqtt_client *mc, MQTTString topic, int qos,
+                    unsigned char retained, struct os_mbuf *om,
+                    unsigned short *packetid)
+{
+    unsigned short id;
+    int rc;
+
+    if (mc->mc_state != MQTT_CLIENT_CONNECTED) {
+        os_mbuf_free_chain(om);
+        return MN_ENOTCONN;
+    }
+
+    id = qos > 0 ? mqtt_client_packetid(mc) : 0;
+    rc = MQTTSerialize_publish_mbuf(&om, 0, qos, retained, id, topic);
+    if (rc <= 0) {
+        if (om) {
+            os_mbuf_free_chain(om);
+            return MN_EINVAL;
+        }
+        return MN_ENOBUFS;
+    }
+    if (packetid) {
+        *packetid = id;
+    }
+
+    mqtt_client_tx(mc, om);
+    return 0;
+}
+
+int
+mqtt_client_subscribe(struct mqtt_client *mc, MQTTString topic, int qos,
+                      unsigned short *packetid)
+{
+    unsigned char buf[MQTT_CLIENT_CTRL_MAX];
+    unsigned short id;
+    int len;
+    int rc;
+
+    if (mc->mc_state != MQTT_CLIENT_CONNECTED) {
+        return MN_ENOTCONN;
+    }
+
+    id = mqtt_client_packetid(mc);
+    len = MQTTSerialize_subscribe(buf, sizeof(buf), 0, id, 1, &topic, &qos);
+    if (len <= 0) {
+        return MN_EINVAL;
+    }
+    rc = mqtt_client_tx_flat(mc, buf, len);
+    if (rc == 0 && packetid) {
+        *packetid = id;
+    }
+    return rc;
+}
+
+void
+mqtt_client_disconnect(struct mqtt_client *mc)
+{
+    struct os_mbuf_pkthdr *omp;
+    unsigned char buf[2];
+    struct os_mbuf *om;
+    int len;
+
+    if (mc->mc_state == MQTT_CLIENT_CONNECTED) {
+        /* Drop what has not reached the socket, and say goodbye. */
+        while ((omp = STAILQ_FIRST(&mc->mc_txq)) != NULL) {
+            STAILQ_REMOVE_HEAD(&mc->mc_txq, omp_next);
+            os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+        }
+        len = MQTTSerialize_disconnect(buf, sizeof(buf));
+        om = os_msys_get_pkthdr(len, 0);
+        if (om && os_mbuf_append(om, buf, len) == 0 &&
+            mn_sendto(mc->mc_sock, om, NULL) == 0) {
+            om = NULL;
+        }
+        os_mbuf_free_chain(om);
+    }
+    mqtt_client_close(mc);
+}
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef MQTTMBUF_H_
+#define MQTTMBUF_H_
+
+#include "os/mynewt.h"
+#include "MQTTPacket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MQTT packets in mbuf chains.  Payloads are never copied: a PUBLISH is
+ * serialized by prepending its headers to the chain holding the payload,
+ * and deserialized by locating the payload within the received chain.
+ */
+
+/**
+ * Works out the size of the packet at the head of a chain, which may hold
+ * only part of it.
+ *
+ * @param om                    The chain, starting with the fixed header.
+ * @param rem_len               On success, the remaining length field.
+ *
+ * @return                      The size of the fixed header on success; the
+ *                                  packet is this plus rem_len bytes long;
+ *                              0 if the chain ends within the fixed header;
+ *                              MQTTPACKET_READ_ERROR if the remaining length
+ *                                  field is malformed.
+ */
+int MQTTPacket_decode_mbuf(const struct os_mbuf *om, int *rem_len);
+
+/**
+ * Turns a chain holding a payload into a PUBLISH packet, by prepending the
+ * fixed header, topic name and packet identifier.  Leading space in the
+ * first mbuf is used if there is enough of it, otherwise an mbuf is
+ * allocated for the headers.
+ *
+ * @param om                    The payload chain; a packet header mbuf.  On
+ *                                  success, points to the packet.  On
+ *                                  failure to allocate, the chain is freed
+ *                                  and this is set to NULL.
+ * @param dup                   The MQTT dup flag.
+ * @param qos                   The MQTT QoS value.
+ * @param retained              The MQTT retained flag.
+ * @param packetid              The packet identifier; omitted for QoS 0.
+ * @param topicName             The topic to publish to.
+ *
+ * @return                      The length of the packet on success;
+ *                              MQTTPACKET_BUFFER_TOO_SHORT if the packet
+ *                                  would be too long for MQTT, or if there
+ *                                  was no memory.
+ */
+int MQTTSerialize_publish_mbuf(struct os_mbuf **om, unsigned char dup,
+                               int qos, unsigned char retained,
+                               unsigned short packetid, MQTTString topicName);
+
+/**
+ * Parses a PUBLISH packet in a chain.  The topic name is returned in place,
+ * and the payload as an offset into the chain.  If the topic name is not
+ * contiguous, the headers are pulled up into the first mbuf.
+ *
+ * @param dup                   On success, the MQTT dup flag.
+ * @param qos                   On success, the MQTT QoS value.
+ * @param retained              On success, the MQTT retained flag.
+ * @param packetid              On success, the packet identifier, if
+ *                                  qos > 0.
+ * @param topicName             On success, points to the topic name in the
+ *                                  chain.
+ * @param payloadoff            On success, the offset of the payload.
+ * @param payloadlen            On success, the length of the payload.
+ * @param om                    The chain, starting with the packet.  Data
+ *                                  past the packet is ignored.  If the pullup
+ *                                  fails for lack of memory, the chain is
+ *                                  freed and this is set to NULL.
+ *
+ * @return                      1 on success; 0 on failure.
+ */
+int MQTTDeserialize_publish_mbuf(unsigned char *dup, int *qos,
+                                 unsigned char *retained,
+                                 unsigned short *packetid,
+                                 MQTTString *topicName, int *payloadoff,
+                                 int *payloadlen, struct os_mbuf **om);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTTMBUF_H_ */
@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "mqtt/MQTTMbuf.h"
+
+/* The remaining length field takes up to 4 bytes. */
+#define MQTT_MBUF_REM_LEN_BYTES         4
+#define MQTT_MBUF_REM_LEN_MAX           268435455
+
+/* Header byte, remaining length, topic name length. */
+#define MQTT_MBUF_PUBLISH_HDR_MAX       (1 + MQTT_MBUF_REM_LEN_BYTES + 2)
+
+int
+MQTTPacket_decode_mbuf(const struct os_mbuf *om, int *rem_len)
+{
+    unsigned char c;
+    int multiplier;
+    int off;
+
+    *rem_len = 0;
+    if (!om) {
+        return 0;
+    }
+
+    multiplier = 1;
+    for (off = 1; off <= MQTT_MBUF_REM_LEN_BYTES; off++) {
+        if (os_mbuf_copydata(om, off, 1, &c)) {
+            return 0;
+        }
+        *rem_len += (c & 127) * multiplier;
+        if (!(c & 128)) {
+            return off + 1;
+        }
+        multiplier *= 128;
+    }
+    return MQTTPACKET_READ_ERROR;
+}
+
+int
+MQTTSerialize_publish_mbuf(struct os_mbuf **om, unsigned char dup, int qos,
+                           unsigned char retained, unsigned short packetid,
+                           MQTTString topicName)
+{
+    unsigned char hdr[MQTT_MBUF_PUBLISH_HDR_MAX];
+    unsigned char id[2];
+    unsigned char *ptr;
+    MQTTHeader header = {0};
+    const char *topic;
+    int topic_len;
+    int rem_len;
+    int hdr_len;
+    int len;
+
+    topic_len = MQTTstrlen(topicName);
+    topic = topicName.cstring ? topicName.cstring : topicName.lenstring.data;
+
+    len = 2 + topic_len + (qos > 0 ? 2 : 0);
+    rem_len = len + OS_MBUF_PKTLEN(*om);
+    if (rem_len > MQTT_MBUF_REM_LEN_MAX) {
+        return MQTTPACKET_BUFFER_TOO_SHORT;
+    }
+
+    header.bits.type = PUBLISH;
+    header.bits.dup = dup;
+    header.bits.qos = qos;
+    header.bits.retain = retained;
+
+    ptr = hdr;
+    writeChar(&ptr, header.byte);
+    ptr += MQTTPacket_encode(ptr, rem_len);
+    writeInt(&ptr, topic_len);
+    hdr_len = ptr - hdr;
+
+    *om = os_mbuf_prepend(*om, hdr_len - 2 + len);
+    if (!*om) {
+        return MQTTPACKET_BUFFER_TOO_SHORT;
+    }
+
+    /* The space is there now; these do not fail. */
+    os_mbuf_copyinto(*om, 0, hdr, hdr_len);
+    os_mbuf_copyinto(*om, hdr_len, topic, topic_len);
+    if (qos > 0) {
+        ptr = id;
+        writeInt(&ptr, packetid);
+        os_mbuf_copyinto(*om, hdr_len + topic_len, id, sizeof(id));
+    }
+
+    return OS_MBUF_PKTLEN(*om);
+}
+
+int
+MQTTDeserialize_publish_mbuf(unsigned char *dup, int *qos,
+                             unsigned char *retained,
+                             unsigned short *packetid,
+                             MQTTString *topicName, int *payloadoff,
+                             int *payloadlen, struct os_mbuf **om)
+{
+    unsigned char hdr[MQTT_MBUF_PUBLISH_HDR_MAX];
+    unsigned char *ptr;
+    MQTTHeader header;
+    struct os_mbuf *m;
+    int topic_len;
+    int rem_len;
+    int hdr_len;
+    int len;
+
+    m = *om;
+    hdr_len = MQTTPacket_decode_mbuf(m, &rem_len);
+    if (hdr_len <= 0 || rem_len < 2 ||
+        OS_MBUF_PKTLEN(m) < hdr_len + rem_len) {
+        return 0;
+    }
+
+    os_mbuf_copydata(m, 0, hdr_len + 2, hdr);
+    header.byte = hdr[0];
+    if (header.bits.type != PUBLISH) {
+        return 0;
+    }
+    ptr = hdr + hdr_len;
+    topic_len = readInt(&ptr);
+
+    len = hdr_len + 2 + topic_len + (header.bits.qos > 0 ? 2 : 0);
+    if (len > hdr_len + rem_len) {
+        return 0;
+    }
+
+    if (m->om_len < len) {
+        if (len > m->om_omp->omp_databuf_len - m->om_pkthdr_len) {
+            /* Cannot be made contiguous; leave the chain alone. */
+            return 0;
+        }
+        m = os_mbuf_pullup(m, len);
+        *om = m;
+        if (!m) {
+            return 0;
+        }
+    }
+
+    *dup = header.bits.dup;
+    *qos = header.bits.qos;
+    *retained = header.bits.retain;
+
+    topicName->cstring = NULL;
+    topicName->lenstring.len = topic_len;
+    topicName->lenstring.data = (char *)m->om_data + hdr_len + 2;
+    if (*qos > 0) {
+        ptr = m->om_data + hdr_len + 2 + topic_len;
+        *packetid = readInt(&ptr);
+    }
+
+    *payloadoff = len;
+    *payloadlen = hdr_len + rem_len - len;
+    return 1;
+}
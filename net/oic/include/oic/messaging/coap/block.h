@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include "oic/messaging/coap/coap.h"
+#include "oic/oc_ri.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Block-wise transfer of responses (RFC 7959 Block2) for resources which
+ * are unaware of it.
+ */
+
+/*
+ * Answers a GET for a later block from a representation kept since an
+ * earlier block of the same transfer.  The response gets the block, with
+ * the code, content format and ETag of the cached response, and 'offset' is
+ * advanced past it, as a resource aware of Block2 would.  To be called only
+ * once the request's resource is found and the request authorized.
+ *
+ * Returns 1 if the request was answered; 0 if the resource's handler must
+ * be run.
+ */
+int coap_block2_cache_get(struct coap_packet_rx *req, coap_packet_t *rsp,
+                          oc_endpoint_t *endpoint, int32_t *offset);
+
+/*
+ * Drops the representations kept for a resource, e.g. when it is deleted.
+ */
+void coap_block2_cache_drop(oc_resource_t *resource);
+
+/*
+ * Cuts the requested block out of the full representation in the
+ * response's payload.  A GET response with blocks left to send is cached
+ * for the requests to follow, and gets an ETag.
+ *
+ * Returns 0 on success; 1 if the block is past the end of the
+ * representation, in which case the response has no payload; -1 if out of
+ * mbufs.
+ */
+int coap_block2_respond(struct coap_packet_rx *req, coap_packet_t *rsp,
+                        oc_endpoint_t *endpoint, uint32_t num, uint16_t size);
+
+void coap_block2_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOCK_H */
@@ -182,10 +182,8 @@ typedef struct coap_packet {
     /* parse options once and store; allows setting options in random order  */
     uint16_t content_format;
     uint32_t max_age;
-#if 0
     uint8_t etag_len;
     uint8_t etag[COAP_ETAG_LEN];
-#endif
 #if COAP_PROXY_OPTION_PROCESSING
     uint16_t proxy_uri_len;
     char *proxy_uri;
@@ -303,6 +301,8 @@ uint16_t coap_tcp_msg_size(uint8_t *hdr, int datalen);
 void coap_init_message(coap_packet_t *, coap_message_type_t type,
                        uint8_t code, uint16_t mid);
 int coap_serialize_message(coap_packet_t *, struct os_mbuf *m);
+int coap_serialize_message_copy(coap_packet_t *, struct os_mbuf *m,
+                                const struct os_mbuf *payload, uint16_t len);
 void coap_send_message(struct os_mbuf *m, int dup);
 coap_status_t coap_parse_message(struct coap_packet_rx *request,
                                  struct os_mbuf **mp);
@@ -43,7 +43,7 @@ extern "C" {
 #define COAP_DEFAULT_MAX_AGE 60
 #define COAP_RESPONSE_TIMEOUT MYNEWT_VAL(OC_COAP_RESPONSE_TIMEOUT)
 #define COAP_RESPONSE_RANDOM_FACTOR 1.5
-#define COAP_MAX_RETRANSMIT 4
+#define COAP_MAX_RETRANSMIT MYNEWT_VAL(OC_COAP_MAX_RETRANSMIT)
 
 #define COAP_HEADER_LEN                                                        \
   4 /* | version:0x03 type:0x0C tkl:0xF0 | code | mid:0x00FF | mid:0xFF00 | */
@@ -47,7 +47,8 @@ extern "C" {
 #define COAP_OBSERVER_URL_LEN 20
 
 typedef struct coap_observer {
-  SLIST_ENTRY(coap_observer) next;
+  LIST_ENTRY(coap_observer) next;       /* endpoint hash bucket */
+  LIST_ENTRY(coap_observer) res_next;   /* resource's observers */
 
   oc_resource_t *resource;
 
@@ -68,6 +69,7 @@ int coap_remove_observer_by_token(oc_endpoint_t *endpoint, uint8_t *token,
                                   size_t token_len);
 int coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri);
 int coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid);
+int coap_remove_observer_by_resource(oc_resource_t *resource);
 
 int coap_notify_observers(oc_resource_t *resource,
                           struct oc_response_buffer *response_buf,
@@ -40,27 +40,21 @@
 extern "C" {
 #endif
 
-/*
- * Modulo mask (thus +1) for a random number to get the tick number for the
- * random
- * retransmission time between COAP_RESPONSE_TIMEOUT and
- * COAP_RESPONSE_TIMEOUT*COAP_RESPONSE_RANDOM_FACTOR.
- */
-#define COAP_RESPONSE_TIMEOUT_TICKS (OS_TICKS_PER_SEC * COAP_RESPONSE_TIMEOUT)
-#define COAP_RESPONSE_TIMEOUT_BACKOFF_MASK                              \
-    (long)((OS_TICKS_PER_SEC * COAP_RESPONSE_TIMEOUT *                  \
-        ((float)COAP_RESPONSE_RANDOM_FACTOR - 1.0)) +                   \
-      0.5) +                                                            \
-    1
+struct coap_peer;
 
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
-    SLIST_ENTRY(coap_transaction) next;
+    LIST_ENTRY(coap_transaction) next;          /* MID hash bucket */
+    STAILQ_ENTRY(coap_transaction) wait_next;   /* waiting for NSTART */
+    struct coap_peer *peer;
 
     uint16_t mid;
     uint8_t retrans_counter;
+    uint8_t waiting:1;
+    uint8_t backoff:7;          /* timeout multiplier, in halves */
     coap_message_type_t type;
     uint32_t retrans_tmo;
+    os_time_t first_tx;
     struct os_callout retrans_timer;
     struct os_mbuf *m;
 } coap_transaction_t;
@@ -71,6 +65,7 @@ coap_transaction_t *coap_new_transaction(uint16_t mid, oc_endpoint_t *);
 
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
+void coap_ack_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
 
 void coap_check_transactions(void);
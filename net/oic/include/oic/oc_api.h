@@ -97,6 +97,8 @@ void oc_resource_set_periodic_observable_ms(oc_resource_t *resource,
 void oc_resource_set_request_handler(oc_resource_t *resource,
                                      oc_method_t method,
                                      oc_request_handler_t handler);
+void oc_resource_set_block1_sink(oc_resource_t *resource,
+                                 oc_block1_sink_t sink);
 bool oc_add_resource(oc_resource_t *resource);
 void oc_delete_resource(oc_resource_t *resource);
 void oc_deactivate_resource(oc_resource_t *resource);
@@ -47,8 +47,23 @@ typedef struct oc_request {
 
 typedef void (*oc_request_handler_t)(oc_request_t *, oc_interface_mask_t);
 
+/*
+ * Receives a PUT or POST with a Block1 option (RFC 7959) one block at a
+ * time, as it arrives; the block is 'len' bytes at offset 'off' of 'm'.
+ * 'offset' is where the block goes within the whole upload, and 'more' is
+ * false for the last block.  The return value is the status of the
+ * response to the last block; for earlier blocks, an error status ends the
+ * upload, and any other is answered with 2.31 Continue.
+ */
+typedef oc_status_t (*oc_block1_sink_t)(oc_request_t *request, uint32_t offset,
+                                        struct os_mbuf *m, uint16_t off,
+                                        uint16_t len, bool more);
+
+struct coap_observer;
+
 typedef struct oc_resource {
   SLIST_ENTRY(oc_resource) next;
+  SLIST_ENTRY(oc_resource) hash_next; /* URI hash bucket */
   int device;
   oc_string_t uri;
   oc_string_array_t types;
@@ -59,9 +74,11 @@ typedef struct oc_resource {
   oc_request_handler_t put_handler;
   oc_request_handler_t post_handler;
   oc_request_handler_t delete_handler;
+  oc_block1_sink_t block1_sink;
   struct os_callout callout;
   uint32_t observe_period_mseconds;
   uint8_t num_observers;
+  LIST_HEAD(, coap_observer) observers;
 } oc_resource_t;
 
 void oc_ri_init(void);
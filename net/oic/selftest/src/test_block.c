@@ -0,0 +1,315 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include <oic/oc_api.h>
+#include <oic/port/mynewt/ip.h>
+#include <oic/messaging/coap/coap.h>
+#include <oic/messaging/coap/block.h>
+#include "test_oic.h"
+
+/*
+ * Block-wise transfers: a large GET response is generated once and served
+ * block by block from the cache, and a Block1 upload reaches the
+ * resource's sink one block at a time.
+ */
+#define TEST_BLOCK_SZ           64
+#define TEST_BLOCK_REP_LEN      600
+#define TEST_BLOCK_UPLOAD_LEN   300
+
+static volatile int test_block_done;
+static int test_block_gets;
+static int test_block_puts;
+static uint8_t test_block_rep[TEST_BLOCK_REP_LEN + 64];
+static uint8_t test_block_upload[TEST_BLOCK_UPLOAD_LEN];
+static uint32_t test_block_upload_len;
+
+static void test_block_run(struct os_event *);
+static struct os_event test_block_ev = {
+    .ev_cb = test_block_run
+};
+
+static void
+test_block_get(struct oc_request *request, oc_interface_mask_t interface)
+{
+    static uint8_t data[TEST_BLOCK_REP_LEN];
+    int i;
+
+    test_block_gets++;
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+    oc_rep_start_root_object();
+    oc_rep_set_byte_string(root, data, data, sizeof(data));
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+}
+
+static void
+test_block_put(struct oc_request *request, oc_interface_mask_t interface)
+{
+    test_block_puts++;
+    oc_send_response(request, OC_STATUS_CHANGED);
+}
+
+static oc_status_t
+test_block_sink(struct oc_request *request, uint32_t offset,
+                struct os_mbuf *m, uint16_t off, uint16_t len, bool more)
+{
+    if (offset != test_block_upload_len ||
+        offset + len > sizeof(test_block_upload)) {
+        return OC_STATUS_BAD_REQUEST;
+    }
+    os_mbuf_copydata(m, off, len, test_block_upload + offset);
+    test_block_upload_len += len;
+    return OC_STATUS_CHANGED;
+}
+
+static void
+test_block_endpoint(struct oc_endpoint_ip *ep)
+{
+    oc_make_ip6_endpoint(tmp, 0, 19999,
+                         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1);
+
+    *ep = tmp;
+}
+
+static void
+test_block_req(struct coap_packet_rx *req, const char *uri, int code)
+{
+    memset(req, 0, sizeof(*req));
+    req->m = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(req->m != NULL);
+    TEST_ASSERT_FATAL(os_mbuf_append(req->m, uri + 1, strlen(uri) - 1) == 0);
+    req->code = code;
+    req->uri_path_len = strlen(uri) - 1;
+    SET_OPTION(req, COAP_OPTION_URI_PATH);
+}
+
+/*
+ * Requests a block the way the CoAP engine does; the resource either
+ * answers from the cache, or generates the whole representation to cut the
+ * block from.
+ */
+static bool
+test_block_req_block(uint32_t num, coap_packet_t *rsp)
+{
+    struct coap_packet_rx req;
+    struct oc_endpoint_ip ep;
+    int32_t new_offset;
+    bool found;
+    int rc;
+
+    test_block_req(&req, "/block/get", COAP_GET);
+    req.block2_num = num;
+    req.block2_size = TEST_BLOCK_SZ;
+    req.block2_offset = num * TEST_BLOCK_SZ;
+    SET_OPTION(&req, COAP_OPTION_BLOCK2);
+    test_block_endpoint(&ep);
+
+    coap_init_message(rsp, COAP_TYPE_ACK, CONTENT_2_05, 0);
+    new_offset = num * TEST_BLOCK_SZ;
+    found = oc_ri_invoke_coap_entity_handler(&req, rsp, &new_offset,
+                                             (oc_endpoint_t *)&ep);
+    if (found && new_offset == num * TEST_BLOCK_SZ) {
+        rc = coap_block2_respond(&req, rsp, (oc_endpoint_t *)&ep, num,
+                                 TEST_BLOCK_SZ);
+        TEST_ASSERT_FATAL(rc == 0, "block %d rc %d", num, rc);
+    }
+    os_mbuf_free_chain(req.m);
+    return found;
+}
+
+static void
+test_block_get_block(uint32_t num, coap_packet_t *rsp)
+{
+    TEST_ASSERT_FATAL(test_block_req_block(num, rsp));
+
+    TEST_ASSERT_FATAL(rsp->code == CONTENT_2_05);
+    TEST_ASSERT_FATAL(IS_OPTION(rsp, COAP_OPTION_BLOCK2));
+    TEST_ASSERT_FATAL(rsp->block2_num == num);
+    TEST_ASSERT_FATAL(rsp->payload_len <= TEST_BLOCK_SZ);
+}
+
+static void
+test_block_put_block(uint32_t num, int more, coap_packet_t *rsp)
+{
+    struct coap_packet_rx req;
+    struct oc_endpoint_ip ep;
+    uint8_t data[TEST_BLOCK_SZ];
+    int32_t new_offset = 0;
+    uint32_t off;
+    int len;
+    int i;
+
+    test_block_req(&req, "/block/put", COAP_PUT);
+    off = num * TEST_BLOCK_SZ;
+    len = min(TEST_BLOCK_UPLOAD_LEN - off, TEST_BLOCK_SZ);
+    for (i = 0; i < len; i++) {
+        data[i] = off + i;
+    }
+    req.payload_off = OS_MBUF_PKTLEN(req.m);
+    req.payload_len = len;
+    TEST_ASSERT_FATAL(os_mbuf_append(req.m, data, len) == 0);
+    req.block1_num = num;
+    req.block1_more = more;
+    req.block1_size = TEST_BLOCK_SZ;
+    req.block1_offset = off;
+    SET_OPTION(&req, COAP_OPTION_BLOCK1);
+    test_block_endpoint(&ep);
+
+    coap_init_message(rsp, COAP_TYPE_ACK, CONTENT_2_05, 0);
+    oc_ri_invoke_coap_entity_handler(&req, rsp, &new_offset,
+                                     (oc_endpoint_t *)&ep);
+    os_mbuf_free_chain(req.m);
+    os_mbuf_free_chain(rsp->payload_m);
+
+    TEST_ASSERT_FATAL(IS_OPTION(rsp, COAP_OPTION_BLOCK1));
+    TEST_ASSERT_FATAL(rsp->block1_num == num);
+    TEST_ASSERT_FATAL(rsp->block1_more == more);
+}
+
+static void
+test_block_run(struct os_event *ev)
+{
+    static struct oc_resource *get_res;
+    static struct oc_resource *put_res;
+    struct coap_packet_rx req;
+    struct oc_endpoint_ip ep;
+    coap_packet_t rsp;
+    int32_t new_offset = 0;
+    uint8_t etag[COAP_ETAG_LEN];
+    uint32_t etag_len;
+    uint32_t off;
+    uint32_t num;
+    int more;
+    int i;
+
+    get_res = oc_new_resource("/block/get", 1, 0);
+    oc_resource_bind_resource_interface(get_res, OC_IF_R);
+    oc_resource_set_default_interface(get_res, OC_IF_R);
+    oc_resource_set_request_handler(get_res, OC_GET, test_block_get);
+    TEST_ASSERT_FATAL(oc_add_resource(get_res));
+
+    put_res = oc_new_resource("/block/put", 1, 0);
+    oc_resource_bind_resource_interface(put_res, OC_IF_RW);
+    oc_resource_set_default_interface(put_res, OC_IF_RW);
+    oc_resource_set_request_handler(put_res, OC_PUT, test_block_put);
+    oc_resource_set_block1_sink(put_res, test_block_sink);
+    TEST_ASSERT_FATAL(oc_add_resource(put_res));
+
+    /*
+     * The GET handler runs for the first block only; the rest come from
+     * the cache, with the same ETag.
+     */
+    off = 0;
+    etag_len = 0;
+    for (num = 0; ; num++) {
+        test_block_get_block(num, &rsp);
+        TEST_ASSERT_FATAL(IS_OPTION(&rsp, COAP_OPTION_ETAG));
+        if (num == 0) {
+            etag_len = rsp.etag_len;
+            memcpy(etag, rsp.etag, etag_len);
+        } else {
+            TEST_ASSERT(rsp.etag_len == etag_len &&
+                        !memcmp(rsp.etag, etag, etag_len));
+        }
+        TEST_ASSERT_FATAL(off + rsp.payload_len <= sizeof(test_block_rep));
+        os_mbuf_copydata(rsp.payload_m, 0, rsp.payload_len,
+                         test_block_rep + off);
+        off += rsp.payload_len;
+        more = rsp.block2_more;
+        os_mbuf_free_chain(rsp.payload_m);
+        if (!more) {
+            break;
+        }
+        TEST_ASSERT_FATAL(rsp.payload_len == TEST_BLOCK_SZ);
+    }
+    TEST_ASSERT(num > 1);
+    TEST_ASSERT(test_block_gets == 1, "%d GETs", test_block_gets);
+
+    /* The blocks add up to the whole representation. */
+    test_block_req(&req, "/block/get", COAP_GET);
+    test_block_endpoint(&ep);
+    coap_init_message(&rsp, COAP_TYPE_ACK, CONTENT_2_05, 0);
+    TEST_ASSERT_FATAL(oc_ri_invoke_coap_entity_handler(&req, &rsp, &new_offset,
+                                                      (oc_endpoint_t *)&ep));
+    os_mbuf_free_chain(req.m);
+    TEST_ASSERT(test_block_gets == 2);
+    TEST_ASSERT_FATAL(rsp.payload_len == off);
+    TEST_ASSERT(os_mbuf_cmpf(rsp.payload_m, 0, test_block_rep, off) == 0);
+    os_mbuf_free_chain(rsp.payload_m);
+
+    /*
+     * The cached response is dropped after its last block; another
+     * request for a later block runs the handler again, and gets a new ETag.
+     */
+    test_block_get_block(1, &rsp);
+    TEST_ASSERT(test_block_gets == 3);
+    TEST_ASSERT(rsp.etag_len == etag_len && memcmp(rsp.etag, etag, etag_len));
+    os_mbuf_free_chain(rsp.payload_m);
+
+    /*
+     * Upload goes to the sink block by block, not to the PUT handler.
+     */
+    test_block_upload_len = 0;
+    for (num = 0; num * TEST_BLOCK_SZ < TEST_BLOCK_UPLOAD_LEN; num++) {
+        more = (num + 1) * TEST_BLOCK_SZ < TEST_BLOCK_UPLOAD_LEN;
+        test_block_put_block(num, more, &rsp);
+        if (more) {
+            TEST_ASSERT(rsp.code == CONTINUE_2_31);
+        } else {
+            TEST_ASSERT(rsp.code == CHANGED_2_04);
+        }
+    }
+    TEST_ASSERT(test_block_upload_len == TEST_BLOCK_UPLOAD_LEN);
+    for (i = 0; i < TEST_BLOCK_UPLOAD_LEN; i++) {
+        TEST_ASSERT_FATAL(test_block_upload[i] == (uint8_t)i);
+    }
+    TEST_ASSERT(test_block_puts == 0);
+
+    /* A block out of order is refused by the sink. */
+    test_block_put_block(2, 1, &rsp);
+    TEST_ASSERT(rsp.code == BAD_REQUEST_4_00);
+    oc_delete_resource(put_res);
+
+    /*
+     * The representation kept for a resource is not served once the
+     * resource is deleted.
+     */
+    test_block_get_block(0, &rsp);
+    TEST_ASSERT(rsp.block2_more);
+    os_mbuf_free_chain(rsp.payload_m);
+    TEST_ASSERT(test_block_gets == 4);
+
+    oc_delete_resource(get_res);
+    TEST_ASSERT(!test_block_req_block(1, &rsp));
+    TEST_ASSERT(rsp.code == NOT_FOUND_4_04);
+    TEST_ASSERT(rsp.payload_len == 0);
+    TEST_ASSERT(test_block_gets == 4);
+    test_block_done = 1;
+}
+
+void
+test_block(void)
+{
+    os_eventq_put(os_eventq_dflt_get(), &test_block_ev);
+    while (!test_block_done)
+        ;
+}
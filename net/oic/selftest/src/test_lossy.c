@@ -0,0 +1,334 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "os/mynewt.h"
+#include <oic/oc_api.h>
+#include <oic/port/mynewt/transport.h>
+#include <oic/messaging/coap/constants.h>
+#include "test_oic.h"
+
+/*
+ * Confirmable requests over a slow, lossy link.  The link is a loopback
+ * transport which delays every packet, and drops confirmable messages
+ * when told to.  Retransmission timeouts must follow the round-trip time
+ * for requests to complete well within the initial timeout, and no more
+ * than NSTART requests may be in flight at a time.  The selftest sets
+ * NSTART above 1, so that the window holds several messages.
+ */
+#define TEST_LOSSY_DELAY        5       /* ticks, each way */
+#define TEST_LOSSY_QLEN         16
+#define TEST_LOSSY_LEARN        8
+#define TEST_LOSSY_REQS         8
+#define TEST_LOSSY_CONCURRENT   (3 * MYNEWT_VAL(OC_COAP_NSTART))
+#define TEST_LOSSY_MAX_LATENCY  (OS_TICKS_PER_SEC)
+
+static int test_lossy_state;
+static volatile int test_lossy_done;
+static struct oc_resource *test_lossy_res;
+static struct oc_server_handle test_lossy_server;
+static int8_t test_lossy_id;
+
+/* link */
+static struct {
+    struct os_mbuf *m;
+    os_time_t due;
+} test_lossy_q[TEST_LOSSY_QLEN];
+static int test_lossy_q_head;
+static int test_lossy_q_cnt;
+static struct os_callout test_lossy_link_timer;
+static int test_lossy_drop;             /* drop every other CON */
+static int test_lossy_cons;
+static int test_lossy_dropped;
+static uint16_t test_lossy_inflight[TEST_LOSSY_QLEN];
+static int test_lossy_inflight_cnt;
+static int test_lossy_inflight_max;
+static uint16_t test_lossy_order[TEST_LOSSY_CONCURRENT];
+static int test_lossy_order_cnt;        /* CONs first sent, in order */
+
+/* requests */
+static int test_lossy_sent;
+static int test_lossy_rcvd;
+static os_time_t test_lossy_req_start;
+static os_time_t test_lossy_max_latency;
+
+static void test_lossy_next_step(struct os_event *);
+static struct os_event test_lossy_next_ev = {
+    .ev_cb = test_lossy_next_step
+};
+
+static void
+test_lossy_inflight_set(uint16_t mid, int add)
+{
+    int i;
+
+    for (i = 0; i < test_lossy_inflight_cnt; i++) {
+        if (test_lossy_inflight[i] == mid) {
+            if (!add) {
+                test_lossy_inflight[i] =
+                  test_lossy_inflight[--test_lossy_inflight_cnt];
+            }
+            return;
+        }
+    }
+    if (add) {
+        TEST_ASSERT_FATAL(test_lossy_inflight_cnt < TEST_LOSSY_QLEN);
+        test_lossy_inflight[test_lossy_inflight_cnt++] = mid;
+        if (test_lossy_inflight_cnt > test_lossy_inflight_max) {
+            test_lossy_inflight_max = test_lossy_inflight_cnt;
+        }
+    }
+}
+
+static void
+test_lossy_order_add(uint16_t mid)
+{
+    int i;
+
+    for (i = 0; i < test_lossy_order_cnt; i++) {
+        if (test_lossy_order[i] == mid) {
+            return;
+        }
+    }
+    TEST_ASSERT_FATAL(test_lossy_order_cnt < TEST_LOSSY_CONCURRENT);
+    test_lossy_order[test_lossy_order_cnt++] = mid;
+}
+
+static void
+test_lossy_link_timer_cb(struct os_event *ev)
+{
+    struct os_mbuf *m;
+    uint8_t hdr[4];
+
+    while (test_lossy_q_cnt) {
+        if (OS_TIME_TICK_GT(test_lossy_q[test_lossy_q_head].due,
+                            os_time_get())) {
+            os_callout_reset(&test_lossy_link_timer,
+                             test_lossy_q[test_lossy_q_head].due -
+                             os_time_get());
+            return;
+        }
+        m = test_lossy_q[test_lossy_q_head].m;
+        test_lossy_q_head = (test_lossy_q_head + 1) % TEST_LOSSY_QLEN;
+        test_lossy_q_cnt--;
+
+        os_mbuf_copydata(m, 0, sizeof(hdr), hdr);
+        if (((hdr[0] >> 4) & 0x3) == COAP_TYPE_ACK) {
+            test_lossy_inflight_set((hdr[2] << 8) | hdr[3], 0);
+        }
+        oc_recv_message(m);
+    }
+}
+
+static uint8_t
+test_lossy_ep_size(const struct oc_endpoint *oe)
+{
+    return sizeof(struct oc_endpoint_plain);
+}
+
+static void
+test_lossy_tx_ucast(struct os_mbuf *m)
+{
+    uint8_t hdr[4];
+    int tail;
+
+    TEST_ASSERT_FATAL(os_mbuf_copydata(m, 0, sizeof(hdr), hdr) == 0);
+    if (((hdr[0] >> 4) & 0x3) == COAP_TYPE_CON) {
+        if (test_lossy_drop && (test_lossy_cons++ & 1)) {
+            test_lossy_dropped++;
+            os_mbuf_free_chain(m);
+            return;
+        }
+        test_lossy_inflight_set((hdr[2] << 8) | hdr[3], 1);
+        if (test_lossy_state == 3) {
+            test_lossy_order_add((hdr[2] << 8) | hdr[3]);
+        }
+    }
+
+    TEST_ASSERT_FATAL(test_lossy_q_cnt < TEST_LOSSY_QLEN);
+    tail = (test_lossy_q_head + test_lossy_q_cnt) % TEST_LOSSY_QLEN;
+    test_lossy_q[tail].m = m;
+    test_lossy_q[tail].due = os_time_get() + TEST_LOSSY_DELAY;
+    if (!test_lossy_q_cnt++) {
+        os_callout_reset(&test_lossy_link_timer, TEST_LOSSY_DELAY);
+    }
+}
+
+static void
+test_lossy_tx_mcast(struct os_mbuf *m)
+{
+    os_mbuf_free_chain(m);
+}
+
+static char *
+test_lossy_ep_str(char *ptr, int maxlen, const struct oc_endpoint *oe)
+{
+    snprintf(ptr, maxlen, "lossy");
+    return ptr;
+}
+
+static const struct oc_transport test_lossy_transport = {
+    .ot_ep_size = test_lossy_ep_size,
+    .ot_tx_ucast = test_lossy_tx_ucast,
+    .ot_tx_mcast = test_lossy_tx_mcast,
+    .ot_ep_str = test_lossy_ep_str,
+};
+
+static void
+test_lossy_get(struct oc_request *request, oc_interface_mask_t interface)
+{
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, test_lossy_state);
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+}
+
+static void test_lossy_rsp(struct oc_client_response *rsp);
+
+static void
+test_lossy_request(void)
+{
+    bool b_rc;
+
+    b_rc = oc_do_get("/lossy", &test_lossy_server, NULL, test_lossy_rsp,
+                     HIGH_QOS);
+    TEST_ASSERT_FATAL(b_rc == true);
+    test_lossy_sent++;
+    oic_test_reset_tmo("lossy");
+}
+
+static void
+test_lossy_rsp(struct oc_client_response *rsp)
+{
+    os_time_t latency;
+
+    TEST_ASSERT(rsp->code == OC_STATUS_OK, "code %d", rsp->code);
+    test_lossy_rcvd++;
+
+    if (test_lossy_state < 3) {
+        /* one at a time */
+        latency = os_time_get() - test_lossy_req_start;
+        if (latency > test_lossy_max_latency) {
+            test_lossy_max_latency = latency;
+        }
+        if (test_lossy_sent < (test_lossy_state == 1 ? TEST_LOSSY_LEARN :
+                                                       TEST_LOSSY_REQS)) {
+            test_lossy_req_start = os_time_get();
+            test_lossy_request();
+            return;
+        }
+    } else if (test_lossy_rcvd < test_lossy_sent) {
+        return;
+    }
+    os_eventq_put(os_eventq_dflt_get(), &test_lossy_next_ev);
+}
+
+static void
+test_lossy_next_step(struct os_event *ev)
+{
+    bool b_rc;
+    int i;
+
+    test_lossy_state++;
+    switch (test_lossy_state) {
+    case 1:
+        test_lossy_id = oc_transport_register(&test_lossy_transport);
+        TEST_ASSERT_FATAL(test_lossy_id >= 0);
+        os_callout_init(&test_lossy_link_timer, os_eventq_dflt_get(),
+                        test_lossy_link_timer_cb, NULL);
+        memset(&test_lossy_server, 0, sizeof(test_lossy_server));
+        test_lossy_server.endpoint.ep.oe_type = test_lossy_id;
+
+        test_lossy_res = oc_new_resource("/lossy", 1, 0);
+        TEST_ASSERT_FATAL(test_lossy_res);
+        oc_resource_bind_resource_interface(test_lossy_res, OC_IF_R);
+        oc_resource_set_default_interface(test_lossy_res, OC_IF_R);
+        oc_resource_set_request_handler(test_lossy_res, OC_GET,
+                                        test_lossy_get);
+        b_rc = oc_add_resource(test_lossy_res);
+        TEST_ASSERT_FATAL(b_rc == true);
+
+        /*
+         * No losses while the round-trip time is learned.
+         */
+        test_lossy_sent = 0;
+        test_lossy_req_start = os_time_get();
+        test_lossy_request();
+        break;
+    case 2:
+        /*
+         * Every other confirmable message is lost.  Retransmissions
+         * must go out after the learned timeout, not the initial one.
+         */
+        test_lossy_drop = 1;
+        test_lossy_max_latency = 0;
+        test_lossy_sent = 0;
+        test_lossy_req_start = os_time_get();
+        test_lossy_request();
+        break;
+    case 3:
+        TEST_ASSERT(test_lossy_dropped >= TEST_LOSSY_REQS / 2,
+                    "dropped %d", test_lossy_dropped);
+        TEST_ASSERT(test_lossy_max_latency < TEST_LOSSY_MAX_LATENCY,
+                    "latency %lu ticks",
+                    (unsigned long)test_lossy_max_latency);
+
+        /*
+         * Requests issued together are sent NSTART at a time, in the order
+         * they were issued.
+         */
+        test_lossy_drop = 0;
+        test_lossy_inflight_max = 0;
+        test_lossy_order_cnt = 0;
+        test_lossy_sent = 0;
+        test_lossy_rcvd = 0;
+        for (i = 0; i < TEST_LOSSY_CONCURRENT; i++) {
+            test_lossy_request();
+        }
+        break;
+    case 4:
+        TEST_ASSERT(test_lossy_rcvd == TEST_LOSSY_CONCURRENT);
+        TEST_ASSERT(test_lossy_inflight_max == MYNEWT_VAL(OC_COAP_NSTART),
+                    "%d in flight", test_lossy_inflight_max);
+        TEST_ASSERT_FATAL(test_lossy_order_cnt == TEST_LOSSY_CONCURRENT);
+        for (i = 1; i < test_lossy_order_cnt; i++) {
+            TEST_ASSERT((uint16_t)(test_lossy_order[i] -
+                                   test_lossy_order[i - 1]) == 1,
+                        "mid %u sent after %u", test_lossy_order[i],
+                        test_lossy_order[i - 1]);
+        }
+        test_lossy_done = 1;
+        break;
+    default:
+        TEST_ASSERT_FATAL(0);
+        break;
+    }
+}
+
+void
+test_lossy(void)
+{
+    os_eventq_put(os_eventq_dflt_get(), &test_lossy_next_ev);
+    while (!test_lossy_done)
+        ;
+
+    os_callout_stop(&test_lossy_link_timer);
+    oc_delete_resource(test_lossy_res);
+    oc_transport_unregister(&test_lossy_transport);
+}
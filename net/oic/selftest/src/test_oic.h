@@ -43,6 +43,9 @@ void oic_test_get_endpoint(struct oc_server_handle *);
 void test_discovery(void);
 void test_getset(void);
 void test_observe(void);
+void test_scale(void);
+void test_block(void);
+void test_lossy(void);
 
 #ifdef __cplusplus
 }
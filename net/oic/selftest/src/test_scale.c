@@ -0,0 +1,254 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include <oic/oc_api.h>
+#include <oic/port/mynewt/ip.h>
+#include <oic/messaging/coap/observe.h>
+#include "test_oic.h"
+
+/*
+ * Many resources and observers: checks the bookkeeping of observe
+ * relationships, and measures URI lookups, observer registration and
+ * removal, and notifications.
+ */
+#define TEST_SCALE_RES          200
+#define TEST_SCALE_OBS          500
+#define TEST_SCALE_ROUNDS       10
+#define TEST_SCALE_LOOKUPS      100
+#define TEST_SCALE_URI_LEN      16
+
+static int test_scale_state;
+static volatile int test_scale_done;
+static struct oc_resource *test_scale_res[TEST_SCALE_RES];
+static char test_scale_uri[TEST_SCALE_RES][TEST_SCALE_URI_LEN];
+static int test_scale_notified;
+static int test_scale_gets;
+
+static uint32_t test_scale_lookup_us;
+static uint32_t test_scale_reg_us;
+static uint32_t test_scale_dereg_us;
+static uint32_t test_scale_notify_us;
+static int64_t test_scale_start;
+
+static void test_scale_next_step(struct os_event *);
+static struct os_event test_scale_next_ev = {
+    .ev_cb = test_scale_next_step
+};
+
+static void
+test_scale_get(struct oc_request *request, oc_interface_mask_t interface)
+{
+    test_scale_gets++;
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, value, test_scale_state);
+    oc_rep_end_root_object();
+    oc_send_response(request, OC_STATUS_OK);
+}
+
+/*
+ * Observer i watches resource i % TEST_SCALE_RES from its own port.
+ */
+static void
+test_scale_endpoint(struct oc_endpoint_ip *ep, int i)
+{
+    oc_make_ip6_endpoint(tmp, 0, 20000 + i,
+                         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1);
+
+    *ep = tmp;
+}
+
+static int
+test_scale_observe(int i, int observe)
+{
+    static struct coap_packet_rx req;
+    coap_packet_t rsp = { 0 };
+    struct oc_endpoint_ip ep;
+    struct oc_resource *res;
+    const char *uri;
+    int rc;
+
+    uri = test_scale_uri[i % TEST_SCALE_RES];
+    res = oc_ri_get_app_resource_by_uri(uri);
+    TEST_ASSERT_FATAL(res == test_scale_res[i % TEST_SCALE_RES]);
+
+    memset(&req, 0, sizeof(req));
+    req.m = os_msys_get_pkthdr(0, 0);
+    TEST_ASSERT_FATAL(req.m != NULL);
+    TEST_ASSERT_FATAL(os_mbuf_append(req.m, uri + 1, strlen(uri) - 1) == 0);
+    req.code = COAP_GET;
+    req.token_len = sizeof(uint16_t);
+    memcpy(req.token, &i, sizeof(uint16_t));
+    req.uri_path_len = strlen(uri) - 1;
+    SET_OPTION(&req, COAP_OPTION_URI_PATH);
+    req.observe = observe;
+    SET_OPTION(&req, COAP_OPTION_OBSERVE);
+
+    test_scale_endpoint(&ep, i);
+    rc = coap_observe_handler(&req, &rsp, res, (struct oc_endpoint *)&ep);
+    os_mbuf_free_chain(req.m);
+    return rc;
+}
+
+static int
+test_scale_num_observers(void)
+{
+    int cnt;
+    int i;
+
+    cnt = 0;
+    for (i = 0; i < TEST_SCALE_RES; i++) {
+        cnt += test_scale_res[i]->num_observers;
+    }
+    return cnt;
+}
+
+static void
+test_scale_next_step(struct os_event *ev)
+{
+    struct oc_endpoint_ip ep;
+    int64_t start;
+    bool b_rc;
+    int rc;
+    int i;
+    int j;
+
+    test_scale_state++;
+    switch (test_scale_state) {
+    case 1:
+        for (i = 0; i < TEST_SCALE_RES; i++) {
+            snprintf(test_scale_uri[i], TEST_SCALE_URI_LEN, "/scale/%d", i);
+            test_scale_res[i] = oc_new_resource(test_scale_uri[i], 1, 0);
+            TEST_ASSERT_FATAL(test_scale_res[i]);
+            oc_resource_bind_resource_interface(test_scale_res[i], OC_IF_R);
+            oc_resource_set_default_interface(test_scale_res[i], OC_IF_R);
+            oc_resource_set_observable(test_scale_res[i]);
+            oc_resource_set_request_handler(test_scale_res[i], OC_GET,
+                                            test_scale_get);
+            b_rc = oc_add_resource(test_scale_res[i]);
+            TEST_ASSERT_FATAL(b_rc == true);
+        }
+        TEST_ASSERT(oc_ri_get_app_resource_by_uri("/scale/200") == NULL);
+        TEST_ASSERT(oc_ri_get_app_resource_by_uri("/scale/1") ==
+                    test_scale_res[1]);
+
+        start = os_get_uptime_usec();
+        for (j = 0; j < TEST_SCALE_LOOKUPS; j++) {
+            for (i = 0; i < TEST_SCALE_RES; i++) {
+                TEST_ASSERT_FATAL(oc_ri_get_app_resource_by_uri(
+                                    test_scale_uri[i]) == test_scale_res[i]);
+            }
+        }
+        test_scale_lookup_us = os_get_uptime_usec() - start;
+
+        /*
+         * Register and remove all observers a number of times; half are
+         * removed by token, as on a GET with observe=1, the other half as
+         * when a client goes away.
+         */
+        for (j = 0; j < TEST_SCALE_ROUNDS; j++) {
+            start = os_get_uptime_usec();
+            for (i = 0; i < TEST_SCALE_OBS; i++) {
+                rc = test_scale_observe(i, 0);
+                TEST_ASSERT_FATAL(rc == 0, "observe %d rc %d", i, rc);
+            }
+            test_scale_reg_us += os_get_uptime_usec() - start;
+            TEST_ASSERT_FATAL(test_scale_num_observers() == TEST_SCALE_OBS);
+
+            /* Re-registering replaces the existing relationship. */
+            rc = test_scale_observe(0, 0);
+            TEST_ASSERT(rc == 1);
+            TEST_ASSERT(test_scale_num_observers() == TEST_SCALE_OBS);
+
+            start = os_get_uptime_usec();
+            for (i = 0; i < TEST_SCALE_OBS; i += 2) {
+                rc = test_scale_observe(i, 1);
+                TEST_ASSERT_FATAL(rc == 1);
+                test_scale_endpoint(&ep, i + 1);
+                rc = coap_remove_observer_by_client((struct oc_endpoint *)&ep);
+                TEST_ASSERT_FATAL(rc == 1);
+            }
+            test_scale_dereg_us += os_get_uptime_usec() - start;
+            TEST_ASSERT_FATAL(test_scale_num_observers() == 0);
+        }
+
+        for (i = 0; i < TEST_SCALE_OBS; i++) {
+            rc = test_scale_observe(i, 0);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        test_scale_notified = 0;
+        test_scale_start = os_get_uptime_usec();
+        os_eventq_put(os_eventq_dflt_get(), &test_scale_next_ev);
+        break;
+    case 2:
+        /*
+         * Notify one resource at a time, so that the notifications are
+         * sent out before the next batch is generated.  The representation
+         * is encoded once for all of the resource's observers.
+         */
+        test_scale_gets = 0;
+        rc = oc_notify_observers(test_scale_res[test_scale_notified]);
+        TEST_ASSERT(rc == test_scale_res[test_scale_notified]->num_observers);
+        TEST_ASSERT(test_scale_gets == 1, "%d GETs", test_scale_gets);
+        if (++test_scale_notified < TEST_SCALE_RES) {
+            test_scale_state--;
+        } else {
+            test_scale_notify_us = os_get_uptime_usec() - test_scale_start;
+        }
+        os_eventq_put(os_eventq_dflt_get(), &test_scale_next_ev);
+        break;
+    case 3:
+        /*
+         * Deleting a resource drops its observers.
+         */
+        for (i = 0; i < TEST_SCALE_RES; i++) {
+            oc_delete_resource(test_scale_res[i]);
+        }
+        for (i = 0; i < TEST_SCALE_OBS; i++) {
+            test_scale_endpoint(&ep, i);
+            rc = coap_remove_observer_by_client((struct oc_endpoint *)&ep);
+            TEST_ASSERT(rc == 0);
+        }
+        test_scale_done = 1;
+        break;
+    default:
+        TEST_ASSERT_FATAL(0);
+        break;
+    }
+}
+
+void
+test_scale(void)
+{
+    os_eventq_put(os_eventq_dflt_get(), &test_scale_next_ev);
+    while (!test_scale_done)
+        ;
+
+    TEST_PASS("%d resources, %d observers: lookup %d x %d: %lu us; "
+              "register %d x %d: %lu us; remove %d x %d: %lu us; "
+              "notify all: %lu us",
+              TEST_SCALE_RES, TEST_SCALE_OBS,
+              TEST_SCALE_LOOKUPS, TEST_SCALE_RES,
+              (unsigned long)test_scale_lookup_us,
+              TEST_SCALE_ROUNDS, TEST_SCALE_OBS,
+              (unsigned long)test_scale_reg_us,
+              TEST_SCALE_ROUNDS, TEST_SCALE_OBS,
+              (unsigned long)test_scale_dereg_us,
+              (unsigned long)test_scale_notify_us);
+}
@@ -82,5 +82,8 @@ TEST_CASE_TASK(oic_tests)
     test_discovery();
     test_getset();
     test_observe();
+    test_block();
+    test_lossy();
+    test_scale();
     oc_main_shutdown();
 }
@@ -76,6 +76,7 @@ dispatch_coap_request(void)
         }
     } else {
         if (!coap_serialize_message(oc_c_request, oc_c_transaction->m)) {
+            oc_c_transaction->type = oc_c_request->type;
             coap_send_transaction(oc_c_transaction);
         } else {
             coap_clear_transaction(oc_c_transaction);
@@ -21,6 +21,7 @@
 
 #include "oic/port/mynewt/config.h"
 #include "oic/oc_helpers.h"
+#include "api/oc_priv.h"
 
 void
 oc_new_string(oc_string_t *os, const char str[])
@@ -128,3 +129,18 @@ _oc_string_array_add_item(oc_string_array_t *osa, const char str[])
     }
     return false;
 }
+
+/*
+ * FNV-1a; used for hash table lookups of URIs and endpoints.
+ */
+uint32_t
+oc_hash(const void *data, int len)
+{
+    const uint8_t *u8 = data;
+    uint32_t h = 2166136261u;
+
+    while (len-- > 0) {
+        h = (h ^ *u8++) * 16777619u;
+    }
+    return h;
+}
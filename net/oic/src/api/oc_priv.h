@@ -23,4 +23,6 @@ void oc_rep_init(void);
 void oc_buffer_init(void);
 void oc_ri_mem_init(void);
 
+uint32_t oc_hash(const void *data, int len);
+
 #endif /* __OC_OC_PRIV_H__ */
@@ -50,6 +50,16 @@ static struct os_mempool oc_resource_pool;
 static uint8_t oc_resource_area[OS_MEMPOOL_BYTES(MAX_APP_RESOURCES,
       sizeof(oc_resource_t))];
 
+/*
+ * Application resources hashed by URI; the leading '/' is not part of the key.
+ */
+#define OC_RI_RES_BUCKETS MYNEWT_VAL(OC_APP_RESOURCE_BUCKETS)
+#if (OC_RI_RES_BUCKETS & (OC_RI_RES_BUCKETS - 1)) != 0
+#error "OC_APP_RESOURCE_BUCKETS must be a power of two"
+#endif
+static SLIST_HEAD(oc_ri_res_bucket, oc_resource)
+    oc_app_res_hash[OC_RI_RES_BUCKETS];
+
 static void periodic_observe_handler(struct os_event *ev);
 #endif /* OC_SERVER */
 
@@ -191,19 +201,55 @@ stop_processes(void)
 }
 
 #ifdef OC_SERVER
-oc_resource_t *
-oc_ri_get_app_resource_by_uri(const char *uri)
+static struct oc_ri_res_bucket *
+oc_ri_res_bucket(const char *path, int path_len)
+{
+    uint32_t h;
+
+    h = oc_hash(path, path_len);
+    return &oc_app_res_hash[h & (OC_RI_RES_BUCKETS - 1)];
+}
+
+static struct oc_ri_res_bucket *
+oc_ri_res_bucket_of(oc_resource_t *res)
+{
+    return oc_ri_res_bucket(oc_string(res->uri) + 1,
+                            oc_string_len(res->uri) - 1);
+}
+
+/*
+ * Finds an application resource by its URI, minus the leading '/'.
+ */
+static oc_resource_t *
+oc_ri_find_app_resource(const char *path, int path_len)
 {
     oc_resource_t *res;
 
-    SLIST_FOREACH(res, &oc_app_resources, next) {
-        if (oc_string_len(res->uri) == strlen(uri) &&
-          strncmp(uri, oc_string(res->uri), strlen(uri)) == 0)
+    SLIST_FOREACH(res, oc_ri_res_bucket(path, path_len), hash_next) {
+        if (oc_string_len(res->uri) == path_len + 1 &&
+          strncmp(oc_string(res->uri) + 1, path, path_len) == 0) {
             return res;
+        }
     }
-
     return NULL;
 }
+
+oc_resource_t *
+oc_ri_get_app_resource_by_uri(const char *uri)
+{
+    oc_resource_t *res;
+    int len;
+
+    len = strlen(uri);
+    if (len == 0) {
+        return NULL;
+    }
+    res = oc_ri_find_app_resource(uri + 1, len - 1);
+    if (res && oc_string(res->uri)[0] != uri[0]) {
+        return NULL;
+    }
+    return res;
+}
 #endif
 
 void
@@ -261,9 +307,14 @@ oc_ri_delete_resource(oc_resource_t *resource)
     SLIST_FOREACH(tmp, &oc_app_resources, next) {
         if (tmp == resource) {
             SLIST_REMOVE(&oc_app_resources, tmp, oc_resource, next);
+            SLIST_REMOVE(oc_ri_res_bucket_of(resource), resource, oc_resource,
+                         hash_next);
             break;
         }
     }
+    os_callout_stop(&resource->callout);
+    coap_remove_observer_by_resource(resource);
+    coap_block2_cache_drop(resource);
     os_memblock_put(&oc_resource_pool, resource);
 }
 
@@ -282,6 +333,7 @@ oc_ri_add_resource(oc_resource_t *resource)
     }
     if (valid) {
         SLIST_INSERT_HEAD(&oc_app_resources, resource, next);
+        SLIST_INSERT_HEAD(oc_ri_res_bucket_of(resource), resource, hash_next);
     }
 
     return valid;
@@ -389,6 +441,36 @@ oc_ri_check_trans_security(const oc_endpoint_t *oe,
   return true;
 }
 
+/*
+ * Passes one block of an upload to the resource's sink, and acknowledges
+ * it with the Block1 option.  Blocks before the last are answered with
+ * 2.31 Continue, unless the sink failed.
+ */
+static void
+oc_ri_block1_to_sink(oc_resource_t *resource, oc_request_t *request,
+                     coap_packet_t *response)
+{
+  struct os_mbuf *m;
+  uint32_t num;
+  uint32_t offset;
+  uint16_t size;
+  uint16_t off;
+  uint16_t len;
+  uint8_t more;
+  int code;
+
+  coap_get_header_block1(request->packet, &num, &more, &size, &offset);
+  len = coap_get_payload(request->packet, &m, &off);
+
+  code = oc_status_code(resource->block1_sink(request, offset, m, off, len,
+                                              more));
+  if (more && code < BAD_REQUEST_4_00) {
+    code = CONTINUE_2_31;
+  }
+  request->response->response_buffer->code = code;
+  coap_set_header_block1(response, num, more, size);
+}
+
 bool
 oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
                                  coap_packet_t *response, int32_t *offset,
@@ -477,14 +559,8 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
   /* Check against list of declared application resources.
    */
   if (!cur_resource && !bad_request) {
-      SLIST_FOREACH(resource, &oc_app_resources, next) {
-          if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-            strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-              uri_path_len) == 0) {
-              request_obj.resource = cur_resource = resource;
-              break;
-          }
-      }
+      cur_resource = oc_ri_find_app_resource(uri_path, uri_path_len);
+      request_obj.resource = cur_resource;
   }
 #endif
 
@@ -539,7 +615,15 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
              * based on the request method. If the resource has not
              * implemented that method, then return a 4.05 response.
              */
-      if (method == OC_GET && cur_resource->get_handler) {
+      if ((method == OC_PUT || method == OC_POST) &&
+          cur_resource->block1_sink &&
+          IS_OPTION(request, COAP_OPTION_BLOCK1)) {
+        oc_ri_block1_to_sink(cur_resource, &request_obj, response);
+      } else if (method == OC_GET &&
+                 coap_block2_cache_get(request, response, endpoint, offset)) {
+        /* A later block of a representation generated earlier. */
+        response_buffer.code = response->code;
+      } else if (method == OC_GET && cur_resource->get_handler) {
         cur_resource->get_handler(&request_obj, interface);
       } else if (method == OC_POST && cur_resource->post_handler) {
         cur_resource->post_handler(&request_obj, interface);
@@ -669,7 +753,8 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
      * of that resource with the change.
      */
     if ((method == OC_PUT || method == OC_POST) &&
-        response_buffer.code < oc_status_code(OC_STATUS_BAD_REQUEST)) {
+        response_buffer.code < oc_status_code(OC_STATUS_BAD_REQUEST) &&
+        response_buffer.code != CONTINUE_2_31) {
         coap_notify_observers(cur_resource, NULL, NULL);
     }
 #endif
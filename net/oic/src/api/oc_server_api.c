@@ -113,6 +113,8 @@ oc_new_resource(const char *uri, uint8_t num_resource_types, int device)
   resource->observe_period_mseconds = 0;
   resource->properties = OC_ACTIVE;
   resource->num_observers = 0;
+  resource->block1_sink = NULL;
+  LIST_INIT(&resource->observers);
   resource->device = device;
   return resource;
 }
@@ -225,6 +227,12 @@ oc_resource_set_request_handler(oc_resource_t *resource, oc_method_t method,
   }
 }
 
+void
+oc_resource_set_block1_sink(oc_resource_t *resource, oc_block1_sink_t sink)
+{
+  resource->block1_sink = sink;
+}
+
 bool
 oc_add_resource(oc_resource_t *resource)
 {
@@ -0,0 +1,330 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#include "oic/port/mynewt/config.h"
+#include "oic/port/mynewt/adaptor.h"
+#include "oic/messaging/coap/block.h"
+
+#define COAP_BLOCK2_CACHE_ENTRIES   MYNEWT_VAL(OC_BLOCK2_CACHE_ENTRIES)
+
+#if COAP_BLOCK2_CACHE_ENTRIES > 0
+/*
+ * The URI path and query of a request.
+ */
+struct coap_block2_target {
+    char path[COAP_MAX_URI];
+    char query[COAP_MAX_URI_QUERY];
+    uint8_t path_len;
+    uint8_t query_len;
+};
+
+/*
+ * A representation being transferred block-wise, kept for the requests for
+ * its later blocks.  The client is told which one it gets with an ETag; if
+ * an entry is dropped in the middle of the transfer, the representation
+ * generated for the next block gets a new one, so that the client does not
+ * mix the two.
+ */
+struct coap_block2_entry {
+    struct os_mbuf *m;          /* NULL if the entry is free */
+    oc_endpoint_t endpoint;
+    struct coap_block2_target target;
+    os_time_t expires;
+    uint32_t etag;
+    uint16_t content_format;
+    uint8_t code;
+};
+
+static struct coap_block2_entry coap_block2_cache[COAP_BLOCK2_CACHE_ENTRIES];
+static struct os_callout coap_block2_timer;
+static uint32_t coap_block2_etag;
+
+static void
+coap_block2_target(struct coap_packet_rx *req, struct coap_block2_target *t)
+{
+    t->path_len = coap_get_header_uri_path(req, t->path, sizeof(t->path));
+    t->query_len = coap_get_header_uri_query(req, t->query,
+                                             sizeof(t->query));
+}
+
+static void
+coap_block2_drop(struct coap_block2_entry *e)
+{
+    os_mbuf_free_chain(e->m);
+    e->m = NULL;
+}
+
+static void
+coap_block2_timer_reset(void)
+{
+    struct coap_block2_entry *e;
+    struct coap_block2_entry *first;
+    os_time_t now;
+    int i;
+
+    first = NULL;
+    for (i = 0; i < COAP_BLOCK2_CACHE_ENTRIES; i++) {
+        e = &coap_block2_cache[i];
+        if (e->m && (!first || OS_TIME_TICK_LT(e->expires, first->expires))) {
+            first = e;
+        }
+    }
+    if (!first) {
+        os_callout_stop(&coap_block2_timer);
+        return;
+    }
+    now = os_time_get();
+    if (OS_TIME_TICK_GT(first->expires, now)) {
+        os_callout_reset(&coap_block2_timer, first->expires - now);
+    } else {
+        os_callout_reset(&coap_block2_timer, 0);
+    }
+}
+
+static void
+coap_block2_expire(struct os_event *ev)
+{
+    struct coap_block2_entry *e;
+    os_time_t now;
+    int i;
+
+    now = os_time_get();
+    for (i = 0; i < COAP_BLOCK2_CACHE_ENTRIES; i++) {
+        e = &coap_block2_cache[i];
+        if (e->m && OS_TIME_TICK_GEQ(now, e->expires)) {
+            OC_LOG_DEBUG("coap_block2: dropping expired response\n");
+            coap_block2_drop(e);
+        }
+    }
+    coap_block2_timer_reset();
+}
+
+static void
+coap_block2_touch(struct coap_block2_entry *e)
+{
+    e->expires = os_time_get() +
+      os_time_ms_to_ticks32(MYNEWT_VAL(OC_BLOCK2_CACHE_TIMEOUT));
+    coap_block2_timer_reset();
+}
+
+static struct coap_block2_entry *
+coap_block2_find(oc_endpoint_t *endpoint, struct coap_block2_target *t)
+{
+    struct coap_block2_entry *e;
+    int i;
+
+    for (i = 0; i < COAP_BLOCK2_CACHE_ENTRIES; i++) {
+        e = &coap_block2_cache[i];
+        if (e->m && e->target.path_len == t->path_len &&
+            e->target.query_len == t->query_len &&
+            !memcmp(e->target.path, t->path, t->path_len) &&
+            !memcmp(e->target.query, t->query, t->query_len) &&
+            !memcmp(&e->endpoint, endpoint, oc_endpoint_size(endpoint))) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Takes over the representation in the response; replaces an older one for
+ * the same request, or else the one which would expire first.
+ */
+static struct coap_block2_entry *
+coap_block2_store(struct coap_packet_rx *req, coap_packet_t *rsp,
+                  oc_endpoint_t *endpoint)
+{
+    struct coap_block2_target t;
+    struct coap_block2_entry *e;
+    int i;
+
+    coap_block2_target(req, &t);
+    e = coap_block2_find(endpoint, &t);
+    if (!e) {
+        for (i = 0; i < COAP_BLOCK2_CACHE_ENTRIES; i++) {
+            if (!coap_block2_cache[i].m) {
+                e = &coap_block2_cache[i];
+                break;
+            }
+            if (!e || OS_TIME_TICK_LT(coap_block2_cache[i].expires,
+                                      e->expires)) {
+                e = &coap_block2_cache[i];
+            }
+        }
+    }
+    if (e->m) {
+        coap_block2_drop(e);
+    }
+
+    e->m = rsp->payload_m;
+    rsp->payload_m = NULL;
+    memcpy(&e->endpoint, endpoint, oc_endpoint_size(endpoint));
+    e->target = t;
+    e->etag = coap_block2_etag++;
+    e->content_format = rsp->content_format;
+    e->code = rsp->code;
+    coap_block2_touch(e);
+
+    return e;
+}
+
+/*
+ * Sets the response's payload to a copy of one block of the cached
+ * representation.
+ */
+static int
+coap_block2_copy(struct coap_block2_entry *e, coap_packet_t *rsp,
+                 uint32_t num, uint16_t size)
+{
+    struct os_mbuf *m;
+    uint32_t off;
+    uint16_t len;
+    int more;
+
+    off = num * size;
+    len = MIN(OS_MBUF_PKTLEN(e->m) - off, size);
+    more = OS_MBUF_PKTLEN(e->m) - off > size;
+
+    m = os_msys_get_pkthdr(len, 0);
+    if (!m) {
+        return -1;
+    }
+    if (os_mbuf_appendfrom(m, e->m, off, len)) {
+        os_mbuf_free_chain(m);
+        return -1;
+    }
+    rsp->payload_m = m;
+    rsp->payload_len = len;
+    coap_set_header_block2(rsp, num, more, size);
+    coap_set_header_etag(rsp, (uint8_t *)&e->etag, sizeof(e->etag));
+
+    if (more) {
+        coap_block2_touch(e);
+    } else {
+        coap_block2_drop(e);
+        coap_block2_timer_reset();
+    }
+    return 0;
+}
+#endif /* COAP_BLOCK2_CACHE_ENTRIES > 0 */
+
+int
+coap_block2_cache_get(struct coap_packet_rx *req, coap_packet_t *rsp,
+                      oc_endpoint_t *endpoint, int32_t *offset)
+{
+#if COAP_BLOCK2_CACHE_ENTRIES > 0
+    struct coap_block2_target t;
+    struct coap_block2_entry *e;
+    uint32_t num;
+    uint32_t off;
+    uint16_t size;
+
+    if (req->code != COAP_GET ||
+        !coap_get_header_block2(req, NULL, NULL, &size, &off) || !off) {
+        return 0;
+    }
+    size = MIN(size, COAP_MAX_BLOCK_SIZE);
+    num = off / size;
+    off = num * size;
+
+    coap_block2_target(req, &t);
+    e = coap_block2_find(endpoint, &t);
+    if (!e || off >= OS_MBUF_PKTLEN(e->m)) {
+        return 0;
+    }
+    OC_LOG_DEBUG("coap_block2: block %u from cache\n", (unsigned)num);
+    rsp->code = e->code;
+    coap_set_header_content_format(rsp, e->content_format);
+    if (coap_block2_copy(e, rsp, num, size)) {
+        return 0;
+    }
+    *offset = rsp->block2_more ? off + rsp->payload_len : -1;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void
+coap_block2_cache_drop(oc_resource_t *resource)
+{
+#if COAP_BLOCK2_CACHE_ENTRIES > 0
+    struct coap_block2_entry *e;
+    const char *path;
+    int path_len;
+    int i;
+
+    /* Requests carry the URI without the leading '/'. */
+    path = oc_string(resource->uri) + 1;
+    path_len = oc_string_len(resource->uri) - 1;
+    for (i = 0; i < COAP_BLOCK2_CACHE_ENTRIES; i++) {
+        e = &coap_block2_cache[i];
+        if (e->m && e->target.path_len == min(path_len, COAP_MAX_URI) &&
+            !memcmp(e->target.path, path, e->target.path_len)) {
+            coap_block2_drop(e);
+        }
+    }
+    coap_block2_timer_reset();
+#endif
+}
+
+int
+coap_block2_respond(struct coap_packet_rx *req, coap_packet_t *rsp,
+                    oc_endpoint_t *endpoint, uint32_t num, uint16_t size)
+{
+    uint32_t off;
+    uint16_t len;
+
+    off = num * size;
+    len = rsp->payload_len;
+    if (off >= len) {
+        os_mbuf_free_chain(rsp->payload_m);
+        rsp->payload_m = NULL;
+        rsp->payload_len = 0;
+        return 1;
+    }
+
+#if COAP_BLOCK2_CACHE_ENTRIES > 0
+    if (req->code == COAP_GET && rsp->code < BAD_REQUEST_4_00 &&
+        len - off > size) {
+        return coap_block2_copy(coap_block2_store(req, rsp, endpoint), rsp,
+                                num, size);
+    }
+#endif
+
+    /* Trim to the block; the tail is cut when the response is serialized. */
+    os_mbuf_adj(rsp->payload_m, off);
+    rsp->payload_len = MIN(len - off, size);
+    coap_set_header_block2(rsp, num, len - off > size, size);
+    return 0;
+}
+
+void
+coap_block2_init(void)
+{
+#if COAP_BLOCK2_CACHE_ENTRIES > 0
+    os_callout_init(&coap_block2_timer, oc_evq_get(), coap_block2_expire,
+                    NULL);
+    coap_block2_etag = oc_random_rand();
+#endif
+}
@@ -366,12 +366,14 @@ coap_serialize_message(coap_packet_t *pkt, struct os_mbuf *m)
     /* Serialize options */
     current_number = 0;
 
-#if 0
     /* The options must be serialized in the order of their number */
+#if 0
     COAP_SERIALIZE_BYTE_OPT(pkt, m, COAP_OPTION_IF_MATCH, if_match, "If-Match");
     COAP_SERIALIZE_STRING_OPT(pkt, m, COAP_OPTION_URI_HOST, uri_host, '\0',
                                  "Uri-Host");
+#endif
     COAP_SERIALIZE_BYTE_OPT(pkt, m, COAP_OPTION_ETAG, etag, "ETag");
+#if 0
     COAP_SERIALIZE_INT_OPT(pkt, m, COAP_OPTION_IF_NONE_MATCH,
         content_format - pkt-> content_format /* hack to get a zero field */,
                            "If-None-Match");
@@ -493,6 +495,28 @@ err_mem:
     return -1;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Like coap_serialize_message(), but the payload is copied from 'payload'
+ * rather than taken over.  The caller keeps the payload, and can serialize
+ * it into any number of messages; it is encoded only once.
+ */
+int
+coap_serialize_message_copy(coap_packet_t *pkt, struct os_mbuf *m,
+                            const struct os_mbuf *payload, uint16_t len)
+{
+    assert(pkt->payload_m == NULL);
+
+    pkt->payload_len = len;
+    if (coap_serialize_message(pkt, m)) {
+        return -1;
+    }
+    if (len && os_mbuf_appendfrom(m, payload, 0, len)) {
+        STATS_INC(coap_stats, oerr);
+        return -1;
+    }
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_send_message(struct os_mbuf *m, int dup)
 {
@@ -1001,6 +1025,7 @@ coap_get_header_etag(struct coap_packet_rx *pkt, const uint8_t **etag)
     *etag = pkt->etag;
     return pkt->etag_len;
 }
+#endif
 
 int
 coap_set_header_etag(coap_packet_t *pkt, const uint8_t *etag,
@@ -1013,6 +1038,7 @@ coap_set_header_etag(coap_packet_t *pkt, const uint8_t *etag,
     return pkt->etag_len;
 }
 /*---------------------------------------------------------------------------*/
+#if 0
 /*FIXME support multiple ETags */
 
 int
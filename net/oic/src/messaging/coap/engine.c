@@ -61,6 +61,7 @@ coap_receive(struct os_mbuf **mp)
     static coap_transaction_t *transaction = NULL;
     struct os_mbuf *rsp;
     struct oc_endpoint endpoint; /* XXX */
+    int rc;
 
     erbium_status_code = NO_ERROR;
 
@@ -148,6 +149,7 @@ coap_receive(struct os_mbuf **mp)
                          (unsigned int) block_num, block_size,
                          COAP_MAX_BLOCK_SIZE, (unsigned int) block_offset);
             block_size = MIN(block_size, COAP_MAX_BLOCK_SIZE);
+            block_num = block_offset / block_size;
             new_offset = block_offset;
         }
 
@@ -178,7 +180,12 @@ coap_receive(struct os_mbuf **mp)
                     if (new_offset == block_offset) {
                         OC_LOG_DEBUG(" Block: unaware resource %u/%u\n",
                                      response->payload_len, block_size);
-                        if (block_offset >= response->payload_len) {
+                        rc = coap_block2_respond(message, response, &endpoint,
+                                                 block_num, block_size);
+                        if (rc < 0) {
+                            erbium_status_code = SERVICE_UNAVAILABLE_5_03;
+                            coap_error_message = "NoFreeBlockBuffer";
+                        } else if (rc > 0) {
                             response->code = BAD_OPTION_4_02;
                             rsp = os_msys_get_pkthdr(0, 0);
                             if (rsp) {
@@ -188,13 +195,6 @@ coap_receive(struct os_mbuf **mp)
                             }
                             /* a const char str[] and sizeof(str)
                                produces larger code size */
-                        } else {
-                            coap_set_header_block2(response, block_num,
-                                         response->payload_len - block_offset >
-                                           block_size, block_size);
-                            response->payload_len = MIN(response->payload_len -
-                                                        block_offset,
-                                                        block_size);
                         } /* if(valid offset) */
 
                         /* resource provides chunk-wise data */
@@ -248,7 +248,7 @@ coap_receive(struct os_mbuf **mp)
 
         /* Open transaction now cleared for ACK since mid matches */
         if ((transaction = coap_get_transaction_by_mid(message->mid))) {
-            coap_clear_transaction(transaction);
+            coap_ack_transaction(transaction);
         }
         /* if(ACKed transaction) */
         transaction = NULL;
@@ -316,6 +316,7 @@ coap_engine_init(void)
 {
     coap_init_connection();
     coap_transaction_init();
+    coap_block2_init();
 #ifdef OC_SERVER
 #if MYNEWT_VAL(OC_SEPARATE_RESPONSES)
     coap_separate_init();
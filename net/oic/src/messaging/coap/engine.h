@@ -35,6 +35,7 @@
 #define ENGINE_H
 
 #include "oic/messaging/coap/coap.h"
+#include "oic/messaging/coap/block.h"
 #include "oic/messaging/coap/observe.h"
 #include "oic/messaging/coap/separate.h"
 #include "oic/messaging/coap/transactions.h"
@@ -31,6 +31,7 @@
  * This file is part of the Contiki operating system.
  */
 
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -44,11 +45,22 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_ri.h"
+#include "api/oc_priv.h"
 
 /*-------------------*/
 uint64_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
-static SLIST_HEAD(, coap_observer) oc_observers;
+/*
+ * Observers are hashed by client endpoint, for the lookups done on requests
+ * and errors from that client.  Each is also on its resource's list of
+ * observers, which is what notifications walk.
+ */
+#define COAP_OBSERVER_BUCKETS MYNEWT_VAL(OC_OBSERVER_BUCKETS)
+#if (COAP_OBSERVER_BUCKETS & (COAP_OBSERVER_BUCKETS - 1)) != 0
+#error "OC_OBSERVER_BUCKETS must be a power of two"
+#endif
+static LIST_HEAD(coap_observer_bucket, coap_observer)
+    oc_observers[COAP_OBSERVER_BUCKETS];
 
 static struct os_mempool coap_observer_pool;
 static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
@@ -57,6 +69,21 @@ static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+static struct coap_observer_bucket *
+coap_observer_bucket(oc_endpoint_t *endpoint)
+{
+    uint32_t h;
+
+    h = oc_hash(endpoint, oc_endpoint_size(endpoint));
+    return &oc_observers[h & (COAP_OBSERVER_BUCKETS - 1)];
+}
+
+static int
+coap_observer_ep_match(coap_observer_t *obs, oc_endpoint_t *endpoint)
+{
+    return memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0;
+}
+
 static int
 add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
              const uint8_t *token, size_t token_len, const char *uri,
@@ -84,7 +111,8 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
         OC_LOG_DEBUG("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
           coap_observer_pool.mp_num_blocks - coap_observer_pool.mp_num_free,
           coap_observer_pool.mp_num_blocks, o->url, o->token[0], o->token[1]);
-        SLIST_INSERT_HEAD(&oc_observers, o, next);
+        LIST_INSERT_HEAD(coap_observer_bucket(endpoint), o, next);
+        LIST_INSERT_HEAD(&resource->observers, o, res_next);
         return dup;
     }
     return -1;
@@ -97,7 +125,9 @@ coap_remove_observer(coap_observer_t *o)
 {
     OC_LOG_DEBUG("Removing observer for /%s [0x%02X%02X]\n",
                  o->url, o->token[0], o->token[1]);
-    SLIST_REMOVE(&oc_observers, o, coap_observer, next);
+    LIST_REMOVE(o, next);
+    LIST_REMOVE(o, res_next);
+    o->resource->num_observers--;
     os_memblock_put(&coap_observer_pool, o);
 }
 /*---------------------------------------------------------------------------*/
@@ -107,11 +137,10 @@ coap_remove_observer_by_client(oc_endpoint_t *endpoint)
     int removed = 0;
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = LIST_FIRST(coap_observer_bucket(endpoint));
     while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0) {
-            obs->resource->num_observers--;
+        next = LIST_NEXT(obs, next);
+        if (coap_observer_ep_match(obs, endpoint)) {
             coap_remove_observer(obs);
             removed++;
         }
@@ -124,23 +153,17 @@ int
 coap_remove_observer_by_token(oc_endpoint_t *endpoint, uint8_t *token,
                               size_t token_len)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
+    LIST_FOREACH(obs, coap_observer_bucket(endpoint), next) {
+        if (coap_observer_ep_match(obs, endpoint) &&
           obs->token_len == token_len &&
           memcmp(obs->token, token, token_len) == 0) {
-            obs->resource->num_observers--;
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
     }
-    return removed;
+    return 0;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -149,13 +172,11 @@ coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
     int removed = 0;
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = LIST_FIRST(coap_observer_bucket(endpoint));
     while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (((memcmp(&obs->endpoint, endpoint,
-                     oc_endpoint_size(endpoint)) == 0)) &&
+        next = LIST_NEXT(obs, next);
+        if (coap_observer_ep_match(obs, endpoint) &&
           (obs->url == uri || memcmp(obs->url, uri, strlen(obs->url)) == 0)) {
-            obs->resource->num_observers--;
             coap_remove_observer(obs);
             removed++;
         }
@@ -167,20 +188,26 @@ coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
 int
 coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
-        if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
-          obs->last_mid == mid) {
-            obs->resource->num_observers--;
+    LIST_FOREACH(obs, coap_observer_bucket(endpoint), next) {
+        if (coap_observer_ep_match(obs, endpoint) && obs->last_mid == mid) {
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
+    }
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_remove_observer_by_resource(oc_resource_t *resource)
+{
+    int removed = 0;
+    coap_observer_t *obs;
+
+    while ((obs = LIST_FIRST(&resource->observers)) != NULL) {
+        coap_remove_observer(obs);
+        removed++;
     }
     return removed;
 }
@@ -190,21 +217,32 @@ coap_observer_walk(int (*walk_func)(struct coap_observer *, void *), void *arg)
 {
     struct coap_observer *obs, *next;
     int rc;
+    int i;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
-        rc = walk_func(obs, arg);
-        if (rc) {
-            break;
+    for (i = 0; i < COAP_OBSERVER_BUCKETS; i++) {
+        obs = LIST_FIRST(&oc_observers[i]);
+        while (obs) {
+            next = LIST_NEXT(obs, next);
+            rc = walk_func(obs, arg);
+            if (rc) {
+                return;
+            }
+            obs = next;
         }
-        obs = next;
     }
 }
 
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*
+ * Notifies the observers of a resource, or the observers registered by a
+ * client endpoint, or those matching both.  At least one of the two must be
+ * given.
+ *
+ * The payload is 'response_buf' if given; otherwise, the resource's GET
+ * handler is run once, and its response goes out to all the observers.
+ */
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
@@ -212,6 +250,7 @@ coap_notify_observers(oc_resource_t *resource,
 {
     int num_observers = 0;
     coap_observer_t *obs = NULL;
+    coap_observer_t *next;
     oc_request_t request = {};
     oc_response_t response = {};
     oc_response_buffer_t response_buffer;
@@ -229,24 +268,37 @@ coap_notify_observers(oc_resource_t *resource,
         }
         response_buffer.block_offset = NULL;
         response.response_buffer = &response_buffer;
+        response.separate_response = 0;
         request.resource = resource;
         request.response = &response;
     }
 
-    /* iterate over observers */
-    for (obs = SLIST_FIRST(&oc_observers); obs; obs = SLIST_NEXT(obs, next)) {
-        /* skip if neither resource nor endpoint match */
-        if ((resource && resource != obs->resource) ||
-            (endpoint && memcmp(&obs->endpoint, endpoint,
-                                oc_endpoint_size(endpoint)) != 0)) {
+    /* iterate over the resource's observers, or the endpoint's */
+    if (resource) {
+        obs = LIST_FIRST(&resource->observers);
+    } else {
+        assert(endpoint);
+        obs = LIST_FIRST(coap_observer_bucket(endpoint));
+    }
+    for (; obs; obs = next) {
+        if (resource) {
+            next = LIST_NEXT(obs, res_next);
+        } else {
+            next = LIST_NEXT(obs, next);
+        }
+        /* skip if endpoint doesn't match */
+        if (endpoint && !coap_observer_ep_match(obs, endpoint)) {
             continue;
         }
 
-        response.separate_response = 0;
         num_observers = obs->resource->num_observers;
         if (!response_buf && resource) {
             OC_LOG_DEBUG("coap_notify_observers: GET request to resource\n");
-            /* performing GET on the resource */
+            /*
+             * Performing GET on the resource.  The representation is
+             * encoded only once, and copied into each observer's
+             * notification.
+             */
             m = os_msys_get_pkthdr(0, 0);
             if (!m) {
                 return num_observers;
@@ -303,8 +355,6 @@ coap_notify_observers(oc_resource_t *resource,
                                  "notification to check for client liveness\n");
                     notification->type = COAP_TYPE_CON;
                 }
-                coap_set_payload(notification, response_buf->buffer,
-                                 OS_MBUF_PKTLEN(response_buf->buffer));
                 coap_set_status_code(notification, response_buf->code);
                 coap_set_header_content_format(notification, APPLICATION_CBOR);
                 if (notification->code < BAD_REQUEST_4_00 &&
@@ -316,20 +366,14 @@ coap_notify_observers(oc_resource_t *resource,
                 }
                 coap_set_token(notification, obs->token, obs->token_len);
 
-                if (!coap_serialize_message(notification, transaction->m)) {
+                if (!coap_serialize_message_copy(notification, transaction->m,
+                      response_buf->buffer,
+                      OS_MBUF_PKTLEN(response_buf->buffer))) {
                     transaction->type = notification->type;
                     coap_send_transaction(transaction);
                 } else {
                     coap_clear_transaction(transaction);
                 }
-                if (response_buf == &response_buffer) {
-                    /*
-                     * We allocated mbuf, and it's still valid.
-                     */
-                    os_mbuf_free_chain(m);
-                    m = NULL;
-                    response_buf = NULL;
-                }
             } else if (response_buf) {
                 /*
                  * Failed to alloc transaction.
@@ -376,6 +420,11 @@ coap_observe_handler(struct coap_packet_rx *coap_req, coap_packet_t *coap_res,
 void
 coap_observe_init(void)
 {
+    int i;
+
+    for (i = 0; i < COAP_OBSERVER_BUCKETS; i++) {
+        LIST_INIT(&oc_observers[i]);
+    }
     os_mempool_init(&coap_observer_pool, COAP_MAX_OBSERVERS,
       sizeof(coap_observer_t), coap_observer_area, "coap_obs");
 }
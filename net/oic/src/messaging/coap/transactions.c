@@ -51,18 +51,199 @@
 
 #include "port/mynewt/adaptor.h"
 
+#define COAP_TRANSACTION_BUCKETS MYNEWT_VAL(OC_COAP_TRANSACTION_BUCKETS)
+#if (COAP_TRANSACTION_BUCKETS & (COAP_TRANSACTION_BUCKETS - 1)) != 0
+#error "OC_COAP_TRANSACTION_BUCKETS must be a power of two"
+#endif
+
+#define COAP_NSTART             MYNEWT_VAL(OC_COAP_NSTART)
+#define COAP_PEERS              MYNEWT_VAL(OC_COAP_PEERS)
+
+/*
+ * Retransmission timeouts, in ms.  The timeout for a peer starts at the
+ * configured response timeout, and follows round-trip times as measured
+ * (CoCoA, draft-ietf-core-cocoa).
+ */
+#define COAP_RTO_INIT           (COAP_RESPONSE_TIMEOUT * 1000)
+#define COAP_RTO_MIN            MYNEWT_VAL(OC_COAP_RTO_MIN)
+#define COAP_RTO_MAX            60000
+
+/* round-trip time estimators */
+#define COAP_RTT_STRONG         0   /* from exchanges without retransmission */
+#define COAP_RTT_WEAK           1   /* with one or two retransmissions */
+
+/*
+ * Congestion control state for one destination.
+ */
+struct coap_peer {
+    oc_endpoint_t endpoint;
+    uint8_t in_use;
+    uint8_t outstanding;        /* CON messages not acknowledged yet */
+    STAILQ_HEAD(, coap_transaction) waiting;
+    os_time_t last_used;
+    os_time_t rto_updated;
+    uint32_t rto;
+    uint32_t srtt[2];           /* 0 until the first sample */
+    uint32_t rttvar[2];
+};
+
+STATS_SECT_START(coap_trans_stats)
+    STATS_SECT_ENTRY(con)
+    STATS_SECT_ENTRY(retrans)
+    STATS_SECT_ENTRY(acked)
+    STATS_SECT_ENTRY(timeout)
+    STATS_SECT_ENTRY(waited)
+    STATS_SECT_ENTRY(nomem)
+STATS_SECT_END
+
+static STATS_SECT_DECL(coap_trans_stats) coap_trans_stats;
+STATS_NAME_START(coap_trans_stats)
+    STATS_NAME(coap_trans_stats, con)
+    STATS_NAME(coap_trans_stats, retrans)
+    STATS_NAME(coap_trans_stats, acked)
+    STATS_NAME(coap_trans_stats, timeout)
+    STATS_NAME(coap_trans_stats, waited)
+    STATS_NAME(coap_trans_stats, nomem)
+STATS_NAME_END(coap_trans_stats)
+
 static struct os_mempool oc_transaction_memb;
 static uint8_t oc_transaction_area[OS_MEMPOOL_BYTES(COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t))];
-static SLIST_HEAD(, coap_transaction) oc_transaction_list;
+static LIST_HEAD(coap_transaction_bucket, coap_transaction)
+    oc_transactions[COAP_TRANSACTION_BUCKETS];
+static struct coap_peer coap_peers[COAP_PEERS];
 
 static void coap_transaction_retrans(struct os_event *ev);
 
+static struct coap_transaction_bucket *
+coap_transaction_bucket(uint16_t mid)
+{
+    return &oc_transactions[mid & (COAP_TRANSACTION_BUCKETS - 1)];
+}
+
+/*---------------------------------------------------------------------------*/
+/*- Peers -------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the state for a destination, taking over the least recently used
+ * idle entry if it is new.  Returns NULL if all the entries are busy.
+ */
+static struct coap_peer *
+coap_peer_get(oc_endpoint_t *endpoint)
+{
+    struct coap_peer *peer;
+    struct coap_peer *idle;
+    int i;
+
+    idle = NULL;
+    for (i = 0; i < COAP_PEERS; i++) {
+        peer = &coap_peers[i];
+        if (!peer->in_use) {
+            if (!idle || idle->in_use) {
+                idle = peer;
+            }
+            continue;
+        }
+        if (!memcmp(&peer->endpoint, endpoint, oc_endpoint_size(endpoint))) {
+            peer->last_used = os_time_get();
+            return peer;
+        }
+        if (!peer->outstanding && (!idle || (idle->in_use &&
+              OS_TIME_TICK_LT(peer->last_used, idle->last_used)))) {
+            idle = peer;
+        }
+    }
+    if (!idle) {
+        return NULL;
+    }
+
+    peer = idle;
+    memset(peer, 0, sizeof(*peer));
+    memcpy(&peer->endpoint, endpoint, oc_endpoint_size(endpoint));
+    peer->in_use = 1;
+    STAILQ_INIT(&peer->waiting);
+    peer->rto = COAP_RTO_INIT;
+    peer->last_used = peer->rto_updated = os_time_get();
+    return peer;
+}
+
+/*
+ * Current retransmission timeout.  A timeout which has not been updated
+ * for a while moves back towards the initial one.
+ */
+static uint32_t
+coap_peer_rto(struct coap_peer *peer)
+{
+    uint32_t idle;
+
+    if (!peer) {
+        return COAP_RTO_INIT;
+    }
+    idle = os_time_ticks_to_ms32(os_time_get() - peer->rto_updated);
+    if (peer->rto < 1000 && idle > 16 * peer->rto) {
+        peer->rto *= 2;
+        peer->rto_updated = os_time_get();
+    } else if (peer->rto > 3000 && idle > 4 * peer->rto) {
+        peer->rto = (COAP_RTO_INIT + peer->rto) / 2;
+        peer->rto_updated = os_time_get();
+    }
+    return peer->rto;
+}
+
+/*
+ * Feeds a round-trip time sample to one of the estimators (RFC 6298), and
+ * moves the overall timeout towards the estimate.
+ */
+static void
+coap_peer_rtt(struct coap_peer *peer, int est, uint32_t rtt)
+{
+    uint32_t diff;
+    uint32_t rto;
+
+    if (!peer->srtt[est]) {
+        peer->srtt[est] = rtt ? rtt : 1;
+        peer->rttvar[est] = rtt / 2;
+    } else {
+        diff = peer->srtt[est] > rtt ? peer->srtt[est] - rtt :
+                                       rtt - peer->srtt[est];
+        peer->rttvar[est] = (3 * peer->rttvar[est] + diff) / 4;
+        peer->srtt[est] = (7 * peer->srtt[est] + rtt) / 8;
+        if (!peer->srtt[est]) {
+            peer->srtt[est] = 1;
+        }
+    }
+
+    if (est == COAP_RTT_STRONG) {
+        rto = peer->srtt[est] + 4 * peer->rttvar[est];
+        peer->rto = (rto + peer->rto) / 2;
+    } else {
+        rto = peer->srtt[est] + peer->rttvar[est];
+        peer->rto = (rto + 3 * peer->rto) / 4;
+    }
+    if (peer->rto < COAP_RTO_MIN) {
+        peer->rto = COAP_RTO_MIN;
+    } else if (peer->rto > COAP_RTO_MAX) {
+        peer->rto = COAP_RTO_MAX;
+    }
+    peer->rto_updated = os_time_get();
+}
+
+/*---------------------------------------------------------------------------*/
 void
 coap_transaction_init(void)
 {
+    int i;
+
     os_mempool_init(&oc_transaction_memb, COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t), oc_transaction_area, "coap_tran");
+    for (i = 0; i < COAP_TRANSACTION_BUCKETS; i++) {
+        LIST_INIT(&oc_transactions[i]);
+    }
+    memset(coap_peers, 0, sizeof(coap_peers));
+
+    (void)stats_init_and_reg(STATS_HDR(coap_trans_stats),
+      STATS_SIZE_INIT_PARMS(coap_trans_stats, STATS_SIZE_32),
+      STATS_NAME_INIT_PARMS(coap_trans_stats), "coap_trans");
 }
 
 coap_transaction_t *
@@ -77,72 +258,74 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
         if (m) {
             t->mid = mid;
             t->retrans_counter = 0;
+            t->peer = NULL;
+            t->waiting = 0;
             t->m = m;
 
             os_callout_init(&t->retrans_timer, oc_evq_get(),
               coap_transaction_retrans, t);
-            /* list itself makes sure same element is not added twice */
-            SLIST_INSERT_HEAD(&oc_transaction_list, t, next);
+            LIST_INSERT_HEAD(coap_transaction_bucket(mid), t, next);
         } else {
             os_memblock_put(&oc_transaction_memb, t);
             t = NULL;
         }
     }
+    if (!t) {
+        STATS_INC(coap_trans_stats, nomem);
+    }
 
     return t;
 }
 
-/*---------------------------------------------------------------------------*/
-void
-coap_send_transaction(coap_transaction_t *t)
+/*
+ * First transmission of a confirmable message.  The retransmission timeout
+ * is randomized, and grows by a factor which depends on how long it is to
+ * begin with.
+ */
+static void
+coap_transaction_start(coap_transaction_t *t)
 {
-    bool confirmable = false;
-
-    confirmable = (COAP_TYPE_CON == t->type) ? true : false;
-
-    OC_LOG_DEBUG("Sending transaction %u\n", t->mid);
+    uint32_t rto;
 
-    if (confirmable) {
-        if (t->retrans_counter < COAP_MAX_RETRANSMIT) {
-            /* not timed out yet */
-            if (t->retrans_counter == 0) {
-                t->retrans_tmo =
-                  COAP_RESPONSE_TIMEOUT_TICKS +
-                  (oc_random_rand() %
-                    (oc_clock_time_t)COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
-                OC_LOG_DEBUG("Initial interval " OC_CLK_FMT "\n",
-                             t->retrans_tmo);
-            } else {
-                t->retrans_tmo <<= 1; /* double */
-                OC_LOG_DEBUG("Doubled " OC_CLK_FMT "\n", t->retrans_tmo);
-            }
-
-            os_callout_reset(&t->retrans_timer, t->retrans_tmo);
+    rto = coap_peer_rto(t->peer);
+    if (rto < 1000) {
+        t->backoff = 6;
+    } else if (rto > 3000) {
+        t->backoff = 3;
+    } else {
+        t->backoff = 4;
+    }
+    rto = os_time_ms_to_ticks32(rto);
+    t->retrans_tmo = rto + oc_random_rand() %
+      ((uint32_t)(rto * (COAP_RESPONSE_RANDOM_FACTOR - 1)) + 1);
+    OC_LOG_DEBUG("Initial interval " OC_CLK_FMT "\n", t->retrans_tmo);
 
-            coap_send_message(t->m, 1);
+    t->first_tx = os_time_get();
+    os_callout_reset(&t->retrans_timer, t->retrans_tmo);
+    STATS_INC(coap_trans_stats, con);
 
-            t = NULL;
-        } else {
-            /* timed out */
-            OC_LOG_DEBUG("Timeout\n");
+    coap_send_message(t->m, 1);
+}
 
-#ifdef OC_SERVER
-            /* handle observers */
-            coap_remove_observer_by_client(OC_MBUF_ENDPOINT(t->m));
-#endif /* OC_SERVER */
+/*---------------------------------------------------------------------------*/
+void
+coap_send_transaction(coap_transaction_t *t)
+{
+    OC_LOG_DEBUG("Sending transaction %u\n", t->mid);
 
-#ifdef OC_SECURITY
-            if (OC_MBUF_ENDPOINT(t->m)->flags & SECURED) {
-                oc_sec_dtls_close_init(OC_MBUF_ENDPOINT(t->m));
+    if (COAP_TYPE_CON == t->type) {
+        t->peer = coap_peer_get(OC_MBUF_ENDPOINT(t->m));
+        if (t->peer) {
+            if (t->peer->outstanding >= COAP_NSTART) {
+                OC_LOG_DEBUG("NSTART reached, queueing %u\n", t->mid);
+                t->waiting = 1;
+                STAILQ_INSERT_TAIL(&t->peer->waiting, t, wait_next);
+                STATS_INC(coap_trans_stats, waited);
+                return;
             }
-#endif /* OC_SECURITY */
-
-#ifdef OC_CLIENT
-            oc_ri_remove_client_cb_by_mid(t->mid);
-#endif /* OC_CLIENT */
-
-            coap_clear_transaction(t);
+            t->peer->outstanding++;
         }
+        coap_transaction_start(t);
     } else {
         coap_send_message(t->m, 0);
         t->m = NULL;
@@ -154,23 +337,54 @@ coap_send_transaction(coap_transaction_t *t)
 void
 coap_clear_transaction(coap_transaction_t *t)
 {
-    struct coap_transaction *tmp;
+    struct coap_peer *peer;
 
     if (t) {
         os_callout_stop(&t->retrans_timer);
         os_mbuf_free_chain(t->m);
+        LIST_REMOVE(t, next);
 
-        /*
-         * Transaction might not be in the list yet.
-         */
-        SLIST_FOREACH(tmp, &oc_transaction_list, next) {
-            if (t == tmp) {
-                SLIST_REMOVE(&oc_transaction_list, t, coap_transaction, next);
-                break;
+        peer = t->peer;
+        if (peer) {
+            if (t->waiting) {
+                STAILQ_REMOVE(&peer->waiting, t, coap_transaction, wait_next);
+            } else {
+                peer->outstanding--;
             }
         }
         os_memblock_put(&oc_transaction_memb, t);
-  }
+
+        /* Let the next message waiting for this peer go. */
+        if (peer && !STAILQ_EMPTY(&peer->waiting) &&
+            peer->outstanding < COAP_NSTART) {
+            t = STAILQ_FIRST(&peer->waiting);
+            STAILQ_REMOVE_HEAD(&peer->waiting, wait_next);
+            t->waiting = 0;
+            peer->outstanding++;
+            coap_transaction_start(t);
+        }
+    }
+}
+
+/*
+ * An ACK or RST for the transaction arrived.
+ */
+void
+coap_ack_transaction(coap_transaction_t *t)
+{
+    uint32_t rtt;
+
+    if (t->type == COAP_TYPE_CON && !t->waiting) {
+        STATS_INC(coap_trans_stats, acked);
+        if (t->peer && t->retrans_counter <= 2) {
+            rtt = os_time_ticks_to_ms32(os_time_get() - t->first_tx);
+            coap_peer_rtt(t->peer, t->retrans_counter ?
+                          COAP_RTT_WEAK : COAP_RTT_STRONG, rtt);
+            OC_LOG_DEBUG("RTT %lu ms, RTO %lu ms\n", (unsigned long)rtt,
+                         (unsigned long)t->peer->rto);
+        }
+    }
+    coap_clear_transaction(t);
 }
 
 coap_transaction_t *
@@ -178,7 +392,7 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
     coap_transaction_t *t;
 
-    SLIST_FOREACH(t, &oc_transaction_list, next) {
+    LIST_FOREACH(t, coap_transaction_bucket(mid), next) {
         if (t->mid == mid) {
             return t;
         }
@@ -190,8 +404,37 @@ static void
 coap_transaction_retrans(struct os_event *ev)
 {
     coap_transaction_t *t = ev->ev_arg;
+
     ++(t->retrans_counter);
-    OC_LOG_DEBUG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
-    coap_send_transaction(t);
-}
+    if (t->retrans_counter < COAP_MAX_RETRANSMIT) {
+        t->retrans_tmo = t->retrans_tmo * t->backoff / 2;
+        OC_LOG_DEBUG("Retransmitting %u (%u), next in " OC_CLK_FMT "\n",
+                     t->mid, t->retrans_counter, t->retrans_tmo);
+        os_callout_reset(&t->retrans_timer, t->retrans_tmo);
+        STATS_INC(coap_trans_stats, retrans);
 
+        coap_send_message(t->m, 1);
+        return;
+    }
+
+    /* timed out */
+    OC_LOG_DEBUG("Timeout\n");
+    STATS_INC(coap_trans_stats, timeout);
+
+#ifdef OC_SERVER
+    /* handle observers */
+    coap_remove_observer_by_client(OC_MBUF_ENDPOINT(t->m));
+#endif /* OC_SERVER */
+
+#ifdef OC_SECURITY
+    if (OC_MBUF_ENDPOINT(t->m)->flags & SECURED) {
+        oc_sec_dtls_close_init(OC_MBUF_ENDPOINT(t->m));
+    }
+#endif /* OC_SECURITY */
+
+#ifdef OC_CLIENT
+    oc_ri_remove_client_cb_by_mid(t->mid);
+#endif /* OC_CLIENT */
+
+    coap_clear_transaction(t);
+}
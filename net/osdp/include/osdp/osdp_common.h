@@ -10,6 +10,8 @@
 #include <os/os_mempool.h>
 #include <os/os_mutex.h>
 
+#include "tinycrypt/aes.h"
+
 #include "osdp/osdp.h"
 #include "osdp/osdp_utils.h"
 
@@ -249,6 +251,12 @@ struct osdp_secure_channel {
     uint8_t pd_client_uid[8];
     uint8_t cp_cryptogram[16];
     uint8_t pd_cryptogram[16];
+#if MYNEWT_VAL(OSDP_SC_KEY_SCHED_CACHE)
+    /* s_enc, s_mac1 and s_mac2, expanded when the session keys are made */
+    struct tc_aes_key_sched_struct s_enc_sched;
+    struct tc_aes_key_sched_struct s_mac1_sched;
+    struct tc_aes_key_sched_struct s_mac2_sched;
+#endif
 };
 
 #if MYNEWT_VAL(OSDP_MODE_PD)
@@ -297,6 +305,7 @@ struct osdp_pd {
 
     int64_t tstamp;
     int64_t sc_tstamp;
+    int64_t activity_tstamp; /* last card read or key press */
     uint8_t rx_buf[MYNEWT_VAL(OSDP_UART_RX_BUFFER_LENGTH)];
     int rx_buf_len;
     int64_t phy_tstamp;
@@ -323,6 +332,9 @@ struct osdp_cp {
     struct osdp_pd *current_pd; /* current operational pd's pointer */
     int pd_offset;          /* current pd's offset into ctx->pd */
     int *channel_lock;
+    int rr_offset;          /* where the next round-robin scan starts */
+    int boost_offset;       /* same, among PDs that may go out of turn */
+    int boosted;            /* last PD on the channel went ahead of its turn */
     void *event_callback_arg;
     cp_event_callback_t event_callback;
 };
@@ -378,6 +390,10 @@ int64_t osdp_millis_since(int64_t last);
 uint16_t osdp_compute_crc16(const uint8_t *buf, size_t len);
 __attribute__((weak)) void osdp_encrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len);
 __attribute__((weak)) void osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len);
+__attribute__((weak)) void osdp_encrypt_sched(const struct tc_aes_key_sched_struct *s,
+                                              uint8_t *iv, uint8_t *data, int len);
+__attribute__((weak)) void osdp_decrypt_sched(const struct tc_aes_key_sched_struct *s,
+                                              uint8_t *iv, uint8_t *data, int len);
 __attribute__((weak)) void osdp_get_rand(uint8_t *buf, int len);
 int osdp_device_lock(struct os_mutex *lock);
 void osdp_device_unlock(struct os_mutex *lock);
@@ -0,0 +1,348 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "osdp_test.h"
+
+/* RS-485 at 9600 baud, 10 bits a byte, and the PD's turnaround time. */
+#define OSDP_TEST_BAUD          9600
+#define OSDP_TEST_WIRE_MS(len)  \
+    (((len) * 10 * 1000 + OSDP_TEST_BAUD - 1) / OSDP_TEST_BAUD)
+#define OSDP_TEST_TURNAROUND_MS 3
+
+#define OSDP_TEST_BUF_LEN       MYNEWT_VAL(OSDP_UART_RX_BUFFER_LENGTH)
+
+int64_t osdp_test_now;
+struct osdp_test_pd osdp_test_pds[OSDP_TEST_NUM_PD];
+struct osdp_test_lat osdp_test_led_lat;
+int64_t osdp_test_bus_ms;
+
+/* The reply on its way to the CP. */
+static struct {
+    uint8_t buf[OSDP_TEST_BUF_LEN];
+    int len;
+    int64_t at;
+} osdp_test_bus;
+
+static uint32_t osdp_test_seed = 1;
+
+int64_t
+osdp_millis_now(void)
+{
+    return osdp_test_now;
+}
+
+void
+osdp_get_rand(uint8_t *buf, int len)
+{
+    osdp_test_fill(buf, len, osdp_test_seed++);
+}
+
+void
+osdp_test_fill(uint8_t *buf, int len, uint32_t seed)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+}
+
+void
+osdp_test_lat_add(struct osdp_test_lat *lat, int64_t ms)
+{
+    lat->count++;
+    lat->total += ms;
+    if (ms > lat->max) {
+        lat->max = ms;
+    }
+}
+
+static void
+osdp_test_pd_init(struct osdp_test_pd *tp, int address)
+{
+    struct osdp_pd *pd;
+
+    memset(tp, 0, sizeof(*tp));
+    tp->ctx.cp = &tp->cp;
+    tp->ctx.pd = &tp->pd;
+    tp->cp.__parent = &tp->ctx;
+    tp->cp.num_pd = 1;
+    tp->cp.current_pd = &tp->pd;
+
+    pd = &tp->pd;
+    pd->__parent = &tp->ctx;
+    pd->address = address;
+    pd->seq_number = -1;
+}
+
+void
+osdp_test_session(struct osdp_test_pd *tp, uint32_t seed)
+{
+    struct osdp_pd *pd;
+
+    osdp_test_pd_init(tp, 1);
+    pd = &tp->pd;
+    SET_FLAG(pd, PD_FLAG_SC_USE_SCBKD);
+    osdp_test_fill(pd->sc.cp_random, sizeof(pd->sc.cp_random), seed);
+    osdp_compute_session_keys(&tp->ctx);
+    osdp_test_fill(pd->sc.r_mac, sizeof(pd->sc.r_mac), seed + 1);
+    osdp_test_fill(pd->sc.c_mac, sizeof(pd->sc.c_mac), seed + 2);
+    SET_FLAG(pd, PD_FLAG_SC_ACTIVE);
+}
+
+/*
+ * Works out the reply to a command, as the PD state machine would.
+ */
+static int
+osdp_test_pd_command(struct osdp_test_pd *tp, const uint8_t *data, int len,
+                     uint8_t *reply)
+{
+    struct osdp_pd *pd;
+    int n;
+
+    pd = &tp->pd;
+    pd->cmd_id = data[0];
+    n = 0;
+
+    switch (pd->cmd_id) {
+    case CMD_POLL:
+        if (tp->card_at != 0) {
+            /* 26 bit Wiegand */
+            pd->reply_id = REPLY_RAW;
+            reply[n++] = 0;
+            reply[n++] = 0;
+            reply[n++] = 26;
+            reply[n++] = 0;
+            osdp_test_fill(reply + n, 4, pd->address);
+            n += 4;
+            tp->input_at = tp->card_at;
+            tp->card_at = 0;
+        } else if (tp->keys_left && tp->key_at <= osdp_test_now) {
+            pd->reply_id = REPLY_KEYPPAD;
+            reply[n++] = 0;
+            reply[n++] = 1;
+            reply[n++] = '0' + tp->keys_left;
+            tp->input_at = tp->key_at;
+            tp->key_at += OSDP_TEST_KEY_MS;
+            tp->keys_left--;
+        } else {
+            pd->reply_id = REPLY_ACK;
+        }
+        break;
+    case CMD_ID:
+        pd->reply_id = REPLY_PDID;
+        reply[n++] = BYTE_0(pd->id.vendor_code);
+        reply[n++] = BYTE_1(pd->id.vendor_code);
+        reply[n++] = BYTE_2(pd->id.vendor_code);
+        reply[n++] = pd->id.model;
+        reply[n++] = pd->id.version;
+        reply[n++] = BYTE_0(pd->id.serial_number);
+        reply[n++] = BYTE_1(pd->id.serial_number);
+        reply[n++] = BYTE_2(pd->id.serial_number);
+        reply[n++] = BYTE_3(pd->id.serial_number);
+        reply[n++] = BYTE_2(pd->id.firmware_version);
+        reply[n++] = BYTE_1(pd->id.firmware_version);
+        reply[n++] = BYTE_0(pd->id.firmware_version);
+        break;
+    case CMD_CAP:
+        pd->reply_id = REPLY_PDCAP;
+        reply[n++] = OSDP_PD_CAP_COMMUNICATION_SECURITY;
+        reply[n++] = 1;
+        reply[n++] = 0;
+        reply[n++] = OSDP_PD_CAP_READER_LED_CONTROL;
+        reply[n++] = 1;
+        reply[n++] = 1;
+        break;
+    case CMD_CHLNG:
+        TEST_ASSERT_FATAL(len == 9);
+        osdp_sc_init(pd);
+        CLEAR_FLAG(pd, PD_FLAG_SC_ACTIVE);
+        memcpy(pd->sc.cp_random, data + 1, 8);
+        osdp_get_rand(pd->sc.pd_random, 8);
+        osdp_compute_session_keys(&tp->ctx);
+        osdp_compute_pd_cryptogram(pd);
+        pd->reply_id = REPLY_CCRYPT;
+        memcpy(reply + n, pd->sc.pd_client_uid, 8);
+        n += 8;
+        memcpy(reply + n, pd->sc.pd_random, 8);
+        n += 8;
+        memcpy(reply + n, pd->sc.pd_cryptogram, 16);
+        n += 16;
+        break;
+    case CMD_SCRYPT:
+        TEST_ASSERT_FATAL(len == 17);
+        memcpy(pd->sc.cp_cryptogram, data + 1, 16);
+        TEST_ASSERT_FATAL(osdp_verify_cp_cryptogram(pd) == 0);
+        osdp_compute_rmac_i(pd);
+        pd->reply_id = REPLY_RMAC_I;
+        memcpy(reply + n, pd->sc.r_mac, 16);
+        n += 16;
+        break;
+    case CMD_LED:
+        osdp_test_lat_add(&osdp_test_led_lat,
+                          osdp_test_now - tp->led_queued_at);
+        tp->leds++;
+        /* The holder of the card now enters a PIN. */
+        tp->key_at = osdp_test_now + OSDP_TEST_KEY_MS;
+        tp->keys_left = OSDP_TEST_KEYS;
+        pd->reply_id = REPLY_ACK;
+        break;
+    default:
+        pd->reply_id = REPLY_ACK;
+        break;
+    }
+
+    return n;
+}
+
+static int
+osdp_test_pd_reply(struct osdp_test_pd *tp, const uint8_t *data, int len,
+                   uint8_t *buf)
+{
+    uint8_t reply[64];
+    struct osdp_pd *pd;
+    uint8_t *smb;
+    int off;
+    int n;
+
+    pd = &tp->pd;
+    n = osdp_test_pd_command(tp, data, len, reply);
+
+    off = osdp_phy_packet_init(pd, buf, OSDP_TEST_BUF_LEN);
+    TEST_ASSERT_FATAL(off > 0);
+    smb = osdp_phy_packet_get_smb(pd, buf);
+    buf[off] = pd->reply_id;
+    memcpy(buf + off + 1, reply, n);
+
+    if (pd->reply_id == REPLY_CCRYPT) {
+        smb[0] = 3;
+        smb[1] = SCS_12;
+        smb[2] = 1;
+    } else if (pd->reply_id == REPLY_RMAC_I) {
+        smb[0] = 3;
+        smb[1] = SCS_14;
+        smb[2] = 1;
+        SET_FLAG(pd, PD_FLAG_SC_ACTIVE);
+    } else if (smb && ISSET_FLAG(pd, PD_FLAG_SC_ACTIVE)) {
+        smb[0] = 2;
+        smb[1] = n ? SCS_18 : SCS_16;
+    }
+
+    return osdp_phy_packet_finalize(pd, buf, off + 1 + n, OSDP_TEST_BUF_LEN);
+}
+
+static int
+osdp_test_bus_send(void *arg, uint8_t *buf, int len)
+{
+    uint8_t cmd[OSDP_TEST_BUF_LEN];
+    struct osdp_test_pd *tp;
+    uint8_t *data;
+    int pkt_len;
+    int addr;
+    int rc;
+
+    memcpy(cmd, buf, len);
+    addr = cmd[cmd[0] == 0xff ? 2 : 1] & 0x7f;
+    TEST_ASSERT_FATAL(addr >= 1 && addr <= OSDP_TEST_NUM_PD);
+    tp = &osdp_test_pds[addr - 1];
+
+    rc = osdp_phy_check_packet(&tp->pd, cmd, len, &pkt_len);
+    TEST_ASSERT_FATAL(rc == OSDP_ERR_PKT_NONE, "PD %d: check %d", addr, rc);
+    rc = osdp_phy_decode_packet(&tp->pd, cmd, pkt_len, &data);
+    TEST_ASSERT_FATAL(rc > 0, "PD %d: decode %d", addr, rc);
+
+    osdp_test_bus.len = osdp_test_pd_reply(tp, data, rc, osdp_test_bus.buf);
+    TEST_ASSERT_FATAL(osdp_test_bus.len > 0);
+    osdp_test_bus.at = osdp_test_now + OSDP_TEST_WIRE_MS(len) +
+                       OSDP_TEST_TURNAROUND_MS +
+                       OSDP_TEST_WIRE_MS(osdp_test_bus.len);
+    osdp_test_bus_ms += OSDP_TEST_WIRE_MS(len) +
+                        OSDP_TEST_WIRE_MS(osdp_test_bus.len);
+
+    return len;
+}
+
+static int
+osdp_test_bus_recv(void *arg, uint8_t *buf, int max_len)
+{
+    int len;
+
+    if (osdp_test_bus.len == 0 || osdp_test_now < osdp_test_bus.at) {
+        return 0;
+    }
+    len = min(osdp_test_bus.len, max_len);
+    memcpy(buf, osdp_test_bus.buf, len);
+    osdp_test_bus.len = 0;
+
+    return len;
+}
+
+static void
+osdp_test_bus_flush(void *arg)
+{
+    osdp_test_bus.len = 0;
+}
+
+void
+osdp_test_bus_init(osdp_pd_info_t *info, int num_pd, uint8_t *master_key)
+{
+    struct osdp_test_pd *tp;
+    struct osdp_pd *pd;
+    int i;
+
+    memset(&osdp_test_bus, 0, sizeof(osdp_test_bus));
+    memset(info, 0, num_pd * sizeof(*info));
+    memset(&osdp_test_led_lat, 0, sizeof(osdp_test_led_lat));
+    osdp_test_bus_ms = 0;
+
+    for (i = 0; i < num_pd; i++) {
+        info[i].baud_rate = OSDP_TEST_BAUD;
+        info[i].address = i + 1;
+        info[i].channel.id = 1;
+        info[i].channel.send = osdp_test_bus_send;
+        info[i].channel.recv = osdp_test_bus_recv;
+        info[i].channel.flush = osdp_test_bus_flush;
+
+        tp = &osdp_test_pds[i];
+        osdp_test_pd_init(tp, i + 1);
+        pd = &tp->pd;
+        SET_FLAG(pd, PD_FLAG_PD_MODE);
+        SET_FLAG(pd, PD_FLAG_SC_CAPABLE);
+        pd->id.vendor_code = 0x00a0a1;
+        pd->id.model = 1;
+        pd->id.version = 1;
+        pd->id.serial_number = 0x1000 + i;
+        osdp_sc_init(pd);
+        osdp_compute_scbk(pd, master_key, pd->sc.scbk);
+    }
+}
+
+TEST_SUITE(osdp_test_all)
+{
+    osdp_sc_mac();
+    osdp_cp_sched();
+}
+
+int
+main(int argc, char **argv)
+{
+    osdp_test_all();
+    return tu_any_failed;
+}
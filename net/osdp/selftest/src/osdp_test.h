@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_OSDP_TEST_
+#define H_OSDP_TEST_
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "osdp/osdp_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSDP_TEST_NUM_PD        MYNEWT_VAL(OSDP_NUM_CONNECTED_PD)
+
+TEST_CASE_DECL(osdp_sc_mac);
+TEST_CASE_DECL(osdp_cp_sched);
+
+/* Virtual time, in milliseconds; osdp_millis_now() returns this. */
+extern int64_t osdp_test_now;
+
+/*
+ * A PD on the loopback bus.  It answers the CP from the bus send callback,
+ * through the phy and secure channel code running in PD mode.
+ */
+struct osdp_test_pd {
+    struct osdp ctx;
+    struct osdp_cp cp;
+    struct osdp_pd pd;
+
+    /* When a card was presented, and is yet to be reported; 0 if none. */
+    int64_t card_at;
+
+    /* When the next of 'keys_left' key presses is made. */
+    int64_t key_at;
+    int keys_left;
+
+    /* When the input in the last reply was made. */
+    int64_t input_at;
+
+    /* When the CP was asked to send the last LED command. */
+    int64_t led_queued_at;
+    int leds;
+};
+
+extern struct osdp_test_pd osdp_test_pds[OSDP_TEST_NUM_PD];
+
+struct osdp_test_lat {
+    int count;
+    int64_t total;
+    int64_t max;
+};
+
+/* Key presses made after each LED command, and the time between them. */
+#define OSDP_TEST_KEYS          4
+#define OSDP_TEST_KEY_MS        150
+
+extern struct osdp_test_lat osdp_test_led_lat;
+
+/* Time spent sending on the bus. */
+extern int64_t osdp_test_bus_ms;
+
+void osdp_test_lat_add(struct osdp_test_lat *lat, int64_t ms);
+
+/*
+ * Sets up 'num_pd' PDs on one bus, keyed from 'master_key', and fills in
+ * the CP's view of them.
+ */
+void osdp_test_bus_init(osdp_pd_info_t *info, int num_pd,
+                        uint8_t *master_key);
+
+/* A session with random keys, for exercising the secure channel code. */
+void osdp_test_session(struct osdp_test_pd *tp, uint32_t seed);
+
+void osdp_test_fill(uint8_t *buf, int len, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "osdp_test.h"
+
+/*
+ * A CP drives a full bus of PDs over secure channels.  Cards are presented
+ * at one reader after another; the application answers each card with an
+ * LED command, after which a PIN is typed in at that reader.  The test
+ * measures how long card reads, LED commands and key presses take to get
+ * across, with the CP refreshed at the usual interval.
+ */
+#define OCS_REFRESH_MS          MYNEWT_VAL(OSDP_REFRESH_INTERVAL_MS)
+#define OCS_UP_MS               30000
+#define OCS_RUN_MS              60000
+/* Not a multiple of the refresh interval, so that cards land anywhere. */
+#define OCS_CARD_MS             1010
+
+static struct osdp_ctx ocs_ctx;
+static osdp_pd_info_t ocs_info[OSDP_TEST_NUM_PD];
+static osdp_t *ocs_osdp;
+static struct osdp_test_lat ocs_card_lat;
+static struct osdp_test_lat ocs_key_lat;
+
+static int
+ocs_event(void *arg, int pd, struct osdp_event *ev)
+{
+    struct osdp_test_pd *tp;
+    struct osdp_cmd cmd;
+    int rc;
+
+    tp = &osdp_test_pds[pd];
+    switch (ev->type) {
+    case OSDP_EVENT_CARDREAD:
+        osdp_test_lat_add(&ocs_card_lat, osdp_test_now - tp->input_at);
+
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.id = OSDP_CMD_LED;
+        cmd.led.temporary.control_code = 2;
+        cmd.led.temporary.on_count = 5;
+        cmd.led.temporary.on_color = 2;
+        cmd.led.temporary.timer_count = 10;
+        tp->led_queued_at = osdp_test_now;
+        rc = osdp_cp_send_command(ocs_osdp, pd, &cmd);
+        TEST_ASSERT(rc == 0);
+        break;
+    case OSDP_EVENT_KEYPRESS:
+        osdp_test_lat_add(&ocs_key_lat, osdp_test_now - tp->input_at);
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/* Runs the bus until 'end', refreshing the CP every interval. */
+static void
+ocs_run(int64_t end, int cards)
+{
+    int64_t next_card;
+    int n;
+
+    next_card = osdp_test_now + OCS_CARD_MS;
+    n = 0;
+    while (osdp_test_now < end) {
+        if (cards && osdp_test_now >= next_card) {
+            /* Spread over the bus, rather than next door to each other. */
+            osdp_test_pds[(n * 5) % OSDP_TEST_NUM_PD].card_at = osdp_test_now;
+            n++;
+            next_card += OCS_CARD_MS;
+            if (n == cards) {
+                cards = 0;
+            }
+        }
+        if (osdp_test_now % OCS_REFRESH_MS == 0) {
+            osdp_refresh(ocs_osdp);
+        }
+        osdp_test_now++;
+    }
+}
+
+static int64_t
+ocs_avg(const struct osdp_test_lat *lat)
+{
+    return lat->count ? lat->total / lat->count : 0;
+}
+
+TEST_CASE_SELF(osdp_cp_sched)
+{
+    uint8_t master_key[16];
+    int64_t bus_ms;
+    int cards;
+    int i;
+
+    osdp_test_fill(master_key, sizeof(master_key), 0x05d9);
+    osdp_test_bus_init(ocs_info, OSDP_TEST_NUM_PD, master_key);
+    for (i = 0; i < OSDP_TEST_NUM_PD; i++) {
+        ocs_info[i].cp_cb = ocs_event;
+    }
+    osdp_test_now = 1;
+
+    ocs_osdp = osdp_cp_setup(&ocs_ctx, OSDP_TEST_NUM_PD, ocs_info,
+                             master_key);
+    TEST_ASSERT_FATAL(ocs_osdp != NULL);
+
+    /* Every PD online, with a secure channel. */
+    while (osdp_get_sc_status_mask(ocs_osdp) != PD_MASK(ocs_osdp)) {
+        TEST_ASSERT_FATAL(osdp_test_now < OCS_UP_MS, "sc mask 0x%x",
+                          (unsigned)osdp_get_sc_status_mask(ocs_osdp));
+        ocs_run(osdp_test_now + OCS_REFRESH_MS, 0);
+    }
+
+    /* Leave time at the end for the last PIN to be typed in. */
+    cards = OCS_RUN_MS / OCS_CARD_MS - 2;
+    osdp_test_bus_ms = 0;
+    ocs_run(osdp_test_now + OCS_RUN_MS, cards);
+    bus_ms = osdp_test_bus_ms;
+
+    TEST_ASSERT(osdp_get_sc_status_mask(ocs_osdp) == PD_MASK(ocs_osdp));
+    TEST_ASSERT(ocs_card_lat.count == cards, "%d cards", ocs_card_lat.count);
+    TEST_ASSERT(osdp_test_led_lat.count == cards, "%d leds",
+                osdp_test_led_lat.count);
+    TEST_ASSERT(ocs_key_lat.count == cards * OSDP_TEST_KEYS, "%d keys",
+                ocs_key_lat.count);
+
+    /* Plain round-robin takes a trip round the bus for each. */
+    TEST_ASSERT(ocs_avg(&osdp_test_led_lat) < 100, "led avg %lld ms",
+                (long long)ocs_avg(&osdp_test_led_lat));
+    TEST_ASSERT(ocs_avg(&ocs_key_lat) < 1000, "key avg %lld ms",
+                (long long)ocs_avg(&ocs_key_lat));
+
+    TEST_PASS("%d PDs: card avg %lld max %lld ms, led avg %lld max %lld ms, "
+              "key avg %lld max %lld ms, bus %d%%", OSDP_TEST_NUM_PD,
+              (long long)ocs_avg(&ocs_card_lat),
+              (long long)ocs_card_lat.max,
+              (long long)ocs_avg(&osdp_test_led_lat),
+              (long long)osdp_test_led_lat.max,
+              (long long)ocs_avg(&ocs_key_lat), (long long)ocs_key_lat.max,
+              (int)(bus_ms * 100 / OCS_RUN_MS));
+
+    osdp_cp_teardown(ocs_osdp);
+}
@@ -0,0 +1,163 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "osdp_test.h"
+#include "tinycrypt/aes.h"
+
+#define OSM_MAX_LEN             200
+#define OSM_PERF_LEN            64
+#define OSM_PERF_ITERS          2000
+
+static struct osdp_test_pd osm_pd;
+
+/*
+ * Reference CBC encryption, setting up the key on every call as the
+ * secure channel once did.
+ */
+static void
+osm_ref_cbc(const uint8_t *key, const uint8_t *iv, uint8_t *data, int len)
+{
+    struct tc_aes_key_sched_struct s;
+    const uint8_t *chain;
+    int off;
+    int i;
+
+    tc_aes128_set_encrypt_key(&s, key);
+    chain = iv;
+    for (off = 0; off < len; off += 16) {
+        for (i = 0; i < 16; i++) {
+            data[off + i] ^= chain[i];
+        }
+        tc_aes_encrypt(data + off, data + off, &s);
+        chain = data + off;
+    }
+}
+
+/* MAC per the OSDP specification, over a padded copy of the packet. */
+static void
+osm_ref_mac(struct osdp_pd *pd, int is_cmd, const uint8_t *data, int len,
+            uint8_t *mac)
+{
+    uint8_t buf[OSM_MAX_LEN + 16];
+    uint8_t iv[16];
+    int pad_len;
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, data, len);
+    pad_len = AES_PAD_LEN(len);
+    if (len % 16 != 0) {
+        buf[len] = 0x80;
+    }
+
+    memcpy(iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
+    if (pad_len > 16) {
+        osm_ref_cbc(pd->sc.s_mac1, iv, buf, pad_len - 16);
+        memcpy(iv, buf + pad_len - 32, 16);
+    }
+    osm_ref_cbc(pd->sc.s_mac2, iv, buf + pad_len - 16, 16);
+    memcpy(mac, buf + pad_len - 16, 16);
+}
+
+static void
+osm_ref_encrypt(struct osdp_pd *pd, int is_cmd, uint8_t *data, int len)
+{
+    uint8_t iv[16];
+    int i;
+
+    memcpy(iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
+    for (i = 0; i < 16; i++) {
+        iv[i] = ~iv[i];
+    }
+    osm_ref_cbc(pd->sc.s_enc, iv, data, len);
+}
+
+static void
+osm_check(int len, int is_cmd)
+{
+    uint8_t data[OSM_MAX_LEN + 16];
+    uint8_t ref[OSM_MAX_LEN + 16];
+    uint8_t mac[16];
+    struct osdp_pd *pd;
+    int pad_len;
+    int rc;
+
+    pd = &osm_pd.pd;
+    osdp_test_fill(data, len, len * 2 + is_cmd);
+
+    osm_ref_mac(pd, is_cmd, data, len, mac);
+    osdp_compute_mac(pd, is_cmd, data, len);
+    TEST_ASSERT(memcmp(is_cmd ? pd->sc.c_mac : pd->sc.r_mac, mac, 16) == 0,
+                "mac len %d is_cmd %d", len, is_cmd);
+
+    /* The EOM marker and padding go in after the data. */
+    memcpy(ref, data, len);
+    pad_len = osdp_encrypt_data(pd, is_cmd, data, len);
+    TEST_ASSERT_FATAL(pad_len == AES_PAD_LEN(len + 1));
+    ref[len] = 0x80;
+    memset(ref + len + 1, 0, pad_len - len - 1);
+    osm_ref_encrypt(pd, is_cmd, ref, pad_len);
+    TEST_ASSERT(memcmp(data, ref, pad_len) == 0, "enc len %d is_cmd %d",
+                len, is_cmd);
+
+    rc = osdp_decrypt_data(pd, is_cmd, data, pad_len);
+    TEST_ASSERT(rc == len, "dec len %d rc %d", len, rc);
+    osdp_test_fill(ref, len, len * 2 + is_cmd);
+    TEST_ASSERT(memcmp(data, ref, len) == 0, "dec len %d is_cmd %d",
+                len, is_cmd);
+}
+
+TEST_CASE_SELF(osdp_sc_mac)
+{
+    uint8_t data[OSM_PERF_LEN + 16];
+    uint8_t mac[16];
+    struct osdp_pd *pd;
+    uint32_t ref_us;
+    uint32_t sc_us;
+    int64_t start;
+    int len;
+    int i;
+
+    osdp_test_session(&osm_pd, 0x05c);
+    pd = &osm_pd.pd;
+
+    for (len = 1; len <= OSM_MAX_LEN; len++) {
+        osm_check(len, 0);
+        osm_check(len, 1);
+    }
+
+    /* A command with data, encrypted then MACed, as on the wire. */
+    osdp_test_fill(data, OSM_PERF_LEN, 1);
+    start = os_get_uptime_usec();
+    for (i = 0; i < OSM_PERF_ITERS; i++) {
+        osm_ref_encrypt(pd, 1, data, OSM_PERF_LEN);
+        osm_ref_mac(pd, 1, data, OSM_PERF_LEN, mac);
+    }
+    ref_us = os_get_uptime_usec() - start;
+
+    start = os_get_uptime_usec();
+    for (i = 0; i < OSM_PERF_ITERS; i++) {
+        osdp_encrypt_data(pd, 1, data, OSM_PERF_LEN - 1);
+        osdp_compute_mac(pd, 1, data, OSM_PERF_LEN);
+    }
+    sc_us = os_get_uptime_usec() - start;
+
+    TEST_PASS("%d x %d B encrypt+mac: key per call %lu us, cached %lu us",
+              OSM_PERF_ITERS, OSM_PERF_LEN, (unsigned long)ref_us,
+              (unsigned long)sc_us);
+}
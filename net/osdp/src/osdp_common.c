@@ -11,7 +11,6 @@
 
 #include <os/os_time.h>
 
-#include "tinycrypt/cbc_mode.h"
 #include "tinycrypt/aes.h"
 #include "tinycrypt/constants.h"
 #if MYNEWT_VAL(TRNG) && !MYNEWT_VAL(OSDP_USE_CRYPTO_HOOK)
@@ -21,15 +20,6 @@
 #include "osdp/osdp_common.h"
 #include "osdp/osdp_hooks.h"
 
-/*
- * Set this to size of the max UART buffer length and add block size
- * If the entire buffer were to be encrypted, account for the
- * the fact that the output buffer comes with IV appended
- */
-#define MAX_UART_BUF (max(MYNEWT_VAL(OSDP_UART_TX_BUFFER_LENGTH), \
-                          MYNEWT_VAL(OSDP_UART_RX_BUFFER_LENGTH)))
-#define MAX_SCRATCH_LEN (MAX_UART_BUF + TC_AES_BLOCK_SIZE)
-static uint8_t scratch_buf1[MAX_SCRATCH_LEN];
 #if MYNEWT_VAL(TRNG) && !MYNEWT_VAL(OSDP_USE_CRYPTO_HOOK)
 static struct trng_dev *trng = NULL;
 #endif /* MYNEWT_VAL(TRNG) && !MYNEWT_VAL(OSDP_USE_CRYPTO_HOOK) */
@@ -64,69 +54,89 @@ osdp_millis_since(int64_t last)
     return osdp_millis_now() - last;
 }
 
+/**
+ * AES-128 with an expanded key.  With an IV, 'data' is CBC encrypted in
+ * place and 'len' must be a multiple of the block size; without one, the
+ * first block is ECB encrypted.
+ */
 void
-osdp_encrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
+osdp_encrypt_sched(const struct tc_aes_key_sched_struct *s, uint8_t *iv,
+                   uint8_t *data, int len)
 {
-    struct tc_aes_key_sched_struct s;
-    (void)tc_aes128_set_encrypt_key(&s, key);
+    const uint8_t *chain;
+    int off, i;
 
-    if (iv != NULL) {
-        /* Check if there is enough space for IV + len */
-        assert(len <= MAX_SCRATCH_LEN - TC_AES_BLOCK_SIZE);
-        if (tc_cbc_mode_encrypt(scratch_buf1, /* out: output buffer */
-            len + TC_AES_BLOCK_SIZE, /* outlen: max output size, including size of IV */
-            data, /* in: input buffer */
-            len, /* inlen: input len */
-            iv, /* iv: IV start */
-            &s) == TC_CRYPTO_FAIL) {
-            OSDP_LOG_ERROR("osdp: sc: CBC ENCRYPT - Failed");
+    if (iv == NULL) {
+        if (tc_aes_encrypt(data, data, s) == TC_CRYPTO_FAIL) {
+            OSDP_LOG_ERROR("osdp: sc: ECB ENCRYPT - Failed\n");
         }
+        return;
+    }
 
-        /* copy ciphertext from offset */
-        memcpy(data, scratch_buf1 + TC_AES_BLOCK_SIZE, len);
+    if (len % TC_AES_BLOCK_SIZE != 0) {
+        OSDP_LOG_ERROR("osdp: sc: CBC ENCRYPT - invalid len:%d\n", len);
+        return;
+    }
 
-    } else {
-        if (tc_aes_encrypt(data, data, &s) == TC_CRYPTO_FAIL) {
-            OSDP_LOG_ERROR("osdp: sc: ECB ENCRYPT - Failed\n");
+    chain = iv;
+    for (off = 0; off < len; off += TC_AES_BLOCK_SIZE) {
+        for (i = 0; i < TC_AES_BLOCK_SIZE; i++) {
+            data[off + i] ^= chain[i];
         }
+        (void)tc_aes_encrypt(data + off, data + off, s);
+        chain = data + off;
     }
 }
 
 void
-osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
+osdp_decrypt_sched(const struct tc_aes_key_sched_struct *s, uint8_t *iv,
+                   uint8_t *data, int len)
 {
-    struct tc_aes_key_sched_struct s;
-    (void)tc_aes128_set_decrypt_key(&s, key);
+    uint8_t chain[TC_AES_BLOCK_SIZE];
+    uint8_t next[TC_AES_BLOCK_SIZE];
+    int off, i;
 
-    if (iv != NULL) {
-        /* Check if there is enough space for IV + len */
-        assert(len <= MAX_SCRATCH_LEN - TC_AES_BLOCK_SIZE);
-        /* Create input buffer. IV and cipher text in contiguous buffer per tinycrypt */
-        memcpy(scratch_buf1, iv, TC_AES_BLOCK_SIZE);
-        memcpy(scratch_buf1 + TC_AES_BLOCK_SIZE, data, len);
-        /*
-           note commit da923ca upstream(tinycrypt)
-           Commit message has this nugget:-
-           When decrypting with CBC mode, the in and out buffers should be the same size.
-           Even though the IV and ciphertext are contiguous, the in buffer points to the first byte of the ciphertext.
-         */
-        if (tc_cbc_mode_decrypt(scratch_buf1, /* out: output buffer */
-            len + TC_AES_BLOCK_SIZE, /* outlen: same as inlen */
-            scratch_buf1 + TC_AES_BLOCK_SIZE, /* in: offset to ciphertext in input buffer */
-            len + TC_AES_BLOCK_SIZE, /* inlen: total length of input, iv + buffer length */
-            scratch_buf1, /* iv: offset to IV in input buffer */
-            &s) == TC_CRYPTO_FAIL) {
-            OSDP_LOG_ERROR("osdp: sc: CBC DECRYPT - Failed\n");
-        }
-        /* Copy decrypted data into output buffer */
-        memcpy(data, scratch_buf1, len);
-    } else {
-        if (tc_aes_decrypt(data, data, &s) == TC_CRYPTO_FAIL) {
+    if (iv == NULL) {
+        if (tc_aes_decrypt(data, data, s) == TC_CRYPTO_FAIL) {
             OSDP_LOG_ERROR("osdp: sc: ECB DECRYPT - Failed\n");
         }
+        return;
+    }
+
+    if (len % TC_AES_BLOCK_SIZE != 0) {
+        OSDP_LOG_ERROR("osdp: sc: CBC DECRYPT - invalid len:%d\n", len);
+        return;
+    }
+
+    memcpy(chain, iv, TC_AES_BLOCK_SIZE);
+    for (off = 0; off < len; off += TC_AES_BLOCK_SIZE) {
+        memcpy(next, data + off, TC_AES_BLOCK_SIZE);
+        (void)tc_aes_decrypt(data + off, data + off, s);
+        for (i = 0; i < TC_AES_BLOCK_SIZE; i++) {
+            data[off + i] ^= chain[i];
+        }
+        memcpy(chain, next, TC_AES_BLOCK_SIZE);
     }
 }
 
+void
+osdp_encrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
+{
+    struct tc_aes_key_sched_struct s;
+
+    (void)tc_aes128_set_encrypt_key(&s, key);
+    osdp_encrypt_sched(&s, iv, data, len);
+}
+
+void
+osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
+{
+    struct tc_aes_key_sched_struct s;
+
+    (void)tc_aes128_set_decrypt_key(&s, key);
+    osdp_decrypt_sched(&s, iv, data, len);
+}
+
 void
 osdp_get_rand(uint8_t *buf, int len)
 {
@@ -19,6 +19,7 @@
 #define OSDP_CMD_RETRY_WAIT_MS         (MYNEWT_VAL(OSDP_CMD_RETRY_WAIT_SEC) * 1000)
 #define OSDP_PD_SC_RETRY_MS            (MYNEWT_VAL(OSDP_SC_RETRY_WAIT_SEC) * 1000)
 #define OSDP_ONLINE_RETRY_WAIT_MAX_MS  (MYNEWT_VAL(OSDP_ONLINE_RETRY_WAIT_MAX_SEC) * 1000)
+#define OSDP_PD_ACTIVE_MS              MYNEWT_VAL(OSDP_CP_PD_ACTIVE_MS)
 
 #define CMD_POLL_LEN                   1
 #define CMD_LSTAT_LEN                  1
@@ -61,6 +62,16 @@
 #define OSDP_CP_ERR_CAN_YIELD          3
 #define OSDP_CP_ERR_INPROG             4
 
+/**
+ * Order in which PDs on a shared channel get to use it: one in the middle
+ * of a transaction, then ones with an application command queued or a
+ * recent card read or key press, then the rest.
+ */
+#define OSDP_CP_SCHED_BUSY             0
+#define OSDP_CP_SCHED_ACTIVE           1
+#define OSDP_CP_SCHED_IDLE             2
+#define OSDP_CP_SCHED_NUM              3
+
 #define POOL_NAME_COMMON "cp_cmd_pool"
 
 /* Enough to hold POOL_NAME_COMMON + digits in 16bit number */
@@ -577,6 +588,7 @@ cp_decode_response(struct osdp_pd *pd, uint8_t *buf, int len)
         ret = OSDP_CP_ERR_NONE;
         break;
     case REPLY_KEYPPAD:
+        pd->activity_tstamp = osdp_millis_now();
         if (len < REPLY_KEYPPAD_DATA_LEN || !cp->event_callback) {
             break;
         }
@@ -593,6 +605,7 @@ cp_decode_response(struct osdp_pd *pd, uint8_t *buf, int len)
         ret = OSDP_CP_ERR_NONE;
         break;
     case REPLY_RAW:
+        pd->activity_tstamp = osdp_millis_now();
         if (len < REPLY_RAW_DATA_LEN || !cp->event_callback) {
             break;
         }
@@ -613,6 +626,7 @@ cp_decode_response(struct osdp_pd *pd, uint8_t *buf, int len)
         ret = OSDP_CP_ERR_NONE;
         break;
     case REPLY_FMT:
+        pd->activity_tstamp = osdp_millis_now();
         if (len < REPLY_FMT_DATA_LEN || !cp->event_callback) {
             break;
         }
@@ -1215,15 +1229,60 @@ osdp_cp_teardown(osdp_t *ctx)
     }
 }
 
+static int
+cp_sched_class(struct osdp_pd *pd)
+{
+    struct osdp_cp *cp = TO_CTX(pd)->cp;
+
+    if (pd->phy_state != OSDP_CP_PHY_STATE_IDLE) {
+        return OSDP_CP_SCHED_BUSY;
+    }
+    /* Every other turn goes in round-robin order, so no PD starves. */
+    if (cp->boosted) {
+        return OSDP_CP_SCHED_IDLE;
+    }
+    /**
+     * Peek without the lock; a command missed now is seen next refresh.
+     * Commands the CP queued itself (PD_FLAG_AWAIT_RESP) don't count.
+     */
+    if ((!TAILQ_EMPTY(&pd->cmd.queue) &&
+         !ISSET_FLAG(pd, PD_FLAG_AWAIT_RESP)) ||
+        (pd->activity_tstamp != 0 &&
+         osdp_millis_since(pd->activity_tstamp) < OSDP_PD_ACTIVE_MS)) {
+        return OSDP_CP_SCHED_ACTIVE;
+    }
+    return OSDP_CP_SCHED_IDLE;
+}
+
 void
 osdp_refresh(osdp_t *ctx)
 {
-    int i, rc;
+    uint8_t class[MYNEWT_VAL(OSDP_NUM_CONNECTED_PD)];
+    uint8_t order[MYNEWT_VAL(OSDP_NUM_CONNECTED_PD)];
+    int c, i, j, n, rc, start;
+    struct osdp_cp *cp;
     struct osdp_pd *pd;
 
     assert(ctx);
+    cp = TO_CP(ctx);
 
+    /* Round-robin within each class, from where its last turn ended. */
     for (i = 0; i < NUM_PD(ctx); i++) {
+        class[i] = cp_sched_class(TO_PD(ctx, i));
+    }
+    n = 0;
+    for (c = 0; c < OSDP_CP_SCHED_NUM; c++) {
+        start = (c == OSDP_CP_SCHED_ACTIVE) ? cp->boost_offset : cp->rr_offset;
+        for (j = 0; j < NUM_PD(ctx); j++) {
+            i = (start + j) % NUM_PD(ctx);
+            if (class[i] == c) {
+                order[n++] = i;
+            }
+        }
+    }
+
+    for (j = 0; j < n; j++) {
+        i = order[j];
         SET_CURRENT_PD(ctx, i);
         /*
            osdp_log_ctx_set(i);
@@ -1237,10 +1296,28 @@ osdp_refresh(osdp_t *ctx)
         }
 
         rc = state_update(pd);
+        if (rc == OSDP_CP_ERR_CAN_YIELD &&
+            ISSET_FLAG(pd, PD_FLAG_AWAIT_RESP)) {
+            /**
+             * The state machine is waiting on a command it queued, or on
+             * acting on its reply; carry on within this turn.
+             */
+            rc = state_update(pd);
+        }
 
-        if (ISSET_FLAG(pd, PD_FLAG_CHN_SHARED) &&
-            rc == OSDP_CP_ERR_CAN_YIELD) {
+        if (!ISSET_FLAG(pd, PD_FLAG_CHN_SHARED)) {
+            continue;
+        }
+        if (rc == OSDP_CP_ERR_CAN_YIELD) {
             cp_channel_release(pd);
+        } else if (class[i] != OSDP_CP_SCHED_BUSY) {
+            /* PD has just started a transaction on the channel */
+            cp->boosted = (class[i] == OSDP_CP_SCHED_ACTIVE);
+            if (cp->boosted) {
+                cp->boost_offset = (i + 1) % NUM_PD(ctx);
+            } else {
+                cp->rr_offset = (i + 1) % NUM_PD(ctx);
+            }
         }
     }
 }
@@ -12,6 +12,23 @@
 #define TAG "SC: "
 #define OSDP_SC_EOM_MARKER             0x80  /* End of Message Marker */
 
+/**
+ * Encrypt or decrypt with one of the session keys: s_enc, s_mac1 or s_mac2.
+ * tinycrypt decrypts with the encryption key schedule, so one cached
+ * schedule serves both.
+ */
+#if MYNEWT_VAL(OSDP_SC_KEY_SCHED_CACHE)
+#define SC_ENCRYPT(pd, key, iv, data, len) \
+    osdp_encrypt_sched(&(pd)->sc.key ## _sched, iv, data, len)
+#define SC_DECRYPT(pd, key, iv, data, len) \
+    osdp_decrypt_sched(&(pd)->sc.key ## _sched, iv, data, len)
+#else
+#define SC_ENCRYPT(pd, key, iv, data, len) \
+    osdp_encrypt((pd)->sc.key, iv, data, len)
+#define SC_DECRYPT(pd, key, iv, data, len) \
+    osdp_decrypt((pd)->sc.key, iv, data, len)
+#endif
+
 /* Default key as specified in OSDP specification */
 static const uint8_t osdp_scbk_default[16] = {
     0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
@@ -68,6 +85,12 @@ osdp_compute_session_keys(struct osdp *ctx)
     osdp_encrypt(pd->sc.scbk, NULL, pd->sc.s_enc,  16);
     osdp_encrypt(pd->sc.scbk, NULL, pd->sc.s_mac1, 16);
     osdp_encrypt(pd->sc.scbk, NULL, pd->sc.s_mac2, 16);
+
+#if MYNEWT_VAL(OSDP_SC_KEY_SCHED_CACHE)
+    (void)tc_aes128_set_encrypt_key(&pd->sc.s_enc_sched, pd->sc.s_enc);
+    (void)tc_aes128_set_encrypt_key(&pd->sc.s_mac1_sched, pd->sc.s_mac1);
+    (void)tc_aes128_set_encrypt_key(&pd->sc.s_mac2_sched, pd->sc.s_mac2);
+#endif
 }
 
 void
@@ -76,7 +99,7 @@ osdp_compute_cp_cryptogram(struct osdp_pd *pd)
     /* cp_cryptogram = AES-ECB( pd_random[8] || cp_random[8], s_enc ) */
     memcpy(pd->sc.cp_cryptogram + 0, pd->sc.pd_random, 8);
     memcpy(pd->sc.cp_cryptogram + 8, pd->sc.cp_random, 8);
-    osdp_encrypt(pd->sc.s_enc, NULL, pd->sc.cp_cryptogram, 16);
+    SC_ENCRYPT(pd, s_enc, NULL, pd->sc.cp_cryptogram, 16);
 }
 
 /**
@@ -106,7 +129,7 @@ osdp_verify_cp_cryptogram(struct osdp_pd *pd)
     /* cp_cryptogram = AES-ECB( pd_random[8] || cp_random[8], s_enc ) */
     memcpy(cp_crypto + 0, pd->sc.pd_random, 8);
     memcpy(cp_crypto + 8, pd->sc.cp_random, 8);
-    osdp_encrypt(pd->sc.s_enc, NULL, cp_crypto, 16);
+    SC_ENCRYPT(pd, s_enc, NULL, cp_crypto, 16);
 
     if (osdp_ct_compare(pd->sc.cp_cryptogram, cp_crypto, 16) != 0) {
         return -1;
@@ -120,7 +143,7 @@ osdp_compute_pd_cryptogram(struct osdp_pd *pd)
     /* pd_cryptogram = AES-ECB( cp_random[8] || pd_random[8], s_enc ) */
     memcpy(pd->sc.pd_cryptogram + 0, pd->sc.cp_random, 8);
     memcpy(pd->sc.pd_cryptogram + 8, pd->sc.pd_random, 8);
-    osdp_encrypt(pd->sc.s_enc, NULL, pd->sc.pd_cryptogram, 16);
+    SC_ENCRYPT(pd, s_enc, NULL, pd->sc.pd_cryptogram, 16);
 }
 
 int
@@ -131,7 +154,7 @@ osdp_verify_pd_cryptogram(struct osdp_pd *pd)
     /* pd_cryptogram = AES-ECB( cp_random[8] || pd_random[8], s_enc ) */
     memcpy(pd_crypto + 0, pd->sc.cp_random, 8);
     memcpy(pd_crypto + 8, pd->sc.pd_random, 8);
-    osdp_encrypt(pd->sc.s_enc, NULL, pd_crypto, 16);
+    SC_ENCRYPT(pd, s_enc, NULL, pd_crypto, 16);
 
     if (osdp_ct_compare(pd->sc.pd_cryptogram, pd_crypto, 16) != 0) {
         return -1;
@@ -144,8 +167,8 @@ osdp_compute_rmac_i(struct osdp_pd *pd)
 {
     /* rmac_i = AES-ECB( AES-ECB( cp_cryptogram, s_mac1 ), s_mac2 ) */
     memcpy(pd->sc.r_mac, pd->sc.cp_cryptogram, 16);
-    osdp_encrypt(pd->sc.s_mac1, NULL, pd->sc.r_mac, 16);
-    osdp_encrypt(pd->sc.s_mac2, NULL, pd->sc.r_mac, 16);
+    SC_ENCRYPT(pd, s_mac1, NULL, pd->sc.r_mac, 16);
+    SC_ENCRYPT(pd, s_mac2, NULL, pd->sc.r_mac, 16);
 }
 
 int
@@ -164,7 +187,7 @@ osdp_decrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
         iv[i] = ~iv[i];
     }
 
-    osdp_decrypt(pd->sc.s_enc, iv, data, length);
+    SC_DECRYPT(pd, s_enc, iv, data, length);
 
     length--;
     while (length && data[length] == 0x00) {
@@ -194,7 +217,7 @@ osdp_encrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
         iv[i] = ~iv[i];
     }
 
-    osdp_encrypt(pd->sc.s_enc, iv, data, pad_len);
+    SC_ENCRYPT(pd, s_enc, iv, data, pad_len);
 
     return pad_len;
 }
@@ -203,34 +226,37 @@ int
 osdp_compute_mac(struct osdp_pd *pd, int is_cmd,
                  const uint8_t *data, int len)
 {
-    int pad_len;
-    uint8_t buf[max(MYNEWT_VAL(OSDP_UART_TX_BUFFER_LENGTH),
-            MYNEWT_VAL(OSDP_UART_RX_BUFFER_LENGTH))] = { 0 };
-    uint8_t iv[16];
+    uint8_t mac[16];
+    int i, n, off;
 
-    memcpy(buf, data, len);
-    pad_len = (len % 16 == 0) ? len : AES_PAD_LEN(len);
-    if (len % 16 != 0) {
-        buf[len] = 0x80; /* end marker */
-    }
     /**
      * MAC for data blocks B[1] .. B[N] (post padding) is computed as:
      * IV1 = R_MAC (or) C_MAC  -- depending on is_cmd
      * IV2 = B[N-1] after -- AES-CBC ( IV1, B[1] to B[N-1], SMAC-1 )
      * MAC = AES-ECB ( IV2, B[N], SMAC-2 )
+     *
+     * Each block is XORed straight into the chaining value, so the data
+     * is not copied out to be padded.
      */
-
-    memcpy(iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
-    if (pad_len > 16) {
+    memcpy(mac, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
+    for (off = 0; ; off += 16) {
+        n = min(len - off, 16);
+        for (i = 0; i < n; i++) {
+            mac[i] ^= data[off + i];
+        }
+        if (n < 16) {
+            mac[n] ^= 0x80; /* end marker */
+        }
+        if (off + 16 >= len) {
+            break;
+        }
         /* N-1 blocks -- encrypted with SMAC-1 */
-        osdp_encrypt(pd->sc.s_mac1, iv, buf, pad_len - 16);
-        /* N-1 th block is the IV for N th block */
-        memcpy(iv, buf + pad_len - 32, 16);
+        SC_ENCRYPT(pd, s_mac1, NULL, mac, 16);
     }
 
     /* N-th Block encrypted with SMAC-2 == MAC */
-    osdp_encrypt(pd->sc.s_mac2, iv, buf + pad_len - 16, 16);
-    memcpy(is_cmd ? pd->sc.c_mac : pd->sc.r_mac, buf + pad_len - 16, 16);
+    SC_ENCRYPT(pd, s_mac2, NULL, mac, 16);
+    memcpy(is_cmd ? pd->sc.c_mac : pd->sc.r_mac, mac, 16);
 
     return 0;
 }
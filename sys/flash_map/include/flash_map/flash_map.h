@@ -103,6 +103,18 @@ int flash_area_is_empty(const struct flash_area *, bool *);
 int flash_area_read_is_empty(const struct flash_area *, uint32_t off, void *dst,
   uint32_t len);
 
+/*
+ * Continue a CRC over len bytes of the area starting at off.  On input, *crc
+ * holds the CRC to continue from; on success it is updated.  Data is read
+ * through a small stack buffer.  Return 0 on success, nonzero on read error.
+ */
+int flash_area_crc8(const struct flash_area *, uint32_t off, uint32_t len,
+  uint8_t *crc);
+int flash_area_crc16_ccitt(const struct flash_area *, uint32_t off,
+  uint32_t len, uint16_t *crc);
+int flash_area_crc32(const struct flash_area *, uint32_t off, uint32_t len,
+  uint32_t *crc);
+
 /*
  * Alignment restriction for flash writes.
  */
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+
+/*
+ * Test flash_area_crc8/16/32 against the CRC of the same data in RAM.
+ */
+TEST_CASE_SELF(flash_map_test_case_crc)
+{
+    const struct flash_area *fa;
+    uint32_t crc32;
+    uint16_t crc16;
+    uint8_t crc8;
+    uint8_t wd[777];
+    int off;
+    int len;
+    int rc;
+    int i;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_erase() fail");
+
+    for (i = 0; i < sizeof(wd); i++) {
+        wd[i] = i * 7 + (i >> 3);
+    }
+    rc = flash_area_write(fa, 0, wd, sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_write() fail");
+
+    /* Odd offsets and lengths, short and spanning several read chunks. */
+    for (off = 0; off < 5; off++) {
+        for (len = 0; len < sizeof(wd) - off; len += 61) {
+            crc8 = crc8_init();
+            rc = flash_area_crc8(fa, off, len, &crc8);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc8 == crc8_calc(crc8_init(), wd + off, len));
+
+            crc16 = CRC16_INITIAL_CRC;
+            rc = flash_area_crc16_ccitt(fa, off, len, &crc16);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc16 ==
+                        crc16_ccitt(CRC16_INITIAL_CRC, wd + off, len));
+
+            crc32 = CRC32_INITIAL_CRC;
+            rc = flash_area_crc32(fa, off, len, &crc32);
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(crc32 ==
+                        crc32_calc(CRC32_INITIAL_CRC, wd + off, len));
+        }
+    }
+
+    /* A running CRC is continued. */
+    crc16 = crc16_ccitt(CRC16_INITIAL_CRC, wd, 100);
+    rc = flash_area_crc16_ccitt(fa, 100, sizeof(wd) - 100, &crc16);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(crc16 == crc16_ccitt(CRC16_INITIAL_CRC, wd, sizeof(wd)));
+
+    /* Out of range; the CRC is left alone. */
+    crc32 = 0x12345678;
+    rc = flash_area_crc32(fa, fa->fa_size - 4, 8, &crc32);
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(crc32 == 0x12345678);
+}
@@ -29,6 +29,9 @@
 #include "mfg/mfg.h"
 #endif
 #include "flash_map/flash_map.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
 
 const struct flash_area *flash_map;
 int flash_map_entries;
@@ -260,6 +263,106 @@ flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
     return hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
 }
 
+typedef void flash_area_crc_fn(void *crc, const void *buf, int len);
+
+static int
+flash_area_crc(const struct flash_area *fa, uint32_t off, uint32_t len,
+               flash_area_crc_fn *fn, void *crc)
+{
+    uint8_t buf[MYNEWT_VAL(FLASH_MAP_CRC_BUF_SIZE)];
+    uint32_t chunk;
+    int rc;
+
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+
+    while (len > 0) {
+        chunk = min(len, sizeof buf);
+        rc = hal_flash_read(fa->fa_device_id, fa->fa_off + off, buf, chunk);
+        if (rc != 0) {
+            return rc;
+        }
+        fn(crc, buf, chunk);
+        off += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+static void
+flash_area_crc8_fn(void *crc, const void *buf, int len)
+{
+    uint8_t *c;
+
+    c = crc;
+    *c = crc8_calc(*c, buf, len);
+}
+
+static void
+flash_area_crc16_ccitt_fn(void *crc, const void *buf, int len)
+{
+    uint16_t *c;
+
+    c = crc;
+    *c = crc16_ccitt(*c, buf, len);
+}
+
+static void
+flash_area_crc32_fn(void *crc, const void *buf, int len)
+{
+    uint32_t *c;
+
+    c = crc;
+    *c = crc32_calc(*c, buf, len);
+}
+
+int
+flash_area_crc8(const struct flash_area *fa, uint32_t off, uint32_t len,
+                uint8_t *crc)
+{
+    uint8_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = flash_area_crc(fa, off, len, flash_area_crc8_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+flash_area_crc16_ccitt(const struct flash_area *fa, uint32_t off, uint32_t len,
+                       uint16_t *crc)
+{
+    uint16_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = flash_area_crc(fa, off, len, flash_area_crc16_ccitt_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+flash_area_crc32(const struct flash_area *fa, uint32_t off, uint32_t len,
+                 uint32_t *crc)
+{
+    uint32_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = flash_area_crc(fa, off, len, flash_area_crc32_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
 uint8_t
 flash_area_align(const struct flash_area *fa)
 {
@@ -62,6 +62,34 @@ struct log_offset {
     void *lo_arg;
 };
 
+/**
+ * Resumable read position in a log.  A cursor lets a log be retrieved in
+ * chunks (e.g., one chunk per management request) without searching for the
+ * first entry of each chunk.  Initialize with `log_cursor_init()` and read
+ * with `log_walk_body_cursor()`.
+ */
+struct log_cursor {
+    /* The log this cursor reads from. */
+    struct log *lc_log;
+
+    /* Index of the next entry to retrieve. */
+    uint32_t lc_index;
+
+#if MYNEWT_VAL(LOG_FCB) || MYNEWT_VAL(LOG_FCB2)
+    /* Maintained by the log handler: location of the last entry visited,
+     * and that entry's index.  Checked against the flash contents before
+     * use, so a location that was rotated out is simply not resumed from.
+     */
+#if MYNEWT_VAL(LOG_FCB)
+    struct fcb_entry lc_loc;
+#else
+    struct fcb2_entry lc_loc;
+#endif
+    uint32_t lc_loc_index;
+    uint8_t lc_loc_valid;
+#endif
+};
+
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
 /**
  * Log storage information
@@ -96,6 +124,9 @@ typedef int (*lh_append_mbuf_body_func_t)(struct log *log,
                                           struct os_mbuf *om);
 typedef int (*lh_walk_func_t)(struct log *,
         log_walk_func_t walk_func, struct log_offset *log_offset);
+typedef int (*lh_walk_cursor_func_t)(struct log *,
+        log_walk_func_t walk_func, struct log_offset *log_offset,
+        struct log_cursor *cursor);
 typedef int (*lh_flush_func_t)(struct log *);
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
 typedef int (*lh_storage_info_func_t)(struct log *, struct log_storage_info *);
@@ -115,6 +146,8 @@ struct log_handler {
     lh_append_mbuf_body_func_t log_append_mbuf_body;
     lh_walk_func_t log_walk;
     lh_walk_func_t log_walk_sector;
+    /* Optional; without it, cursor walks search by index each time. */
+    lh_walk_cursor_func_t log_walk_cursor;
     lh_flush_func_t log_flush;
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     lh_storage_info_func_t log_storage_info;
@@ -607,6 +640,44 @@ int log_flush(struct log *log);
 int log_walk_body_section(struct log *log, log_walk_body_func_t walk_body_func,
               struct log_offset *log_offset);
 
+/**
+ * @brief Initializes a log cursor.
+ *
+ * @param cursor                The cursor to initialize.
+ * @param log                   The log the cursor reads from.
+ * @param index                 Index of the first entry to retrieve.
+ */
+void log_cursor_init(struct log_cursor *cursor, struct log *log,
+                     uint32_t index);
+
+/**
+ * @brief Applies a callback to log entries, starting at a cursor.
+ *
+ * Like `log_walk_body`, but the walk starts at the cursor's index and the
+ * cursor is advanced past every entry the callback consumes.  The callback
+ * returns:
+ *     o 0 if it consumed the entry;
+ *     o positive to stop the walk without consuming the entry (e.g., the
+ *       response buffer is full); the next walk starts with this entry;
+ *     o negative on error; the walk is aborted.
+ *
+ * For FCB logs, the next walk resumes at the location where this one
+ * stopped instead of searching the log for the cursor's index.  If that
+ * location has been erased in the meantime, the walk falls back to a
+ * search and starts with the oldest entry whose index is not below the
+ * cursor's.
+ *
+ * @param cursor                The cursor to read from.
+ * @param walk_body_func        The function to apply to each log entry.
+ * @param arg                   Passed to the callback as `lo_arg`.
+ *
+ * @return                      0 if the walk reached the end of the log or
+ *                                  was stopped by the callback;
+ *                              negative on error.
+ */
+int log_walk_body_cursor(struct log_cursor *cursor,
+                         log_walk_body_func_t walk_body_func, void *arg);
+
 #if MYNEWT_VAL(LOG_MODULE_LEVELS)
 /**
  * @brief Retrieves the globally configured minimum log level for the specified
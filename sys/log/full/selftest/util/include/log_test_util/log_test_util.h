@@ -73,6 +73,7 @@ TEST_CASE_DECL(log_test_case_level);
 TEST_CASE_DECL(log_test_case_append_cb);
 
 TEST_CASE_DECL(log_test_case_2logs);
+TEST_CASE_DECL(log_test_case_cursor);
 
 #ifdef __cplusplus
 }
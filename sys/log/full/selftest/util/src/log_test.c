@@ -53,4 +53,7 @@ TEST_SUITE(log_test_suite_misc)
 #if MYNEWT_VAL(LOG_FCB)
     log_test_case_2logs();
 #endif
+#if MYNEWT_VAL(LOG_FCB) || MYNEWT_VAL(LOG_FCB2)
+    log_test_case_cursor();
+#endif
 }
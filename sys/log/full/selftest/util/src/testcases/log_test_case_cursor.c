@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "log_test_util/log_test_util.h"
+
+#define LTCC_NUM_ENTRIES    256
+#define LTCC_CHUNK_SZ       16
+
+struct ltcc_arg {
+    /* Number of entries retrieved by the current walk. */
+    int cnt;
+
+    /* Number of the next entry expected, as written in its body. */
+    int next;
+
+    /* Index of the last entry retrieved; -1 if none. */
+    int64_t last_index;
+};
+
+static void
+ltcc_append(struct log *log, int num)
+{
+    char buf[16];
+    int len;
+    int rc;
+
+    len = snprintf(buf, sizeof buf, "%d", num);
+    rc = log_append_body(log, 0, 0, LOG_ETYPE_STRING, buf, len);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Retrieves up to LTCC_CHUNK_SZ entries and checks that they are the
+ * expected ones, in order.
+ */
+static int
+ltcc_walk_chunk(struct log *log, struct log_offset *log_offset,
+                const struct log_entry_hdr *hdr, const void *dptr,
+                uint16_t len)
+{
+    struct ltcc_arg *arg;
+    char body[16];
+    char exp[16];
+    int rc;
+
+    arg = log_offset->lo_arg;
+
+    if (arg->cnt == LTCC_CHUNK_SZ) {
+        /* Chunk full; this entry goes into the next one. */
+        return 1;
+    }
+
+    TEST_ASSERT_FATAL(len < sizeof body);
+    rc = log_read_body(log, dptr, body, 0, len);
+    TEST_ASSERT_FATAL(rc == len);
+    body[len] = '\0';
+
+    snprintf(exp, sizeof exp, "%d", arg->next);
+    TEST_ASSERT(strcmp(body, exp) == 0);
+    TEST_ASSERT(hdr->ue_index > arg->last_index);
+
+    arg->last_index = hdr->ue_index;
+    arg->next++;
+    arg->cnt++;
+
+    return 0;
+}
+
+/**
+ * Retrieves the log in chunks until a chunk comes back empty.
+ *
+ * @return                      The number of entries retrieved.
+ */
+static int
+ltcc_read_all(struct log_cursor *cursor, struct ltcc_arg *arg)
+{
+    int total;
+    int rc;
+
+    total = 0;
+    do {
+        arg->cnt = 0;
+        rc = log_walk_body_cursor(cursor, ltcc_walk_chunk, arg);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(arg->cnt <= LTCC_CHUNK_SZ);
+        total += arg->cnt;
+    } while (arg->cnt != 0);
+
+    return total;
+}
+
+/**
+ * Retrieves the log in chunks the way it was done without cursors: each
+ * chunk is a fresh walk starting at the index following the last entry.
+ */
+static void
+ltcc_read_all_by_index(struct log *log, struct ltcc_arg *arg)
+{
+    struct log_offset log_offset = { 0 };
+    int rc;
+
+    do {
+        arg->cnt = 0;
+        log_offset.lo_index = arg->last_index + 1;
+        log_offset.lo_arg = arg;
+        rc = log_walk_body(log, ltcc_walk_chunk, &log_offset);
+        TEST_ASSERT_FATAL(rc == 0);
+    } while (arg->cnt != 0);
+}
+
+TEST_CASE_SELF(log_test_case_cursor)
+{
+    struct log_cursor cursor;
+    struct ltcc_arg arg;
+    struct fcb_log fcb_log;
+    struct log log;
+    uint32_t by_index_us;
+    uint32_t cursor_us;
+    int64_t start;
+    int cnt;
+    int rc;
+    int i;
+
+    ltu_setup_fcb(&fcb_log, &log);
+
+    for (i = 0; i < LTCC_NUM_ENTRIES; i++) {
+        ltcc_append(&log, i);
+    }
+
+    /* Retrieve everything in chunks. */
+    arg = (struct ltcc_arg) { .last_index = -1 };
+    log_cursor_init(&cursor, &log, 0);
+
+    start = os_get_uptime_usec();
+    cnt = ltcc_read_all(&cursor, &arg);
+    cursor_us = os_get_uptime_usec() - start;
+
+    TEST_ASSERT(cnt == LTCC_NUM_ENTRIES);
+    TEST_ASSERT(cursor.lc_index == arg.last_index + 1);
+
+    /* The cursor picks up entries appended after it reached the end. */
+    for (i = 0; i < 5; i++) {
+        ltcc_append(&log, LTCC_NUM_ENTRIES + i);
+    }
+    cnt = ltcc_read_all(&cursor, &arg);
+    TEST_ASSERT(cnt == 5);
+
+    /* Same retrieval, restarting each chunk from an index. */
+    arg = (struct ltcc_arg) { .last_index = -1 };
+    start = os_get_uptime_usec();
+    ltcc_read_all_by_index(&log, &arg);
+    by_index_us = os_get_uptime_usec() - start;
+    TEST_ASSERT(arg.next == LTCC_NUM_ENTRIES + 5);
+
+    /* Erasing the log invalidates the cursor's location; the next walk
+     * starts with the first entry written afterwards.
+     */
+    rc = log_flush(&log);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < 3; i++) {
+        ltcc_append(&log, 1000 + i);
+    }
+
+    arg.next = 1000;
+    arg.last_index = cursor.lc_index - 1;
+    cnt = ltcc_read_all(&cursor, &arg);
+    TEST_ASSERT(cnt == 3);
+
+    TEST_PASS("%d entries in chunks of %d: cursor=%lu us by index=%lu us",
+              LTCC_NUM_ENTRIES + 5, LTCC_CHUNK_SZ,
+              (unsigned long)cursor_us, (unsigned long)by_index_us);
+}
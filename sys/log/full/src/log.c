@@ -934,6 +934,105 @@ err:
     return rc;
 }
 
+/**
+ * Argument passed to the handler's walk function to perform a cursor walk.
+ */
+struct log_walk_cursor_arg {
+    /** The body walk function to call on each entry. */
+    log_walk_body_func_t fn;
+
+    /** The original argument passed to `log_walk_body_cursor`. */
+    void *arg;
+
+    /** The cursor being advanced. */
+    struct log_cursor *cursor;
+};
+
+/**
+ * Performs a cursor walk on a single log entry.  Entries the cursor has
+ * already moved past are skipped; the cursor is advanced past each entry
+ * the callback consumes.
+ */
+static int
+log_walk_cursor_fn(struct log *log, struct log_offset *log_offset,
+                   const void *dptr, uint16_t len)
+{
+    struct log_walk_cursor_arg *lwca;
+    struct log_entry_hdr ueh;
+    int rc;
+
+    lwca = log_offset->lo_arg;
+
+    rc = log_read_hdr(log, dptr, &ueh);
+    if (rc != 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_FCB) || MYNEWT_VAL(LOG_FCB2)
+    /* The handler has recorded this entry's location; tag it with the index
+     * so that the location can be verified before it is resumed from.
+     */
+    lwca->cursor->lc_loc_index = ueh.ue_index;
+    lwca->cursor->lc_loc_valid = 1;
+#endif
+
+    if (ueh.ue_index < lwca->cursor->lc_index) {
+        return 0;
+    }
+
+    len -= log_hdr_len(&ueh);
+
+    log_offset->lo_arg = lwca->arg;
+    rc = lwca->fn(log, log_offset, &ueh, dptr, len);
+    log_offset->lo_arg = lwca;
+
+    if (rc == 0) {
+        lwca->cursor->lc_index = ueh.ue_index + 1;
+    }
+
+    return rc;
+}
+
+void
+log_cursor_init(struct log_cursor *cursor, struct log *log, uint32_t index)
+{
+    memset(cursor, 0, sizeof *cursor);
+    cursor->lc_log = log;
+    cursor->lc_index = index;
+}
+
+int
+log_walk_body_cursor(struct log_cursor *cursor,
+                     log_walk_body_func_t walk_body_func, void *arg)
+{
+    struct log_walk_cursor_arg lwca = {
+        .fn = walk_body_func,
+        .arg = arg,
+        .cursor = cursor,
+    };
+    struct log_offset log_offset = {
+        .lo_ts = 0,
+        .lo_index = cursor->lc_index,
+        .lo_arg = &lwca,
+    };
+    struct log *log;
+    int rc;
+
+    log = cursor->lc_log;
+
+    if (log->l_log->log_walk_cursor != NULL) {
+        rc = log->l_log->log_walk_cursor(log, log_walk_cursor_fn, &log_offset,
+                                         cursor);
+    } else {
+        rc = log->l_log->log_walk(log, log_walk_cursor_fn, &log_offset);
+    }
+
+    if (rc > 0) {
+        rc = 0;
+    }
+    return rc;
+}
+
 /**
  * Reads from the specified log.
  *
@@ -639,6 +639,81 @@ log_fcb_walk_area(struct log *log, log_walk_func_t walk_func,
     return log_fcb_walk_impl(log, walk_func, log_offset, true);
 }
 
+/**
+ * Determines whether a cursor's recorded location can be resumed from: it
+ * must still hold the entry it was recorded for.
+ */
+static bool
+log_fcb_cursor_loc_ok(struct log *log, const struct log_cursor *cursor)
+{
+    struct log_entry_hdr hdr;
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = log->l_arg;
+
+    if (!cursor->lc_loc_valid) {
+        return false;
+    }
+
+    /* The location must still be in one of the log's sectors... */
+    if (cursor->lc_loc.fe_area < fcb_log->fl_fcb.f_sectors ||
+        cursor->lc_loc.fe_area >=
+            fcb_log->fl_fcb.f_sectors + fcb_log->fl_fcb.f_sector_cnt) {
+        return false;
+    }
+
+    /* ...and hold the same entry.  Indices only grow, so an entry written
+     * after the sector got rotated out has a different one.
+     */
+    rc = log_read_hdr(log, &cursor->lc_loc, &hdr);
+    return rc == 0 && hdr.ue_index == cursor->lc_loc_index;
+}
+
+static int
+log_fcb_walk_cursor(struct log *log, log_walk_func_t walk_func,
+                    struct log_offset *log_offset, struct log_cursor *cursor)
+{
+    struct fcb_log *fcb_log;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (log_fcb_cursor_loc_ok(log, cursor)) {
+        loc = cursor->lc_loc;
+    } else {
+        rc = log_fcb_find_gte(log, log_offset, &loc);
+        switch (rc) {
+        case 0:
+            break;
+        case SYS_ENOENT:
+            return 0;
+        default:
+            return rc;
+        }
+    }
+
+    do {
+        /* The walk function tags the location with the entry's index. */
+        cursor->lc_loc = loc;
+        cursor->lc_loc_valid = 0;
+
+        rc = walk_func(log, log_offset, &loc, loc.fe_data_len);
+        if (rc != 0) {
+            if (rc < 0) {
+                return rc;
+            } else {
+                return 0;
+            }
+        }
+    } while (fcb_getnext(fcb, &loc) == 0);
+
+    return 0;
+}
+
 static int
 log_fcb_flush(struct log *log)
 {
@@ -981,6 +1056,7 @@ const struct log_handler log_fcb_handler = {
     .log_append_mbuf_body = log_fcb_append_mbuf_body,
     .log_walk             = log_fcb_walk,
     .log_walk_sector      = log_fcb_walk_area,
+    .log_walk_cursor      = log_fcb_walk_cursor,
     .log_flush            = log_fcb_flush,
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     .log_storage_info     = log_fcb_storage_info,
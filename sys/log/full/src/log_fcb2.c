@@ -516,6 +516,82 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
     return 0;
 }
 
+/**
+ * Determines whether a cursor's recorded location can be resumed from: it
+ * must still hold the entry it was recorded for.
+ */
+static bool
+log_fcb2_cursor_loc_ok(struct log *log, const struct log_cursor *cursor)
+{
+    struct log_entry_hdr hdr;
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = log->l_arg;
+
+    if (!cursor->lc_loc_valid) {
+        return false;
+    }
+
+    /* The location must still be in one of the log's sectors... */
+    if (cursor->lc_loc.fe_range < fcb_log->fl_fcb.f_ranges ||
+        cursor->lc_loc.fe_range >=
+            fcb_log->fl_fcb.f_ranges + fcb_log->fl_fcb.f_range_cnt ||
+        cursor->lc_loc.fe_sector >= fcb_log->fl_fcb.f_sector_cnt) {
+        return false;
+    }
+
+    /* ...and hold the same entry.  Indices only grow, so an entry written
+     * after the sector got rotated out has a different one.
+     */
+    rc = log_read_hdr(log, &cursor->lc_loc, &hdr);
+    return rc == 0 && hdr.ue_index == cursor->lc_loc_index;
+}
+
+static int
+log_fcb2_walk_cursor(struct log *log, log_walk_func_t walk_func,
+                     struct log_offset *log_off, struct log_cursor *cursor)
+{
+    struct fcb_log *fcb_log;
+    struct fcb2_entry loc;
+    struct fcb2 *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (log_fcb2_cursor_loc_ok(log, cursor)) {
+        loc = cursor->lc_loc;
+    } else {
+        rc = log_fcb2_find_gte(log, log_off, &loc);
+        switch (rc) {
+        case 0:
+            break;
+        case SYS_ENOENT:
+            return 0;
+        default:
+            return rc;
+        }
+    }
+
+    do {
+        /* The walk function tags the location with the entry's index. */
+        cursor->lc_loc = loc;
+        cursor->lc_loc_valid = 0;
+
+        rc = walk_func(log, log_off, &loc, loc.fe_data_len);
+        if (rc != 0) {
+            if (rc < 0) {
+                return rc;
+            } else {
+                return 0;
+            }
+        }
+    } while (fcb2_getnext(fcb, &loc) == 0);
+
+    return 0;
+}
+
 static int
 log_fcb2_flush(struct log *log)
 {
@@ -894,6 +970,7 @@ const struct log_handler log_fcb_handler = {
     .log_append_mbuf = log_fcb2_append_mbuf,
     .log_append_mbuf_body = log_fcb2_append_mbuf_body,
     .log_walk = log_fcb2_walk,
+    .log_walk_cursor = log_fcb2_walk_cursor,
     .log_flush = log_fcb2_flush,
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     .log_storage_info = log_fcb2_storage_info,
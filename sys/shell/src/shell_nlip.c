@@ -34,6 +34,12 @@
  */
 #define MGMT_NLIP_MAX_FRAME     127
 
+/* Source bytes carried by one frame.  A multiple of 3, so that only the last
+ * frame of a packet ends in padding; base64 encoded, plus the frame header
+ * and newline, it fits in MGMT_NLIP_MAX_FRAME.
+ */
+#define SHELL_NLIP_FRAME_DATA_MAX   90
+
 static shell_nlip_input_func_t g_shell_nlip_in_func;
 static void *g_shell_nlip_in_arg;
 static struct os_mqueue g_shell_nlip_mq;
@@ -55,7 +61,6 @@ shell_nlip_process(char *data, int len)
 {
     uint16_t copy_len;
     int rc;
-    struct os_mbuf *m;
     uint16_t crc;
 
     /* Trim trailing newline. */
@@ -99,9 +104,7 @@ shell_nlip_process(char *data, int len)
     if (OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len == g_nlip_expected_len) {
         if (g_shell_nlip_in_func) {
             crc = CRC16_INITIAL_CRC;
-            for (m = g_nlip_mbuf; m; m = SLIST_NEXT(m, om_next)) {
-                crc = crc16_ccitt(crc, m->om_data, m->om_len);
-            }
+            crc16_ccitt_mbuf(g_nlip_mbuf, 0, g_nlip_expected_len, &crc);
             if (crc == 0 && g_nlip_expected_len >= sizeof(crc)) {
                 os_mbuf_adj(g_nlip_mbuf, -sizeof(crc));
                 g_shell_nlip_in_func(g_nlip_mbuf, g_shell_nlip_in_arg);
@@ -120,24 +123,20 @@ err:
     return (rc);
 }
 
+/**
+ * Writes a packet to the console as a series of NLIP frames.  The packet is
+ * freed.
+ */
 static int
 shell_nlip_mtx(struct os_mbuf *m)
 {
-#define SHELL_NLIP_MTX_BUF_SIZE (12)
-    uint8_t readbuf[SHELL_NLIP_MTX_BUF_SIZE];
-    char encodebuf[BASE64_ENCODE_SIZE(SHELL_NLIP_MTX_BUF_SIZE)];
-    char pkt_seq[3] = { '\n', SHELL_NLIP_PKT_START1, SHELL_NLIP_PKT_START2 };
-    char esc_seq[2] = { SHELL_NLIP_DATA_START1, SHELL_NLIP_DATA_START2 };
+    char frame[2 + BASE64_ENCODE_SIZE(SHELL_NLIP_FRAME_DATA_MAX) + 1];
     uint16_t totlen;
     uint16_t dlen;
     uint16_t off;
     uint16_t crc;
-    int rb_off;
     int elen;
-    uint16_t bodylen;
-    uint16_t newbodylen;
     int rc;
-    struct os_mbuf *tmp;
     void *ptr;
 
     /* Convert the mbuf into a packet.
@@ -154,9 +153,7 @@ shell_nlip_mtx(struct os_mbuf *m)
      * buffer has been sent.
      */
     crc = CRC16_INITIAL_CRC;
-    for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
-        crc = crc16_ccitt(crc, tmp->om_data, tmp->om_len);
-    }
+    crc16_ccitt_mbuf(m, 0, OS_MBUF_PKTLEN(m), &crc);
     crc = htons(crc);
     ptr = os_mbuf_extend(m, sizeof(crc));
     if (!ptr) {
@@ -165,10 +162,15 @@ shell_nlip_mtx(struct os_mbuf *m)
     }
     memcpy(ptr, &crc, sizeof(crc));
 
-    totlen = OS_MBUF_PKTHDR(m)->omp_len;
-    off = 0;
-    bodylen = 0;
-    rb_off = 0;
+    /* The packet length is encoded along with the data. */
+    totlen = htons(OS_MBUF_PKTLEN(m));
+    m = os_mbuf_prepend(m, sizeof(totlen));
+    if (!m) {
+        rc = -1;
+        goto err;
+    }
+    memcpy(m->om_data, &totlen, sizeof(totlen));
+    totlen = OS_MBUF_PKTLEN(m);
 
     rc = console_lock(OS_TICKS_PER_SEC);
     if (rc != OS_OK) {
@@ -176,62 +178,34 @@ shell_nlip_mtx(struct os_mbuf *m)
     }
 
     /* Start a packet */
-    console_write(pkt_seq, sizeof(pkt_seq));
-
-    /* Encode the packet length. */
-    dlen = htons(totlen);
-    memcpy(readbuf, &dlen, sizeof(dlen));
-    rb_off += 2;
-
-    while (totlen > 0) {
-        /* Calculate number of source bytes to include in this chunk. */
-        dlen = min(SHELL_NLIP_MTX_BUF_SIZE - rb_off, totlen);
-
-        /* If appending this chunk to the current line causes the line to be
-         * too long, terminate the line before emitting the chunk.
-         *
-         * Total line length:
-         *     2                       +    // Frame header.
-         *     bodylen                 +    // Body bytes already emitted.
-         *     BASE64_ENCODE_SIZE(...) +    // Next chunk.
-         *     1                            // Terminating newline.
-         */
-        newbodylen = 2 + bodylen + BASE64_ENCODE_SIZE(dlen + rb_off) + 1;
-        if (newbodylen > MGMT_NLIP_MAX_FRAME) {
-            /* The chunk won't fit.  Terminate the current line. */
-            elen = base64_pad(encodebuf, bodylen);
-            console_write(encodebuf, elen);
-            console_write("\n", 1);
-
-            /* Begin the next frame. */
-            console_write(esc_seq, sizeof(esc_seq));
-            bodylen = 0;
-        } else {
-            /* The chunk will fit.  Emit it. */
-            rc = os_mbuf_copydata(m, off, dlen, readbuf + rb_off);
-            if (rc != 0) {
-                goto end;
-            }
+    console_write("\n", 1);
+    frame[0] = SHELL_NLIP_PKT_START1;
+    frame[1] = SHELL_NLIP_PKT_START2;
 
-            elen = base64_encode(readbuf, dlen + rb_off, encodebuf, 0);
-            console_write(encodebuf, elen);
-            bodylen += elen;
-            totlen -= dlen;
-            off += dlen;
+    for (off = 0; off < totlen; off += dlen) {
+        if (off != 0) {
+            frame[0] = SHELL_NLIP_DATA_START1;
+            frame[1] = SHELL_NLIP_DATA_START2;
         }
 
-        rb_off = 0;
+        /* Encode one line straight from the packet.  Only the last line can
+         * end in padding.
+         */
+        dlen = min(totlen - off, SHELL_NLIP_FRAME_DATA_MAX);
+        elen = base64_encode_mbuf(m, off, dlen, frame + 2, 1);
+        if (elen < 0) {
+            rc = -1;
+            goto end;
+        }
+        frame[2 + elen] = '\n';
+        console_write(frame, 2 + elen + 1);
     }
 
-    /* The final line was never terminated.  Terminate it now. */ 
-    elen = base64_pad(encodebuf, bodylen);
-    console_write(encodebuf, elen);
-    console_write("\n", 1);
-
 end:
     (void)console_unlock();
 
 err:
+    os_mbuf_free_chain(m);
     return (rc);
 }
 
@@ -255,9 +229,7 @@ shell_event_data_in(struct os_event *ev)
 {
     struct os_mbuf *m;
 
-    /* Copy data out of the mbuf 12 bytes at a time and write it to
-     * the console.
-     */
+    /* Encode each packet and write it to the console. */
     while (1) {
         m = os_mqueue_get(&g_shell_nlip_mq);
         if (!m) {
@@ -265,8 +237,6 @@ shell_event_data_in(struct os_event *ev)
         }
 
         (void) shell_nlip_mtx(m);
-
-        os_mbuf_free_chain(m);
     }
 }
 
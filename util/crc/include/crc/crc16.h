@@ -34,8 +34,24 @@
 extern "C" {
 #endif
 
+struct os_mbuf;
+
 #define CRC16_INITIAL_CRC       0       /* what to seed crc16 with */
 unsigned short crc16_ccitt(uint16_t initial_crc, const void *buf, int len);
+uint16_t crc16_ccitt_sw(uint16_t initial_crc, const void *buf, int len);
+
+/**
+ * Continues a CRC16-CCITT over len bytes of an mbuf chain, starting at
+ * offset off.
+ *
+ * @param crc                   On input, the CRC to continue from; on
+ *                                  success, the updated CRC.
+ *
+ * @return                      0 on success; -1 if the chain is shorter
+ *                                  than off + len.
+ */
+int crc16_ccitt_mbuf(const struct os_mbuf *om, int off, int len,
+                     uint16_t *crc);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC32_H_
+#define _UTIL_CRC32_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_mbuf;
+
+/*
+ * CRC-32 as used by zlib, Ethernet and PNG (reflected polynomial 0xedb88320).
+ * The pre- and post-inversion is done internally, so a running CRC can be
+ * passed back in to continue over the next buffer.
+ */
+#define CRC32_INITIAL_CRC       0
+
+uint32_t crc32_calc(uint32_t crc, const void *buf, int len);
+uint32_t crc32_calc_sw(uint32_t crc, const void *buf, int len);
+
+/**
+ * Continues a CRC-32 over len bytes of an mbuf chain, starting at offset off.
+ *
+ * @param crc                   On input, the CRC to continue from; on
+ *                                  success, the updated CRC.
+ *
+ * @return                      0 on success; -1 if the chain is shorter
+ *                                  than off + len.
+ */
+int crc32_calc_mbuf(const struct os_mbuf *om, int off, int len,
+                    uint32_t *crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -30,8 +30,22 @@
 extern "C" {
 #endif
 
+struct os_mbuf;
+
 uint8_t crc8_init(void);
-uint8_t crc8_calc(uint8_t val, void *buf, int cnt);
+uint8_t crc8_calc(uint8_t val, const void *buf, int cnt);
+uint8_t crc8_calc_sw(uint8_t val, const void *buf, int cnt);
+
+/**
+ * Continues a CRC8 over len bytes of an mbuf chain, starting at offset off.
+ *
+ * @param crc                   On input, the CRC to continue from; on
+ *                                  success, the updated CRC.
+ *
+ * @return                      0 on success; -1 if the chain is shorter
+ *                                  than off + len.
+ */
+int crc8_calc_mbuf(const struct os_mbuf *om, int off, int len, uint8_t *crc);
 
 #ifdef __cplusplus
 }
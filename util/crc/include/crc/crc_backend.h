@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_CRC_BACKEND_
+#define H_CRC_BACKEND_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hooks for offloading CRC computation to a peripheral.  Each hook has the
+ * same contract as the corresponding software routine (crc8_calc_sw(),
+ * crc16_ccitt_sw(), crc32_calc_sw()), including continuing from the CRC it
+ * is passed.  A NULL hook leaves that CRC in software.
+ *
+ * The hooks may be called from any task, and from interrupt context if the
+ * application computes CRCs there; the backend does its own locking.
+ */
+struct crc_backend {
+    uint8_t (*cb_crc8)(uint8_t crc, const void *buf, int len);
+    uint16_t (*cb_crc16_ccitt)(uint16_t crc, const void *buf, int len);
+    uint32_t (*cb_crc32)(uint32_t crc, const void *buf, int len);
+
+    /* Buffers shorter than this are done in software; for short inputs,
+     * setting up the peripheral costs more than the table lookups.
+     */
+    int cb_min_len;
+};
+
+/**
+ * Installs a CRC backend.  Requires CRC_BACKEND to be enabled.
+ *
+ * @param cb                    The backend to use; NULL to go back to
+ *                                  software.  The structure must stay valid
+ *                                  while it is installed.
+ */
+void crc_backend_set(const struct crc_backend *cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
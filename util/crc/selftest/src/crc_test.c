@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+#define CRC_TEST_POOL_BUF_SIZE   \
+    (sizeof(struct os_mbuf) + sizeof(struct os_mbuf_pkthdr) + 32)
+#define CRC_TEST_POOL_BUF_COUNT  400
+
+static os_membuf_t crc_test_membuf[
+    OS_MEMPOOL_SIZE(CRC_TEST_POOL_BUF_COUNT, CRC_TEST_POOL_BUF_SIZE)];
+static struct os_mempool crc_test_mempool;
+static struct os_mbuf_pool crc_test_mbuf_pool;
+
+static void
+crc_test_init(void)
+{
+    int rc;
+
+    rc = os_mempool_init(&crc_test_mempool, CRC_TEST_POOL_BUF_COUNT,
+                         CRC_TEST_POOL_BUF_SIZE, crc_test_membuf,
+                         "crc_test");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(&crc_test_mbuf_pool, &crc_test_mempool,
+                           CRC_TEST_POOL_BUF_SIZE, CRC_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+uint8_t
+crc_test_ref8(uint8_t crc, const void *buf, int len)
+{
+    const uint8_t *p;
+    int i;
+
+    for (p = buf; len > 0; len--, p++) {
+        crc ^= *p;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t
+crc_test_ref16(uint16_t crc, const void *buf, int len)
+{
+    const uint8_t *p;
+    int i;
+
+    for (p = buf; len > 0; len--, p++) {
+        crc ^= *p << 8;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint32_t
+crc_test_ref32(uint32_t crc, const void *buf, int len)
+{
+    const uint8_t *p;
+    int i;
+
+    crc = ~crc;
+    for (p = buf; len > 0; len--, p++) {
+        crc ^= *p;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+void
+crc_test_fill(uint8_t *buf, int len)
+{
+    uint32_t x;
+    int i;
+
+    x = 0x2545f491;
+    for (i = 0; i < len; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = x >> 16;
+    }
+}
+
+/**
+ * Builds a packet holding the specified data, split into mbufs of at most
+ * chunk bytes each (chunk <= 32).
+ */
+struct os_mbuf *
+crc_test_chain(const void *data, int len, int chunk)
+{
+    struct os_mbuf *prev;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int off;
+    int n;
+
+    om = os_mbuf_get_pkthdr(&crc_test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    prev = om;
+    for (off = 0; off < len; off += n) {
+        if (off == 0) {
+            m = om;
+        } else {
+            m = os_mbuf_get(&crc_test_mbuf_pool, 0);
+            TEST_ASSERT_FATAL(m != NULL);
+            SLIST_NEXT(prev, om_next) = m;
+        }
+
+        n = min(chunk, len - off);
+        TEST_ASSERT_FATAL(n <= OS_MBUF_TRAILINGSPACE(m));
+        memcpy(m->om_data, (const uint8_t *)data + off, n);
+        m->om_len = n;
+        OS_MBUF_PKTHDR(om)->omp_len += n;
+
+        prev = m;
+    }
+
+    return om;
+}
+
+TEST_SUITE(crc_test_suite)
+{
+    crc_test_init();
+
+    crc_check();
+    crc_slice();
+    crc_mbuf();
+    crc_backend_hook();
+    crc_perf();
+}
+
+int
+main(int argc, char **argv)
+{
+    crc_test_suite();
+    return tu_any_failed;
+}
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_CRC_TEST_PRIV_
+#define H_CRC_TEST_PRIV_
+
+#include "testutil/testutil.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+#include "crc/crc_backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TEST_CASE_DECL(crc_check);
+TEST_CASE_DECL(crc_slice);
+TEST_CASE_DECL(crc_mbuf);
+TEST_CASE_DECL(crc_backend_hook);
+TEST_CASE_DECL(crc_perf);
+
+/* Bit-at-a-time reference implementations. */
+uint8_t crc_test_ref8(uint8_t crc, const void *buf, int len);
+uint16_t crc_test_ref16(uint16_t crc, const void *buf, int len);
+uint32_t crc_test_ref32(uint32_t crc, const void *buf, int len);
+
+void crc_test_fill(uint8_t *buf, int len);
+struct os_mbuf *crc_test_chain(const void *data, int len, int chunk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
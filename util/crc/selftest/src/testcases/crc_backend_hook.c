@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+static int crc_backend_calls;
+
+/* Stand-in for a peripheral: counts calls, defers to the software CRC. */
+static uint8_t
+crc_backend_crc8(uint8_t crc, const void *buf, int len)
+{
+    crc_backend_calls++;
+    return crc8_calc_sw(crc, buf, len);
+}
+
+static uint16_t
+crc_backend_crc16(uint16_t crc, const void *buf, int len)
+{
+    crc_backend_calls++;
+    return crc16_ccitt_sw(crc, buf, len);
+}
+
+static uint32_t
+crc_backend_crc32(uint32_t crc, const void *buf, int len)
+{
+    crc_backend_calls++;
+    return crc32_calc_sw(crc, buf, len);
+}
+
+TEST_CASE_SELF(crc_backend_hook)
+{
+    struct crc_backend cb = {
+        .cb_crc8 = crc_backend_crc8,
+        .cb_crc16_ccitt = crc_backend_crc16,
+        .cb_crc32 = crc_backend_crc32,
+        .cb_min_len = 16,
+    };
+    uint8_t data[64];
+    struct os_mbuf *om;
+    uint16_t crc16;
+
+    crc_test_fill(data, sizeof data);
+    crc_backend_calls = 0;
+    crc_backend_set(&cb);
+
+    /* Short buffers stay in software. */
+    TEST_ASSERT(crc8_calc(0xff, data, 15) == crc8_calc_sw(0xff, data, 15));
+    TEST_ASSERT(crc16_ccitt(0, data, 15) == crc16_ccitt_sw(0, data, 15));
+    TEST_ASSERT(crc32_calc(0, data, 15) == crc32_calc_sw(0, data, 15));
+    TEST_ASSERT(crc_backend_calls == 0);
+
+    TEST_ASSERT(crc8_calc(0xff, data, 16) == crc8_calc_sw(0xff, data, 16));
+    TEST_ASSERT(crc16_ccitt(0, data, 16) == crc16_ccitt_sw(0, data, 16));
+    TEST_ASSERT(crc32_calc(0, data, 64) == crc32_calc_sw(0, data, 64));
+    TEST_ASSERT(crc_backend_calls == 3);
+
+    /* The mbuf variants go through the backend one mbuf at a time. */
+    om = crc_test_chain(data, sizeof data, 32);
+    crc16 = 0;
+    TEST_ASSERT(crc16_ccitt_mbuf(om, 0, sizeof data, &crc16) == 0);
+    TEST_ASSERT(crc16 == crc16_ccitt_sw(0, data, sizeof data));
+    TEST_ASSERT(crc_backend_calls == 5);
+    os_mbuf_free_chain(om);
+
+    /* A NULL hook leaves that CRC in software. */
+    cb.cb_crc32 = NULL;
+    TEST_ASSERT(crc32_calc(0, data, 64) == crc32_calc_sw(0, data, 64));
+    TEST_ASSERT(crc_backend_calls == 5);
+
+    crc_backend_set(NULL);
+    TEST_ASSERT(crc16_ccitt(0, data, 64) == crc16_ccitt_sw(0, data, 64));
+    TEST_ASSERT(crc_backend_calls == 5);
+}
@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+/* Standard check values: the CRC of the ASCII string "123456789". */
+TEST_CASE_SELF(crc_check)
+{
+    static const char check[] = "123456789";
+    uint32_t crc32;
+    uint16_t crc16;
+    uint8_t crc8;
+
+    TEST_ASSERT(crc8_calc(crc8_init(), check, 9) == 0xfb);
+    TEST_ASSERT(crc16_ccitt(CRC16_INITIAL_CRC, check, 9) == 0x31c3);
+    TEST_ASSERT(crc16_ccitt(0xffff, check, 9) == 0x29b1);
+    TEST_ASSERT(crc32_calc(CRC32_INITIAL_CRC, check, 9) == 0xcbf43926);
+
+    /* Zero-length input leaves the CRC alone. */
+    TEST_ASSERT(crc8_calc(0x5a, check, 0) == 0x5a);
+    TEST_ASSERT(crc16_ccitt(0x1234, check, 0) == 0x1234);
+    TEST_ASSERT(crc32_calc(0x12345678, check, 0) == 0x12345678);
+
+    /* A running CRC continues across calls. */
+    crc8 = crc8_calc(crc8_init(), check, 4);
+    TEST_ASSERT(crc8_calc(crc8, check + 4, 5) == 0xfb);
+    crc16 = crc16_ccitt(CRC16_INITIAL_CRC, check, 2);
+    TEST_ASSERT(crc16_ccitt(crc16, check + 2, 7) == 0x31c3);
+    crc32 = crc32_calc(CRC32_INITIAL_CRC, check, 7);
+    TEST_ASSERT(crc32_calc(crc32, check + 7, 2) == 0xcbf43926);
+}
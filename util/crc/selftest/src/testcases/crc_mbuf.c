@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+#define CRC_MBUF_DATA_LEN       300
+
+static void
+crc_mbuf_check(const uint8_t *data, struct os_mbuf *om, int off, int len)
+{
+    uint32_t crc32;
+    uint16_t crc16;
+    uint8_t crc8;
+    int rc;
+
+    crc8 = crc8_init();
+    rc = crc8_calc_mbuf(om, off, len, &crc8);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(crc8 == crc_test_ref8(crc8_init(), data + off, len));
+
+    crc16 = CRC16_INITIAL_CRC;
+    rc = crc16_ccitt_mbuf(om, off, len, &crc16);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(crc16 == crc_test_ref16(CRC16_INITIAL_CRC, data + off, len));
+
+    crc32 = CRC32_INITIAL_CRC;
+    rc = crc32_calc_mbuf(om, off, len, &crc32);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(crc32 == crc_test_ref32(CRC32_INITIAL_CRC, data + off, len));
+}
+
+TEST_CASE_SELF(crc_mbuf)
+{
+    static const int chunks[] = { 1, 3, 7, 16, 32 };
+    uint8_t data[CRC_MBUF_DATA_LEN];
+    struct os_mbuf *om;
+    uint32_t crc32;
+    uint16_t crc16;
+    uint8_t crc8;
+    int off;
+    int rc;
+    int i;
+
+    crc_test_fill(data, sizeof data);
+
+    for (i = 0; i < sizeof chunks / sizeof chunks[0]; i++) {
+        om = crc_test_chain(data, sizeof data, chunks[i]);
+
+        crc_mbuf_check(data, om, 0, sizeof data);
+        crc_mbuf_check(data, om, 0, 0);
+        crc_mbuf_check(data, om, sizeof data, 0);
+        for (off = 0; off < 40; off += 3) {
+            crc_mbuf_check(data, om, off, sizeof data - off);
+            crc_mbuf_check(data, om, off, 17);
+        }
+
+        /* Chain too short; the CRC is left alone. */
+        crc8 = 0x11;
+        rc = crc8_calc_mbuf(om, 1, sizeof data, &crc8);
+        TEST_ASSERT(rc == -1);
+        TEST_ASSERT(crc8 == 0x11);
+
+        crc16 = 0x2222;
+        rc = crc16_ccitt_mbuf(om, sizeof data + 1, 0, &crc16);
+        TEST_ASSERT(rc == -1);
+        TEST_ASSERT(crc16 == 0x2222);
+
+        crc32 = 0x33333333;
+        rc = crc32_calc_mbuf(om, sizeof data - 4, 5, &crc32);
+        TEST_ASSERT(rc == -1);
+        TEST_ASSERT(crc32 == 0x33333333);
+
+        os_mbuf_free_chain(om);
+    }
+}
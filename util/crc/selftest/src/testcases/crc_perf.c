@@ -0,0 +1,145 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+#define CRC_PERF_BYTES          (256 * 1024)
+
+/* Element and frame sizes: a small FCB entry, an SMP/NLIP serial frame, and
+ * a flash page.
+ */
+static const int crc_perf_sizes[] = { 16, 127, 4096 };
+
+/*
+ * Reference: one table lookup per byte, as crc8.c (nibble table), crc16.c
+ * and a typical CRC-32 did before slicing.
+ */
+static uint8_t crc_perf_tab8[16];
+static uint16_t crc_perf_tab16[256];
+static uint32_t crc_perf_tab32[256];
+
+static void
+crc_perf_tables(void)
+{
+    uint8_t b;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        b = i;
+        crc_perf_tab8[i] = crc_test_ref8(0, &b, 1);
+    }
+    for (i = 0; i < 256; i++) {
+        b = i;
+        crc_perf_tab16[i] = crc_test_ref16(0, &b, 1);
+        crc_perf_tab32[i] = ~crc_test_ref32(0xffffffff, &b, 1);
+    }
+}
+
+static uint8_t
+crc_perf_ref8(uint8_t crc, const uint8_t *p, int len)
+{
+    while (len-- > 0) {
+        crc ^= *p++;
+        crc = (crc << 4) ^ crc_perf_tab8[crc >> 4];
+        crc = (crc << 4) ^ crc_perf_tab8[crc >> 4];
+    }
+    return crc;
+}
+
+static uint16_t
+crc_perf_ref16(uint16_t crc, const uint8_t *p, int len)
+{
+    while (len-- > 0) {
+        crc = (crc << 8) ^ crc_perf_tab16[((crc >> 8) ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+static uint32_t
+crc_perf_ref32(uint32_t crc, const uint8_t *p, int len)
+{
+    crc = ~crc;
+    while (len-- > 0) {
+        crc = (crc >> 8) ^ crc_perf_tab32[(crc ^ *p++) & 0xff];
+    }
+    return ~crc;
+}
+
+/*
+ * Runs each CRC over CRC_PERF_BYTES of data in pieces of each size, with the
+ * byte-wise reference and with the sliced implementation.
+ */
+TEST_CASE_SELF(crc_perf)
+{
+    static uint8_t data[4096];
+    uint32_t us[3][2];
+    uint32_t r32[2];
+    uint16_t r16[2];
+    uint8_t r8[2];
+    int64_t start;
+    int size;
+    int s;
+    int i;
+
+    crc_perf_tables();
+    crc_test_fill(data, sizeof data);
+    TEST_ASSERT_FATAL(crc_perf_ref32(0, data, 9) ==
+                      crc_test_ref32(0, data, 9));
+    TEST_ASSERT_FATAL(crc_perf_ref8(0xff, data, 9) ==
+                      crc_test_ref8(0xff, data, 9));
+
+    for (s = 0; s < sizeof crc_perf_sizes / sizeof crc_perf_sizes[0]; s++) {
+        size = crc_perf_sizes[s];
+        memset(r8, 0, sizeof r8);
+        memset(r16, 0, sizeof r16);
+        memset(r32, 0, sizeof r32);
+
+        start = os_get_uptime_usec();
+        for (i = 0; i < CRC_PERF_BYTES / size; i++) {
+            r8[0] = crc_perf_ref8(r8[0], data, size);
+            r16[0] = crc_perf_ref16(r16[0], data, size);
+            r32[0] = crc_perf_ref32(r32[0], data, size);
+        }
+        us[s][0] = os_get_uptime_usec() - start;
+
+        start = os_get_uptime_usec();
+        for (i = 0; i < CRC_PERF_BYTES / size; i++) {
+            r8[1] = crc8_calc_sw(r8[1], data, size);
+            r16[1] = crc16_ccitt_sw(r16[1], data, size);
+            r32[1] = crc32_calc_sw(r32[1], data, size);
+        }
+        us[s][1] = os_get_uptime_usec() - start;
+
+        TEST_ASSERT(r8[0] == r8[1]);
+        TEST_ASSERT(r16[0] == r16[1]);
+        TEST_ASSERT(r32[0] == r32[1]);
+    }
+
+    TEST_PASS("%d KB of crc8+crc16+crc32, byte-wise/sliced by %d: "
+              "%d-byte pieces %lu/%lu us, %d-byte %lu/%lu us, "
+              "%d-byte %lu/%lu us",
+              CRC_PERF_BYTES / 1024, MYNEWT_VAL(CRC_SLICE_BY),
+              crc_perf_sizes[0], (unsigned long)us[0][0],
+              (unsigned long)us[0][1],
+              crc_perf_sizes[1], (unsigned long)us[1][0],
+              (unsigned long)us[1][1],
+              crc_perf_sizes[2], (unsigned long)us[2][0],
+              (unsigned long)us[2][1]);
+}
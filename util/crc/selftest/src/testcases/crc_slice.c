@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc_test_priv.h"
+
+#define CRC_SLICE_DATA_LEN      80
+
+/*
+ * Compares the sliced routines with the bitwise reference for every length
+ * and start alignment up to a few slices, and with the input split in two
+ * at every point.
+ */
+TEST_CASE_SELF(crc_slice)
+{
+    uint8_t data[CRC_SLICE_DATA_LEN + 8];
+    const uint8_t *p;
+    uint32_t crc32;
+    uint16_t crc16;
+    uint8_t crc8;
+    int align;
+    int split;
+    int len;
+
+    crc_test_fill(data, sizeof data);
+
+    for (align = 0; align < 8; align++) {
+        p = data + align;
+        for (len = 0; len <= CRC_SLICE_DATA_LEN; len++) {
+            TEST_ASSERT_FATAL(crc8_calc_sw(0xff, p, len) ==
+                              crc_test_ref8(0xff, p, len));
+            TEST_ASSERT_FATAL(crc16_ccitt_sw(0, p, len) ==
+                              crc_test_ref16(0, p, len));
+            TEST_ASSERT_FATAL(crc16_ccitt_sw(0xffff, p, len) ==
+                              crc_test_ref16(0xffff, p, len));
+            TEST_ASSERT_FATAL(crc32_calc_sw(0, p, len) ==
+                              crc_test_ref32(0, p, len));
+        }
+    }
+
+    for (split = 0; split <= CRC_SLICE_DATA_LEN; split++) {
+        crc8 = crc8_calc_sw(0xff, data, split);
+        crc8 = crc8_calc_sw(crc8, data + split, CRC_SLICE_DATA_LEN - split);
+        TEST_ASSERT(crc8 == crc_test_ref8(0xff, data, CRC_SLICE_DATA_LEN));
+
+        crc16 = crc16_ccitt_sw(0, data, split);
+        crc16 = crc16_ccitt_sw(crc16, data + split,
+                               CRC_SLICE_DATA_LEN - split);
+        TEST_ASSERT(crc16 == crc_test_ref16(0, data, CRC_SLICE_DATA_LEN));
+
+        crc32 = crc32_calc_sw(0, data, split);
+        crc32 = crc32_calc_sw(crc32, data + split, CRC_SLICE_DATA_LEN - split);
+        TEST_ASSERT(crc32 == crc_test_ref32(0, data, CRC_SLICE_DATA_LEN));
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+
+typedef void crc_mbuf_fn(void *crc, const void *buf, int len);
+
+/**
+ * Feeds len bytes of an mbuf chain, starting at offset off, to the specified
+ * function one mbuf at a time.  Nothing is copied.
+ */
+static int
+crc_mbuf_walk(const struct os_mbuf *om, int off, int len, crc_mbuf_fn *fn,
+              void *crc)
+{
+    int chunk;
+
+    if (off < 0 || len < 0) {
+        return -1;
+    }
+
+    while (om != NULL && off >= om->om_len) {
+        off -= om->om_len;
+        om = SLIST_NEXT(om, om_next);
+    }
+    if (om == NULL && off > 0) {
+        return -1;
+    }
+
+    while (len > 0) {
+        if (om == NULL) {
+            return -1;
+        }
+
+        chunk = min(om->om_len - off, len);
+        fn(crc, om->om_data + off, chunk);
+        len -= chunk;
+        off = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return 0;
+}
+
+static void
+crc8_mbuf_fn(void *crc, const void *buf, int len)
+{
+    uint8_t *c;
+
+    c = crc;
+    *c = crc8_calc(*c, buf, len);
+}
+
+static void
+crc16_ccitt_mbuf_fn(void *crc, const void *buf, int len)
+{
+    uint16_t *c;
+
+    c = crc;
+    *c = crc16_ccitt(*c, buf, len);
+}
+
+static void
+crc32_mbuf_fn(void *crc, const void *buf, int len)
+{
+    uint32_t *c;
+
+    c = crc;
+    *c = crc32_calc(*c, buf, len);
+}
+
+int
+crc8_calc_mbuf(const struct os_mbuf *om, int off, int len, uint8_t *crc)
+{
+    uint8_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = crc_mbuf_walk(om, off, len, crc8_mbuf_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+crc16_ccitt_mbuf(const struct os_mbuf *om, int off, int len, uint16_t *crc)
+{
+    uint16_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = crc_mbuf_walk(om, off, len, crc16_ccitt_mbuf_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}
+
+int
+crc32_calc_mbuf(const struct os_mbuf *om, int off, int len, uint32_t *crc)
+{
+    uint32_t tmp;
+    int rc;
+
+    tmp = *crc;
+    rc = crc_mbuf_walk(om, off, len, crc32_mbuf_fn, &tmp);
+    if (rc == 0) {
+        *crc = tmp;
+    }
+    return rc;
+}